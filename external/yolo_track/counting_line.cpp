@@ -1,32 +1,92 @@
 #include "counting_line.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <random>
+#include "config_manager.h"
+
+namespace
+{
+    constexpr int kDefaultTrackCapacity = 1024;  // ״̬Ĭϲλ
+    constexpr int kDefaultRecordCapacity = 1024; // ¼λĬ
+    constexpr int kDefaultTrackTtl = 300;        // Ĭϸ״̬֡
+    constexpr int kEvictInterval = 64;           // ÿٴθһιڸ״̬
+
+    // IDɢУ˷ɢУȡλ
+    inline size_t hashTrackId(int track_id, size_t mask)
+    {
+        return static_cast<size_t>((static_cast<uint32_t>(track_id) * 2654435761u) >> 7) & mask;
+    }
+}
 
 /**
- * @brief 캯 - ʼģ
- * @param frame_width Ƶ֡ȣأڻƼߺͱ߽
- * @param frame_height Ƶ֡߶ȣأĬϼλúͱ߽
- * @param fps Ƶ֡ʣ֡/룩ڼ֡ʱʱ
- * @param video_path Ƶļ·ļм¼Ԫ
+ * @brief 캯 - 캯õĳԱʼ־
+ * @param detection_line_y Y꣨أ
+ * @param show_label Ƿʾ߱ǩ
  */
 CountingLineModule::CountingLineModule(
     int frame_width,                       // Ƶ֡
     int frame_height,                      // Ƶ֡߶
     double fps,                            // Ƶ֡
-    const std::string &video_path)         // Ƶļ·
+    const std::string &video_path,         // Ƶļ·
+    int detection_line_y,                  // λ
+    bool show_label)                       // Ƿʾ߱ǩ
     : frame_width_(frame_width),           // Ƶ֡
       frame_height_(frame_height),         // Ƶ֡߶
       fps_(fps),                           // Ƶ֡
       frame_duration_ms_(1000.0 / fps),    // Ƶ֡ʱ
       video_path_(video_path),             // Ƶļ·
-      detection_line_y_(frame_height / 2), // ĬϼλΪƵ
-      show_label_(true),                   // Ƿʾ߱ǩ
+      detection_line_y_(detection_line_y), // λ
+      show_label_(show_label),             // Ƿʾ߱ǩ
+      track_count_(0),                     // ״̬еĿ
+      track_ttl_frames_(kDefaultTrackTtl), // ״̬֡
+      update_frame_(0),                    // ´
+      log_crossings_(true),                // ǷÿԽ־
       total_count_(0),                     // ܼ
       detection_sequence_(0),              // к
+      record_head_(0),                     // λдλ
+      record_count_(0),                    // λеļ¼
       file_initialized_(false)             // ļǷʼ
 {
-    std::cout << "CountingLineModule initialized: " << frame_width_ << "x" << frame_height_
-              << ", " << fps_ << " fps, detection line at y=" << detection_line_y_ << std::endl;
+    setCapacity(kDefaultTrackCapacity, kDefaultRecordCapacity);
+}
+
+/**
+ * @brief 캯 - ʼģ飨Ĭλڻ룩
+ * @param frame_width Ƶ֡ȣأڻƼߺͱ߽
+ * @param frame_height Ƶ֡߶ȣأĬϼλúͱ߽
+ * @param fps Ƶ֡ʣ֡/룩ڼ֡ʱʱ
+ * @param video_path Ƶļ·ļм¼Ԫ
+ */
+CountingLineModule::CountingLineModule(int frame_width, int frame_height, double fps, const std::string &video_path)
+    : CountingLineModule(frame_width, frame_height, fps, video_path, frame_height / 2, true)
+{
+    std::cout << "CountingLineModule initialized (legacy mode):" << std::endl;
+    std::cout << "  - Frame size: " << frame_width_ << "x" << frame_height_ << std::endl;
+    std::cout << "  - FPS: " << fps_ << std::endl;
+    std::cout << "  - Detection line Y: " << detection_line_y_ << std::endl;
+}
+
+/**
+ * @brief 캯 - ʹùеļλǩʾ
+ * @param config ùdetection_line_y Ϊ -1 ʱλڻ룬ֱʹøֵΧ飩
+ * @param video_path Ƶļ·ļм¼Ԫ
+ *
+ * Ԥ counting_line.lib еͬ캯Ϊһ£üļ·
+ * ״̬֡ʹĬֵɵ÷ͨ setTrackTtl 
+ */
+CountingLineModule::CountingLineModule(int frame_width, int frame_height, double fps,
+                                       const ConfigManager &config, const std::string &video_path)
+    : CountingLineModule(frame_width, frame_height, fps, video_path,
+                         config.getDetectionLineY() == -1 ? frame_height / 2 : config.getDetectionLineY(),
+                         config.showLabel())
+{
+    std::cout << "CountingLineModule initialized from configuration:" << std::endl;
+    std::cout << "  - Frame size: " << frame_width_ << "x" << frame_height_ << std::endl;
+    std::cout << "  - FPS: " << fps_ << std::endl;
+    std::cout << "  - Detection line Y: " << detection_line_y_ << std::endl;
+    std::cout << "  - Show label: " << (show_label_ ? "true" : "false") << std::endl;
 }
 
 /**
@@ -70,6 +130,16 @@ void CountingLineModule::setCountingFile(const std::string &file_path)
     counting_file_path_ = file_path;
 }
 
+/**
+ * @brief ü¼շ
+ * @param sink ÿ¼¼Ļص׷߳еãӦֻӵ
+ *             úٴļҲԽ־
+ */
+void CountingLineModule::setRecordSink(std::function<void(const CountingRecord &)> sink)
+{
+    record_sink_ = std::move(sink);
+}
+
 /**
  * @brief ʼʼļдͷ
  * @return bool ɹtrueʧܷfalse
@@ -77,6 +147,14 @@ void CountingLineModule::setCountingFile(const std::string &file_path)
  */
 bool CountingLineModule::startCounting()
 {
+    // ¼ⲿ¼־ʱٴļ
+    if (record_sink_)
+    {
+        file_initialized_ = true;
+        std::cout << "Counting started, records go to the record sink" << std::endl;
+        return true;
+    }
+
     // ļ·Ƿ
     if (counting_file_path_.empty())
     {
@@ -113,6 +191,13 @@ int CountingLineModule::updateCounting(const std::vector<TrackResult> &track_res
 {
     int new_crossings = 0; // ¼θĴԽ
 
+    // ʱδֵĿ֤꣬״̬Сн
+    update_frame_++;
+    if (update_frame_ % kEvictInterval == 0)
+    {
+        evictExpiredTracks();
+    }
+
     // ǰ֡еиĿ
     for (const auto &track : track_results)
     {
@@ -129,12 +214,16 @@ int CountingLineModule::updateCounting(const std::vector<TrackResult> &track_res
             static_cast<int>((track.bbox[1] + track.bbox[3]) / 2)  // ĵY
         );
 
+        // ҸĿ״̬ûʷλü¼Ŀ걾ֻ֡¼λ
+        const size_t slot = findTrackSlot(track_id);
+        const bool has_history = track_table_[slot].used;
+        TrackState &state = has_history ? track_table_[slot] : acquireTrack(track_id);
+
         // ĿǷʷλü¼δ
         // ֻٵĿܽдԽ
-        if (previous_positions_.find(track_id) != previous_positions_.end() &&
-            counted_targets_.find(track_id) == counted_targets_.end())
+        if (has_history && !state.counted)
         {
-            cv::Point prev_center = previous_positions_[track_id]; // ȡһ֡ĵλ
+            cv::Point prev_center = state.center; // ȡһ֡ĵλ
 
             // ĿǷԽ˼
             if (checkLineCrossing(prev_center, current_center))
@@ -143,7 +232,7 @@ int CountingLineModule::updateCounting(const std::vector<TrackResult> &track_res
                 total_count_++;                    // ܼ
                 detection_sequence_++;             // кţTarget_ID
                 new_crossings++;                   // ӱ
-                counted_targets_.insert(track_id); // ĿΪѼֹظ
+                state.counted = true;              // ĿΪѼֹظ
 
                 // ʵʱ䣺ǰ֡ʱȥʱ䣬õĿʵʴԽʱ
                 double real_time_ms = current_frame_time_ms - real_processing_time_ms;
@@ -151,23 +240,40 @@ int CountingLineModule::updateCounting(const std::vector<TrackResult> &track_res
                 // ¼
                 CountingRecord record;
                 record.sequence_id = detection_sequence_;                 // IDΪTarget_ID
+                record.track_id = track_id;                               // ID
                 record.real_processing_time_ms = real_processing_time_ms; // ʱ
                 record.current_frame_time_ms = current_frame_time_ms;     // ǰ֡ʱ
                 record.real_time_ms = real_time_ms;                       // ʵʱ
 
-                // ¼洢ڴ
-                counting_records_.push_back(record);
-
-                // дļ
-                writeCountingRecord(record);
-
-                std::cout << "*** Target " << detection_sequence_
-                          << " crossed detection line, total count: " << total_count_ << std::endl;
+                // ¼洢ڴУλ壬ʱɵļ¼
+                record_ring_[record_head_] = record;
+                record_head_ = (record_head_ + 1) % record_ring_.size();
+                if (record_count_ < record_ring_.size())
+                {
+                    record_count_++;
+                }
+
+                // ¼շֻӣдļ
+                if (record_sink_)
+                {
+                    record_sink_(record);
+                }
+                else
+                {
+                    writeCountingRecord(record);
+                }
+
+                if (log_crossings_ && !record_sink_)
+                {
+                    std::cout << "*** Target " << detection_sequence_
+                              << " crossed detection line, total count: " << total_count_ << std::endl;
+                }
             }
         }
 
         // ¸ĿʷλΪǰλãһ֡ʹ
-        previous_positions_[track_id] = current_center;
+        state.center = current_center;
+        state.last_seen = update_frame_;
     }
 
     return new_crossings;
@@ -179,20 +285,50 @@ int CountingLineModule::updateCounting(const std::vector<TrackResult> &track_res
  *              ҪΪMat͵Ĳɫͼ
  */
 void CountingLineModule::drawDetectionLine(cv::Mat &frame)
+{
+    drawDetectionLine(frame, detection_line_y_, frame_width_, show_label_);
+}
+
+/**
+ * @brief ģʵƼߺͱǩ drawDetectionLine(frame) Ļͬ
+ * @param frame Ƶ֡ͼ
+ * @param line_y ߵY
+ * @param line_width ߳ȣ֡Եʼ
+ * @param show_label ǷƱǩ
+ */
+void CountingLineModule::drawDetectionLine(cv::Mat &frame, int line_y, int line_width, bool show_label)
 {
     // ˮƽߣ֡ԵұԵ
     // ɫBGRʽĻɫ(0, 255, 255)߿3
-    cv::line(frame, cv::Point(0, detection_line_y_), cv::Point(frame_width_, detection_line_y_),
+    cv::line(frame, cv::Point(0, line_y), cv::Point(line_width, line_y),
              cv::Scalar(0, 255, 255), 3);
 
     // ڼ߸ֱǩ˱ǩʾ
-    if (show_label_)
+    if (show_label)
     {
-        cv::putText(frame, "Detection Line", cv::Point(10, detection_line_y_ - 10),
+        cv::putText(frame, "Detection Line", cv::Point(10, line_y - 10),
                     cv::FONT_HERSHEY_SIMPLEX, 0.7, cv::Scalar(0, 255, 255), 2);
     }
 }
 
+/**
+ * @brief ȡλ
+ * @return int ߵY
+ */
+int CountingLineModule::getDetectionLineY() const
+{
+    return detection_line_y_;
+}
+
+/**
+ * @brief ȡǷʾ߱ǩ
+ * @return bool Ƿʾǩ
+ */
+bool CountingLineModule::getShowLabel() const
+{
+    return show_label_;
+}
+
 /**
  * @brief ȡǰܼ
  * @return int ԿʼԽߵĿ
@@ -234,12 +370,255 @@ void CountingLineModule::finishCounting(int total_frames)
 }
 
 /**
- * @brief ȡм¼
- * @return const std::vector<CountingRecord>& ش洢м¼ĳ
+ * @brief ȡļ¼
+ * @return std::vector<CountingRecord> ʱȺеļ¼Ϊλļ¼ֻڼļ
+ */
+std::vector<CountingRecord> CountingLineModule::getCountingRecords() const
+{
+    std::vector<CountingRecord> records;
+    records.reserve(record_count_);
+    const size_t start = (record_head_ + record_ring_.size() - record_count_) % record_ring_.size();
+    for (size_t i = 0; i < record_count_; i++)
+    {
+        records.push_back(record_ring_[(start + i) % record_ring_.size()]);
+    }
+    return records;
+}
+
+/**
+ * @brief ɾ׷ƳĿļ״̬
+ * @param track_ids α׷ƳĸIDByteTrackḴIDƳ״̬Ҫ
+ */
+void CountingLineModule::removeTracks(const std::vector<int> &track_ids)
+{
+    for (int track_id : track_ids)
+    {
+        const size_t slot = findTrackSlot(track_id);
+        if (track_table_[slot].used)
+        {
+            eraseTrackSlot(slot);
+        }
+    }
+}
+
+/**
+ * @brief ø״̬ı֡
+ * @param frames Ŀٴμδֺɾ״̬ӦС׷ʧ켣֡
+ */
+void CountingLineModule::setTrackTtl(int frames)
+{
+    track_ttl_frames_ = std::max(1, frames);
+}
+
+/**
+ * @brief ø״̬¼λ
+ * @param track_capacity ״̬λȡΪ2ݣʹ3/4
+ * @param record_capacity ڴб¼
+ */
+void CountingLineModule::setCapacity(int track_capacity, int record_capacity)
+{
+    size_t slots = 8;
+    while (slots < static_cast<size_t>(std::max(1, track_capacity)))
+    {
+        slots <<= 1;
+    }
+    track_table_.assign(slots, TrackState{0, 0, cv::Point(), false, false});
+    track_count_ = 0;
+
+    record_ring_.assign(static_cast<size_t>(std::max(1, record_capacity)), CountingRecord{});
+    record_head_ = 0;
+    record_count_ = 0;
+}
+
+/**
+ * @brief ȡǰм״̬Ŀ
+ */
+int CountingLineModule::getTrackedCount() const
+{
+    return static_cast<int>(track_count_);
+}
+
+/**
+ * @brief ҸIDڲλ̽⣩
+ * @return IDڵĲλʱ̽ϵһղλ
+ */
+size_t CountingLineModule::findTrackSlot(int track_id) const
+{
+    const size_t mask = track_table_.size() - 1;
+    size_t slot = hashTrackId(track_id, mask);
+    while (track_table_[slot].used && track_table_[slot].track_id != track_id)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief ȡID״̬ʱ
+ * ״̬ʹó3/4ʱĿ꣬ȻɾδֵĿ
+ */
+CountingLineModule::TrackState &CountingLineModule::acquireTrack(int track_id)
+{
+    size_t slot = findTrackSlot(track_id);
+    if (track_table_[slot].used)
+    {
+        return track_table_[slot];
+    }
+
+    if ((track_count_ + 1) * 4 > track_table_.size() * 3)
+    {
+        evictExpiredTracks();
+        if ((track_count_ + 1) * 4 > track_table_.size() * 3)
+        {
+            size_t oldest = 0;
+            uint64_t oldest_age = 0;
+            bool found = false;
+            for (size_t i = 0; i < track_table_.size(); i++)
+            {
+                const uint64_t age = update_frame_ - track_table_[i].last_seen;
+                if (track_table_[i].used && (!found || age > oldest_age))
+                {
+                    oldest = i;
+                    oldest_age = age;
+                    found = true;
+                }
+            }
+            eraseTrackSlot(oldest);
+        }
+        slot = findTrackSlot(track_id);
+    }
+
+    track_table_[slot] = TrackState{track_id, update_frame_, cv::Point(), false, true};
+    track_count_++;
+    return track_table_[slot];
+}
+
+/**
+ * @brief ɾλеĿ꣬Ѻ̽ϵԪǰƣʹɾǣ
+ */
+void CountingLineModule::eraseTrackSlot(size_t slot)
+{
+    const size_t mask = track_table_.size() - 1;
+    size_t hole = slot;
+    size_t next = (hole + 1) & mask;
+    while (track_table_[next].used)
+    {
+        // Ԫصλò (hole, next] ʱǰƵλ
+        const size_t home = hashTrackId(track_table_[next].track_id, mask);
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            track_table_[hole] = track_table_[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    track_table_[hole].used = false;
+    track_count_--;
+}
+
+/**
+ * @brief ɾ֡δֵĿ
  */
-const std::vector<CountingRecord> &CountingLineModule::getCountingRecords() const
+void CountingLineModule::evictExpiredTracks()
 {
-    return counting_records_;
+    for (size_t i = 0; i < track_table_.size();)
+    {
+        // ɾԪؿǰƵǰλҪټһ
+        if (track_table_[i].used && update_frame_ - track_table_[i].last_seen > static_cast<uint64_t>(track_ttl_frames_))
+        {
+            eraseTrackSlot(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+/**
+ * @brief ʱģ⣺֡ɳĿ꣬ÿģСʱһ״̬¼ռ
+ * @param hours ģʱСʱ
+ *
+ * һĿ뿪ʱͨ removeTracks ɾӦ׷Ƴ¼һֻ
+ */
+void CountingLineModule::runSoakTest(int frame_width, int frame_height, double fps, double hours)
+{
+    CountingLineModule module(frame_width, frame_height, fps);
+    module.log_crossings_ = false;
+    module.setTrackTtl(static_cast<int>(fps * 2));
+
+    struct Target
+    {
+        int id;
+        float x, y, vy;
+        int lifetime;
+    };
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<Target> targets;
+    std::vector<TrackResult> tracks;
+    std::vector<int> removed;
+    int next_id = 0;
+    size_t peak_tracked = 0;
+
+    const long long frames_per_hour = static_cast<long long>(fps * 3600.0);
+    const long long total_frames = static_cast<long long>(frames_per_hour * hours);
+    for (long long frame = 1; frame <= total_frames; frame++)
+    {
+        // ƽÿԼһĿ꣬ӻϷ·ٶȴ
+        if (uniform(rng) < 1.0f / fps)
+        {
+            Target target;
+            target.id = ++next_id;
+            target.x = uniform(rng) * frame_width;
+            const bool from_top = uniform(rng) < 0.5f;
+            target.y = from_top ? 0.0f : static_cast<float>(frame_height);
+            target.vy = (from_top ? 1.0f : -1.0f) * (2.0f + 10.0f * uniform(rng));
+            target.lifetime = static_cast<int>(frame_height / std::abs(target.vy));
+            targets.push_back(target);
+        }
+
+        tracks.clear();
+        removed.clear();
+        for (size_t i = 0; i < targets.size();)
+        {
+            Target &target = targets[i];
+            target.y += target.vy;
+            if (--target.lifetime <= 0)
+            {
+                if (target.id % 2 == 0)
+                {
+                    removed.push_back(target.id);
+                }
+                targets[i] = targets.back();
+                targets.pop_back();
+                continue;
+            }
+            TrackResult track{};
+            track.track_id = target.id;
+            track.bbox[0] = target.x - 20.0f;
+            track.bbox[1] = target.y - 40.0f;
+            track.bbox[2] = target.x + 20.0f;
+            track.bbox[3] = target.y + 40.0f;
+            track.conf = 0.9f;
+            tracks.push_back(track);
+            i++;
+        }
+        module.updateCounting(tracks, frame * module.frame_duration_ms_, 0.0);
+        module.removeTracks(removed);
+        peak_tracked = std::max(peak_tracked, module.track_count_);
+
+        if (frame % frames_per_hour == 0)
+        {
+            std::cout << "CountingLineModule soak test: hour " << frame / frames_per_hour
+                      << ", total count " << module.total_count_
+                      << ", tracks in table " << module.track_count_ << "/" << module.track_table_.size()
+                      << " (peak " << peak_tracked << ")"
+                      << ", records " << module.record_count_ << "/" << module.record_ring_.size()
+                      << ", table+ring memory " << module.track_table_.capacity() * sizeof(TrackState) + module.record_ring_.capacity() * sizeof(CountingRecord)
+                      << " bytes" << std::endl;
+        }
+    }
 }
 
 /**
@@ -257,9 +636,13 @@ void CountingLineModule::setShowLabel(bool show)
  */
 void CountingLineModule::reset()
 {
-    previous_positions_.clear(); // ʷλü¼
-    counted_targets_.clear();    // ѼĿ¼
-    counting_records_.clear();   // ռ¼
+    for (TrackState &state : track_table_)
+    {
+        state.used = false; // ʷλѼĿ¼
+    }
+    track_count_ = 0;
+    record_head_ = 0;  // ռ¼
+    record_count_ = 0;
     total_count_ = 0;            // ܼ
     detection_sequence_ = 0;     // к
 
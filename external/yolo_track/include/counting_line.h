@@ -2,9 +2,9 @@
 #define COUNTING_LINE_H
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
 #include <fstream>
-#include <map>
-#include <set>
+#include <functional>
 #include <string>
 #include <vector>
 #include "tracker.h"
@@ -16,6 +16,7 @@ class ConfigManager;
 struct CountingRecord
 {
     int sequence_id;
+    int track_id;
     double real_processing_time_ms;
     double current_frame_time_ms;
     double real_time_ms;
@@ -54,15 +55,27 @@ public:
     // set counting record file path
     void setCountingFile(const std::string &file_path);
 
-    // start counting (create record file)
+    // start counting (create record file, or only mark counting started when a record sink is set)
     bool startCounting();
 
+    // hand each new counting record to sink instead of writing the record file and logging the crossing
+    void setRecordSink(std::function<void(const CountingRecord &)> sink);
+
     // update counting (input tracking results, return new count)
     int updateCounting(const std::vector<TrackResult> &track_results, double current_frame_time_ms, double real_processing_time_ms);
 
     // draw detection line to frame
     void drawDetectionLine(cv::Mat &frame);
 
+    // draw a detection line at line_y from the left edge over line_width pixels (what drawDetectionLine draws)
+    static void drawDetectionLine(cv::Mat &frame, int line_y, int line_width, bool show_label);
+
+    // get detection line position
+    int getDetectionLineY() const;
+
+    // get detection line label display
+    bool getShowLabel() const;
+
     // get total count
     int getTotalCount() const;
 
@@ -72,8 +85,23 @@ public:
     // finish counting (write statistics and close file)
     void finishCounting(int total_frames);
 
-    // get all counting records
-    const std::vector<CountingRecord> &getCountingRecords() const;
+    // get the most recent counting records (oldest first, at most record capacity entries)
+    std::vector<CountingRecord> getCountingRecords() const;
+
+    // forget per-track state for tracks the tracker has removed
+    void removeTracks(const std::vector<int> &track_ids);
+
+    // frames (updateCounting calls) a track may go unseen before its state is evicted
+    void setTrackTtl(int frames);
+
+    // size the track table (rounded up to a power of two) and the record ring; clears per-track state and records
+    void setCapacity(int track_capacity, int record_capacity);
+
+    // number of tracks currently holding counting state
+    int getTrackedCount() const;
+
+    // simulate hours of traffic on a fresh module and log track table and record ring occupancy once per simulated hour
+    static void runSoakTest(int frame_width, int frame_height, double fps, double hours);
 
     // set detection line label display
     void setShowLabel(bool show);
@@ -82,12 +110,37 @@ public:
     void reset();
 
 private:
+    // shared initialization for both public constructors (no logging)
+    CountingLineModule(int frame_width, int frame_height, double fps, const std::string &video_path, int detection_line_y, bool show_label);
+
     // check if target crosses detection line
     bool checkLineCrossing(const cv::Point &prev_center, const cv::Point &current_center);
 
     // write counting record to file
     void writeCountingRecord(const CountingRecord &record);
 
+    // per-track counting state, kept in an open-addressing table keyed by track ID
+    struct TrackState
+    {
+        int track_id;
+        uint64_t last_seen; // update counter value when the track was last seen
+        cv::Point center;
+        bool counted;
+        bool used;
+    };
+
+    // slot holding track_id, or the empty slot where it would be inserted
+    size_t findTrackSlot(int track_id) const;
+
+    // state for track_id, inserted if absent (evicts expired or least recently seen tracks when the table is full)
+    TrackState &acquireTrack(int track_id);
+
+    // remove the entry at slot and shift the following probe chain back
+    void eraseTrackSlot(size_t slot);
+
+    // evict tracks unseen for longer than the TTL
+    void evictExpiredTracks();
+
 private:
     // video parameters
     int frame_width_;
@@ -101,18 +154,24 @@ private:
     bool show_label_;
 
     // counting status
-    std::map<int, cv::Point> previous_positions_; // track_id -> previous frame center point
-    std::set<int> counted_targets_;               // counted target ID
+    std::vector<TrackState> track_table_; // track_id -> previous center point and counted flag
+    size_t track_count_;
+    int track_ttl_frames_;
+    uint64_t update_frame_; // update counter; track ages use unsigned subtraction
+    bool log_crossings_;
     int total_count_;
     int detection_sequence_;
 
-    // record storage
-    std::vector<CountingRecord> counting_records_;
+    // record storage (fixed-size ring of the most recent records)
+    std::vector<CountingRecord> record_ring_;
+    size_t record_head_;
+    size_t record_count_;
 
     // file operation
     std::string counting_file_path_;
     std::ofstream counting_file_;
     bool file_initialized_;
+    std::function<void(const CountingRecord &)> record_sink_;
 };
 
 #endif // COUNTING_LINE_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "kalmanFilter.h"
+#include "tracker.h"
+
+class ConfigManager;
+class IDetector;
+
+/**
+ * @brief 单路可见光的自适应检测间隔控制器
+ *
+ * 每 k 帧运行一次检测，k 按以下规则在 [1, maxInterval] 内调整，取各项的最小值：
+ * - 画面中没有目标：maxInterval
+ * - 有目标：maxPredictPx / 目标最大运动速度（像素/帧），保证两次检测之间预测位置的累积位移不超过 maxPredictPx
+ * - 新目标（连续检测到的次数不足 minTrackHits）或未被任何跟踪框覆盖的高置信度检测：1（等待速度收敛、新轨迹确认）
+ * - GYK实速高于 stationarySpeedKmh 时按车速线性缩短，达到 fullRateSpeedKmh 时为1
+ *
+ * 检测帧的跟踪结果用于更新每个跟踪ID的卡尔曼状态（与ByteTrack相同的 byte_kalman 匀速模型），
+ * 间隔帧推进一步预测并输出预测位置，供计数线按同一跟踪ID继续判断越线。
+ * ByteTrack追踪器只在检测帧更新（空检测更新会删除尚未确认的新轨迹）。
+ *
+ * 线程约定：shouldDetect 由检测阶段调用，observe/predict 由追踪阶段调用，两者只通过原子变量交换间隔。
+ */
+class CadenceController
+{
+public:
+    struct Params
+    {
+        int maxInterval = 4;             // 两次检测之间最多间隔的帧数
+        float maxPredictPx = 12.0f;      // 两次检测之间预测位置允许累积的最大位移（像素）
+        int minTrackHits = 3;            // 新目标至少连续检测到的次数，之前每帧检测
+        float stationarySpeedKmh = 2.0f; // 低于该车速视为停车
+        float fullRateSpeedKmh = 80.0f;  // 达到该车速时每帧检测
+        float newObjectConf = 0.5f;      // 未被跟踪框覆盖的检测达到该置信度时视为新目标出现
+        int trackClass = -1;             // 只统计该类别的检测（<0 统计全部类别）
+    };
+
+    CadenceController(const Params &params, const std::string &name);
+
+    /**
+     * @brief 检测阶段调用：当前帧是否运行检测
+     * @param trainSpeedKmh GYK实速（km/h），<0 表示未知（不参与间隔计算）
+     */
+    bool shouldDetect(float trainSpeedKmh);
+
+    /**
+     * @brief 追踪阶段调用：检测帧的检测与跟踪结果，更新卡尔曼状态和间隔
+     */
+    void observe(const std::vector<Detection> &detections, const std::vector<TrackResult> &tracks);
+
+    /**
+     * @brief 追踪阶段调用：未检测帧推进一帧预测
+     * @param tracks 输出预测位置（与上次检测帧的跟踪ID相同）
+     */
+    void predict(std::vector<TrackResult> &tracks);
+
+    uint64_t detectedFrames() const { return detectedFrames_; }
+    uint64_t skippedFrames() const { return skippedFrames_; }
+
+    /**
+     * @brief 在录像上对比每帧检测与自适应间隔的越线计数，输出推理次数减少倍数与漏计率
+     *
+     * 两路共用同一个检测器的输出（自适应一路只在 shouldDetect 为真的帧使用检测结果），
+     * 分别经过独立的追踪器与计数线；越线事件在 maxInterval 帧内按时间顺序配对，
+     * 每帧检测一路中未配对的事件计为漏计，自适应一路中未配对的计为多计。
+     * @param detector 检测后端
+     * @param config 追踪与计数参数
+     * @param params 间隔参数（车速视为未知）
+     * @param videoPath 录像文件
+     */
+    static void evaluate(IDetector &detector, const ConfigManager &config, const Params &params, const std::string &videoPath);
+
+private:
+    struct TrackState
+    {
+        KAL_MEAN mean;
+        KAL_COVA covariance;
+        TrackResult last;  // 最近一次输出（类别、置信度等沿用）
+        int hits = 0;      // 连续检测到的次数
+        bool seen = false; // 本次检测帧是否出现（observe 内部使用）
+    };
+
+    static DETECTBOX toXyah(const float bbox[4]);
+    static void toTlbr(const KAL_MEAN &mean, float bbox[4]);
+
+    Params params_;
+    std::string name_;
+    byte_kalman::KalmanFilter kalman_;
+    std::unordered_map<int, TrackState> states_; // 跟踪ID → 卡尔曼状态（追踪阶段内使用）
+
+    std::atomic<int> motionInterval_; // 由目标与运动决定的间隔（追踪阶段写，检测阶段读）
+    int sinceDetect_;                 // 距上次检测的帧数（检测阶段内使用）
+    int currentInterval_;             // 最近一次采用的间隔（检测阶段内使用）
+    std::atomic<uint64_t> detectedFrames_{0};
+    std::atomic<uint64_t> skippedFrames_{0};
+};
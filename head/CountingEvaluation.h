@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "tracker.h"
+#include "types.h"
+
+class ConfigManager;
+class IDetector;
+
+/**
+ * @brief 录像上的越线计数对比（自适应检测间隔、推理区域等评估共用）
+ *
+ * 打开录像后逐帧运行两路：参考路对整帧检测、经过独立的 TrackerModule 与 CountingLineModule 计数；
+ * 候选路由调用方给出本帧的跟踪结果，再经过另一个计数线计数。
+ * 两路越线事件在帧容差内按时间顺序配对，参考路中未配对的计为漏计，候选路中未配对的计为多计。
+ */
+class CountingEvaluation
+{
+public:
+    /**
+     * @brief 候选路的单帧处理
+     * @param frame 当前帧
+     * @param referenceDetections 参考路本帧的整帧检测结果（可直接复用）
+     * @param tracker 候选路专用的追踪器
+     * @return 候选路本帧的跟踪结果
+     */
+    using CandidateStep = std::function<std::vector<TrackResult>(cv::Mat &frame, const std::vector<Detection> &referenceDetections,
+                                                                 TrackerModule &tracker)>;
+
+    struct Result
+    {
+        uint64_t frames = 0;            // 处理的帧数
+        double referenceDetectMs = 0.0; // 参考路整帧检测累计耗时（毫秒）
+        std::vector<double> reference;  // 参考路越线发生的帧号
+        std::vector<double> candidate;  // 候选路越线发生的帧号
+        size_t matched = 0;             // 容差内配对的越线事件数
+
+        size_t missed() const { return reference.size() - matched; }
+        size_t extra() const { return candidate.size() - matched; }
+    };
+
+    /**
+     * @brief 在录像上运行两路计数并配对越线事件
+     * @param detector 检测后端（参考路每帧调用一次）
+     * @param config 追踪与计数参数
+     * @param videoPath 录像文件
+     * @param tolerance 越线事件配对的帧容差
+     * @param candidate 候选路的单帧处理
+     * @param result 输出：帧数、越线帧号与配对数量
+     * @return 录像无法打开时返回false
+     */
+    static bool run(IDetector &detector, const ConfigManager &config, const std::string &videoPath, double tolerance,
+                    const CandidateStep &candidate, Result &result);
+
+    /**
+     * @brief 按时间顺序在容差内配对两组越线帧号（均为递增），返回配对数量
+     */
+    static size_t matchCrossings(const std::vector<double> &reference, const std::vector<double> &candidate, double tolerance);
+};
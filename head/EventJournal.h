@@ -0,0 +1,155 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MpscQueue.h"
+
+/**
+ * @brief 二进制追加式事件日志（越线计数、热成像新高温物体、上报数据包）
+ *
+ * 生产线程只把定长事件复制进无锁队列（不做格式化和文件IO），后台线程按入队顺序编号写入文件，
+ * 队列空闲时刷新缓冲区，并按 fsyncIntervalMs 把数据落盘。队列满时丢弃事件并计数。
+ *
+ * 文件格式（小端）：
+ * - 文件头16字节："HKEJ" + 版本号(uint32) + 创建时间(int64，Unix微秒)
+ * - 每条记录：类型(uint16) + 负载长度(uint16) + CRC32(uint32，覆盖序号、时间和负载) + 序号(uint64) + 时间(int64，Unix微秒) + 负载
+ * 打开已有文件时从最后一条完整记录之后继续追加（截掉断电留下的残缺尾部），序号接续。
+ * 读取使用 EventJournal::read，utils/EventJournalDump 把日志导出为CSV或JSON。
+ */
+class EventJournal
+{
+public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kFileHeaderSize = 16;
+    static constexpr size_t kRecordHeaderSize = 24;
+    static constexpr size_t kMaxPayload = 96;
+
+    enum class EventType : uint16_t
+    {
+        Crossing = 1,         // 可见光目标越过计数线
+        ThermalDetection = 2, // 热成像新确认的高温物体
+        ReportPacket = 3      // 已发送的上报数据包
+    };
+
+#pragma pack(push, 1)
+    struct CrossingEvent
+    {
+        uint8_t cameraId;           // 设备号（1=一位端，2=二位端）
+        int32_t trackId;            // 跟踪ID
+        int32_t sequenceId;         // 计数序号（Target_ID）
+        double processingTimeMs;    // 处理耗时
+        double frameTimeMs;         // 帧时间
+        double realTimeMs;          // 真实越线时间（帧时间减处理耗时）
+    };
+
+    struct ThermalDetectionEvent
+    {
+        uint8_t cameraId;     // 设备号（1=一位端，2=二位端）
+        int32_t spotId;       // 高温物体轨迹ID
+        uint64_t frameSeq;    // 热成像原始帧序号
+        float x, y, w, h;     // 外接矩形（温度矩阵坐标）
+        float alarmThreshold; // 分析时使用的报警阈值
+    };
+
+    struct ReportPacketEvent
+    {
+        uint8_t flags[4];      // 检测标志位（一位端可见光、一位端热成像、二位端可见光、二位端热成像）
+        uint8_t sent;          // 是否发送成功
+        uint16_t clientCount;  // 发送时的TCP客户端数量
+        uint16_t packetSize;   // 数据包原始长度
+        uint8_t packet[64];    // 数据包内容（超出部分截断）
+    };
+#pragma pack(pop)
+
+    struct Params
+    {
+        std::string path = "events.journal"; // 日志文件路径
+        size_t queueCapacity = 4096;         // 队列容量（事件数）
+        int fsyncIntervalMs = 1000;          // 落盘间隔（毫秒）
+    };
+
+    /**
+     * @brief 读出的一条记录（payload 只在回调期间有效）
+     */
+    struct Record
+    {
+        uint64_t seq = 0;
+        int64_t timeUs = 0;
+        EventType type = EventType::Crossing;
+        const uint8_t *payload = nullptr;
+        uint16_t size = 0;
+    };
+
+    EventJournal() = default;
+    ~EventJournal();
+
+    EventJournal(const EventJournal &) = delete;
+    EventJournal &operator=(const EventJournal &) = delete;
+
+    /**
+     * @brief 打开日志文件并启动写入线程
+     * @return 文件无法打开或已有文件格式不符时返回false
+     */
+    bool start(const Params &params);
+
+    /**
+     * @brief 写完队列中剩余的事件，落盘后关闭文件
+     */
+    void stop();
+
+    bool isRunning() const { return running_; }
+
+    /**
+     * @brief 记录事件（任意线程，只入队）
+     * @return false 日志未启动或队列已满
+     */
+    bool logCrossing(int cameraId, int trackId, int sequenceId, double processingTimeMs, double frameTimeMs, double realTimeMs);
+    bool logThermalDetection(int cameraId, int spotId, uint64_t frameSeq, float x, float y, float w, float h, float alarmThreshold);
+    bool logReportPacket(const uint8_t flags[4], bool sent, size_t clientCount, const std::vector<uint8_t> &packet);
+
+    /**
+     * @brief 因队列满被丢弃的事件数
+     */
+    uint64_t droppedEvents() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 按顺序读取日志中的全部完整记录
+     * @param validBytes 输出：最后一条完整记录结束处的文件偏移（可为空）
+     * @return 文件无法打开或文件头不符时返回false；残缺或校验失败的尾部记录被忽略
+     */
+    static bool read(const std::string &path, const std::function<void(const Record &)> &callback, uint64_t *validBytes = nullptr);
+
+    static const char *typeName(EventType type);
+
+private:
+    struct Event
+    {
+        EventType type = EventType::Crossing;
+        uint16_t size = 0;
+        int64_t timeUs = 0;
+        uint8_t payload[kMaxPayload];
+    };
+
+    template <typename Payload>
+    bool enqueue(EventType type, const Payload &payload);
+
+    void run();
+    void write(const Event &event);
+    void sync();
+
+    static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size);
+
+    Params params_;
+    std::unique_ptr<MpscQueue<Event>> queue_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> dropped_{0};
+    FILE *file_ = nullptr;
+    uint64_t nextSeq_ = 0;
+    bool unsynced_ = false;
+};
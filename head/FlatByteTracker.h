@@ -0,0 +1,164 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+#include "LapjvSolver.h"
+#include "tracker.h"
+
+/**
+ * @brief 缓存友好的 ByteTrack 追踪核心
+ *
+ * 关联流程、阈值与卡尔曼模型与 BYTETracker 相同（高分检测关联全部轨迹 → 低分检测关联未匹配的跟踪中轨迹 →
+ * 未确认轨迹关联剩余高分检测 → 新建轨迹 → 过期删除 → 跟踪/丢失列表去重），在同一检测序列上产生相同的跟踪ID与框，
+ * 区别只在数据布局：
+ * - 轨迹存放在容量固定的结构数组中（均值、协方差、框、ID、状态等各自连续），跟踪/丢失列表只保存槽位下标，
+ *   不再逐帧复制 STrack 对象
+ * - IoU 代价矩阵写入一块跨帧复用的连续缓冲区，由 LapjvSolver 求解（不再构造嵌套 vector 和每次调用 malloc）
+ * - 卡尔曼预测与修正使用定长 Eigen 类型，分别在一次遍历中批量完成
+ *
+ * 跟踪ID按实例编号（BYTETracker 的ID计数器为全局静态变量，多路共用）。
+ */
+class FlatByteTracker
+{
+public:
+    struct Params
+    {
+        int frameRate = 30;              // 视频帧率
+        int trackBuffer = 30;            // 丢失轨迹保留的帧数（按30fps折算）
+        float trackThresh = 0.5f;        // 高/低分检测的分界
+        float highThresh = 0.6f;         // 新建轨迹的最低分数
+        float matchThresh = 0.8f;        // 第一次关联的IoU距离阈值
+        float unconfirmedThresh = 0.7f;  // 未确认轨迹关联的IoU距离阈值
+        float lowMatchThresh = 0.5f;     // 低分检测关联的IoU距离阈值
+        int capacity = 1024;             // 轨迹表容量（同时存在的轨迹上限）
+        int trackClass = -1;             // 只追踪该类别（<0 追踪全部类别）
+        float minTargetArea = 0.0f;      // 面积小于该值的检测不参与追踪
+    };
+
+    explicit FlatByteTracker(const Params &params);
+
+    /**
+     * @brief 与 TrackerModule::update 相同的接口：按类别与面积过滤检测后更新，输出已激活的轨迹
+     */
+    void update(const std::vector<Detection> &detections, std::vector<TrackResult> &results);
+
+    /**
+     * @brief 追踪核心：不做过滤，直接用全部检测更新一帧
+     */
+    void step(const std::vector<Detection> &detections);
+
+    /**
+     * @brief 已激活的跟踪中轨迹（与 BYTETracker::update 的输出顺序相同）
+     */
+    void activeTracks(std::vector<TrackResult> &results);
+
+    /**
+     * @brief 上一次更新中被移除的跟踪ID（已从跟踪和丢失列表中删除，之后不会再出现）
+     */
+    const std::vector<int> &removedTracks() const { return removedIds_; }
+
+    /**
+     * @brief 把一帧检测追加到检测序列文件（每帧一行 "frame 帧号 数量"，之后每个检测一行 "x1 y1 x2 y2 置信度 类别"）
+     */
+    static void writeTraceFrame(std::ostream &out, uint64_t frameIndex, const std::vector<Detection> &detections);
+
+    /**
+     * @brief 读取检测序列文件
+     */
+    static bool loadTrace(const std::string &path, std::vector<std::vector<Detection>> &frames);
+
+    /**
+     * @brief 在检测序列上同时运行 BYTETracker 与本追踪核心（输入均为按类别与面积过滤后的检测），
+     *        逐帧比较输出的跟踪ID（允许固定偏移）和框
+     * @return 全部帧一致返回true
+     */
+    static bool compareWithByteTrack(const std::string &tracePath, const Params &params);
+
+    /**
+     * @brief 在10/100/500个目标的合成场景上对比 BYTETracker 与本追踪核心的每帧耗时，结果输出到日志
+     */
+    static void runBenchmark(const Params &params, int frames);
+
+private:
+    using Mean = Eigen::Matrix<float, 1, 8, Eigen::RowMajor>;
+    using Cova = Eigen::Matrix<float, 8, 8, Eigen::RowMajor>;
+    using Box = std::array<float, 4>;
+
+    enum State : uint8_t
+    {
+        kNew = 0,
+        kTracked,
+        kLost,
+        kRemoved
+    };
+
+    /**
+     * @brief 按类别与面积过滤检测
+     */
+    void filterDetections(const std::vector<Detection> &detections, std::vector<Detection> &filtered) const;
+
+    int allocate();
+    void initiate(int slot, const Box &tlwh);
+    void predict(const std::vector<int> &slots);
+    void applyUpdates();
+    void refreshTlbr(int slot);
+
+    /**
+     * @brief IoU距离关联：代价写入 cost_，求解后拆分为匹配对与未匹配的行、列（与 linear_assignment 相同）
+     */
+    void associate(const std::vector<int> &trackSlots, const std::vector<int> &dets, float thresh);
+
+    static float iou(const Box &a, const Box &b);
+
+    Params params_;
+    int maxTimeLost_;
+    int frame_ = 0;
+    int nextId_ = 0;
+    uint64_t droppedTracks_ = 0;
+
+    // 轨迹表（结构数组，下标为槽位）
+    std::vector<Mean, Eigen::aligned_allocator<Mean>> mean_;
+    std::vector<Cova, Eigen::aligned_allocator<Cova>> cova_;
+    std::vector<Box> tlbr_;
+    std::vector<int> id_;
+    std::vector<int> frameId_;
+    std::vector<int> startFrame_;
+    std::vector<int> removedFrame_; // 第一次被删除的帧（0=未删除）
+    std::vector<int> listedFrame_;  // 最近一次出现在跟踪/丢失列表中的帧
+    std::vector<int> classId_;
+    std::vector<float> score_;
+    std::vector<uint8_t> state_;
+    std::vector<uint8_t> activated_;
+    std::vector<uint8_t> reported_;
+    std::vector<int> freeSlots_;
+    std::vector<int> tracked_; // 跟踪中轨迹（含未确认）
+    std::vector<int> lost_;    // 丢失轨迹，按ID升序
+    std::vector<int> removedIds_;
+
+    // 当前帧检测
+    std::vector<Box> detTlwh_;
+    std::vector<Box> detTlbr_;
+    std::vector<float> detScore_;
+    std::vector<int> detClass_;
+
+    // 逐帧复用的工作区
+    std::vector<Detection> filtered_;
+    std::vector<int> high_, low_, remaining_;
+    std::vector<int> pool_, unconfirmed_, rTracked_;
+    std::vector<int> refind_, newTracks_, newLost_, candidates_, scratch_;
+    std::vector<std::pair<int, int>> matches_; // (行, 列)
+    std::vector<int> unmatchedRows_, unmatchedCols_;
+    std::vector<std::pair<int, int>> pending_; // 待修正的 (槽位, 检测)
+    std::vector<uint8_t> dupTracked_, dupLost_;
+    std::vector<float> cost_;
+    std::vector<int> rowsol_, colsol_;
+    LapjvSolver lapjv_;
+
+    // 卡尔曼模型
+    Cova motion_;
+    Eigen::Matrix<float, 4, 8, Eigen::RowMajor> update_;
+};
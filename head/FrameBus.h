@@ -0,0 +1,185 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 共享内存帧总线（本机进程间发布处理后的原始帧）
+ *
+ * 每路流一个命名共享内存环，本机的显示或分析进程映射后直接读取帧数据，不再经过
+ * RTSP编码 → 回环 → 解码。写端每帧复制一次到下一个槽位，读端不复制：
+ * - 槽位用序列锁保护：写入前序列号加1（奇数表示正在写），写完再加1；读端取视图前后比较序列号，
+ *   写端要绕环一整圈（slotCount-1 帧之后）才会覆盖同一槽位，读端在此之前用完视图即可
+ * - 头部的 latestSeq 为最近发布的总线序号，读端总是取最新一帧，落后时直接跳过中间的帧并计数
+ * - 唤醒：Linux 对头部的32位等待字使用 futex（跨进程，FUTEX_WAIT 在等待字变化时立即返回）；
+ *   Windows 使用两个命名手动重置事件按帧交替置位（发布第 n 帧时置位 n%2 号事件、复位另一个），
+ *   读端等待下一帧对应的事件并带超时重新检查，避免错过连续两帧时的唤醒
+ * - 时间戳与 steadyClockUs 相同（单调时钟，本机各进程一致），读端可直接计算发布到取帧的延迟
+ *
+ * 命名：Windows 为 "Local\\<名称>"（事件为 "<名称>_ev0/1"），POSIX 为 "/<名称>"。
+ * 共享内存在第一次发布时按帧大小创建，之后更大的帧会被丢弃并计数。每个写端只能由一个线程使用。
+ * utils/FrameBusTool 为参考读端（查看、统计延迟），也可作为模拟写端做跨进程延迟测试。
+ */
+
+/**
+ * @brief 共享内存头部（进程间共享的布局，只包含定长字段）
+ */
+struct FrameBusHeader
+{
+    static constexpr uint32_t kMagic = 0x42464B48; // "HKFB"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t headerBytes;
+    uint64_t slotStride;            // 相邻槽位的间隔（字节）
+    uint64_t slotCapacity;          // 每个槽位可容纳的帧数据字节数
+    uint64_t sessionId;             // 写端每次创建时更新，读端据此识别写端重启
+    std::atomic<uint64_t> latestSeq; // 最近发布的总线序号（从1开始，0表示尚无帧）
+    std::atomic<uint32_t> wakeWord;  // latestSeq 的低32位（futex 等待字）
+    uint32_t reserved;
+};
+
+/**
+ * @brief 槽位头部，帧数据紧随其后（从 kDataOffset 开始，连续存放）
+ */
+struct FrameBusSlot
+{
+    static constexpr size_t kDataOffset = 256;
+
+    std::atomic<uint32_t> sequence; // 序列锁，奇数表示正在写入
+    uint32_t bytes;                 // 帧数据字节数
+    uint64_t busSeq;                // 总线序号
+    uint64_t frameSeq;              // FrameMeta::seq
+    int64_t captureTimeUs;          // FrameMeta::captureTimeUs
+    int64_t publishTimeUs;          // 发布完成的时间（steadyClockUs）
+    int32_t width;
+    int32_t height;
+    int32_t type; // cv::Mat::type()
+    int32_t step; // 行字节数
+};
+
+/**
+ * @brief 帧总线写端
+ */
+class FrameBusWriter
+{
+public:
+    FrameBusWriter() = default;
+    ~FrameBusWriter();
+    FrameBusWriter(const FrameBusWriter &) = delete;
+    FrameBusWriter &operator=(const FrameBusWriter &) = delete;
+
+    /**
+     * @brief 启用写端（共享内存在第一次发布时创建）
+     * @param name 总线名称
+     * @param slotCount 槽位数量（至少2）
+     */
+    void configure(const std::string &name, int slotCount);
+
+    bool enabled() const { return !name_.empty(); }
+
+    /**
+     * @brief 发布一帧：复制到下一个槽位并唤醒读端；未启用时直接返回
+     */
+    void publish(const cv::Mat &frame, uint64_t frameSeq, int64_t captureTimeUs);
+
+    uint64_t published() const { return published_; }
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    bool create(size_t frameBytes);
+    void release();
+
+    std::string name_;
+    int slotCount_ = 0;
+    bool failed_ = false; // 创建失败后不再重试
+    FrameBusHeader *header_ = nullptr;
+    uint8_t *base_ = nullptr;
+    size_t mappedBytes_ = 0;
+    uint64_t seq_ = 0;
+    uint64_t published_ = 0;
+    uint64_t dropped_ = 0;
+#ifdef _WIN32
+    void *mapping_ = nullptr;
+    void *events_[2] = {nullptr, nullptr};
+#else
+    int fd_ = -1;
+#endif
+};
+
+/**
+ * @brief 帧总线读端（只读映射，取到的帧直接指向共享内存）
+ */
+class FrameBusReader
+{
+public:
+    /**
+     * @brief 一帧的只读视图
+     */
+    struct View
+    {
+        cv::Mat frame;             // 指向共享内存中的槽位数据，只读，写端绕环一圈后会被覆盖
+        uint64_t busSeq = 0;       // 总线序号
+        uint64_t frameSeq = 0;     // FrameMeta::seq
+        int64_t captureTimeUs = 0; // FrameMeta::captureTimeUs
+        int64_t publishTimeUs = 0; // 发布时间
+        uint64_t skipped = 0;      // 与上一次取到的帧之间跳过的帧数
+        int slot = -1;
+        uint32_t sequence = 0;     // 取视图时槽位的序列号
+    };
+
+    FrameBusReader() = default;
+    ~FrameBusReader();
+    FrameBusReader(const FrameBusReader &) = delete;
+    FrameBusReader &operator=(const FrameBusReader &) = delete;
+
+    /**
+     * @brief 映射已存在的总线
+     * @return 写端尚未创建或布局不兼容时返回false（可稍后重试）
+     */
+    bool open(const std::string &name);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    /**
+     * @brief 等待比上一次取到的帧更新的帧
+     * @return 有新帧返回true，超时返回false
+     */
+    bool wait(int timeoutMs);
+
+    /**
+     * @brief 取最新一帧的视图（不复制）
+     * @return 没有新帧或连续多次与写端冲突时返回false
+     */
+    bool acquire(View &view);
+
+    /**
+     * @brief 视图在使用期间是否未被写端覆盖（用完数据后调用，返回false时应丢弃结果）
+     */
+    bool validate(const View &view) const;
+
+    /**
+     * @brief 写端是否已退出或重启（需要重新打开）
+     */
+    bool writerRestarted() const;
+
+    uint64_t torn() const { return torn_; }
+
+private:
+    std::string name_;
+    const FrameBusHeader *header_ = nullptr;
+    const uint8_t *base_ = nullptr;
+    size_t mappedBytes_ = 0;
+    uint64_t sessionId_ = 0;
+    uint64_t lastSeq_ = 0;
+    uint64_t torn_ = 0; // 因写端覆盖而重试的次数
+#ifdef _WIN32
+    void *mapping_ = nullptr;
+    void *events_[2] = {nullptr, nullptr};
+#else
+    int fd_ = -1;
+#endif
+};
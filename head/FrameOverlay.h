@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "tracker.h"
+
+/**
+ * @brief 标注图层，按位组合为图层集合
+ */
+enum OverlayLayer : uint32_t
+{
+    kOverlayNone = 0,
+    kOverlayTracks = 1u << 0,       // 可见光跟踪框
+    kOverlayCountingLine = 1u << 1, // 计数线
+    kOverlayFusion = 1u << 2,       // 被热成像确认的目标框
+    kOverlayHotSpots = 1u << 3,     // 热成像高温区域
+    kOverlayAll = kOverlayTracks | kOverlayCountingLine | kOverlayFusion | kOverlayHotSpots
+};
+
+/**
+ * @brief 一帧的标注数据（帧像素坐标），与处理后帧一起发布，发布后不再修改
+ * 生产线程只记录要画什么，真正需要带标注的画面时再由 OverlayCache 绘制
+ */
+struct FrameOverlay
+{
+    std::vector<TrackResult> tracks;                       // 跟踪结果（TrackerModule::drawTrackResults 绘制）
+    int countingLineY = -1;                                // 计数线纵坐标，<0 表示没有计数线
+    int countingLineWidth = 0;                             // 计数线长度（从左边缘开始）
+    bool countingLineLabel = false;                        // 是否显示计数线标签
+    std::vector<std::pair<cv::Rect, cv::Scalar>> fusionBoxes; // 被热成像确认的目标框及颜色
+    std::vector<std::array<cv::Point2f, 4>> hotSpots;      // 高温区域最小外接矩形的顶点
+
+    /**
+     * @brief 把指定图层画到帧上
+     */
+    void draw(cv::Mat &frame, uint32_t layers) const;
+
+    /**
+     * @brief 图层名称列表（tracks / counting_line / fusion / hot_spots）转换为图层集合
+     * @param unknown 不为空时返回无法识别的名称（以逗号分隔）
+     */
+    static uint32_t parseLayers(const std::vector<std::string> &names, std::string *unknown = nullptr);
+
+    /**
+     * @brief 图层集合的可读名称，用于日志
+     */
+    static std::string layerNames(uint32_t layers);
+};
+using FrameOverlayPtr = std::shared_ptr<const FrameOverlay>;
+
+/**
+ * @brief 一路处理后帧的标注渲染缓存
+ *
+ * 处理后帧本身不带标注。输出端（推流、四分屏、显示窗口）取帧时给出所需的图层集合，
+ * 按 (帧序号, 标注数据, 图层集合) 缓存绘制结果：同一帧被多个输出以相同图层取用时只复制、绘制一次。
+ * 新一帧到来时丢弃旧帧的结果；不再被任何输出引用的缓冲区留作下一次绘制使用，运行中不反复分配帧缓冲区。
+ * 由对应的processed锁保护（调用方持锁），返回的图像为只读共享数据。
+ */
+class OverlayCache
+{
+public:
+    /**
+     * @brief 取得带指定图层的帧（图层集合为空时即为处理后帧的副本）
+     * @param clean 处理后帧（不带标注）
+     * @param seq 处理后帧的采集帧序号
+     * @param overlay 该帧的标注数据（可为空）
+     * @param layers 需要的图层集合
+     */
+    cv::Mat render(const cv::Mat &clean, uint64_t seq, const FrameOverlayPtr &overlay, uint32_t layers);
+
+    uint64_t renders() const { return renders_; } // 实际绘制（含复制）的次数
+    uint64_t hits() const { return hits_; }       // 直接复用已有结果的次数
+
+private:
+    struct Entry
+    {
+        uint64_t seq = 0;
+        FrameOverlayPtr overlay;
+        uint32_t layers = 0;
+        cv::Mat frame;
+    };
+
+    static constexpr size_t kMaxEntries = 4; // 同一帧最多缓存的图层集合数
+
+    std::vector<Entry> entries_;
+    std::vector<cv::Mat> spare_; // 旧帧的缓冲区，不再被输出引用时复用
+    uint64_t renders_ = 0;
+    uint64_t hits_ = 0;
+};
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "types.h"
+
+struct ObjectTrackingConfig;
+
+/**
+ * @brief 目标检测后端接口
+ *
+ * 追踪线程只依赖该接口，检测结果统一为原图坐标的 Detection（x1, y1, x2, y2, 置信度, 类别）。
+ * 已有实现：
+ * - TensorRtDetector：封装 yolo_track 库的 YoloDetector（TensorRT引擎，GPU预处理/解码/NMS）
+ * - OpenCvDnnDetector：OpenCV DNN 在CPU上运行ONNX模型，CPU letterbox预处理与解码/NMS，
+ *   用于没有GPU的集成测试机
+ */
+class IDetector
+{
+public:
+    virtual ~IDetector() = default;
+
+    /**
+     * @brief 检测一帧图像
+     * @param img 输入图像（BGR，与 YoloDetector::inference 一致按非常量引用传入，后端不修改其内容）
+     * @return 原图坐标的检测结果
+     */
+    virtual std::vector<Detection> detect(cv::Mat &img) = 0;
+
+    /**
+     * @brief 批量检测，默认逐张调用 detect，支持多批次推理的后端可重写为一次前向
+     * @param images 输入图像（BGR）
+     * @return 与输入一一对应的检测结果
+     */
+    virtual std::vector<std::vector<Detection>> detectBatch(const std::vector<cv::Mat *> &images);
+
+    /**
+     * @brief 后端名称（用于日志）
+     */
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief 按配置创建检测后端（"tensorrt" / "opencv_dnn"）
+     * @return 创建失败或后端未编译时返回空指针
+     */
+    static std::unique_ptr<IDetector> create(const ObjectTrackingConfig &config, const std::string &backend);
+
+    /**
+     * @brief 在图像目录上对比两个后端的检测结果，按坐标匹配后输出数量差异、最大坐标偏差和置信度偏差
+     *        （由 utils/DetectorParity 调用）
+     * @param reference 参考后端
+     * @param candidate 待验证后端
+     * @param imageDir 测试图像目录（jpg/png/bmp）
+     * @param tolerancePx 坐标偏差容差（像素），超过即计为不一致
+     * @return 所有图像的检测结果都在容差内时返回true
+     */
+    static bool compareBackends(IDetector &reference, IDetector &candidate, const std::string &imageDir, float tolerancePx);
+};
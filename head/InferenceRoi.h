@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "tracker.h"
+
+class ConfigManager;
+class IDetector;
+
+/**
+ * @brief 单路可见光的推理区域（只对计数线附近做检测）
+ *
+ * 区域按模式选择：
+ * - band：计数线上下各 bandHalfHeight 像素的整宽水平带
+ * - tracks：水平带与最近一帧跟踪框（外扩 trackMargin）的外接矩形，随活动目标扩大
+ * 区域沿水平方向切成 strips 段（相邻段重叠 stripOverlap 像素），纵向拼接成一张图送入检测器，
+ * 宽而矮的区域因此在 letterbox 中得到更大的缩放比例（更高的有效分辨率）；检测结果按所在段映射回整帧坐标，
+ * 重叠区域中同一目标的重复框按“交集/较小框面积”合并，保留较大的框。
+ * fullFrameInterval>0 时每隔若干次检测做一次整帧检测，用于发现区域外出现的目标。
+ *
+ * 线程约定：prepare/mapBack 由检测阶段调用，observe 由追踪阶段调用，两者只通过加锁的跟踪框外接矩形交换数据。
+ */
+class InferenceRoi
+{
+public:
+    struct Params
+    {
+        std::string mode = "band";  // band 或 tracks
+        int lineY = 0;              // 计数线位置（整帧坐标，<=0 取画面中央）
+        int bandHalfHeight = 160;   // 计数线上下各保留的高度（像素）
+        int trackMargin = 48;       // tracks 模式下跟踪框外扩的像素
+        int strips = 2;             // 区域切分的段数（1=直接裁剪）
+        int stripOverlap = 128;     // 相邻两段重叠的宽度（像素），应不小于目标宽度
+        int fullFrameInterval = 0;  // >0: 每隔该次数检测做一次整帧检测
+    };
+
+    explicit InferenceRoi(const Params &params);
+
+    /**
+     * @brief 检测阶段调用：按本帧区域生成送入检测器的图像
+     * @param frame 整帧图像
+     * @return 本帧做整帧检测时返回 frame 本身，否则返回内部拼接缓冲区（下次调用前有效）
+     */
+    cv::Mat &prepare(cv::Mat &frame);
+
+    /**
+     * @brief 检测阶段调用：把 prepare 所返回图像上的检测结果映射回整帧坐标
+     */
+    void mapBack(std::vector<Detection> &detections);
+
+    /**
+     * @brief 追踪阶段调用：记录本帧跟踪框的外接矩形，供 tracks 模式扩大区域
+     */
+    void observe(const std::vector<TrackResult> &tracks);
+
+    /**
+     * @brief 最近一次 prepare 使用的区域（整帧坐标，整帧检测时为整帧）
+     */
+    const cv::Rect &region() const { return region_; }
+
+    uint64_t roiFrames() const { return roiFrames_; }
+    uint64_t fullFrames() const { return fullFrames_; }
+
+    /**
+     * @brief 在录像上对比整帧检测与区域检测：每帧检测耗时（含预处理）、计数线附近的检测数量与越线计数
+     *
+     * 两路各自经过独立的追踪器与计数线；区域内检测按IoU配对，分别统计只在整帧或只在区域检测中出现的框，
+     * 越线事件在2帧容差内按时间顺序配对。
+     * @param detector 检测后端
+     * @param config 追踪与计数参数
+     * @param params 区域参数
+     * @param videoPath 录像文件
+     */
+    static void evaluate(IDetector &detector, const ConfigManager &config, const Params &params, const std::string &videoPath);
+
+private:
+    Params params_;
+    std::mutex trackMutex_;
+    cv::Rect trackBounds_; // 最近一帧跟踪框的外接矩形（追踪阶段写，检测阶段读）
+
+    // 检测阶段内使用
+    cv::Mat mosaic_;       // 拼接后的图像
+    cv::Rect region_;      // 本帧区域（整帧坐标）
+    bool fullFrame_ = true;
+    int stripCount_ = 1;
+    int stripWidth_ = 0;
+    int sinceFull_ = 0;
+    uint64_t roiFrames_ = 0;
+    uint64_t fullFrames_ = 0;
+    std::vector<int> stripOf_;
+    std::vector<int> order_;
+    std::vector<uint8_t> suppressed_;
+    std::vector<Detection> merged_;
+};
@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "IDetector.h"
+
+/**
+ * @brief 跨摄像头的动态批处理推理调度器
+ *
+ * 各路视频提交待检测帧后得到 future，调度线程把等待中的请求合并成批次：
+ * 凑满 maxBatch 个请求，或最早的请求等待超过 maxWaitUs 时立即执行一次 IDetector::detectBatch，
+ * 再把每张图的检测结果分发回对应请求。调度逻辑只依赖 IDetector 接口，与检测后端无关。
+ * 提交的帧在 future 就绪前必须保持有效且不被修改。
+ */
+class InferenceScheduler
+{
+public:
+    struct Params
+    {
+        int maxBatch = 2;     // 单批最多帧数
+        int maxWaitUs = 5000; // 最早请求的最长等待时间（微秒），0=有请求立即执行
+    };
+
+    InferenceScheduler(IDetector &detector, const Params &params);
+    ~InferenceScheduler();
+
+    /**
+     * @brief 启动调度线程
+     */
+    void start();
+
+    /**
+     * @brief 停止调度线程，未执行的请求以空结果返回
+     */
+    void stop();
+
+    /**
+     * @brief 提交一帧待检测图像
+     * @param frame 输入图像（BGR），在返回的 future 就绪前保持有效
+     * @return 检测结果
+     */
+    std::future<std::vector<Detection>> submit(cv::Mat &frame);
+
+    /**
+     * @brief 对不同批大小与等待时限组合测量吞吐量和延迟（p50/p99），结果输出到日志
+     * @param detector 检测后端
+     * @param frameSize 测试帧尺寸
+     * @param producers 并发提交的视频路数（每路收到结果后立即提交下一帧）
+     * @param framesPerCase 每种组合每路提交的帧数
+     */
+    static void runBenchmark(IDetector &detector, const cv::Size &frameSize, int producers, int framesPerCase);
+
+private:
+    struct Request
+    {
+        cv::Mat *frame;
+        std::promise<std::vector<Detection>> promise;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    void run();
+
+    IDetector &detector_;
+    Params params_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Request> pending_;
+
+    // 调度线程内复用
+    std::vector<Request> batch_;
+    std::vector<cv::Mat *> batchFrames_;
+
+    // 统计（调度线程内更新）
+    uint64_t batches_ = 0;
+    uint64_t frames_ = 0;
+    double totalWaitMs_ = 0.0;
+};
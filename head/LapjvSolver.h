@@ -0,0 +1,46 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Jonker-Volgenant 稠密线性分配求解器（工作数组跨调用复用）
+ *
+ * 算法与 lapjv.h 的 lapjv_internal 逐步一致（列归约、两轮增广行归约、最短增广路），
+ * 相同输入得到相同的分配；区别是代价方阵与各工作数组作为成员保留，调用之间不再分配内存。
+ * solveRect 与 BYTETracker::linear_assignment 的扩展方式相同：rows×cols 代价矩阵扩展为
+ * (rows+cols) 方阵，虚拟行列代价为 costLimit/2，虚拟行与虚拟列之间为0，分配到虚拟行列视为未匹配。
+ */
+class LapjvSolver
+{
+public:
+    /**
+     * @brief 求解矩形代价矩阵的分配
+     * @param cost 行优先的连续代价矩阵（rows×cols）
+     * @param costLimit 代价上限
+     * @param rowsol 输出每行分配的列，未匹配为-1
+     * @param colsol 输出每列分配的行，未匹配为-1
+     */
+    void solveRect(const float *cost, int rows, int cols, float costLimit, std::vector<int> &rowsol, std::vector<int> &colsol);
+
+private:
+    int ccrrt(int n);
+    int carr(int n, int nFreeRows);
+    int findDense(int n, int lo);
+    int scanDense(int n, int &plo, int &phi);
+    int findPath(int n, int startRow);
+    void ca(int n, int nFreeRows);
+    void solve(int n);
+
+    double cost(int i, int j) const { return cost_[static_cast<size_t>(i) * n_ + j]; }
+
+    int n_ = 0;
+    std::vector<double> cost_;   // n×n 代价方阵（行优先）
+    std::vector<int> x_, y_;     // 行→列、列→行
+    std::vector<int> freeRows_;  // 未分配的行
+    std::vector<double> v_;      // 列对偶变量
+    std::vector<double> d_;      // 最短路距离
+    std::vector<int> cols_;      // 最短路扫描顺序
+    std::vector<int> pred_;      // 最短路前驱行
+    std::vector<uint8_t> unique_;
+};
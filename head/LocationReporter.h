@@ -11,6 +11,7 @@
 
 // Forward declaration
 struct ObjectTrackingConfig;
+class EventJournal;
 
 // Windows网络编程相关头文件
 #include <ws2tcpip.h>
@@ -145,6 +146,20 @@ public:
      */
     size_t getClientCount() const;
 
+    /**
+     * @brief 获取最近一帧有效的GYK解析数据（与 reportLocation 在同一线程调用）
+     * @param data 输出数据
+     * @return 是否已有有效数据
+     */
+    bool getLastValidData(ParsedGYKData &data) const;
+
+    /**
+     * @brief 设置事件日志，发送的数据包写入日志（在 reportLocation 之前调用）
+     * @param journal 事件日志，nullptr 表示不记录
+     * @param logAllPackets true 记录每个数据包，false 只记录带检测标志位或发送失败的数据包
+     */
+    void setEventJournal(EventJournal *journal, bool logAllPackets);
+
 private:
     /**
      * @brief 组装包含车辆运行数据的完整数据包并广播
@@ -174,6 +189,10 @@ private:
     int tcpServerPort_;
     const ObjectTrackingConfig *config_; // 配置对象指针
 
+    // 事件日志
+    EventJournal *eventJournal_ = nullptr;
+    bool journalAllPackets_ = false;
+
     /**
      * @brief 打开RS422串口
      */
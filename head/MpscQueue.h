@@ -0,0 +1,106 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief 有界多生产者单消费者环形队列
+ *
+ * 每个槽位带一个序号：生产者用CAS占用尾部下标后写入元素，再发布槽位序号；消费者按序号判断槽位是否已写完。
+ * 入队/出队都不加锁、不分配内存，队列满时 tryPush 立即返回失败。
+ * tryPush 可由任意线程调用，tryPop 只能由一个消费者线程调用。
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    /**
+     * @param capacity 最多容纳的元素个数（向上取整为2的幂）
+     */
+    explicit MpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * @brief 非阻塞入队（任意线程）
+     * @return false 队列已满
+     */
+    bool tryPush(const T &item)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;)
+        {
+            cell = &cells_[pos & mask_];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 该槽位还未被消费者取走，队列已满
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed); // 被其他生产者抢先，重新读取尾部
+            }
+        }
+        cell->value = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 非阻塞出队（消费者线程）
+     * @return false 队列为空（或队首元素尚未写完）
+     */
+    bool tryPop(T &item)
+    {
+        const size_t pos = head_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[pos & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+            return false;
+        item = cell.value;
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief 当前元素个数（其他线程读取时为近似值）
+     */
+    size_t size() const
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0}; // 等于下标时可写，等于下标+1时可读
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0}; // 下一个写入位置（生产者竞争）
+    alignas(64) std::atomic<size_t> head_{0}; // 下一个读取位置（消费者写）
+};
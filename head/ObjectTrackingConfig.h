@@ -21,6 +21,67 @@ struct ObjectTrackingConfig
     int videoHeight = 1080; // 视频高度（像素）
     int processingFps = 25; // 处理帧率（fps）
 
+    // ========== 检测后端配置 ==========
+    struct DetectorConfig
+    {
+        std::string backend = "tensorrt";                // 检测后端：tensorrt（GPU）或 opencv_dnn（CPU）
+        std::string onnxPath = "./models/20250928.onnx"; // opencv_dnn 后端使用的ONNX模型
+        int inputSize = 1280;                            // opencv_dnn 后端的网络输入尺寸
+    } detector;
+
+    // ========== 推理批处理调度配置 ==========
+    struct InferenceSchedulerConfig
+    {
+        bool enable = false;        // 两路可见光帧合并为批次推理（仅 opencv_dnn 后端有收益）
+        int maxBatch = 2;           // 单批最多帧数
+        float maxWaitMs = 5.0f;     // 最早提交的帧最长等待时间（毫秒）
+        int benchmarkFrames = 0;    // >0: 启动时按批大小×等待时限组合测量吞吐量和延迟（每路帧数）
+        int benchmarkProducers = 2; // 测量时并发提交的视频路数
+    } scheduler;
+
+    // ========== 自适应检测间隔配置 ==========
+    struct DetectionCadenceConfig
+    {
+        bool enable = false;             // 按目标数、运动和车速调整检测间隔，间隔帧用卡尔曼预测位置
+        int maxInterval = 4;             // 两次检测之间最多间隔的帧数（1=每帧检测）
+        float maxPredictPx = 12.0f;      // 两次检测之间预测位置允许累积的最大位移（像素）
+        int minTrackHits = 3;            // 新目标至少连续检测到的次数，之前每帧检测（速度尚未收敛）
+        float stationarySpeedKmh = 2.0f; // GYK实速低于该值视为停车，不因车速缩短间隔
+        float fullRateSpeedKmh = 80.0f;  // GYK实速达到该值时每帧检测
+        std::string evaluationVideo;     // 非空时启动时在该录像上对比每帧检测与自适应间隔的计数结果
+    } cadence;
+
+    // ========== 推理区域配置 ==========
+    struct InferenceRoiConfig
+    {
+        bool enable = false;         // 只对计数线附近的区域做检测（结果映射回整帧坐标）
+        std::string mode = "band";   // band：计数线上下的固定水平带；tracks：水平带并入活动目标的外接矩形
+        int bandHalfHeight = 160;    // 计数线上下各保留的高度（像素）
+        int trackMargin = 48;        // tracks 模式下跟踪框外扩的像素
+        int strips = 2;              // 区域沿水平方向切成几段后纵向拼接送入网络（提高宽区域的有效分辨率，1=直接裁剪）
+        int stripOverlap = 128;      // 相邻两段重叠的宽度（像素），应不小于目标宽度
+        int fullFrameInterval = 0;   // >0: 每隔该次数检测做一次整帧检测
+        std::string evaluationVideo; // 非空时启动时在该录像上对比整帧检测与区域检测的耗时、区域内检测数与越线计数
+    } inferenceRoi;
+
+    // ========== 追踪核心配置 ==========
+    struct TrackerCoreConfig
+    {
+        std::string backend = "bytetrack"; // 追踪核心：bytetrack（预编译BYTETracker）或 flat（结构数组轨迹表，与ByteTrack结果一致）
+        int capacity = 1024;               // flat 核心的轨迹表容量
+        std::string recordTrace;           // 非空时把设备1每次追踪更新的检测写入该文件（检测序列）
+        std::string parityTrace;           // 非空时启动时在该检测序列上对比 flat 核心与 BYTETracker 的跟踪ID
+        int benchmarkFrames = 0;           // >0: 启动时在10/100/500个目标的合成场景上对比两种核心的每帧耗时
+    } trackerCore;
+
+    // ========== 计数状态配置 ==========
+    struct CountingStateConfig
+    {
+        int trackCapacity = 1024;  // 每路计数状态表槽位数（最多使用3/4，超出时淘汰最久未出现的目标）
+        int recordCapacity = 1024; // 每路内存中保留的最近计数记录条数（完整记录在计数文件中）
+        double soakHours = 0.0;    // >0: 启动时模拟该时长的连续计数，按小时输出状态表与记录缓冲占用
+    } countingState;
+
     // ========== 显示配置 ==========
     bool enableDisplay = false;                 // 是否启用实时显示窗口
     std::string windowName = "Object Tracking"; // 显示窗口名称
@@ -28,7 +89,7 @@ struct ObjectTrackingConfig
     int windowHeight = 600;                     // 显示窗口高度
 
     // ========== 性能优化配置 ==========
-    int threadSleepMs = 10;              // 线程休眠时间（毫秒，控制CPU使用率）
+    int threadSleepMs = 10;              // 等待新帧与阶段队列的超时时间（毫秒，超时后检查停止标志）
     bool enablePerformanceStats = false; // 是否启用性能统计显示
 
     // ========== 定位上报配置 ==========
@@ -79,6 +140,73 @@ struct ObjectTrackingConfig
                 processingFps = video.value("processing_fps", processingFps);
             }
 
+            // 加载检测后端配置
+            if (tracking.contains("detector"))
+            {
+                const auto &det = tracking["detector"];
+                detector.backend = det.value("backend", detector.backend);
+                detector.onnxPath = det.value("onnx_path", detector.onnxPath);
+                detector.inputSize = det.value("input_size", detector.inputSize);
+            }
+
+            // 加载推理批处理调度配置
+            if (tracking.contains("inference_scheduler"))
+            {
+                const auto &sched = tracking["inference_scheduler"];
+                scheduler.enable = sched.value("enable", scheduler.enable);
+                scheduler.maxBatch = sched.value("max_batch", scheduler.maxBatch);
+                scheduler.maxWaitMs = sched.value("max_wait_ms", scheduler.maxWaitMs);
+                scheduler.benchmarkFrames = sched.value("benchmark_frames", scheduler.benchmarkFrames);
+                scheduler.benchmarkProducers = sched.value("benchmark_producers", scheduler.benchmarkProducers);
+            }
+
+            // 加载自适应检测间隔配置
+            if (tracking.contains("detection_cadence"))
+            {
+                const auto &cad = tracking["detection_cadence"];
+                cadence.enable = cad.value("enable", cadence.enable);
+                cadence.maxInterval = cad.value("max_interval", cadence.maxInterval);
+                cadence.maxPredictPx = cad.value("max_predict_px", cadence.maxPredictPx);
+                cadence.minTrackHits = cad.value("min_track_hits", cadence.minTrackHits);
+                cadence.stationarySpeedKmh = cad.value("stationary_speed_kmh", cadence.stationarySpeedKmh);
+                cadence.fullRateSpeedKmh = cad.value("full_rate_speed_kmh", cadence.fullRateSpeedKmh);
+                cadence.evaluationVideo = cad.value("evaluation_video", cadence.evaluationVideo);
+            }
+
+            // 加载推理区域配置
+            if (tracking.contains("inference_roi"))
+            {
+                const auto &roi = tracking["inference_roi"];
+                inferenceRoi.enable = roi.value("enable", inferenceRoi.enable);
+                inferenceRoi.mode = roi.value("mode", inferenceRoi.mode);
+                inferenceRoi.bandHalfHeight = roi.value("band_half_height", inferenceRoi.bandHalfHeight);
+                inferenceRoi.trackMargin = roi.value("track_margin", inferenceRoi.trackMargin);
+                inferenceRoi.strips = roi.value("strips", inferenceRoi.strips);
+                inferenceRoi.stripOverlap = roi.value("strip_overlap", inferenceRoi.stripOverlap);
+                inferenceRoi.fullFrameInterval = roi.value("full_frame_interval", inferenceRoi.fullFrameInterval);
+                inferenceRoi.evaluationVideo = roi.value("evaluation_video", inferenceRoi.evaluationVideo);
+            }
+
+            // 加载追踪核心配置
+            if (tracking.contains("tracker_core"))
+            {
+                const auto &core = tracking["tracker_core"];
+                trackerCore.backend = core.value("backend", trackerCore.backend);
+                trackerCore.capacity = core.value("capacity", trackerCore.capacity);
+                trackerCore.recordTrace = core.value("record_trace", trackerCore.recordTrace);
+                trackerCore.parityTrace = core.value("parity_trace", trackerCore.parityTrace);
+                trackerCore.benchmarkFrames = core.value("benchmark_frames", trackerCore.benchmarkFrames);
+            }
+
+            // 加载计数状态配置
+            if (tracking.contains("counting_state"))
+            {
+                const auto &counting = tracking["counting_state"];
+                countingState.trackCapacity = counting.value("track_capacity", countingState.trackCapacity);
+                countingState.recordCapacity = counting.value("record_capacity", countingState.recordCapacity);
+                countingState.soakHours = counting.value("soak_hours", countingState.soakHours);
+            }
+
             // 加载显示配置
             if (tracking.contains("display"))
             {
@@ -146,12 +274,52 @@ struct ObjectTrackingConfig
             return false;
         }
 
+        if (detector.backend != "tensorrt" && detector.backend != "opencv_dnn")
+        {
+            std::cerr << "[ObjectTrackingConfig] 检测后端无效: " << detector.backend << std::endl;
+            return false;
+        }
+
         if (processingFps <= 0)
         {
             std::cerr << "[ObjectTrackingConfig] 处理帧率无效: " << processingFps << std::endl;
             return false;
         }
 
+        if (cadence.maxInterval < 1 || cadence.fullRateSpeedKmh <= cadence.stationarySpeedKmh)
+        {
+            std::cerr << "[ObjectTrackingConfig] 自适应检测间隔参数无效: 最大间隔 " << cadence.maxInterval
+                      << ", 车速范围 " << cadence.stationarySpeedKmh << "~" << cadence.fullRateSpeedKmh << " km/h" << std::endl;
+            return false;
+        }
+
+        if ((inferenceRoi.mode != "band" && inferenceRoi.mode != "tracks") || inferenceRoi.bandHalfHeight <= 0 ||
+            inferenceRoi.strips < 1 || inferenceRoi.stripOverlap < 0)
+        {
+            std::cerr << "[ObjectTrackingConfig] 推理区域配置无效: " << inferenceRoi.mode << ", 半高 " << inferenceRoi.bandHalfHeight
+                      << ", " << inferenceRoi.strips << " 段, 重叠 " << inferenceRoi.stripOverlap << std::endl;
+            return false;
+        }
+
+        if ((trackerCore.backend != "flat" && trackerCore.backend != "bytetrack") || trackerCore.capacity <= 0)
+        {
+            std::cerr << "[ObjectTrackingConfig] 追踪核心配置无效: " << trackerCore.backend << ", 容量 " << trackerCore.capacity << std::endl;
+            return false;
+        }
+
+        if (countingState.trackCapacity <= 0 || countingState.recordCapacity <= 0)
+        {
+            std::cerr << "[ObjectTrackingConfig] 计数状态容量无效: " << countingState.trackCapacity
+                      << ", " << countingState.recordCapacity << std::endl;
+            return false;
+        }
+
+        if (threadSleepMs <= 0)
+        {
+            std::cerr << "[ObjectTrackingConfig] 等待超时时间无效: " << threadSleepMs << std::endl;
+            return false;
+        }
+
         return true;
     }
 
@@ -173,6 +341,14 @@ struct ObjectTrackingConfig
             std::cout << "追踪类别: " << configManager->getTrackClass() << "\n";
             std::cout << "启用计数: " << (configManager->isCountingEnabled() ? "是" : "否") << "\n";
         }
+        std::cout << "检测后端: " << detector.backend << "\n";
+        std::cout << "批处理调度: " << (scheduler.enable ? "是" : "否") << " (最大批 " << scheduler.maxBatch
+                  << ", 等待 " << scheduler.maxWaitMs << " ms)\n";
+        std::cout << "自适应检测间隔: " << (cadence.enable ? "是" : "否") << " (最大间隔 " << cadence.maxInterval
+                  << " 帧, 最大预测位移 " << cadence.maxPredictPx << " px)\n";
+        std::cout << "推理区域: " << (inferenceRoi.enable ? inferenceRoi.mode : std::string("整帧")) << "\n";
+        std::cout << "追踪核心: " << trackerCore.backend << "\n";
+        std::cout << "计数状态容量: " << countingState.trackCapacity << " 个目标, " << countingState.recordCapacity << " 条记录\n";
         std::cout << "视频尺寸: " << videoWidth << "x" << videoHeight << "\n";
         std::cout << "处理帧率: " << processingFps << " fps\n";
         std::cout << "启用显示: " << (enableDisplay ? "是" : "否") << "\n";
@@ -0,0 +1,82 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "IDetector.h"
+
+/**
+ * @brief CPU检测后端（OpenCV DNN 运行 YOLOv8 ONNX 模型）
+ *
+ * 与 TensorRT 后端保持相同的输入输出约定：
+ * - 预处理：等比例缩放后居中填充到 inputSize×inputSize（letterbox），BGR→RGB，HWC→CHW，归一化到[0,1]；
+ *   BGR交织数据拆分为三个浮点平面时使用OpenCV通用SIMD指令（不可用时退回标量循环）
+ * - 输出：[1, 4+类别数, 候选数]（也兼容转置后的 [1, 候选数, 4+类别数]）
+ * - 解码：每个候选取最高类别得分，超过置信度阈值后转换为 x1y1x2y2，最多保留 kMaxCandidates 个
+ * - NMS：同类别按置信度降序贪心抑制，坐标映射回原图（与 scale_bbox 相同的公式）
+ * detectBatch 把多张图的letterbox结果写入同一个 N×3×H×W 输入，一次前向完成（要求ONNX导出为动态批次）
+ */
+class OpenCvDnnDetector : public IDetector
+{
+public:
+    static constexpr int kMaxCandidates = 1000; // 与 kMaxNumOutputBbox 一致
+
+    struct Params
+    {
+        std::string modelPath;    // ONNX模型路径
+        int inputSize = 1280;     // 网络输入尺寸（与 kInputW/kInputH 一致）
+        float confThresh = 0.25f; // 置信度阈值
+        float nmsThresh = 0.45f;  // NMS IoU阈值
+        int numClass = 1;         // 类别数量
+    };
+
+    /**
+     * @brief 构造函数，加载ONNX模型并设置为CPU推理
+     * @throws std::runtime_error 模型加载失败
+     */
+    explicit OpenCvDnnDetector(const Params &params);
+
+    std::vector<Detection> detect(cv::Mat &img) override;
+    std::vector<std::vector<Detection>> detectBatch(const std::vector<cv::Mat *> &images) override;
+    const char *name() const override { return "opencv_dnn"; }
+
+private:
+    // 单张图的letterbox参数
+    struct Letterbox
+    {
+        float scale = 1.0f;
+        float padX = 0.0f;
+        float padY = 0.0f;
+    };
+
+    /**
+     * @brief 按批大小分配网络输入（N×3×H×W 浮点）
+     */
+    void allocateBlob(int batch);
+
+    /**
+     * @brief letterbox预处理，结果写入 dst 开始的3个浮点平面
+     */
+    Letterbox letterbox(const cv::Mat &img, float *dst);
+
+    /**
+     * @brief 解码一张图的网络输出并做NMS，坐标映射回原图
+     * @param data 该图的输出起始地址
+     * @param dim1 输出第2维（通道数或候选数）
+     * @param dim2 输出第3维（候选数或通道数）
+     */
+    void decode(const float *data, int dim1, int dim2, const Letterbox &box, std::vector<Detection> &detections);
+
+    static float iou(const Detection &a, const Detection &b);
+
+    Params params_;
+    cv::dnn::Net net_;
+
+    // 复用的中间缓冲区
+    cv::Mat canvas_;        // letterbox画布（inputSize×inputSize，CV_8UC3）
+    cv::Size canvasSource_; // 画布填充区域对应的输入尺寸
+    cv::Mat blob_;          // 网络输入（N×3×H×W，CV_32F）
+    int blobBatch_ = 0;     // blob_ 当前的批大小
+    std::vector<Detection> candidates_;
+    std::vector<int> order_;
+    std::vector<uint8_t> suppressed_;
+};
@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 热成像调色板阈值标定器（每个设备一个实例）
+ *
+ * 对画面右侧温度条区域维护256级灰度直方图，每K帧采样一次并以指数平滑方式并入直方图，
+ * 百分位数通过累计直方图在O(256)内求得，不再排序像素。
+ * 相机AGC温度范围（实时最低/最高温度）变化时立即重新采样，旧直方图直接丢弃。
+ * 修改百分位数只需在现有直方图上重新查找，下一帧即生效。
+ */
+class PaletteCalibrator
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param paletteRoi 温度条区域（默认：左上角(1242,101)，宽35像素，高517像素）
+     * @param sampleInterval 采样间隔（帧数）
+     */
+    explicit PaletteCalibrator(const cv::Rect &paletteRoi = cv::Rect(1242, 101, 35, 517), int sampleInterval = 25);
+
+    /**
+     * @brief 设置百分位数，仅在现有直方图上重新计算阈值
+     * @param percentile 百分位数值 (0.0-1.0)
+     */
+    void setPercentile(float percentile);
+
+    /**
+     * @brief 设置采样间隔
+     * @param frames 每隔多少帧采样一次温度条（>=1）
+     */
+    void setSampleInterval(int frames);
+
+    /**
+     * @brief 每帧调用：到达采样间隔或AGC温度范围变化时采样温度条并更新阈值
+     * @param frame 热成像视频帧
+     * @param minTemp 当前实时最低温度
+     * @param maxTemp 当前实时最高温度
+     * @return 是否已有有效阈值
+     */
+    bool update(const cv::Mat &frame, float minTemp, float maxTemp);
+
+    /**
+     * @brief 强制下一帧重新采样（丢弃历史直方图）
+     */
+    void reset();
+
+    bool isCalibrated() const { return calibrated_; }
+
+    /**
+     * @brief 当前高温阈值灰度值
+     */
+    float threshold() const { return threshold_; }
+
+    /**
+     * @brief 在当前直方图上计算指定百分位数对应的灰度值（O(256)）
+     * @param percentile 百分位数 (0.0-1.0)
+     */
+    float percentileValue(float percentile) const;
+
+private:
+    /**
+     * @brief 采样温度条区域的灰度直方图
+     * @param frame 热成像视频帧
+     * @param replace 是否替换历史直方图（否则按平滑系数并入）
+     * @return 是否采样成功
+     */
+    bool sample(const cv::Mat &frame, bool replace);
+
+    /**
+     * @brief 累计权重达到rank时所在的灰度级
+     */
+    int valueAtRank(float rank) const;
+
+    static constexpr float kBlendFactor = 0.25f;  // 新采样直方图的平滑权重
+    static constexpr float kAgcTolerance = 0.5f;  // AGC温度范围变化判定阈值（°C）
+
+    cv::Rect roi_;             // 温度条区域
+    int sampleInterval_;       // 采样间隔（帧）
+    int framesSinceSample_;    // 距离上次采样的帧数
+    float histogram_[256];     // 平滑后的灰度直方图
+    float total_;              // 直方图总权重
+    float percentile_;         // 当前百分位数
+    float threshold_;          // 当前阈值灰度值
+    bool calibrated_;          // 是否已有有效直方图
+    bool hasRange_;            // 是否记录过AGC温度范围
+    float lastMinTemp_;        // 上次采样时的最低温度
+    float lastMaxTemp_;        // 上次采样时的最高温度
+    cv::Mat grayRoi_;          // 温度条灰度图（复用缓冲区）
+};
@@ -0,0 +1,74 @@
+﻿#pragma once
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include "YuvOverlayRenderer.h"
+
+/**
+ * @brief 四分屏合成器
+ *
+ * 将 T1 / V1 / T2 / V2 四路最新帧拼接为一个2×2画面，直接写入常驻的I420画布，
+ * 供推流器编码为第五路流。画布跨帧复用，只有帧序号变化的分块才会重新缩放和转换，
+ * 没有新帧的分块保留上一次的内容。
+ * 传入标注数据时，标注在分块转换为I420之后直接画到分块的YUV平面上（见 YuvOverlayRenderer）。
+ *
+ * 分块布局：
+ *   [0] T1 | [1] V1
+ *   [2] T2 | [3] V2
+ */
+class QuadCompositor
+{
+public:
+    static constexpr int kTileCount = 4;
+
+    /**
+     * @brief 构造函数
+     * @param width 画布宽度（向下取整到4的倍数，保证每个分块的色度平面尺寸为整数）
+     * @param height 画布高度（向下取整到4的倍数）
+     */
+    QuadCompositor(int width, int height);
+
+    /**
+     * @brief 更新一个分块
+     * @param tileIndex 分块索引（0~3）
+     * @param bgr 该路最新的BGR帧
+     * @param seq 该帧的序号，与上次绘制的序号相同时跳过
+     * @param overlay 该帧的标注数据（为空时不绘制）
+     * @param layers 绘制的图层
+     * @param scaleX 标注坐标到 bgr 坐标的横向缩放比例
+     * @param scaleY 标注坐标到 bgr 坐标的纵向缩放比例
+     * @return 是否重新绘制了该分块
+     */
+    bool updateTile(int tileIndex, const cv::Mat &bgr, uint64_t seq, const FrameOverlay *overlay = nullptr,
+                    uint32_t layers = kOverlayNone, double scaleX = 1.0, double scaleY = 1.0);
+
+    /**
+     * @brief 获取I420画布（连续内存，height*3/2 行 × width 列，CV_8UC1）
+     */
+    const cv::Mat &canvas() const { return canvas_; }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    /**
+     * @brief 获取自上次调用以来被重新绘制的分块数量，并清零
+     */
+    int takeDirtyTileCount();
+
+private:
+    /**
+     * @brief 将分块缓冲区中的I420数据逐行拷贝到画布对应位置
+     */
+    void blitTile(int tileIndex);
+
+    int width_;
+    int height_;
+    int tileWidth_;
+    int tileHeight_;
+
+    cv::Mat canvas_;    // 常驻I420画布
+    cv::Mat tileBgr_;   // 分块缩放缓冲区（复用）
+    cv::Mat tileI420_;  // 分块I420缓冲区（复用）
+    YuvOverlayRenderer overlay_{YuvOverlayRenderer::kBt601Limited}; // 分块标注绘制（与 cvtColor 相同的系数）
+    uint64_t lastSeq_[kTileCount] = {0, 0, 0, 0}; // 每个分块上次绘制的帧序号
+    int dirtyTiles_ = 0;
+};
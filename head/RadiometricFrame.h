@@ -0,0 +1,132 @@
+﻿#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 一帧辐射测温数据（每像素真实温度，摄氏度）
+ * 温度矩阵来自固定容量的缓冲池，最后一个持有者释放后自动归还，发布后不再修改
+ */
+struct RadiometricFrame
+{
+    uint64_t seq = 0;          // 辐射测温帧序号（按设备递增）
+    int64_t captureTimeUs = 0; // 采集完成时间（steadyClockUs）
+    cv::Size sourceSize;       // 相机原始测温分辨率
+    cv::Mat temperature;       // 温度矩阵（640x512，CV_32FC1，摄氏度）
+    float minTemp = 0.0f;      // 全帧最低温度
+    float maxTemp = 0.0f;      // 全帧最高温度
+};
+using RadiometricFramePtr = std::shared_ptr<const RadiometricFrame>;
+
+/**
+ * @brief 辐射测温帧缓冲池
+ * 预先分配固定数量的温度矩阵，acquire() 返回的帧在最后一个持有者释放时归还池中，
+ * 稳定运行时不再分配内存。池耗尽（下游持有过多帧）时返回空，由调用方丢弃该帧。
+ */
+class RadiometricFramePool
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param size 温度矩阵尺寸
+     * @param capacity 缓冲帧数量
+     */
+    RadiometricFramePool(const cv::Size &size, int capacity);
+
+    /**
+     * @brief 取出一个空闲帧，池耗尽时返回空
+     */
+    std::shared_ptr<RadiometricFrame> acquire();
+
+    const cv::Size &size() const { return state_->size; }
+
+private:
+    struct State
+    {
+        cv::Size size;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<RadiometricFrame>> freeFrames;
+    };
+    std::shared_ptr<State> state_; // 由已借出的帧共同持有，池先于帧销毁时仍然有效
+};
+
+/**
+ * @brief 辐射测温数据解析器（纯数据处理，不依赖SDK，可直接用录制文件验证）
+ *
+ * 支持的负载格式：
+ * - Float32：每像素4字节小端浮点，摄氏度（NET_DVR_CaptureJPEGPicture_WithAppendData 的全屏测温数据）
+ * - Raw16：每像素2字节无符号整数，温度 = 值 × raw16Scale + raw16Offset
+ *
+ * 录制文件为 32 字节文件头（"HRAD"、版本、宽、高、每像素字节数、数据长度、采集时间）+ 原始负载；
+ * 不带文件头的原始负载按长度推断常见测温分辨率（640x512 / 384x288 / 256x192 / 160x120）。
+ */
+class RadiometricParser
+{
+public:
+    struct Options
+    {
+        float raw16Scale = 0.1f;      // Raw16 比例系数
+        float raw16Offset = -273.15f; // Raw16 偏移（默认 0.1K 单位转摄氏度）
+        float minValid = -40.0f;      // 有效温度下限，超出范围的像素钳位
+        float maxValid = 2000.0f;     // 有效温度上限
+    };
+
+    /**
+     * @brief 录制文件头
+     */
+    struct RecordingHeader
+    {
+        char magic[4] = {'H', 'R', 'A', 'D'};
+        uint32_t version = 1;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t bytesPerPixel = 4;
+        uint32_t dataLength = 0;
+        int64_t captureTimeUs = 0;
+    };
+
+    RadiometricParser() = default;
+    explicit RadiometricParser(const Options &options) : options_(options) {}
+
+    void setOptions(const Options &options) { options_ = options; }
+
+    /**
+     * @brief 将一帧测温负载解析到温度矩阵（尺寸与目标帧相同时直接写入，不同时双线性缩放）
+     * @param data 负载数据
+     * @param length 负载长度
+     * @param width 负载宽度
+     * @param height 负载高度
+     * @param frame 目标帧（temperature 已按池尺寸分配），同时填写 sourceSize / minTemp / maxTemp
+     * @return 长度与尺寸不匹配或数据无效时返回false
+     */
+    bool parse(const uint8_t *data, size_t length, int width, int height, RadiometricFrame &frame);
+
+    /**
+     * @brief 按负载长度推断测温分辨率
+     * @return 是否为已知分辨率
+     */
+    static bool inferDimensions(size_t length, int &width, int &height);
+
+    /**
+     * @brief 读取录制文件（带文件头或原始负载）
+     * @param path 文件路径
+     * @param payload 输出负载
+     * @param width 输出宽度
+     * @param height 输出高度
+     * @return 是否读取成功
+     */
+    static bool readRecording(const std::string &path, std::vector<uint8_t> &payload, int &width, int &height);
+
+    /**
+     * @brief 将一帧负载写入录制文件（带文件头）
+     */
+    static bool writeRecording(const std::string &path, const uint8_t *data, size_t length, int width, int height,
+                               int64_t captureTimeUs);
+
+private:
+    Options options_;
+    cv::Mat scratch_; // Raw16 转换及缩放前的中间缓冲区（复用）
+};
@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SharedData.h"
+#include "HCNetSDK.h"
+#include "RadiometricFrame.h"
+
+/**
+ * @brief 辐射测温数据采集（每个设备一个线程）
+ *
+ * 按配置的帧率获取相机的全屏测温数据，解析为池化的 640x512 浮点温度矩阵后发布到
+ * SharedData::radiometricFrame_1/2，热成像线程据此按真实温度（摄氏度）生成高温掩码。
+ * 数据来源为 NET_DVR_CaptureJPEGPicture_WithAppendData（热成像JPEG + 附加测温数据），可选录制负载，
+ * 录制文件可用 utils/RadiometricCheck 离线解析验证。
+ */
+class RadiometricIngest
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param deviceIdx 设备索引（0或1）
+     * @param userID 海康设备用户ID
+     * @param data 共享数据引用
+     * @param config 辐射测温采集配置
+     */
+    RadiometricIngest(int deviceIdx, LONG userID, SharedData &data, const RadiometricIngestConfig &config);
+    ~RadiometricIngest();
+
+    /**
+     * @brief 启动采集线程
+     * @return 是否启动成功
+     */
+    bool start();
+
+    /**
+     * @brief 停止采集线程
+     */
+    void stop();
+
+private:
+    void run();
+
+    /**
+     * @brief 通过SDK抓取一帧测温负载
+     * @return 是否成功，成功时 payload 指向内部缓冲区
+     */
+    bool captureFromSdk(const uint8_t *&payload, size_t &length, int &width, int &height);
+
+    /**
+     * @brief 按配置录制一帧负载
+     */
+    void recordPayload(const uint8_t *payload, size_t length, int width, int height, int64_t captureTimeUs);
+
+    int deviceIdx_;
+    LONG userID_;
+    SharedData &data_;
+    RadiometricIngestConfig config_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    RadiometricFramePool pool_;
+    RadiometricParser parser_;
+
+    // SDK抓图缓冲区（由调用方分配，SDK写入）
+    std::vector<char> jpegBuffer_;
+    std::vector<char> p2pBuffer_;
+    std::vector<char> visibleBuffer_;
+
+    // 统计
+    uint64_t seq_ = 0;
+    uint64_t droppedFrames_ = 0;  // 缓冲池耗尽丢弃的帧数
+    uint64_t failedCaptures_ = 0; // 抓取或解析失败次数
+    int recordedFrames_ = 0;      // 已录制的负载数量
+};
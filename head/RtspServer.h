@@ -0,0 +1,202 @@
+﻿#pragma once
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+
+/**
+ * @brief 一个访问单元（AU）打包后的全部RTP包
+ * 由推流线程打包一次，通过shared_ptr在所有订阅客户端之间共享，发送时不再复制负载
+ */
+struct RtpPacketGroup
+{
+    std::vector<uint8_t> buffer;                    // 所有RTP包连续存储（每包含12字节RTP头）
+    std::vector<std::pair<size_t, size_t>> packets; // 每个RTP包在buffer中的偏移和长度
+    uint32_t rtpTimestamp = 0;                      // 90kHz RTP时间戳
+    bool keyFrame = false;                          // 是否为IDR帧（新订阅者从关键帧开始发送）
+};
+using RtpPacketGroupPtr = std::shared_ptr<const RtpPacketGroup>;
+
+class RtspServer;
+class RtspClientSession;
+
+/**
+ * @brief 内嵌RTSP服务器中的一路媒体流（如 thermal1 / visible1）
+ * 保存SPS/PPS、RTP序列号状态和订阅该路径的客户端列表
+ */
+struct RtspMediaStream
+{
+    std::string path;           // 流路径（不含前导'/'）
+    std::vector<uint8_t> sps;   // H.264 SPS（不含起始码）
+    std::vector<uint8_t> pps;   // H.264 PPS（不含起始码）
+    uint32_t ssrc = 0;          // RTP SSRC
+    uint16_t nextSeq = 0;       // 下一个RTP序列号
+    uint32_t lastTimestamp = 0; // 最近一个AU的RTP时间戳（用于PLAY响应的RTP-Info）
+
+    std::mutex mutex;                                         // 保护以上状态与订阅者列表
+    std::vector<std::shared_ptr<RtspClientSession>> subscribers; // 处于PLAY状态的客户端
+};
+
+/**
+ * @brief 单个RTSP客户端连接
+ * 每个连接一个接收线程（解析RTSP请求）和一个发送线程（从发送窗口取RTP包发送）
+ * 发送窗口有上限，客户端消费过慢时丢弃到下一个关键帧，不阻塞推流线程
+ */
+class RtspClientSession : public std::enable_shared_from_this<RtspClientSession>
+{
+public:
+    RtspClientSession(RtspServer &server, SOCKET socket, const sockaddr_in &addr, size_t sendWindow);
+    ~RtspClientSession();
+
+    void start();
+    void close();
+    bool isClosed() const { return closed_; }
+
+    /**
+     * @brief 等待接收与发送线程退出（先调用close）
+     * 会话线程不持有自身的shared_ptr，最后一个引用只会在服务器或推流线程中释放，不会在会话自己的线程中析构
+     */
+    void join();
+
+    /**
+     * @brief 推流线程调用：将一个AU放入该客户端的发送窗口（仅增加引用计数）
+     */
+    void enqueue(const RtpPacketGroupPtr &group);
+
+private:
+    void recvLoop();
+    void sendLoop();
+    bool handleRequest(const std::string &request);
+    bool sendResponse(int code, const std::string &reason, int cseq, const std::string &headers,
+                      const std::string &body = "");
+    bool sendAll(const char *data, size_t len);
+    bool sendInterleaved(uint8_t channel, const uint8_t *data, size_t len);
+
+    RtspServer &server_;
+    SOCKET socket_;
+    sockaddr_in addr_;
+    std::string sessionId_;
+    std::thread recvThread_;
+    std::thread sendThread_;
+    std::atomic<bool> closed_{false};
+    std::mutex socketSendMutex_; // RTSP响应与TCP交织RTP共用同一socket
+
+    // 传输参数
+    bool useTcp_ = true;      // true: RTP/AVP/TCP 交织; false: RTP/AVP UDP
+    uint8_t rtpChannel_ = 0;  // TCP交织RTP通道号
+    sockaddr_in udpDest_{};   // UDP模式下客户端RTP地址
+    std::string streamPath_;  // SETUP/PLAY的流路径
+    bool playing_ = false;
+
+    // 发送窗口
+    std::mutex queueMutex_;
+    std::condition_variable queueCv_;
+    std::deque<RtpPacketGroupPtr> queue_;
+    size_t sendWindow_;          // 发送窗口上限（AU个数）
+    bool waitKeyFrame_ = true;   // 新订阅或发生丢弃后等待关键帧
+    uint64_t droppedGroups_ = 0; // 因窗口溢出丢弃的AU数量
+};
+
+/**
+ * @brief 内嵌RTSP/RTP服务器，替代外部 rtsp-simple-server.exe
+ *
+ * - 推流线程调用 publishPacket() 提交编码后的H.264访问单元，服务器按RFC 6184打包一次，
+ *   然后以共享指针分发给所有订阅客户端（零拷贝扇出）
+ * - 支持 RTP/AVP/TCP 交织传输和 RTP/AVP UDP 单播传输
+ * - 可直接使用 ffprobe / ffplay 作为客户端验证：ffplay -rtsp_transport tcp rtsp://127.0.0.1:8556/visible1
+ */
+class RtspServer
+{
+public:
+    RtspServer();
+    ~RtspServer();
+
+    /**
+     * @brief 启动RTSP服务器
+     * @param port RTSP监听端口（TCP）
+     * @param rtpPort UDP传输时服务器使用的RTP端口（RTCP为rtpPort+1）
+     * @param sendWindow 每个客户端发送窗口上限（AU个数）
+     * @return 是否启动成功
+     */
+    bool start(uint16_t port, uint16_t rtpPort = 8000, size_t sendWindow = 64);
+
+    /**
+     * @brief 停止服务器，关闭所有客户端连接
+     */
+    void stop();
+
+    /**
+     * @brief 设置流参数（从编码器extradata中提取SPS/PPS），流不存在时自动创建
+     * @param path 流路径，如 "visible1"
+     * @param extradata 编码器extradata（Annex B 或 avcC 格式）
+     * @param size extradata长度
+     */
+    void setStreamParameters(const std::string &path, const uint8_t *extradata, int size);
+
+    /**
+     * @brief 发布一个编码后的访问单元（Annex B格式）
+     * @param path 流路径
+     * @param data 编码数据
+     * @param size 数据长度
+     * @param pts90k 90kHz时钟下的显示时间戳
+     * @param keyFrame 是否为关键帧
+     */
+    void publishPacket(const std::string &path, const uint8_t *data, int size, int64_t pts90k, bool keyFrame);
+
+    /**
+     * @brief 获取某路流当前的订阅客户端数量
+     */
+    size_t getSubscriberCount(const std::string &path);
+
+    /**
+     * @brief 从RTSP URL中提取流路径，如 rtsp://127.0.0.1:8556/visible1 -> visible1
+     */
+    static std::string pathFromUrl(const std::string &url);
+
+private:
+    friend class RtspClientSession;
+
+    void acceptLoop();
+    std::shared_ptr<RtspMediaStream> findStream(const std::string &path);
+    std::shared_ptr<RtspMediaStream> getOrCreateStream(const std::string &path);
+    void subscribe(const std::string &path, const std::shared_ptr<RtspClientSession> &session);
+    void unsubscribe(const RtspClientSession *session);
+    std::string buildSdp(const std::shared_ptr<RtspMediaStream> &stream, const std::string &localIp);
+    void reapClosedSessions();
+
+    // 打包一个AU为RTP包组
+    static void packetizeNal(RtspMediaStream &stream, RtpPacketGroup &group, const uint8_t *nal, size_t len,
+                             bool lastNalOfAu);
+
+    std::atomic<bool> running_{false};
+    uint16_t port_ = 0;
+    uint16_t rtpPort_ = 0;
+    size_t sendWindow_ = 64;
+    SOCKET listenSocket_ = INVALID_SOCKET;
+    SOCKET udpRtpSocket_ = INVALID_SOCKET;  // UDP传输共用的RTP发送socket
+    SOCKET udpRtcpSocket_ = INVALID_SOCKET; // 占用RTCP端口（接收客户端RR，内容忽略）
+    std::thread acceptThread_;
+
+    std::mutex streamsMutex_;
+    std::map<std::string, std::shared_ptr<RtspMediaStream>> streams_;
+
+    std::mutex sessionsMutex_;
+    std::vector<std::shared_ptr<RtspClientSession>> sessions_;
+
+    static constexpr size_t kMaxRtpPayload = 1400; // RTP负载上限，避免IP分片
+};
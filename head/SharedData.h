@@ -1,13 +1,28 @@
 ﻿#pragma once
 #include <opencv2/opencv.hpp>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <string>
+#include <map>
+#include <array>
+#include <deque>
+#include <vector>
+#include <chrono>
 #include <filesystem>
 
 // 海康威视SDK头文件，提供BYTE、DWORD等类型定义
 #include "HCNetSDK.h"
 
+// 按位打包的热成像高温掩码与高温区域分析结果
+#include "ThermalBitMask.h"
+#include "ThermalAnalyzer.h"
+#include "ThermalVisibleFusion.h"
+#include "RadiometricFrame.h"
+#include "EventJournal.h"
+#include "FrameOverlay.h"
+#include "FrameBus.h"
+
 // ========== 实时温度数据结构 ==========
 /**
  * @brief 实时温度数据结构
@@ -77,15 +92,282 @@ struct ThermalProcessingConfig
 {
     bool enableThermalProcessing = true;    // Whether to enable thermal processing
     float environmentTempThreshold = 50.0f; // Minimum environment temperature to start processing
+    int matrixBenchmarkIterations = 0;      // >0: compare legacy and single-pass matrix generation once at startup
+    int persistenceFrames = 2;              // N: frames within the window a pixel must be hot to be reported
+    int persistenceWindow = 3;              // M: temporal persistence window length in frames (1 disables filtering)
+    int paletteSampleInterval = 25;         // K: resample the temperature-bar histogram every K frames (AGC changes resample at once)
+    std::string blobExtraction = "runlength"; // Hot blob extraction: "runlength" (packed-mask CCL) or "contours" (findContours)
+    float hotSpotGateDistance = 50.0f;      // Hot spot tracker: centroid association gate in matrix pixels
+    int hotSpotMaxAgeMs = 2000;             // Hot spot tracker: drop a track after this long without a match
+    int hotSpotMinHits = 1;                 // Hot spot tracker: matched frames before a track raises its single event
+    bool tileChangeDetection = true;        // Recompute the hot mask only for 32x32 tiles whose sampled luma changed
+    float tileChangeThreshold = 6.0f;       // Mean absolute luma difference (gray levels) for a tile to count as changed
+    int tileFullRefreshFrames = 250;        // Force a full-frame mask refresh every N frames (<=0 never)
 
     // Reset to default values
     void reset()
     {
         enableThermalProcessing = true;
         environmentTempThreshold = 50.0f;
+        matrixBenchmarkIterations = 0;
+        persistenceFrames = 2;
+        persistenceWindow = 3;
+        paletteSampleInterval = 25;
+        blobExtraction = "runlength";
+        hotSpotGateDistance = 50.0f;
+        hotSpotMaxAgeMs = 2000;
+        hotSpotMinHits = 1;
+        tileChangeDetection = true;
+        tileChangeThreshold = 6.0f;
+        tileFullRefreshFrames = 250;
+    }
+};
+
+// ========== Radiometric Ingest Configuration Structure ==========
+/**
+ * @brief Radiometric ingest configuration structure
+ * Per-pixel temperatures from the camera replace the palette analysis of the colourised video frame
+ */
+struct RadiometricIngestConfig
+{
+    bool enable = false;                      // Whether to build hot masks from radiometric data (real degrees)
+    int channel = 2;                          // Thermal channel number for SDK capture
+    float fps = 5.0f;                         // Capture rate per device
+    int poolSize = 4;                         // Pooled 640x512 float matrices per device
+    std::string recordDir;                    // Save raw payloads here for offline checks, empty disables
+    int recordFrames = 0;                     // Payloads to save per device
+    float raw16Scale = 0.1f;                  // 16-bit payloads: temperature = value * scale + offset
+    float raw16Offset = -273.15f;             // 16-bit payloads: offset in degrees Celsius
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        channel = 2;
+        fps = 5.0f;
+        poolSize = 4;
+        recordDir.clear();
+        recordFrames = 0;
+        raw16Scale = 0.1f;
+        raw16Offset = -273.15f;
+    }
+};
+
+// ========== Multicast Output Configuration Structure ==========
+/**
+ * @brief Multicast output configuration structure
+ * Each encoded stream is additionally sent once to a multicast group, so adding a viewer costs no server bandwidth
+ */
+struct MulticastOutputConfig
+{
+    bool enable = false;                      // Whether to enable multicast output
+    std::string format = "rtp";               // "rtp" (H.264/RTP), "rtp_mpegts" (MPEG-TS/RTP) or "mpegts" (raw MPEG-TS/UDP)
+    int ttl = 1;                              // Multicast TTL (1 = local subnet only)
+    int pktSize = 1316;                       // UDP payload size (7 TS packets, below typical MTU)
+    std::string localAddress;                 // Local interface address for sending, empty means system default
+    std::string sdpDir = "./sdp";             // Directory for generated SDP files
+    std::map<std::string, std::string> groups; // Stream path -> "group:port", e.g. "thermal1" -> "239.255.10.1:5004"
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        format = "rtp";
+        ttl = 1;
+        pktSize = 1316;
+        localAddress.clear();
+        sdpDir = "./sdp";
+        groups.clear();
+    }
+};
+
+// ========== Quad View Configuration Structure ==========
+/**
+ * @brief Quad view (2x2 composite) stream configuration structure
+ * T1/V1/T2/V2 are tiled into one canvas and encoded once as an extra stream for overview screens
+ */
+struct QuadViewConfig
+{
+    bool enable = false;       // Whether to enable the quad view stream
+    int width = 1280;          // Canvas width (even)
+    int height = 720;          // Canvas height (even)
+    std::string path = "quad"; // RTSP stream path
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        width = 1280;
+        height = 720;
+        path = "quad";
+    }
+};
+
+// ========== Stream Pacing Configuration Structure ==========
+/**
+ * @brief RTSP stream pacing configuration structure
+ * Each output encodes only when a new captured frame arrives, at most at its own fps
+ */
+struct StreamPacingConfig
+{
+    int thermalFps = 0;   // Max encode fps of thermal streams, 0 means use rtsp_streaming.fps
+    int visibleFps = 0;   // Max encode fps of visible streams, 0 means use rtsp_streaming.fps
+    int keepaliveFps = 1; // Repeat the last frame at this fps when a stream is idle, 0 disables keep-alive
+
+    // Reset to default values
+    void reset()
+    {
+        thermalFps = 0;
+        visibleFps = 0;
+        keepaliveFps = 1;
+    }
+};
+
+// ========== ROI Encoding Configuration Structure ==========
+/**
+ * @brief Region-of-interest encoding configuration structure
+ * Track boxes and thermal hot spots get a lower QP, the remaining background a higher one
+ */
+struct RoiEncodingConfig
+{
+    bool enable = false;            // Whether to attach ROI side data to encoded frames
+    float roiQOffset = -0.3f;       // Quantizer offset of target regions, [-1, 1], negative means better quality
+    float backgroundQOffset = 0.2f; // Quantizer offset of the background, [-1, 1], 0 disables background region
+    int marginPx = 16;              // Margin added around each target box (stream pixels)
+    int maxRegions = 32;            // Max number of target regions per frame
+    int statsIntervalSec = 10;      // Bitrate statistics log interval in seconds, 0 disables
+    int crf = 0;                    // >0 switches the encoder to CRF so ROI savings show up as lower bitrate, 0 keeps ABR
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        roiQOffset = -0.3f;
+        backgroundQOffset = 0.2f;
+        marginPx = 16;
+        maxRegions = 32;
+        statsIntervalSec = 10;
+        crf = 0;
+    }
+};
+
+// ========== Thermal-Visible Fusion Configuration Structure ==========
+/**
+ * @brief Thermal-visible fusion configuration structure
+ * Per-device homography maps normalized thermal coordinates to normalized visible coordinates
+ */
+struct ThermalVisibleFusionConfig
+{
+    bool enable = false;          // Whether to fuse visible track boxes with paired thermal frames
+    int maxTimeSkewMs = 80;       // Max capture time difference when pairing a visible frame with a thermal frame
+    float minHotFraction = 0.05f; // Min hot area fraction inside a track box to mark it as thermally confirmed
+    int cellSize = 8;             // Lookup table cell size in visible pixels
+    std::array<std::vector<double>, 2> homography;            // Per device: 9 values row-major, empty means identity
+    std::array<std::vector<cv::Point2f>, 2> thermalPoints;    // Per device calibration points in thermal image (normalized)
+    std::array<std::vector<cv::Point2f>, 2> visiblePoints;    // Per device calibration points in visible image (normalized)
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        maxTimeSkewMs = 80;
+        minHotFraction = 0.05f;
+        cellSize = 8;
+        for (int i = 0; i < 2; i++)
+        {
+            homography[i].clear();
+            thermalPoints[i].clear();
+            visiblePoints[i].clear();
+        }
+    }
+};
+
+// ========== Event Journal Configuration Structure ==========
+/**
+ * @brief Event journal configuration structure
+ * Crossings, thermal detections and report packets are appended to one binary journal by a background thread
+ */
+struct EventJournalConfig
+{
+    bool enable = false;                 // Whether to write the event journal
+    std::string path = "events.journal"; // Journal file path (appended across runs)
+    int queueCapacity = 4096;            // Max events waiting for the writer thread, extra events are dropped
+    int fsyncIntervalMs = 1000;          // Interval between flushes to disk
+    bool logAllPackets = false;          // Journal every report packet, false only packets with a detection flag or a failed send
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        path = "events.journal";
+        queueCapacity = 4096;
+        fsyncIntervalMs = 1000;
+        logAllPackets = false;
+    }
+};
+
+// ========== Overlay Rendering Configuration Structure ==========
+/**
+ * @brief Overlay rendering configuration structure
+ * Processed frames are published without annotations; each output burns in its layers only when it has a viewer
+ */
+struct OverlayRenderConfig
+{
+    bool lazy = true;                     // Skip rendering for embedded-server streams without subscribers
+    uint32_t streamLayers = kOverlayAll;  // Layers burned into the RTSP streams and the quad view
+    uint32_t displayLayers = kOverlayAll; // Layers drawn in the local display windows
+    bool yuvStreams = true;               // Draw stream overlays into the encoder's YUV planes instead of the BGR frame
+
+    // Reset to default values
+    void reset()
+    {
+        lazy = true;
+        streamLayers = kOverlayAll;
+        displayLayers = kOverlayAll;
+        yuvStreams = true;
     }
 };
 
+// ========== Frame Bus Configuration Structure ==========
+/**
+ * @brief Frame bus configuration structure
+ * Processed frames (without overlays) are published to one shared-memory ring per stream for local viewer/analysis processes
+ */
+struct FrameBusConfig
+{
+    bool enable = false;                    // Whether to publish processed frames to shared memory
+    std::string namePrefix = "HikFrameBus"; // Bus names are <prefix>_T1 / _V1 / _T2 / _V2
+    int slots = 4;                          // Slots per ring; a reader's zero-copy view stays valid for slots-1 frames
+
+    // Reset to default values
+    void reset()
+    {
+        enable = false;
+        namePrefix = "HikFrameBus";
+        slots = 4;
+    }
+};
+
+/**
+ * @brief 获取单调时钟的当前时间（微秒），帧采集时间戳与推流PTS使用同一时钟
+ */
+inline int64_t steadyClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief 帧元数据，与对应帧在同一把锁下更新
+ * 处理后帧沿用其原始采集帧的元数据，因此同一采集帧被重复处理时序号不变
+ */
+struct FrameMeta
+{
+    uint64_t seq = 0;          // 采集帧序号（按设备通道递增），0表示尚无数据
+    int64_t captureTimeUs = 0; // 解码回调收到该帧的时间（steadyClockUs）
+};
+
 /**
  * @brief 共享数据结构（简化版）
  * 回退到简单的cv::Mat + std::mutex组合
@@ -119,9 +401,67 @@ struct SharedData
     std::mutex processed_thermal_mutex_2; // 二位端处理后热成像锁
     std::mutex processed_visible_mutex_2; // 二位端处理后可见光锁
 
-    // ========== 温度数据（保持不变）==========
-    cv::Mat thermalMatrix_1;          // 热成像温度矩阵（CV_32FC1单通道浮点）
-    cv::Mat thermalMatrix_2;          // 热成像温度矩阵（CV_32FC1单通道浮点）
+    // ========== 原始帧元数据（由对应的原始帧锁保护）==========
+    FrameMeta thermal_video_meta_1; // 一位端热成像帧元数据
+    FrameMeta visible_video_meta_1; // 一位端可见光帧元数据
+    FrameMeta thermal_video_meta_2; // 二位端热成像帧元数据
+    FrameMeta visible_video_meta_2; // 二位端可见光帧元数据
+
+    // ========== 新可见光帧通知（采集线程每发布一帧可见光原始帧递增版本号并唤醒等待方）==========
+    std::mutex visibleFrameNotifyMutex;     // 保护 visibleFrameVersion
+    std::condition_variable visibleFrameCv; // 新可见光帧条件变量
+    uint64_t visibleFrameVersion = 0;       // 可见光原始帧发布次数
+
+    /**
+     * @brief 发布一帧可见光原始帧后调用，唤醒等待新帧的处理线程
+     */
+    void notifyVisibleFrame()
+    {
+        {
+            std::lock_guard<std::mutex> lock(visibleFrameNotifyMutex);
+            visibleFrameVersion++;
+        }
+        visibleFrameCv.notify_all();
+    }
+
+    // ========== 处理后帧元数据（由对应的processed锁保护）==========
+    FrameMeta processed_thermal_meta_1; // 一位端处理后热成像帧元数据
+    FrameMeta processed_visible_meta_1; // 一位端处理后可见光帧元数据
+    FrameMeta processed_thermal_meta_2; // 二位端处理后热成像帧元数据
+    FrameMeta processed_visible_meta_2; // 二位端处理后可见光帧元数据
+
+    // ========== 处理后帧中的目标区域（处理后帧像素坐标，由对应的processed锁保护）==========
+    std::vector<cv::Rect> processed_thermal_rois_1; // 一位端热成像高温区域外接矩形
+    std::vector<cv::Rect> processed_visible_rois_1; // 一位端可见光跟踪框
+    std::vector<cv::Rect> processed_thermal_rois_2; // 二位端热成像高温区域外接矩形
+    std::vector<cv::Rect> processed_visible_rois_2; // 二位端可见光跟踪框
+
+    // ========== 处理后帧的标注（处理后帧本身不带标注，由对应的processed锁保护）==========
+    FrameOverlayPtr processed_thermal_overlay_1; // 一位端热成像标注数据（高温区域）
+    FrameOverlayPtr processed_visible_overlay_1; // 一位端可见光标注数据（跟踪框、计数线、融合目标）
+    FrameOverlayPtr processed_thermal_overlay_2; // 二位端热成像标注数据
+    FrameOverlayPtr processed_visible_overlay_2; // 二位端可见光标注数据
+    OverlayCache processed_thermal_render_1;     // 一位端热成像标注渲染缓存（各输出共用）
+    OverlayCache processed_visible_render_1;     // 一位端可见光标注渲染缓存
+    OverlayCache processed_thermal_render_2;     // 二位端热成像标注渲染缓存
+    OverlayCache processed_visible_render_2;     // 二位端可见光标注渲染缓存
+
+    // ========== 共享内存帧总线（处理后帧发布给本机其他进程，各由对应的处理线程写入）==========
+    FrameBusWriter processed_thermal_bus_1; // 一位端热成像（TaskDisplay 写入）
+    FrameBusWriter processed_visible_bus_1; // 一位端可见光（TaskObjectTracking 写入）
+    FrameBusWriter processed_thermal_bus_2; // 二位端热成像
+    FrameBusWriter processed_visible_bus_2; // 二位端可见光
+
+    // ========== 温度数据（按位打包的高温掩码，已经过N-of-M持续性滤波）==========
+    ThermalBitMask thermalMask_1;     // 一位端高温掩码（640x512，1位/像素）
+    ThermalBitMask thermalMask_2;     // 二位端高温掩码（640x512，1位/像素）
+    ThermalAnalysisResultPtr thermalAnalysis_1; // 一位端高温区域分析结果（不可变，与掩码同时发布）
+    ThermalAnalysisResultPtr thermalAnalysis_2; // 二位端高温区域分析结果（不可变，与掩码同时发布）
+    std::deque<ThermalAnalysisResultPtr> thermalHistory_1; // 一位端最近若干帧分析结果（按采集时间递增，用于与可见光帧配对）
+    std::deque<ThermalAnalysisResultPtr> thermalHistory_2; // 二位端最近若干帧分析结果
+    static constexpr size_t kThermalHistoryDepth = 8;      // 分析结果历史长度
+    RadiometricFramePtr radiometricFrame_1; // 一位端最新辐射测温帧（真实温度，启用辐射测温采集时有效）
+    RadiometricFramePtr radiometricFrame_2; // 二位端最新辐射测温帧
     std::mutex thermalmatrix_mutex_1; // 温度数据访问同步锁
     std::mutex thermalmatrix_mutex_2; // 温度数据访问同步锁
 
@@ -145,6 +485,9 @@ struct SharedData
     std::atomic<bool> camera2_visible_detected{false}; // 二位端可见光检测状态
     std::atomic<bool> camera2_thermal_detected{false}; // 二位端热成像检测状态
 
+    // ========== 列车运行数据（定位上报线程写入）==========
+    std::atomic<float> trainSpeedKmh{-1.0f}; // 最近一帧有效GYK数据的实速（km/h），<0表示尚无有效数据
+
     // ========== 系统控制标志位（保持不变）==========
     std::atomic_bool isRunning; // 线程控制标志位
 
@@ -155,6 +498,32 @@ struct SharedData
     // ========== Thermal Processing Configuration (New) ==========
     ThermalProcessingConfig thermalProcessingConfig; // Thermal processing configuration
     std::mutex thermalProcessingConfigMutex;         // Thermal processing configuration sync lock
+    RadiometricIngestConfig radiometricIngestConfig; // Radiometric ingest configuration (read-only after startup)
+
+    // ========== Multicast Output Configuration ==========
+    MulticastOutputConfig multicastOutputConfig; // Multicast output configuration (read-only after startup)
+
+    // ========== Quad View Configuration ==========
+    QuadViewConfig quadViewConfig; // Quad view stream configuration (read-only after startup)
+
+    // ========== Stream Pacing Configuration ==========
+    StreamPacingConfig streamPacingConfig; // RTSP stream pacing configuration (read-only after startup)
+
+    // ========== ROI Encoding Configuration ==========
+    RoiEncodingConfig roiEncodingConfig; // ROI encoding configuration (read-only after startup)
+
+    // ========== Thermal-Visible Fusion Configuration ==========
+    ThermalVisibleFusionConfig thermalVisibleFusionConfig; // Thermal-visible fusion configuration (read-only after startup)
+
+    // ========== Event Journal ==========
+    EventJournalConfig eventJournalConfig; // Event journal configuration (read-only after startup)
+    EventJournal *eventJournal = nullptr;  // Started by main before the task threads, nullptr when disabled
+
+    // ========== Overlay Rendering Configuration ==========
+    OverlayRenderConfig overlayRenderConfig; // Overlay rendering configuration (read-only after startup)
+
+    // ========== Frame Bus Configuration ==========
+    FrameBusConfig frameBusConfig; // Shared-memory frame bus configuration (read-only after startup)
 
     float g_alarmThreshold = 40.0f; // 报警阈值
 };
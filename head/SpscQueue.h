@@ -0,0 +1,142 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 有界单生产者单消费者环形队列
+ *
+ * 入队/出队只操作一对原子下标，不加锁；队列空或满时阻塞等待的一方在条件变量上休眠，
+ * 另一方操作成功后短暂获取同一把锁再唤醒，避免丢失唤醒。
+ * tryPush/push 只能由生产者线程调用，tryPop/pop 只能由消费者线程调用。
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    /**
+     * @param capacity 最多容纳的元素个数
+     */
+    explicit SpscQueue(size_t capacity)
+        : slots_(capacity + 1)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * @brief 非阻塞入队（生产者线程）
+     * @return false 队列已满
+     */
+    bool tryPush(const T &item)
+    {
+        if (!enqueue(item))
+            return false;
+        wake(notEmpty_);
+        return true;
+    }
+
+    /**
+     * @brief 非阻塞出队（消费者线程）
+     * @return false 队列为空
+     */
+    bool tryPop(T &item)
+    {
+        if (!dequeue(item))
+            return false;
+        wake(notFull_);
+        return true;
+    }
+
+    /**
+     * @brief 入队，队列满时最多等待 timeout
+     * @return false 超时仍未入队
+     */
+    bool push(const T &item, std::chrono::milliseconds timeout)
+    {
+        if (tryPush(item))
+            return true;
+        bool pushed;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            pushed = notFull_.wait_for(lock, timeout, [&] { return enqueue(item); });
+        }
+        if (pushed)
+            notEmpty_.notify_one();
+        return pushed;
+    }
+
+    /**
+     * @brief 出队，队列空时最多等待 timeout
+     * @return false 超时仍为空
+     */
+    bool pop(T &item, std::chrono::milliseconds timeout)
+    {
+        if (tryPop(item))
+            return true;
+        bool popped;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            popped = notEmpty_.wait_for(lock, timeout, [&] { return dequeue(item); });
+        }
+        if (popped)
+            notFull_.notify_one();
+        return popped;
+    }
+
+    /**
+     * @brief 当前元素个数（其他线程读取时为近似值）
+     */
+    size_t size() const
+    {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : tail + slots_.size() - head;
+    }
+
+    size_t capacity() const { return slots_.size() - 1; }
+
+private:
+    size_t increment(size_t index) const { return index + 1 == slots_.size() ? 0 : index + 1; }
+
+    bool enqueue(const T &item)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = increment(tail);
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+        slots_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool dequeue(T &item)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        item = slots_[head];
+        head_.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    // 等待方在 waitMutex_ 下检查条件后休眠，这里先获取同一把锁再通知，保证通知不会落在检查与休眠之间
+    void wake(std::condition_variable &cv)
+    {
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+        }
+        cv.notify_one();
+    }
+
+    std::vector<T> slots_; // 多留一个空位用于区分空和满
+    alignas(64) std::atomic<size_t> head_{0}; // 下一个读取位置（消费者写）
+    alignas(64) std::atomic<size_t> tail_{0}; // 下一个写入位置（生产者写）
+    std::mutex waitMutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
@@ -20,7 +20,11 @@ private:
 	void updateDisplay(const cv::Mat &displayFrame);						// 更新窗口显示
 	void initializeDisplay();												// 初始化显示窗口
 	void cleanupDisplay();													// 清理显示窗口
-	void processTemperatureData(const cv::Mat &tempMatrix, cv::Mat &frame); // 处理温度数据
+	void processTemperatureData(const ThermalAnalysisResult &analysis, const cv::Mat &frame,
+								std::vector<cv::Rect> &hotRects, FrameOverlay &overlay); // 高温区域记入标注数据，输出高温区域外接矩形
+	void generateFakeThermalMask(ThermalBitMask &mask, const std::vector<cv::Point> &hotSpots,
+								 float baseTemp, float hotTemp); // 测试模式：生成模拟高温掩码
+	float currentAlarmThreshold();										// 读取当前报警阈值
 
 	SharedData &data_; // 共享数据引用
 	// cv::VideoCapture& cap_; // 视频捕获对象引用
@@ -28,4 +32,5 @@ private:
 	bool enableDisplay_;	 // 控制是否启用窗口显示
 	bool windowInitialized_; // 窗口是否已初始化
 	std::string windowName_; // 窗口名称
+	ThermalAnalyzer fakeAnalyzer_; // 测试模式下分析模拟高温掩码
 };
\ No newline at end of file
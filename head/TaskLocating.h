@@ -3,12 +3,13 @@
 #include <mutex>
 #include <vector>
 #include "SharedData.h"
+#include "ThermalHotSpotTracker.h"
 /**
  * @brief 热成像检测任务类
  *
  * 职责：
- * 1. 从SharedData中获取热成像温度矩阵
- * 2. 检测高温物体（温度阈值分割、轮廓检测）
+ * 1. 从SharedData中获取热成像高温区域分析结果
+ * 2. 检测新出现的高温物体
  * 3. 设置检测标志位供统一上报线程使用
  * 4. 不再直接负责定位上报逻辑
  */
@@ -44,15 +45,16 @@ private:
 
     /**
      * @brief 处理热成像数据，检测高温物体并设置检测标志位
-     * @param thermalMatrix 热成像温度矩阵
+     * @param analysis 高温区域分析结果
      * @param data 共享数据引用
      * @param deviceIndex 设备索引 (0=设备1/一位端, 1=设备2/二位端)
      */
-    void processThermalData(const cv::Mat &thermalMatrix, SharedData &data, int deviceIndex);
+    void processThermalData(const ThermalAnalysisResult &analysis, SharedData &data, int deviceIndex);
 
     // 核心成员变量
     SharedData &data_;                                     // 共享数据引用
     std::thread thread_;                                   // 热成像检测线程
-    std::mutex trackedObjectsMutex_;                       // 跟踪物体的互斥锁
-    std::vector<std::vector<cv::Point2f>> trackedObjects_; // 每个设备的跟踪物体列表[设备索引][物体列表]
+    ThermalHotSpotTracker trackers_[2];                    // 每个设备的高温物体跟踪器
+    ThermalAnalysisResultPtr lastAnalysis_[2];             // 每个设备上次处理的分析结果（避免重复处理同一帧）
+    std::vector<int> newSpotIds_;                          // 本帧新确认的高温物体ID（复用的缓冲区）
 };
\ No newline at end of file
@@ -2,16 +2,23 @@
 #include <thread>
 #include <memory>
 #include <chrono>
+#include <future>
 #include <opencv2/opencv.hpp>
 #include "SharedData.h"
 #include "ObjectTrackingConfig.h"
+#include "ThermalVisibleFusion.h"
+#include "SpscQueue.h"
 
 // 避免在头文件中包含Windows相关头文件，使用基本类型
 // Windows相关的包含将在.cpp文件中处理
 
 // 前向声明yolo_track库的类，避免头文件依赖
-class YoloDetector;
+class IDetector;
+class InferenceScheduler;
+class CadenceController;
+class InferenceRoi;
 class TrackerModule;
+class FlatByteTracker;
 class CountingLineModule;
 struct Detection;
 struct TrackResult;
@@ -22,7 +29,15 @@ struct TrackResult;
  * 集成YOLO检测器、ByteTrack追踪器和虚拟检测线计数模块
  *
  * 数据流向：
- * visible_video_Frame_1/2 → YOLO检测 → ByteTrack追踪 → 计数统计 → processedVisibleframe_1/2
+ * visible_video_Frame_1/2 → YOLO检测（两路合并批次） → ByteTrack追踪 → 计数统计 → processedVisibleframe_1/2
+ *                                                 ↘ 与时间最接近的热成像帧融合 → 标注数据中的融合目标框
+ *
+ * 三个阶段各占一个线程，通过有界SPSC队列传递帧任务，第N+1帧的预处理与推理和第N帧的追踪、计数重叠执行：
+ * 检测阶段（等待新帧 → 复制 → 推理） → 追踪阶段（ByteTrack） → 输出阶段（计数、融合、发布、显示）
+ * 输出阶段不在帧上绘制，跟踪框、计数线与融合目标作为标注数据随处理后帧发布，由需要带标注画面的输出端绘制。
+ * 帧任务对象预先分配，输出阶段处理完后经空闲队列回收到检测阶段，运行中不分配帧缓冲区。
+ * 启用自适应检测间隔时，检测阶段按 CadenceController 的决定跳过部分帧的推理，
+ * 这些帧在追踪阶段使用卡尔曼预测的跟踪位置继续计数。
  */
 class TaskObjectTracking
 {
@@ -52,20 +67,63 @@ public:
     void stop();
 
 private:
+    // 在阶段之间传递的单帧任务（定义见.cpp）
+    struct FrameJob;
+
     /**
-     * @brief 线程主函数，循环处理两路可见光视频流
-     * 从SharedData读取原始视频帧，进行检测追踪处理，输出到处理后的视频帧
+     * @brief 线程主函数，初始化模块后启动追踪与输出阶段线程，本线程执行检测阶段
      */
     void run();
 
     /**
-     * @brief 处理单帧视频的核心函数
-     * @param inputFrame 输入的原始视频帧 (BGR格式)
-     * @param outputFrame 输出的处理后视频帧 (BGR格式)
-     * @param cameraId 摄像头ID (1或2，用于区分不同的计数器)
-     * @return 当前帧检测到的目标数量
+     * @brief 检测阶段：等待新的可见光帧，复制两路新帧并合并提交检测，结果送入追踪队列
+     */
+    void runDetectStage();
+
+    /**
+     * @brief 追踪阶段：按摄像头更新ByteTrack追踪器，结果送入输出队列
+     */
+    void runTrackStage();
+
+    /**
+     * @brief 输出阶段：计数、融合、发布与显示，处理完的任务回收到空闲队列
+     */
+    void runOutputStage();
+
+    /**
+     * @brief 提交一帧检测：启用批处理调度时交给调度器与另一路合并，否则同步检测
+     * @param frame 待检测帧 (BGR格式)，在返回的 future 就绪前保持有效
+     * @return 检测结果
+     */
+    std::future<std::vector<Detection>> submitDetection(cv::Mat &frame);
+
+    /**
+     * @brief 处理单帧的计数（检测与追踪结果已由前两个阶段填入任务）
+     * @param job 帧任务，填充 job.overlay（标注数据）与 job.trackRects（用于ROI编码）
+     * @return 当前帧追踪到的目标数量
+     */
+    int processFrame(FrameJob &job);
+
+    /**
+     * @brief 输出各阶段占用率（忙碌时间/墙钟时间）与队列深度
+     */
+    void reportStageOccupancy();
+
+    /**
+     * @brief 将跟踪框与采集时间最接近的热成像分析结果融合，被热成像确认的目标记入标注数据
+     * @param cameraId 摄像头ID (1或2)
+     * @param frame 处理后的视频帧（提供帧尺寸）
+     * @param meta 可见光帧元数据
+     * @param trackRects 当前帧的跟踪框
+     * @param overlay 本帧标注数据
      */
-    int processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame, int cameraId);
+    void fuseWithThermal(int cameraId, const cv::Mat &frame, const FrameMeta &meta,
+                         const std::vector<cv::Rect> &trackRects, FrameOverlay &overlay);
+
+    /**
+     * @brief 初始化热成像-可见光配准（每个设备的单应矩阵与融合参数）
+     */
+    void initializeFusion();
 
     /**
      * @brief 初始化所有追踪模块 (YOLO检测器、追踪器、计数器)
@@ -91,11 +149,41 @@ private:
     std::thread thread_;          // 处理线程对象
 
     // ========== YOLO追踪模块 (智能指针管理，延迟初始化) ==========
-    std::unique_ptr<YoloDetector> detector_;       // YOLO目标检测器
-    std::unique_ptr<TrackerModule> tracker1_;      // 一位端ByteTrack追踪器
-    std::unique_ptr<TrackerModule> tracker2_;      // 二位端ByteTrack追踪器
-    std::unique_ptr<CountingLineModule> counter1_; // 一位端虚拟检测线计数器
-    std::unique_ptr<CountingLineModule> counter2_; // 二位端虚拟检测线计数器
+    std::unique_ptr<IDetector> detector_;           // YOLO目标检测器（TensorRT或CPU后端）
+    std::unique_ptr<InferenceScheduler> scheduler_; // 两路检测的批处理调度器（未启用时为空）
+    std::unique_ptr<TrackerModule> tracker1_;       // 一位端ByteTrack追踪器（bytetrack 核心）
+    std::unique_ptr<TrackerModule> tracker2_;       // 二位端ByteTrack追踪器（bytetrack 核心）
+    std::unique_ptr<FlatByteTracker> flatTracker_[2]; // 每路的结构数组追踪核心（flat 核心）
+    std::ofstream traceOut_;                          // 设备1检测序列记录（未配置时不打开）
+    uint64_t traceFrames_ = 0;                        // 已记录的追踪更新次数
+    std::unique_ptr<CountingLineModule> counter1_;  // 一位端虚拟检测线计数器
+    std::unique_ptr<CountingLineModule> counter2_;  // 二位端虚拟检测线计数器
+    std::unique_ptr<CadenceController> cadence_[2]; // 每路的自适应检测间隔（未启用时为空）
+    std::unique_ptr<InferenceRoi> roi_[2];          // 每路的推理区域（未启用时为空，整帧检测）
+
+    // ========== 热成像-可见光融合 ==========
+    bool fusionEnabled_ = false;     // 是否启用融合
+    ThermalVisibleFusion fusion_[2]; // 每个设备的配准与融合
+
+    // ========== 流水线阶段 ==========
+    static constexpr size_t kStageQueueDepth = 4;                    // 阶段间队列容量（帧）
+    static constexpr size_t kJobPoolSize = 2 * kStageQueueDepth + 4; // 帧任务总数（两个队列加各阶段在处理中的任务）
+    std::vector<std::unique_ptr<FrameJob>> jobPool_;                 // 预分配的帧任务
+    SpscQueue<FrameJob *> freeJobs_;                                 // 空闲任务（输出阶段 → 检测阶段）
+    SpscQueue<FrameJob *> trackQueue_;                               // 检测阶段 → 追踪阶段，nullptr 表示结束
+    SpscQueue<FrameJob *> outputQueue_;                              // 追踪阶段 → 输出阶段，nullptr 表示结束
+
+    // 各阶段累计忙碌时间（微秒，由对应阶段线程写入，输出阶段每10秒换算为占用率输出）
+    enum Stage
+    {
+        kDetectStage = 0,
+        kTrackStage,
+        kOutputStage,
+        kStageCount
+    };
+    std::atomic<uint64_t> stageBusyUs_[kStageCount];
+    uint64_t lastStageBusyUs_[kStageCount] = {};              // 上次输出时的忙碌时间
+    std::chrono::steady_clock::time_point lastOccupancyTime_; // 上次输出占用率的时间点
 
     // ========== 性能统计变量 ==========
     std::chrono::steady_clock::time_point lastStatsTime_; // 上次统计时间点
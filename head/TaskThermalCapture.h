@@ -1,15 +1,21 @@
 ﻿#pragma once
 #include "SharedData.h"
 #include "HCNetSDK.h"
+#include "PaletteCalibrator.h"
+#include "RadiometricIngest.h"
+#include "TileChangeDetector.h"
 #include <thread>
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include <chrono>
+#include <atomic>
+#include <memory>
 
 /**
  * @brief 热成像数据捕获任务类
  * 负责从热成像视频流通过颜色分析获取温度矩阵数据，支持多设备（1-2个摄像头）
- * 不再使用海康SDK获取温度数据，而是通过分析视频流颜色反推温度数据
+ * 默认通过分析视频流颜色反推温度数据；启用辐射测温采集时改用相机的全屏测温数据，
+ * 按真实温度与报警阈值生成高温掩码
  */
 class TaskThermalCapture
 {
@@ -58,21 +64,6 @@ private:
      */
     bool getCachedTemperatureRange(int deviceIdx, float &minTemp, float &maxTemp);
 
-    /**
-     * @brief 一次性初始化调色板并计算阈值灰度值
-     * @param frame 热成像视频帧
-     * @return 是否初始化成功
-     */
-    bool initializePalette(const cv::Mat &frame);
-
-    /**
-     * @brief 计算向量的指定百分位数值
-     * @param values 输入数值向量
-     * @param percentile 百分位数 (0.0-1.0)
-     * @return 百分位数对应的值
-     */
-    float calculatePercentile(std::vector<float> &values, float percentile);
-
     /**
      * @brief 从温度条区域读取调色板颜色范围（已简化）
      * @param frame 热成像视频帧
@@ -88,24 +79,53 @@ private:
     cv::Mat createMaskRegions(const cv::Mat &frame);
 
     /**
-     * @brief 根据颜色和温度范围建立线性映射关系
-     * @param grayValue 像素灰度值（0-255）
-     * @param palette 调色板灰度值向量
-     * @param minTemp 最低温度
-     * @param maxTemp 最高温度
-     * @return 对应的温度值
+     * @brief 从热成像视频帧生成按位打包的高温掩码
+     * 单次遍历完成灰度转换、区域平均缩放、屏蔽和阈值判断，按输出行并行执行，直接写入64位字
+     * @param frame 热成像视频帧（1280x720）
+     * @param thresholdGray 该设备的高温阈值灰度值
+     * @param mask 输出高温掩码（640x512，1=HIGH_TEMP，0=LOW_TEMP）
+     * @param tiles 分块变化检测结果，为空时全帧计算，非空时只重新计算变化分块（其余保留上一帧结果）
+     * @return 是否生成成功
      */
-    float mapGrayToTemperature(float grayValue, const std::vector<float> &palette,
-                               float minTemp, float maxTemp);
+    bool generateTemperatureMask(const cv::Mat &frame, float thresholdGray, ThermalBitMask &mask, const TileChangeDetector *tiles = nullptr);
 
     /**
-     * @brief 从热成像视频帧生成温度矩阵
-     * @param frame 热成像视频帧（1280x720）
-     * @param minTemp 最低温度
-     * @param maxTemp 最高温度
+     * @brief 累计分块变化检测统计（脏块比例、掩码生成耗时），定期输出到日志
+     * @param tiles 本帧的分块变化检测结果
+     * @param maskMs 本帧掩码生成耗时（毫秒）
+     */
+    void recordTileStats(const TileChangeDetector &tiles, double maskMs);
+
+    /**
+     * @brief 处理一帧辐射测温数据：按报警阈值直接打包高温掩码，再做持续性滤波与高温区域分析
+     * @param deviceIdx 设备索引（0或1）
+     * @param alarmThreshold 报警阈值（摄氏度）
+     * @param environmentTempThreshold 环境温度阈值，全帧最高温度低于该值时跳过
+     * @return 是否处理了新帧
+     */
+    bool processRadiometricFrame(int deviceIdx, float alarmThreshold, float environmentTempThreshold);
+
+    /**
+     * @brief 旧版温度矩阵生成（逐帧建掩码 + resize + 逐像素at<>），仅用于性能对比
+     * @param frame 热成像视频帧
+     * @param thresholdGray 高温阈值灰度值
      * @return 温度矩阵（640x512，CV_32FC1）
      */
-    cv::Mat generateTemperatureMatrix(const cv::Mat &frame, float minTemp, float maxTemp);
+    cv::Mat generateTemperatureMatrixLegacy(const cv::Mat &frame, float thresholdGray);
+
+    /**
+     * @brief 按输入分辨率准备缩放表和静态屏蔽掩码，分辨率不变时直接返回
+     * @param frame 热成像视频帧
+     */
+    void prepareMatrixTables(const cv::Mat &frame);
+
+    /**
+     * @brief 对比旧版与单次遍历版本的耗时和输出一致性，结果输出到日志
+     * @param frame 热成像视频帧
+     * @param thresholdGray 高温阈值灰度值
+     * @param iterations 每种实现的运行次数
+     */
+    void benchmarkTemperatureMatrix(const cv::Mat &frame, float thresholdGray, int iterations);
 
     // 基本成员变量
     std::vector<LONG> userIDs_; // 海康设备用户ID列表
@@ -124,10 +144,43 @@ private:
     int frameCount_;             // 已处理帧数
     double totalProcessingTime_; // 总处理时间（毫秒）
 
-    // 调色板缓存（优化：仅提取一次）
-    bool paletteInitialized_;                 // 调色板是否已初始化
-    float thresholdGrayValue_;                // 高温阈值灰度值
-    float percentileThreshold_;               // 百分位数阈值 (0.7=70%, 0.8=80%, 0.9=90%)
+    // 调色板阈值（每个设备独立标定，基于温度条直方图持续更新）
+    PaletteCalibrator calibrators_[2];        // 设备1/设备2的调色板标定器
+    std::atomic<float> percentileThreshold_;  // 百分位数阈值 (0.7=70%, 0.8=80%, 0.9=90%)，下一帧生效
     static constexpr float HIGH_TEMP = 50.0f; // 高温赋值
     static constexpr float LOW_TEMP = 25.0f;  // 低温赋值
+
+    // 温度矩阵生成缓存（按输入分辨率构建一次）
+    static constexpr int MATRIX_WIDTH = 640;  // 温度矩阵宽度
+    static constexpr int MATRIX_HEIGHT = 512; // 温度矩阵高度
+    cv::Size tableSourceSize_;                // 缩放表对应的输入分辨率
+    std::vector<int> colStart_, colEnd_;      // 每个输出列对应的源列区间 [start, end)
+    std::vector<int> rowStart_, rowEnd_;      // 每个输出行对应的源行区间 [start, end)
+    ThermalBitMask staticValid_;              // 输出分辨率下的屏蔽掩码，按位打包（1=有效，0=屏蔽）
+    bool benchmarkDone_ = false;              // 是否已执行过性能对比
+
+    // 高温掩码与时间持续性滤波（每个设备独立）
+    ThermalBitMask rawMask_[2];               // 当前帧原始掩码（复用缓冲区）
+    ThermalBitMask filteredMask_[2];          // 持续性滤波后的掩码（复用缓冲区）
+    ThermalPersistenceFilter persistence_[2]; // N-of-M 持续性滤波器
+    ThermalAnalyzer analyzers_[2];            // 高温区域分析器
+    uint64_t lastFrameSeq_[2] = {0, 0};       // 上次处理的原始帧序号
+
+    // 分块变化检测（只重新计算变化区域的掩码）
+    struct TileStats
+    {
+        double fullFrameMs = 0.0; // 全帧刷新的掩码生成耗时（指数平均）
+        uint64_t frames = 0;      // 统计周期内的帧数
+        uint64_t dirtyTiles = 0;  // 统计周期内累计脏块数
+        uint64_t totalTiles = 0;  // 统计周期内累计分块数
+        double maskMs = 0.0;      // 统计周期内累计掩码生成耗时
+    };
+    TileChangeDetector tileDetectors_[2];         // 每个设备的分块变化检测器
+    float lastThresholdGray_[2] = {-1.0f, -1.0f}; // 上一帧的阈值灰度值
+    TileStats tileStats_;                         // 两个设备合计的统计
+
+    // 辐射测温采集（启用时替代调色板分析）
+    std::unique_ptr<RadiometricIngest> radiometric_[2]; // 每个设备的测温数据采集线程
+    bool radiometricEnabled_ = false;                   // 是否至少有一个设备的测温采集已启动
+    uint64_t lastRadiometricSeq_[2] = {0, 0};           // 上次处理的测温帧序号
 };
\ No newline at end of file
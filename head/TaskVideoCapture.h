@@ -163,6 +163,8 @@ private:
     // 帧数据缓存
     std::vector<std::array<cv::Mat, 2>> frameBuffers_;                     // [设备][通道]
     std::vector<std::array<std::unique_ptr<std::mutex>, 2>> frameMutexes_; // [设备][通道]
+    std::vector<std::array<FrameMeta, 2>> frameMetas_;                    // [设备][通道] 帧序号与采集时间戳（由frameMutexes_保护）
+    std::vector<std::array<uint64_t, 2>> publishedSeqs_;                  // [设备][通道] 已复制到SharedData的帧序号（仅run线程访问）
 
     // SDK视频保存相关（基于NET_DVR_SaveRealData）
     std::vector<bool> videoSaveActive_;         // 视频保存状态[设备索引] (仅可见光通道)
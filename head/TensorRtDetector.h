@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <memory>
+#include "IDetector.h"
+
+class ConfigManager;
+class YoloDetector;
+
+/**
+ * @brief TensorRT检测后端（封装 yolo_track 库的 YoloDetector）
+ */
+class TensorRtDetector : public IDetector
+{
+public:
+    /**
+     * @brief 构造函数，按ConfigManager中的引擎路径、GPU ID和阈值加载TensorRT引擎
+     * @param config 追踪参数管理器
+     */
+    explicit TensorRtDetector(const ConfigManager &config);
+    ~TensorRtDetector() override;
+
+    std::vector<Detection> detect(cv::Mat &img) override;
+    const char *name() const override { return "tensorrt"; }
+
+private:
+    std::unique_ptr<YoloDetector> detector_;
+};
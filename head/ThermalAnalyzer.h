@@ -0,0 +1,139 @@
+﻿#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "ThermalBitMask.h"
+
+/**
+ * @brief 单个高温区域（温度矩阵坐标，640x512）
+ */
+struct ThermalBlob
+{
+    float area = 0.0f;             // 面积（像素）
+    cv::Point2f centroid;          // 质心
+    cv::Rect boundingBox;          // 外接矩形
+    cv::RotatedRect orientedBox;   // 最小外接旋转矩形（游程模式下为主轴方向外接矩形）
+};
+
+/**
+ * @brief 一帧热成像的分析结果
+ * 由热成像线程每个新帧生成一次，发布后不再修改，定位线程和显示线程共享同一份结果
+ */
+struct ThermalAnalysisResult
+{
+    uint64_t seq = 0;                // 对应热成像原始帧序号
+    int64_t captureTimeUs = 0;       // 对应热成像原始帧采集时间（steady_clock微秒）
+    cv::Size matrixSize;             // 温度矩阵尺寸
+    float alarmThreshold = 0.0f;     // 分析时使用的报警阈值
+    std::vector<ThermalBlob> blobs;  // 面积超过下限的高温区域
+    ThermalBitMask mask;             // 分析时使用的高温掩码（已滤波），供热成像-可见光融合按配准表采样
+};
+using ThermalAnalysisResultPtr = std::shared_ptr<const ThermalAnalysisResult>;
+
+/**
+ * @brief 热成像高温区域分析器
+ *
+ * 按报警阈值解释高温掩码，经开运算去噪后提取连通区域，计算面积、质心、外接矩形和旋转矩形。
+ * 支持两种连通区域提取方式：
+ * - RunLength（默认）：直接在打包掩码上做开运算，逐行提取游程并用并查集合并（8连通），
+ *   统计量在同一遍中累加，面积过滤在合并时完成，不展开为8位图像
+ * - Contours：展开为CV_8U后使用 findContours + contourArea + moments（原实现，用于对比）
+ */
+class ThermalAnalyzer
+{
+public:
+    enum class Method
+    {
+        RunLength, // 游程 + 并查集连通区域标记
+        Contours   // findContours 轮廓
+    };
+
+    /**
+     * @brief 构造函数
+     * @param minArea 高温区域最小面积（像素），小于该值视为噪声
+     * @param openKernelSize 开运算核尺寸，<=1 时不做开运算
+     * @param method 连通区域提取方式
+     */
+    explicit ThermalAnalyzer(float minArea = 100.0f, int openKernelSize = 5, Method method = Method::RunLength);
+
+    void setMethod(Method method)
+    {
+        if (method != method_)
+            last_.reset();
+        method_ = method;
+    }
+    Method method() const { return method_; }
+
+    /**
+     * @brief 掩码与上一帧完全相同时直接复用上一帧的连通区域（只更新帧序号和时间）
+     * 配合分块变化检测使用：场景静止时掩码大部分帧不变，无需重新标记
+     */
+    void setReuseUnchanged(bool enable)
+    {
+        reuseUnchanged_ = enable;
+        if (!enable)
+            last_.reset();
+    }
+
+    /**
+     * @brief 复用上一帧结果的累计帧数
+     */
+    uint64_t reusedFrames() const { return reusedFrames_; }
+
+    /**
+     * @brief 解析配置字符串（"runlength" / "contours"），无法识别时返回 RunLength
+     */
+    static Method parseMethod(const std::string &name);
+
+    /**
+     * @brief 分析一帧高温掩码
+     * @param mask 按位打包的高温掩码
+     * @param alarmThreshold 报警阈值
+     * @param seq 帧序号
+     * @param captureTimeUs 采集时间
+     * @return 不可变的分析结果
+     */
+    ThermalAnalysisResultPtr analyze(const ThermalBitMask &mask, float alarmThreshold,
+                                     uint64_t seq, int64_t captureTimeUs);
+
+private:
+    // 一行中连续置位的像素段
+    struct Run
+    {
+        int y;
+        int x0;    // 起始列（含）
+        int x1;    // 结束列（含）
+        int label; // 临时标签
+    };
+
+    // 连通区域统计量（按临时标签累加，合并时折叠到根标签）
+    struct BlobStats
+    {
+        int64_t area = 0;
+        double sumX = 0, sumY = 0, sumXX = 0, sumYY = 0, sumXY = 0;
+        int minX = INT32_MAX, minY = INT32_MAX, maxX = -1, maxY = -1;
+    };
+
+    void extractContours(const ThermalBitMask &mask, float alarmThreshold, std::vector<ThermalBlob> &blobs);
+    void extractRunLength(const ThermalBitMask &mask, float alarmThreshold, std::vector<ThermalBlob> &blobs);
+    int findRoot(int label);
+
+    float minArea_;
+    int openRadius_;
+    Method method_;
+    cv::Mat kernel_;  // 开运算核（为空时跳过）
+    cv::Mat binary_;  // 展开后的二值图像（轮廓模式复用）
+
+    // 掩码未变化时复用的上一帧结果
+    bool reuseUnchanged_ = false;
+    ThermalAnalysisResultPtr last_;
+    uint64_t reusedFrames_ = 0;
+
+    // 游程模式复用的缓冲区
+    ThermalBitMask hot_, eroded_, opened_;
+    std::vector<Run> runs_;
+    std::vector<int> parent_;
+    std::vector<BlobStats> stats_;
+};
@@ -0,0 +1,163 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 按位打包的热成像高温掩码
+ *
+ * 温度矩阵只有高温/低温两种取值，因此每个像素用1位表示（1=高温）。
+ * 每行按64位字对齐存储，640×512的掩码只占40KB（CV_32FC1矩阵为1.3MB）。
+ * highValue / lowValue 记录置位/清零像素对应的温度，下游按报警阈值解释掩码时使用。
+ */
+class ThermalBitMask
+{
+public:
+    ThermalBitMask() = default;
+    ThermalBitMask(int width, int height) { create(width, height); }
+
+    /**
+     * @brief 按尺寸分配存储（尺寸不变时复用），内容清零
+     */
+    void create(int width, int height);
+
+    void clear();
+    bool empty() const { return words_.empty(); }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int wordsPerRow() const { return wordsPerRow_; }
+    size_t wordCount() const { return words_.size(); }
+
+    uint64_t *row(int y) { return words_.data() + static_cast<size_t>(y) * wordsPerRow_; }
+    const uint64_t *row(int y) const { return words_.data() + static_cast<size_t>(y) * wordsPerRow_; }
+    uint64_t *data() { return words_.data(); }
+    const uint64_t *data() const { return words_.data(); }
+
+    bool test(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1ULL; }
+    void set(int x, int y) { row(y)[x >> 6] |= 1ULL << (x & 63); }
+
+    /**
+     * @brief 统计置位像素数量
+     */
+    size_t countSet() const;
+
+    /**
+     * @brief 判断两个掩码的尺寸、置位/清零温度和所有位是否完全相同
+     */
+    bool sameBits(const ThermalBitMask &other) const;
+
+    /**
+     * @brief 按报警阈值判断置位/清零像素是否属于报警区域
+     * @param threshold 报警温度阈值
+     * @param setIsHot 输出：置位像素是否超过阈值
+     * @param clearIsHot 输出：清零像素是否超过阈值
+     */
+    void classify(float threshold, bool &setIsHot, bool &clearIsHot) const
+    {
+        setIsHot = highValue > threshold;
+        clearIsHot = lowValue > threshold;
+    }
+
+    /**
+     * @brief 按报警阈值展开为8位二值图像（255=超过阈值），用于轮廓等需要cv::Mat的处理
+     * @param dst 输出图像（CV_8UC1，尺寸不变时复用）
+     * @param threshold 报警温度阈值
+     */
+    void unpack(cv::Mat &dst, float threshold) const;
+
+    /**
+     * @brief 按报警阈值生成"超过阈值"掩码（置位=超过阈值），逐字处理，不展开
+     * @param dst 输出掩码
+     * @param threshold 报警温度阈值
+     */
+    void selectHot(ThermalBitMask &dst, float threshold) const;
+
+    /**
+     * @brief 矩形结构元素腐蚀（与cv::erode默认边界一致：图像外视为置位）
+     * @param dst 输出掩码（不能与自身相同）
+     * @param radius 结构元素半径（核尺寸 2*radius+1）
+     */
+    void erode(ThermalBitMask &dst, int radius) const;
+
+    /**
+     * @brief 矩形结构元素膨胀（图像外视为清零）
+     * @param dst 输出掩码（不能与自身相同）
+     * @param radius 结构元素半径（核尺寸 2*radius+1）
+     */
+    void dilate(ThermalBitMask &dst, int radius) const;
+
+    /**
+     * @brief 由浮点温度矩阵按阈值打包（温度 > threshold 置位）
+     * @param temperature 温度矩阵（CV_32FC1）
+     * @param threshold 温度阈值
+     */
+    void packFrom(const cv::Mat &temperature, float threshold);
+
+    float highValue = 50.0f; // 置位像素对应的温度
+    float lowValue = 25.0f;  // 清零像素对应的温度
+
+private:
+    /**
+     * @brief 可分离的矩形形态学运算：先逐行水平合并，再逐列垂直合并
+     * @param isErode true=腐蚀（按位与），false=膨胀（按位或）
+     */
+    void morph(ThermalBitMask &dst, int radius, bool isErode) const;
+
+    /**
+     * @brief 清除每行最后一个字中超出宽度的填充位
+     */
+    void clearPadding();
+
+    int width_ = 0;
+    int height_ = 0;
+    int wordsPerRow_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @brief N-of-M 时间持续性滤波器
+ *
+ * 保留最近M帧的掩码，像素在其中至少N帧为高温时才输出为高温，用于抑制单帧闪烁。
+ * 每个像素的计数以位切片形式保存（计数的第k位存放在第k个平面中），
+ * 新帧入窗加一、旧帧出窗减一、与N比较全部按64位字并行完成，不逐像素循环。
+ */
+class ThermalPersistenceFilter
+{
+public:
+    /**
+     * @brief 设置窗口参数，参数变化时清空历史
+     * @param n 最少高温帧数（1 <= n <= m）
+     * @param m 窗口帧数（1 <= m <= 15）
+     */
+    void configure(int n, int m);
+
+    /**
+     * @brief 清空历史帧和计数
+     */
+    void reset();
+
+    /**
+     * @brief 送入一帧原始掩码并输出滤波结果
+     * @param raw 当前帧原始掩码
+     * @param out 输出：窗口内至少N帧为高温的像素
+     */
+    void update(const ThermalBitMask &raw, ThermalBitMask &out);
+
+    int n() const { return n_; }
+    int m() const { return m_; }
+
+private:
+    static constexpr int kMaxPlanes = 4; // 计数最大15，4个位平面
+
+    int n_ = 1;
+    int m_ = 1;
+    int planes_ = 1;
+    int width_ = 0;
+    int height_ = 0;
+
+    std::vector<ThermalBitMask> history_;              // 窗口内的历史帧（环形）
+    int head_ = 0;                                     // 下一帧写入位置
+    int filled_ = 0;                                   // 已填充的历史帧数
+    std::vector<uint64_t> counterPlanes_[kMaxPlanes]; // 位切片计数平面
+};
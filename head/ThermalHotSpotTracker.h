@@ -0,0 +1,78 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "ThermalAnalyzer.h"
+
+/**
+ * @brief 热成像高温物体跟踪器（每个设备一个实例）
+ *
+ * 将每帧分析得到的高温区域与已有轨迹关联，每个物理高温物体只在轨迹确认时产生一次事件：
+ * - 轨迹按匀速模型、以各自距最近一次关联的时长预测当前位置，关联代价为 1-IoU（无重叠时按质心距离在门限内退化为 1+距离/门限）
+ * - 使用 bytetrack 库中的 LAPJV 求解最优分配
+ * - 轨迹容量固定，超过最大丢失时间（按帧采集时间计）后释放
+ * - 每帧参与关联的高温区域数量有上限（按面积取最大的若干个），单帧跟踪开销有界
+ */
+class ThermalHotSpotTracker
+{
+public:
+    static constexpr int kMaxTracks = 64;     // 轨迹容量
+    static constexpr int kMaxDetections = 64; // 每帧参与关联的高温区域上限
+
+    struct Params
+    {
+        float gateDistance = 50.0f; // 质心关联门限（温度矩阵像素）
+        int64_t maxAgeUs = 2000000; // 轨迹最大丢失时间（微秒）
+        int minHits = 1;            // 确认轨迹所需的关联帧数
+    };
+
+    struct Track
+    {
+        bool active = false;
+        int id = 0;
+        cv::Rect2f box;       // 最近一次关联的外接矩形
+        cv::Point2f center;   // 最近一次关联的质心
+        cv::Point2f velocity; // 质心速度（像素/秒）
+        int64_t lastSeenUs = 0;
+        int hits = 0;
+        bool reported = false; // 是否已产生事件
+    };
+
+    ThermalHotSpotTracker() = default;
+    explicit ThermalHotSpotTracker(const Params &params) : params_(params) {}
+
+    void setParams(const Params &params) { params_ = params; }
+
+    /**
+     * @brief 用一帧分析结果更新轨迹
+     * @param analysis 高温区域分析结果
+     * @param newEvents 输出：本帧新确认的轨迹ID（每个物体只输出一次），可为空
+     * @return 本帧新确认的轨迹数量
+     */
+    int update(const ThermalAnalysisResult &analysis, std::vector<int> *newEvents = nullptr);
+
+    /**
+     * @brief 当前活动轨迹数量
+     */
+    int activeCount() const;
+
+    const std::array<Track, kMaxTracks> &tracks() const { return tracks_; }
+
+private:
+    /**
+     * @brief 关联代价，超出门限时返回负值
+     */
+    float associationCost(const Track &track, const cv::Point2f &predicted, const ThermalBlob &blob) const;
+
+    Params params_;
+    std::array<Track, kMaxTracks> tracks_;
+    int nextId_ = 1;
+
+    // 复用的缓冲区
+    std::vector<int> detectionOrder_;
+    std::vector<int> trackSlots_;
+    std::vector<double> costData_;
+    std::vector<double *> costRows_;
+    std::vector<int> rowSolution_, colSolution_;
+};
@@ -0,0 +1,135 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "ThermalAnalyzer.h"
+
+/**
+ * @brief 融合后的单个目标（可见光帧像素坐标）
+ */
+struct FusedDetection
+{
+    cv::Rect box;             // 可见光帧中的外接矩形
+    float hotFraction = 0.0f; // 框内超过报警阈值的面积比例（按配准表采样）
+    bool visible = false;     // 是否来自可见光跟踪框
+    bool hot = false;         // 是否被热成像确认（hotFraction 达到下限，或为纯热成像目标）
+};
+
+/**
+ * @brief 一帧可见光与其配对热成像帧的融合结果，发布后不再修改
+ */
+struct FusedDetectionList
+{
+    uint64_t visibleSeq = 0;     // 可见光帧序号
+    uint64_t thermalSeq = 0;     // 配对的热成像帧序号，0表示时间差内没有可配对的热成像帧
+    int64_t skewUs = 0;          // 可见光采集时间 - 热成像采集时间（微秒）
+    std::vector<FusedDetection> detections;
+};
+using FusedDetectionListPtr = std::shared_ptr<const FusedDetectionList>;
+
+/**
+ * @brief 热成像-可见光配准与目标融合（每个设备一个实例）
+ *
+ * 同一设备的热成像与可见光通道拍摄同一场景，两者之间的映射用一个单应矩阵描述
+ * （归一化坐标：热成像 [0,1]² → 可见光 [0,1]²，由标定点对求得或直接配置）。
+ * 可见光帧尺寸确定后，按 cellSize 划分网格，预先计算每个网格中心对应的热成像像素下标（查找表），
+ * 之后每帧只需按表采样高温掩码，再对网格做积分图，每个跟踪框的高温比例为 O(1)。
+ *
+ * 融合规则：
+ * - 可见光跟踪框按其高温比例标记是否被热成像确认
+ * - 没有与任何可见光框重叠的高温区域，经单应矩阵正向映射后作为纯热成像目标加入
+ */
+class ThermalVisibleFusion
+{
+public:
+    struct Params
+    {
+        int cellSize = 8;             // 查找表网格尺寸（可见光像素）
+        float minHotFraction = 0.05f; // 跟踪框被判为高温的最小高温面积比例
+        int64_t maxSkewUs = 80000;    // 热成像与可见光配对的最大采集时间差（微秒）
+    };
+
+    ThermalVisibleFusion();
+    explicit ThermalVisibleFusion(const Params &params);
+
+    void setParams(const Params &params);
+
+    /**
+     * @brief 设置归一化单应矩阵（热成像→可见光），行优先9个元素；矩阵不可逆时保持原值
+     * @return 是否设置成功
+     */
+    bool setHomography(const std::array<double, 9> &h);
+
+    /**
+     * @brief 由标定点对（归一化坐标）求单应矩阵，至少4对
+     * @param thermalPoints 热成像中的点
+     * @param visiblePoints 可见光中的对应点
+     * @return 是否求解成功
+     */
+    bool calibrate(const std::vector<cv::Point2f> &thermalPoints, const std::vector<cv::Point2f> &visiblePoints);
+
+    /**
+     * @brief 在热成像历史中选取采集时间与可见光帧最接近的一帧
+     * @param history 按时间递增排列的热成像分析结果
+     * @param visibleTimeUs 可见光帧采集时间
+     * @param maxSkewUs 最大允许时间差
+     * @return 配对结果，超出时间差时为空
+     */
+    static ThermalAnalysisResultPtr pairNearest(const std::deque<ThermalAnalysisResultPtr> &history,
+                                                int64_t visibleTimeUs, int64_t maxSkewUs);
+
+    /**
+     * @brief 融合一帧可见光跟踪框与配对的热成像分析结果
+     * @param visibleSize 可见光帧尺寸（变化时重建查找表）
+     * @param visibleSeq 可见光帧序号
+     * @param visibleTimeUs 可见光帧采集时间
+     * @param trackRects 可见光跟踪框
+     * @param thermal 配对的热成像分析结果，可为空（此时只输出可见光目标）
+     * @return 不可变的融合结果
+     */
+    FusedDetectionListPtr fuse(const cv::Size &visibleSize, uint64_t visibleSeq, int64_t visibleTimeUs,
+                               const std::vector<cv::Rect> &trackRects, const ThermalAnalysisResultPtr &thermal);
+
+    const Params &params() const { return params_; }
+
+private:
+    /**
+     * @brief 按可见光帧和热成像矩阵尺寸重建查找表（尺寸未变化时直接返回）
+     */
+    void prepareTables(const cv::Size &visibleSize, const cv::Size &thermalSize);
+
+    /**
+     * @brief 按查找表采样高温掩码并生成网格积分图
+     */
+    void sampleHotCells(const ThermalBitMask &hot);
+
+    /**
+     * @brief 可见光矩形内高温网格所占比例（积分图查询）
+     */
+    float hotFraction(const cv::Rect &box) const;
+
+    /**
+     * @brief 将热成像矩阵中的矩形映射到可见光帧（四角映射后取外接矩形）
+     */
+    cv::Rect toVisible(const cv::Rect &thermalBox) const;
+
+    Params params_;
+    std::array<double, 9> homography_; // 归一化单应矩阵（热成像→可见光，行优先）
+    std::array<double, 9> inverse_;    // 逆矩阵（可见光→热成像）
+
+    // 查找表：每个可见光网格中心对应的热成像像素（x,y），落在热成像视场外时为-1
+    cv::Size visibleSize_;
+    cv::Size thermalSize_;
+    int gridCols_ = 0;
+    int gridRows_ = 0;
+    std::vector<int16_t> lutX_;
+    std::vector<int16_t> lutY_;
+    bool tablesValid_ = false;
+
+    // 复用的缓冲区
+    ThermalBitMask hot_;
+    std::vector<int> integral_; // (gridRows_+1) x (gridCols_+1) 高温网格积分图
+};
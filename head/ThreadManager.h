@@ -27,6 +27,7 @@ public:
      * @param streamWidth RTSP推流宽度，0表示使用原始分辨率
      * @param streamHeight RTSP推流高度，0表示使用原始分辨率
      * @param streamFps RTSP推流帧率
+     * @param embeddedServer 内嵌RTSP服务器，nullptr表示推流到外部服务器
      */
     ThreadManager(int cameraCount,
                   const std::vector<nlohmann::json> &deviceConfigs,
@@ -35,7 +36,8 @@ public:
                   const ObjectTrackingConfig &trackingConfig = ObjectTrackingConfig{},
                   int streamWidth = 0,
                   int streamHeight = 0,
-                  int streamFps = 25);
+                  int streamFps = 25,
+                  RtspServer *embeddedServer = nullptr);
 
     /**
      * @brief 析构函数，确保所有线程安全停止
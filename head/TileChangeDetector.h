@@ -0,0 +1,99 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 热成像分块变化检测器（每个设备一个实例）
+ *
+ * 将输出矩阵（640x512）划分为 32x32 的分块，每个分块在源帧对应区域上均匀采样 8x8 个像素的亮度，
+ * 与该分块最近一次重新计算时保存的参考采样做绝对差之和（SAD），平均差超过阈值的分块标记为变化，再扩展到8邻域分块。
+ * 高温掩码生成只重新计算变化分块所在的64位字，其余字沿用之前的结果；只有被重新计算的分块才更新参考采样，
+ * 因此逐帧低于阈值的缓慢变化会累积，直到相对参考超过阈值。
+ * 第一帧、输入尺寸变化、调用 invalidate() 后，以及每隔 fullRefreshFrames 帧，所有分块都视为变化。
+ */
+class TileChangeDetector
+{
+public:
+    static constexpr int kTileSize = 32;      // 分块尺寸（输出矩阵像素）
+    static constexpr int kSamplesPerAxis = 8; // 每个分块每个方向的亮度采样数
+
+    struct Params
+    {
+        bool enable = true;          // 关闭时每帧所有分块都视为变化
+        float threshold = 6.0f;      // 分块平均亮度差阈值（灰度级）
+        int fullRefreshFrames = 250; // 强制全帧刷新间隔（帧），<=0 不强制
+    };
+
+    void setParams(const Params &params) { params_ = params; }
+    const Params &params() const { return params_; }
+
+    /**
+     * @brief 下一帧强制全帧刷新（阈值变化等导致旧结果失效时调用）
+     */
+    void invalidate() { forceFull_ = true; }
+
+    /**
+     * @brief 对比当前帧与各分块参考采样的亮度，更新变化分块（需要重新计算的分块同时更新参考采样）
+     * @param frame 源帧（BGR、BGRA或灰度，8位）
+     * @param matrixSize 输出矩阵尺寸
+     */
+    void update(const cv::Mat &frame, const cv::Size &matrixSize);
+
+    int tileCols() const { return tileCols_; }
+    int tileRows() const { return tileRows_; }
+    int tileCount() const { return tileCols_ * tileRows_; }
+
+    /**
+     * @brief 本帧SAD超过阈值的分块数量（不含邻域扩展）
+     */
+    int changedTileCount() const { return changedTiles_; }
+
+    /**
+     * @brief 本帧需要重新计算的分块数量（含邻域扩展）
+     */
+    int dirtyTileCount() const { return dirtyTiles_; }
+
+    /**
+     * @brief 本帧是否为全帧刷新
+     */
+    bool fullRefresh() const { return fullRefresh_; }
+
+    /**
+     * @brief 某个分块行中各64位字是否需要重新计算（wordsPerRow 个标志）
+     */
+    const uint8_t *dirtyWords(int tileRow) const { return dirtyWords_.data() + static_cast<size_t>(tileRow) * wordsPerRow_; }
+
+    /**
+     * @brief 某个分块行中是否有需要重新计算的字
+     */
+    bool rowDirty(int tileRow) const { return rowDirty_[tileRow] != 0; }
+
+private:
+    /**
+     * @brief 按源帧和输出矩阵尺寸生成采样坐标表
+     */
+    void prepare(const cv::Size &sourceSize, const cv::Size &matrixSize);
+
+    Params params_;
+    cv::Size sourceSize_;
+    cv::Size matrixSize_;
+    int tileCols_ = 0;
+    int tileRows_ = 0;
+    int wordsPerRow_ = 0;
+
+    std::vector<int> sampleX_;      // 每个采样列对应的源列
+    std::vector<int> sampleY_;      // 每个采样行对应的源行
+    std::vector<uint8_t> luma_;          // 当前帧采样亮度
+    std::vector<uint8_t> referenceLuma_; // 各分块最近一次重新计算时的采样亮度
+    std::vector<uint8_t> changed_;  // SAD超过阈值的分块
+    std::vector<uint8_t> dirty_;    // 扩展到邻域后的分块
+    std::vector<uint8_t> dirtyWords_;
+    std::vector<uint8_t> rowDirty_;
+
+    bool forceFull_ = true;
+    bool fullRefresh_ = true;
+    int framesSinceFull_ = 0;
+    int changedTiles_ = 0;
+    int dirtyTiles_ = 0;
+};
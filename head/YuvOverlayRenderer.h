@@ -0,0 +1,158 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "FrameOverlay.h"
+
+/**
+ * @brief 一帧 YUV 4:2:0 图像的平面描述（I420 三个平面，或 NV12 亮度平面 + UV交织平面）
+ */
+struct YuvPlanes
+{
+    uint8_t *y = nullptr;
+    uint8_t *u = nullptr;
+    uint8_t *v = nullptr;
+    int yStride = 0;
+    int uvStride = 0;
+    int uvStep = 1; // 同一色度平面相邻样本的间隔（I420 为1，NV12 为2）
+    int width = 0;
+    int height = 0;
+
+    /**
+     * @brief 连续的I420缓冲区（Y | U | V）
+     */
+    static YuvPlanes i420(uint8_t *data, int width, int height);
+
+    /**
+     * @brief 连续的NV12缓冲区（Y | UV交织）
+     */
+    static YuvPlanes nv12(uint8_t *data, int width, int height);
+};
+
+/**
+ * @brief 直接在 YUV 4:2:0 平面上绘制标注（框、线段、旋转矩形、文字）
+ *
+ * 推流前标注不再画到BGR帧上再整帧转换：每个图元先光栅化为逐行的像素区间（同一图元内合并），
+ * 亮度平面直接填色，色度平面按每个2×2块内被覆盖的亮度像素数（0~4）混合，
+ * 与先画到全分辨率再按面积下采样的结果一致，细线与框边不会出现整块染色。
+ * 线宽与端点的画法与 cv::line / cv::rectangle 相同（粗线为加宽的四边形加圆端）。
+ *
+ * 文字使用预先栅格化的字形图集：每种字号与线宽第一次使用时用 cv::putText 把可打印ASCII字符
+ * 逐个画到掩码中缓存，之后按字宽拼接，亮度平面用SIMD按掩码选择写入。
+ *
+ * 颜色换算需与该YUV数据的来源一致：推流器的 cudaBGR2YUV420P 使用 kPushStream，
+ * cv::cvtColor(COLOR_BGR2YUV_I420)（如四分屏画布）使用 kBt601Limited。
+ */
+class YuvOverlayRenderer
+{
+public:
+    enum ColorMatrix
+    {
+        kPushStream = 0, // 与 cudaBGR2YUV420P 相同的系数（全范围）
+        kBt601Limited    // 与 cv::COLOR_BGR2YUV_I420 相同的系数（16~235）
+    };
+
+    struct Color
+    {
+        uint8_t y = 0;
+        uint8_t u = 128;
+        uint8_t v = 128;
+    };
+
+    explicit YuvOverlayRenderer(ColorMatrix matrix = kPushStream);
+
+    /**
+     * @brief BGR颜色换算为YUV
+     */
+    Color color(const cv::Scalar &bgr) const;
+
+    /**
+     * @brief 实心矩形
+     */
+    void fillRect(const YuvPlanes &planes, const cv::Rect &rect, const cv::Scalar &bgr);
+
+    /**
+     * @brief 矩形框（与 cv::rectangle(img, rect, color, thickness) 相同）
+     */
+    void drawRect(const YuvPlanes &planes, const cv::Rect &rect, const cv::Scalar &bgr, int thickness);
+
+    /**
+     * @brief 线段（与 cv::line 相同）
+     */
+    void drawLine(const YuvPlanes &planes, const cv::Point2f &a, const cv::Point2f &b, const cv::Scalar &bgr, int thickness);
+
+    /**
+     * @brief 旋转矩形的四条边（四个顶点按顺序给出）
+     */
+    void drawRotatedRect(const YuvPlanes &planes, const std::array<cv::Point2f, 4> &vertices, const cv::Scalar &bgr, int thickness);
+
+    /**
+     * @brief 文字（FONT_HERSHEY_SIMPLEX，origin 为左下基线位置，与 cv::putText 相同）
+     */
+    void drawText(const YuvPlanes &planes, const std::string &text, const cv::Point &origin, double fontScale, int thickness,
+                  const cv::Scalar &bgr);
+
+    /**
+     * @brief 把标注数据的指定图层画到YUV平面
+     *
+     * 标注坐标乘以 scaleX / scaleY 换算到平面坐标（线宽与字号按纵向比例缩放）。
+     * 跟踪框使用 TrackerModule::getClassColor 的类别颜色，框上方标出跟踪ID；
+     * 计数线、融合目标框与高温区域的颜色和线宽与 FrameOverlay::draw 相同。
+     */
+    void draw(const YuvPlanes &planes, const FrameOverlay &overlay, uint32_t layers, double scaleX, double scaleY);
+
+private:
+    // 一个图元光栅化后的一段像素区间 [x0, x1)
+    struct Span
+    {
+        int y;
+        int x0;
+        int x1;
+    };
+
+    // 一种字号与线宽的字形图集
+    struct GlyphAtlas
+    {
+        struct Glyph
+        {
+            int offsetX = 0; // 掩码左上角相对于字符原点的偏移
+            int offsetY = 0;
+            int width = 0;
+            int height = 0;
+            size_t offset = 0; // 掩码在 masks 中的起始位置（行宽为 width）
+        };
+        std::array<Glyph, 95> glyphs; // ' ' ~ '~'
+        std::array<float, 95> advance{}; // 字宽（含小数，拼接时累加后取整）
+        std::vector<uint8_t> masks;   // 0 / 0xFF
+    };
+
+    const GlyphAtlas &atlas(double fontScale, int thickness);
+    static GlyphAtlas buildAtlas(double fontScale, int thickness);
+
+    void addSpan(int y, int x0, int x1);
+    void addConvex(const cv::Point2f *pts, int count);
+    void addDisc(const cv::Point2f &center, int radius);
+    void addLine(const cv::Point2f &a, const cv::Point2f &b, int thickness);
+
+    /**
+     * @brief 把已收集的像素区间作为一个图元写入平面，然后清空
+     */
+    void flushSpans(const YuvPlanes &planes, const Color &c);
+
+    /**
+     * @brief 按掩码（0 / 0xFF，行宽 maskStride）写入平面，掩码左上角位于 (x, y)
+     */
+    void blitMask(const YuvPlanes &planes, const uint8_t *mask, int maskStride, int maskW, int maskH, int x, int y, const Color &c);
+
+    ColorMatrix matrix_;
+    int clipW_ = 0; // 当前平面尺寸（addSpan 裁剪用）
+    int clipH_ = 0;
+    std::vector<Span> spans_;
+    std::vector<uint8_t> coverage_;  // 色度列覆盖计数（复用）
+    std::vector<uint8_t> textMask_;  // 拼接后的文字掩码（复用）
+    std::map<std::pair<int, int>, GlyphAtlas> atlases_; // (字号×1000, 线宽) -> 图集
+};
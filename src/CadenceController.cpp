@@ -0,0 +1,200 @@
+﻿#include "CadenceController.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "CountingEvaluation.h"
+#include "IDetector.h"
+
+CadenceController::CadenceController(const Params &params, const std::string &name)
+    : params_(params), name_(name)
+{
+    params_.maxInterval = (std::max)(1, params_.maxInterval);
+    motionInterval_ = params_.maxInterval;
+    sinceDetect_ = params_.maxInterval; // 第一帧总是检测
+    currentInterval_ = params_.maxInterval;
+}
+
+DETECTBOX CadenceController::toXyah(const float bbox[4])
+{
+    const float w = (std::max)(1.0f, bbox[2] - bbox[0]);
+    const float h = (std::max)(1.0f, bbox[3] - bbox[1]);
+    DETECTBOX box;
+    box << bbox[0] + w * 0.5f, bbox[1] + h * 0.5f, w / h, h;
+    return box;
+}
+
+void CadenceController::toTlbr(const KAL_MEAN &mean, float bbox[4])
+{
+    const float h = mean(3);
+    const float w = mean(2) * h;
+    bbox[0] = mean(0) - w * 0.5f;
+    bbox[1] = mean(1) - h * 0.5f;
+    bbox[2] = mean(0) + w * 0.5f;
+    bbox[3] = mean(1) + h * 0.5f;
+}
+
+bool CadenceController::shouldDetect(float trainSpeedKmh)
+{
+    int interval = motionInterval_;
+
+    // 列车运行越快，场景变化越快，间隔线性缩短
+    if (trainSpeedKmh > params_.stationarySpeedKmh)
+    {
+        const float t = (trainSpeedKmh - params_.stationarySpeedKmh) / (params_.fullRateSpeedKmh - params_.stationarySpeedKmh);
+        const int speedInterval = static_cast<int>(std::lround(params_.maxInterval - t * (params_.maxInterval - 1)));
+        interval = (std::min)(interval, (std::max)(1, speedInterval));
+    }
+    currentInterval_ = interval;
+
+    if (++sinceDetect_ >= interval)
+    {
+        sinceDetect_ = 0;
+        detectedFrames_++;
+    }
+    else
+    {
+        skippedFrames_++;
+    }
+
+    const uint64_t detected = detectedFrames_;
+    const uint64_t frames = detected + skippedFrames_;
+    if (frames % 3000 == 0)
+    {
+        std::cout << "[CadenceController] " << name_ << " 帧数: " << frames << ", 检测: " << detected
+                  << " (推理减少 " << static_cast<double>(frames) / (std::max)(uint64_t(1), detected)
+                  << " 倍), 当前间隔: " << currentInterval_ << " 帧" << std::endl;
+    }
+    return sinceDetect_ == 0;
+}
+
+void CadenceController::observe(const std::vector<Detection> &detections, const std::vector<TrackResult> &tracks)
+{
+    for (auto &entry : states_)
+    {
+        entry.second.seen = false;
+    }
+
+    // 检测帧：已有状态先预测到当前帧再用跟踪框修正，新ID初始化
+    float maxSpeed = 0.0f;
+    bool converging = false;
+    for (const TrackResult &track : tracks)
+    {
+        if (track.is_lost)
+            continue;
+        const DETECTBOX measurement = toXyah(track.bbox);
+        auto it = states_.find(track.track_id);
+        if (it == states_.end())
+        {
+            TrackState state;
+            KAL_DATA data = kalman_.initiate(measurement);
+            state.mean = data.first;
+            state.covariance = data.second;
+            it = states_.emplace(track.track_id, state).first;
+        }
+        else
+        {
+            TrackState &state = it->second;
+            kalman_.predict(state.mean, state.covariance);
+            KAL_DATA data = kalman_.update(state.mean, state.covariance, measurement);
+            state.mean = data.first;
+            state.covariance = data.second;
+        }
+
+        TrackState &state = it->second;
+        state.last = track;
+        state.last.is_new = false;
+        state.hits++;
+        state.seen = true;
+        converging = converging || state.hits < params_.minTrackHits;
+        maxSpeed = (std::max)(maxSpeed, std::hypot(state.mean(4), state.mean(5)));
+    }
+
+    // 本帧未出现的ID不再预测
+    for (auto it = states_.begin(); it != states_.end();)
+    {
+        it = it->second.seen ? std::next(it) : states_.erase(it);
+    }
+
+    // 未被任何跟踪框覆盖的高置信度检测：新目标正在进入，轨迹尚未确认
+    bool newObject = false;
+    for (const Detection &det : detections)
+    {
+        if (det.conf < params_.newObjectConf || (params_.trackClass >= 0 && det.classId != params_.trackClass))
+            continue;
+        const float cx = (det.bbox[0] + det.bbox[2]) * 0.5f;
+        const float cy = (det.bbox[1] + det.bbox[3]) * 0.5f;
+        bool covered = false;
+        for (const TrackResult &track : tracks)
+        {
+            if (!track.is_lost && cx >= track.bbox[0] && cx <= track.bbox[2] && cy >= track.bbox[1] && cy <= track.bbox[3])
+            {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered)
+        {
+            newObject = true;
+            break;
+        }
+    }
+
+    int interval = params_.maxInterval;
+    if (converging || newObject)
+    {
+        interval = 1;
+    }
+    else if (maxSpeed > 0.0f)
+    {
+        interval = static_cast<int>(params_.maxPredictPx / maxSpeed);
+    }
+    motionInterval_ = (std::max)(1, (std::min)(params_.maxInterval, interval));
+}
+
+void CadenceController::predict(std::vector<TrackResult> &tracks)
+{
+    tracks.clear();
+    for (auto &entry : states_)
+    {
+        TrackState &state = entry.second;
+        kalman_.predict(state.mean, state.covariance);
+        TrackResult result = state.last;
+        toTlbr(state.mean, result.bbox);
+        tracks.push_back(result);
+    }
+}
+
+void CadenceController::evaluate(IDetector &detector, const ConfigManager &config, const Params &params, const std::string &videoPath)
+{
+    CadenceController cadence(params, "评估");
+    std::vector<TrackResult> adaptiveTracks;
+
+    // 自适应间隔：只在检测帧使用同一帧的检测结果，其余帧用预测位置
+    auto adaptive = [&](cv::Mat &, const std::vector<Detection> &detections, TrackerModule &tracker)
+    {
+        if (cadence.shouldDetect(-1.0f))
+        {
+            adaptiveTracks = tracker.update(detections);
+            cadence.observe(detections, adaptiveTracks);
+        }
+        else
+        {
+            cadence.predict(adaptiveTracks);
+        }
+        return adaptiveTracks;
+    };
+
+    CountingEvaluation::Result result;
+    if (!CountingEvaluation::run(detector, config, videoPath, params.maxInterval, adaptive, result))
+    {
+        std::cerr << "[CadenceController] 无法打开评估录像: " << videoPath << std::endl;
+        return;
+    }
+    const uint64_t inferences = cadence.detectedFrames();
+
+    std::cout << "[CadenceController] 自适应检测间隔评估（" << videoPath << "）- 帧数: " << result.frames
+              << ", 推理次数: " << inferences << " (减少 " << (inferences > 0 ? static_cast<double>(result.frames) / inferences : 0.0) << " 倍)"
+              << ", 越线计数 每帧检测/自适应: " << result.reference.size() << "/" << result.candidate.size()
+              << ", 漏计: " << result.missed() << ", 多计: " << result.extra()
+              << ", 漏计率: " << (result.reference.empty() ? 0.0 : 100.0 * result.missed() / result.reference.size()) << "%" << std::endl;
+}
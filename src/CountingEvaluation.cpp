@@ -0,0 +1,60 @@
+﻿#include "CountingEvaluation.h"
+#include <chrono>
+#include "IDetector.h"
+#include "config_manager.h"
+#include "counting_line.h"
+
+bool CountingEvaluation::run(IDetector &detector, const ConfigManager &config, const std::string &videoPath, double tolerance,
+                             const CandidateStep &candidate, Result &result)
+{
+    cv::VideoCapture capture(videoPath);
+    if (!capture.isOpened())
+        return false;
+    double fps = capture.get(cv::CAP_PROP_FPS);
+    if (fps <= 0.0)
+        fps = config.getFrameRate();
+    const int width = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    const int height = static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    TrackerModule referenceTracker(config), candidateTracker(config);
+    CountingLineModule referenceCounter(width, height, fps, config), candidateCounter(width, height, fps, config);
+
+    result = Result();
+    cv::Mat frame;
+    const double frameMs = 1000.0 / fps;
+    while (capture.read(frame))
+    {
+        const double frameTimeMs = result.frames * frameMs;
+        const double frameIndex = static_cast<double>(result.frames);
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<Detection> detections = detector.detect(frame);
+        result.referenceDetectMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // 计数器内存中只保留最近的记录，越线帧号在这里自行收集
+        result.reference.insert(result.reference.end(),
+                                referenceCounter.updateCounting(referenceTracker.update(detections), frameTimeMs, 0.0), frameIndex);
+        result.candidate.insert(result.candidate.end(),
+                                candidateCounter.updateCounting(candidate(frame, detections, candidateTracker), frameTimeMs, 0.0), frameIndex);
+        result.frames++;
+    }
+
+    result.matched = matchCrossings(result.reference, result.candidate, tolerance);
+    return true;
+}
+
+size_t CountingEvaluation::matchCrossings(const std::vector<double> &reference, const std::vector<double> &candidate, double tolerance)
+{
+    size_t matched = 0, j = 0;
+    for (double frame : reference)
+    {
+        while (j < candidate.size() && candidate[j] < frame - tolerance)
+            j++;
+        if (j < candidate.size() && candidate[j] <= frame + tolerance)
+        {
+            matched++;
+            j++;
+        }
+    }
+    return matched;
+}
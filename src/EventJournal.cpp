@@ -0,0 +1,309 @@
+﻿#include "EventJournal.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    constexpr char kMagic[4] = {'H', 'K', 'E', 'J'};
+    constexpr int kIdleSleepMs = 5; // 队列空时写入线程的轮询间隔
+
+    int64_t unixTimeUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    template <typename T>
+    void putLe(uint8_t *dst, T value)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+            dst[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+    }
+
+    template <typename T>
+    T getLe(const uint8_t *src)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            value |= static_cast<uint64_t>(src[i]) << (8 * i);
+        return static_cast<T>(value);
+    }
+}
+
+EventJournal::~EventJournal()
+{
+    stop();
+}
+
+bool EventJournal::start(const Params &params)
+{
+    if (running_)
+        return true;
+    params_ = params;
+
+    // 已有文件：校验文件头，截掉残缺的尾部记录，序号接续
+    std::error_code ec;
+    bool append = std::filesystem::exists(params_.path, ec) && std::filesystem::file_size(params_.path, ec) > 0;
+    if (append && std::filesystem::file_size(params_.path, ec) < kFileHeaderSize)
+    {
+        // 写文件头时中断留下的残缺文件头：与残缺的尾部记录一样丢弃，按新文件重写
+        std::cout << "[EventJournal] 文件头不完整，重新创建: " << params_.path << std::endl;
+        append = false;
+    }
+    if (append)
+    {
+        uint64_t validBytes = 0;
+        uint64_t lastSeq = 0, records = 0;
+        if (!read(params_.path, [&](const Record &record) { lastSeq = record.seq; records++; }, &validBytes))
+        {
+            std::cerr << "[EventJournal] 已有文件不是事件日志: " << params_.path << std::endl;
+            return false;
+        }
+        if (validBytes < std::filesystem::file_size(params_.path, ec))
+        {
+            std::filesystem::resize_file(params_.path, validBytes, ec);
+            std::cout << "[EventJournal] 截掉残缺的尾部记录，保留 " << validBytes << " 字节" << std::endl;
+        }
+        nextSeq_ = records > 0 ? lastSeq + 1 : 0;
+    }
+
+    file_ = std::fopen(params_.path.c_str(), append ? "ab" : "wb");
+    if (!file_)
+    {
+        std::cerr << "[EventJournal] 无法打开事件日志文件: " << params_.path << std::endl;
+        return false;
+    }
+    if (!append)
+    {
+        uint8_t header[kFileHeaderSize];
+        std::memcpy(header, kMagic, 4);
+        putLe<uint32_t>(header + 4, kVersion);
+        putLe<int64_t>(header + 8, unixTimeUs());
+        std::fwrite(header, 1, sizeof(header), file_);
+        unsynced_ = true;
+    }
+
+    queue_ = std::make_unique<MpscQueue<Event>>(params_.queueCapacity);
+    running_ = true;
+    thread_ = std::thread(&EventJournal::run, this);
+    std::cout << "[EventJournal] 事件日志: " << params_.path << "，起始序号 " << nextSeq_ << "，队列容量 "
+              << queue_->capacity() << "，落盘间隔 " << params_.fsyncIntervalMs << " ms" << std::endl;
+    return true;
+}
+
+void EventJournal::stop()
+{
+    if (!running_)
+        return;
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+
+    // 写入线程退出后生产者可能仍有少量事件入队
+    Event event;
+    while (queue_->tryPop(event))
+        write(event);
+    sync();
+    std::fclose(file_);
+    file_ = nullptr;
+    std::cout << "[EventJournal] 事件日志已关闭，共写入 " << nextSeq_ << " 条，丢弃 " << droppedEvents() << " 条" << std::endl;
+}
+
+template <typename Payload>
+bool EventJournal::enqueue(EventType type, const Payload &payload)
+{
+    static_assert(sizeof(Payload) <= kMaxPayload, "payload too large");
+    if (!running_)
+        return false;
+    Event event;
+    event.type = type;
+    event.size = static_cast<uint16_t>(sizeof(Payload));
+    event.timeUs = unixTimeUs();
+    std::memcpy(event.payload, &payload, sizeof(Payload));
+    if (!queue_->tryPush(event))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool EventJournal::logCrossing(int cameraId, int trackId, int sequenceId, double processingTimeMs, double frameTimeMs, double realTimeMs)
+{
+    CrossingEvent payload;
+    payload.cameraId = static_cast<uint8_t>(cameraId);
+    payload.trackId = trackId;
+    payload.sequenceId = sequenceId;
+    payload.processingTimeMs = processingTimeMs;
+    payload.frameTimeMs = frameTimeMs;
+    payload.realTimeMs = realTimeMs;
+    return enqueue(EventType::Crossing, payload);
+}
+
+bool EventJournal::logThermalDetection(int cameraId, int spotId, uint64_t frameSeq, float x, float y, float w, float h, float alarmThreshold)
+{
+    ThermalDetectionEvent payload;
+    payload.cameraId = static_cast<uint8_t>(cameraId);
+    payload.spotId = spotId;
+    payload.frameSeq = frameSeq;
+    payload.x = x;
+    payload.y = y;
+    payload.w = w;
+    payload.h = h;
+    payload.alarmThreshold = alarmThreshold;
+    return enqueue(EventType::ThermalDetection, payload);
+}
+
+bool EventJournal::logReportPacket(const uint8_t flags[4], bool sent, size_t clientCount, const std::vector<uint8_t> &packet)
+{
+    ReportPacketEvent payload = {};
+    std::memcpy(payload.flags, flags, 4);
+    payload.sent = sent ? 1 : 0;
+    payload.clientCount = static_cast<uint16_t>((std::min)(clientCount, static_cast<size_t>(UINT16_MAX)));
+    payload.packetSize = static_cast<uint16_t>((std::min)(packet.size(), static_cast<size_t>(UINT16_MAX)));
+    std::memcpy(payload.packet, packet.data(), (std::min)(packet.size(), sizeof(payload.packet)));
+    return enqueue(EventType::ReportPacket, payload);
+}
+
+void EventJournal::run()
+{
+    auto lastSync = std::chrono::steady_clock::now();
+    uint64_t reportedDrops = 0;
+    Event event;
+    while (running_)
+    {
+        bool wrote = false;
+        while (queue_->tryPop(event))
+        {
+            write(event);
+            wrote = true;
+        }
+        if (wrote)
+            std::fflush(file_);
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastSync >= std::chrono::milliseconds(params_.fsyncIntervalMs))
+        {
+            sync();
+            lastSync = now;
+            const uint64_t drops = droppedEvents();
+            if (drops != reportedDrops)
+            {
+                std::cerr << "[EventJournal] 队列已满，累计丢弃 " << drops << " 条事件" << std::endl;
+                reportedDrops = drops;
+            }
+        }
+        if (!wrote)
+            std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleepMs));
+    }
+}
+
+void EventJournal::write(const Event &event)
+{
+    uint8_t header[kRecordHeaderSize];
+    putLe<uint16_t>(header, static_cast<uint16_t>(event.type));
+    putLe<uint16_t>(header + 2, event.size);
+    putLe<uint64_t>(header + 8, nextSeq_);
+    putLe<int64_t>(header + 16, event.timeUs);
+    const uint32_t crc = crc32(crc32(0, header + 8, 16), event.payload, event.size);
+    putLe<uint32_t>(header + 4, crc);
+    std::fwrite(header, 1, sizeof(header), file_);
+    std::fwrite(event.payload, 1, event.size, file_);
+    nextSeq_++;
+    unsynced_ = true;
+}
+
+void EventJournal::sync()
+{
+    if (!unsynced_)
+        return;
+    std::fflush(file_);
+#ifdef _WIN32
+    _commit(_fileno(file_));
+#else
+    fsync(fileno(file_));
+#endif
+    unsynced_ = false;
+}
+
+bool EventJournal::read(const std::string &path, const std::function<void(const Record &)> &callback, uint64_t *validBytes)
+{
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[kRecordHeaderSize];
+    if (std::fread(header, 1, kFileHeaderSize, file) != kFileHeaderSize || std::memcmp(header, kMagic, 4) != 0 ||
+        getLe<uint32_t>(header + 4) != kVersion)
+    {
+        std::fclose(file);
+        return false;
+    }
+
+    uint64_t offset = kFileHeaderSize;
+    std::vector<uint8_t> payload(UINT16_MAX);
+    while (std::fread(header, 1, kRecordHeaderSize, file) == kRecordHeaderSize)
+    {
+        Record record;
+        record.type = static_cast<EventType>(getLe<uint16_t>(header));
+        record.size = getLe<uint16_t>(header + 2);
+        record.seq = getLe<uint64_t>(header + 8);
+        record.timeUs = getLe<int64_t>(header + 16);
+        record.payload = payload.data();
+        if (std::fread(payload.data(), 1, record.size, file) != record.size ||
+            crc32(crc32(0, header + 8, 16), payload.data(), record.size) != getLe<uint32_t>(header + 4))
+        {
+            break;
+        }
+        offset += kRecordHeaderSize + record.size;
+        callback(record);
+    }
+    std::fclose(file);
+    if (validBytes)
+        *validBytes = offset;
+    return true;
+}
+
+const char *EventJournal::typeName(EventType type)
+{
+    switch (type)
+    {
+    case EventType::Crossing:
+        return "crossing";
+    case EventType::ThermalDetection:
+        return "thermal_detection";
+    case EventType::ReportPacket:
+        return "report_packet";
+    }
+    return "unknown";
+}
+
+uint32_t EventJournal::crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    static const auto table = []
+    {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
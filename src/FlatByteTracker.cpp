@@ -0,0 +1,675 @@
+﻿#include "FlatByteTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "BYTETracker.h"
+
+namespace
+{
+    // 以下常量取自预编译的 bytetrack.lib（与 ByteTrack 上游源码中的 1/20、1/160、0.15 不同）
+    constexpr float kStdWeightPosition = 1.0f / 40;
+    constexpr float kStdWeightVelocity = 1.0f / 320;
+    constexpr float kDuplicateDistance = 0.5f; // remove_duplicate_stracks 的IoU距离阈值
+}
+
+FlatByteTracker::FlatByteTracker(const Params &params)
+    : params_(params)
+{
+    params_.capacity = (std::max)(1, params_.capacity);
+    maxTimeLost_ = static_cast<int>(params_.frameRate / 30.0 * params_.trackBuffer);
+
+    const size_t capacity = static_cast<size_t>(params_.capacity);
+    mean_.resize(capacity);
+    cova_.resize(capacity);
+    tlbr_.resize(capacity);
+    id_.resize(capacity);
+    frameId_.resize(capacity);
+    startFrame_.resize(capacity);
+    removedFrame_.resize(capacity);
+    listedFrame_.assign(capacity, 0);
+    classId_.resize(capacity);
+    score_.resize(capacity);
+    state_.resize(capacity);
+    activated_.resize(capacity);
+    reported_.resize(capacity);
+    freeSlots_.reserve(capacity);
+    for (int slot = params_.capacity - 1; slot >= 0; slot--)
+    {
+        freeSlots_.push_back(slot);
+    }
+    tracked_.reserve(capacity);
+    lost_.reserve(capacity);
+
+    motion_.setIdentity();
+    for (int i = 0; i < 4; i++)
+    {
+        motion_(i, 4 + i) = 1.0f;
+    }
+    update_.setIdentity();
+}
+
+int FlatByteTracker::allocate()
+{
+    if (freeSlots_.empty())
+        return -1;
+    const int slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    return slot;
+}
+
+void FlatByteTracker::refreshTlbr(int slot)
+{
+    // 与 STrack::static_tlwh / static_tlbr 相同的计算顺序
+    const Mean &mean = mean_[slot];
+    Box &box = tlbr_[slot];
+    box[0] = mean(0);
+    box[1] = mean(1);
+    box[2] = mean(2);
+    box[3] = mean(3);
+    box[2] *= box[3];
+    box[0] -= box[2] / 2;
+    box[1] -= box[3] / 2;
+    box[2] += box[0];
+    box[3] += box[1];
+}
+
+void FlatByteTracker::initiate(int slot, const Box &tlwh)
+{
+    const float h = tlwh[3];
+    Mean &mean = mean_[slot];
+    mean << tlwh[0] + tlwh[2] / 2, tlwh[1] + tlwh[3] / 2, tlwh[2] / tlwh[3], h, 0, 0, 0, 0;
+
+    Mean stdDev;
+    stdDev << 2 * kStdWeightPosition * h, 2 * kStdWeightPosition * h, 1e-2f, 2 * kStdWeightPosition * h,
+        10 * kStdWeightVelocity * h, 10 * kStdWeightVelocity * h, 1e-5f, 10 * kStdWeightVelocity * h;
+    Mean var = stdDev.array().square();
+    cova_[slot] = var.asDiagonal();
+}
+
+void FlatByteTracker::predict(const std::vector<int> &slots)
+{
+    for (int slot : slots)
+    {
+        Mean &mean = mean_[slot];
+        Cova &cova = cova_[slot];
+        // bytetrack.lib 的 multi_predict 不清零丢失轨迹的高度速度
+        const float wp = kStdWeightPosition * mean(3);
+        const float wv = kStdWeightVelocity * mean(3);
+        Mean stdDev;
+        stdDev << wp, wp, 1e-2f, wp, wv, wv, 1e-5f, wv;
+        Mean var = stdDev.array().square();
+        Cova motionCov = var.asDiagonal();
+
+        Mean predicted = motion_ * mean.transpose();
+        Cova predictedCov = motion_ * cova * motion_.transpose();
+        predictedCov += motionCov;
+        mean = predicted;
+        cova = predictedCov;
+        refreshTlbr(slot);
+    }
+}
+
+void FlatByteTracker::applyUpdates()
+{
+    for (const auto &entry : pending_)
+    {
+        const int slot = entry.first;
+        const Box &tlwh = detTlwh_[entry.second];
+        Mean &mean = mean_[slot];
+        Cova &cova = cova_[slot];
+
+        Eigen::Matrix<float, 1, 4, Eigen::RowMajor> measurement;
+        measurement << tlwh[0] + tlwh[2] / 2, tlwh[1] + tlwh[3] / 2, tlwh[2] / tlwh[3], tlwh[3];
+
+        // 投影到观测空间
+        const float wp = kStdWeightPosition * mean(3);
+        Eigen::Matrix<float, 1, 4, Eigen::RowMajor> stdDev;
+        stdDev << wp, wp, 1e-1f, wp;
+        Eigen::Matrix<float, 1, 4, Eigen::RowMajor> projectedMean = update_ * mean.transpose();
+        Eigen::Matrix<float, 4, 4, Eigen::RowMajor> projectedCov = update_ * cova * update_.transpose();
+        Eigen::Matrix<float, 4, 4> innovationCov = stdDev.asDiagonal();
+        innovationCov = innovationCov.array().square().matrix();
+        projectedCov += innovationCov;
+
+        Eigen::Matrix<float, 4, 8> b = (cova * update_.transpose()).transpose();
+        Eigen::Matrix<float, 8, 4> gain = (projectedCov.llt().solve(b)).transpose();
+        Eigen::Matrix<float, 1, 4> innovation = measurement - projectedMean;
+        Mean correction = innovation * gain.transpose();
+        mean = (mean.array() + correction.array()).matrix();
+        cova = cova - gain * projectedCov * gain.transpose();
+        refreshTlbr(slot);
+    }
+}
+
+float FlatByteTracker::iou(const Box &a, const Box &b)
+{
+    // 与 BYTETracker::ious 相同的 +1 像素约定
+    const float iw = (std::min)(a[2], b[2]) - (std::max)(a[0], b[0]) + 1;
+    if (iw <= 0)
+        return 0.0f;
+    const float ih = (std::min)(a[3], b[3]) - (std::max)(a[1], b[1]) + 1;
+    if (ih <= 0)
+        return 0.0f;
+    const float areaB = (b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+    const float ua = (a[2] - a[0] + 1) * (a[3] - a[1] + 1) + areaB - iw * ih;
+    return iw * ih / ua;
+}
+
+void FlatByteTracker::associate(const std::vector<int> &trackSlots, const std::vector<int> &dets, float thresh)
+{
+    matches_.clear();
+    unmatchedRows_.clear();
+    unmatchedCols_.clear();
+    const int rows = static_cast<int>(trackSlots.size());
+    const int cols = static_cast<int>(dets.size());
+    if (rows == 0 || cols == 0)
+    {
+        for (int i = 0; i < rows; i++)
+            unmatchedRows_.push_back(i);
+        for (int j = 0; j < cols; j++)
+            unmatchedCols_.push_back(j);
+        return;
+    }
+
+    cost_.resize(static_cast<size_t>(rows) * cols);
+    for (int i = 0; i < rows; i++)
+    {
+        const Box &box = tlbr_[trackSlots[i]];
+        float *row = cost_.data() + static_cast<size_t>(i) * cols;
+        for (int j = 0; j < cols; j++)
+        {
+            row[j] = 1 - iou(box, detTlbr_[dets[j]]);
+        }
+    }
+
+    lapjv_.solveRect(cost_.data(), rows, cols, thresh, rowsol_, colsol_);
+    for (int i = 0; i < rows; i++)
+    {
+        if (rowsol_[i] >= 0)
+            matches_.emplace_back(i, rowsol_[i]);
+        else
+            unmatchedRows_.push_back(i);
+    }
+    for (int j = 0; j < cols; j++)
+    {
+        if (colsol_[j] < 0)
+            unmatchedCols_.push_back(j);
+    }
+}
+
+void FlatByteTracker::step(const std::vector<Detection> &detections)
+{
+    frame_++;
+
+    // 检测框转换与 Object → STrack 相同：x1y1x2y2 → tlwh → tlbr
+    const size_t count = detections.size();
+    detTlwh_.resize(count);
+    detTlbr_.resize(count);
+    detScore_.resize(count);
+    detClass_.resize(count);
+    high_.clear();
+    low_.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        const Detection &det = detections[i];
+        const float x = det.bbox[0], y = det.bbox[1];
+        const float right = x + (det.bbox[2] - det.bbox[0]);
+        const float bottom = y + (det.bbox[3] - det.bbox[1]);
+        Box &tlwh = detTlwh_[i];
+        tlwh = {x, y, right - x, bottom - y};
+        detTlbr_[i] = {tlwh[0], tlwh[1], tlwh[2] + tlwh[0], tlwh[3] + tlwh[1]};
+        detScore_[i] = det.conf;
+        detClass_[i] = det.classId;
+        (det.conf >= params_.trackThresh ? high_ : low_).push_back(static_cast<int>(i));
+    }
+
+    // 已确认的跟踪中轨迹与丢失轨迹一起预测
+    unconfirmed_.clear();
+    pool_.clear();
+    for (int slot : tracked_)
+    {
+        (activated_[slot] ? pool_ : unconfirmed_).push_back(slot);
+    }
+    pool_.insert(pool_.end(), lost_.begin(), lost_.end());
+    predict(pool_);
+
+    pending_.clear();
+    refind_.clear();
+    auto match = [&](int slot, int det) {
+        if (state_[slot] != kTracked)
+            refind_.push_back(slot);
+        state_[slot] = kTracked;
+        activated_[slot] = 1;
+        frameId_[slot] = frame_;
+        score_[slot] = detScore_[det];
+        classId_[slot] = detClass_[det];
+        pending_.emplace_back(slot, det);
+    };
+
+    // 第一次关联：高分检测
+    associate(pool_, high_, params_.matchThresh);
+    for (const auto &m : matches_)
+    {
+        match(pool_[m.first], high_[m.second]);
+    }
+    remaining_.clear();
+    for (int j : unmatchedCols_)
+    {
+        remaining_.push_back(high_[j]);
+    }
+    rTracked_.clear();
+    for (int i : unmatchedRows_)
+    {
+        if (state_[pool_[i]] == kTracked)
+            rTracked_.push_back(pool_[i]);
+    }
+
+    // 第二次关联：低分检测与未匹配的跟踪中轨迹
+    associate(rTracked_, low_, params_.lowMatchThresh);
+    for (const auto &m : matches_)
+    {
+        match(rTracked_[m.first], low_[m.second]);
+    }
+    newLost_.clear();
+    for (int i : unmatchedRows_)
+    {
+        const int slot = rTracked_[i];
+        state_[slot] = kLost;
+        newLost_.push_back(slot);
+    }
+
+    // 未确认轨迹与剩余高分检测
+    associate(unconfirmed_, remaining_, params_.unconfirmedThresh);
+    for (const auto &m : matches_)
+    {
+        match(unconfirmed_[m.first], remaining_[m.second]);
+    }
+    for (int i : unmatchedRows_)
+    {
+        const int slot = unconfirmed_[i];
+        state_[slot] = kRemoved;
+        if (removedFrame_[slot] == 0)
+            removedFrame_[slot] = frame_;
+    }
+
+    // 新建轨迹
+    newTracks_.clear();
+    for (int j : unmatchedCols_)
+    {
+        const int det = remaining_[j];
+        if (detScore_[det] < params_.highThresh)
+            continue;
+        const int slot = allocate();
+        if (slot < 0)
+        {
+            if (droppedTracks_++ % 1000 == 0)
+            {
+                std::cerr << "[FlatByteTracker] 轨迹表已满（容量 " << params_.capacity << "），新目标被丢弃，累计: "
+                          << droppedTracks_ << std::endl;
+            }
+            continue;
+        }
+        initiate(slot, detTlwh_[det]);
+        tlbr_[slot] = detTlbr_[det];
+        id_[slot] = ++nextId_;
+        state_[slot] = kTracked;
+        activated_[slot] = 1; // bytetrack.lib 的 STrack::activate 总是置为已激活，新轨迹当帧即输出
+        frameId_[slot] = frame_;
+        startFrame_[slot] = frame_;
+        removedFrame_[slot] = 0;
+        classId_[slot] = detClass_[det];
+        score_[slot] = detScore_[det];
+        reported_[slot] = 0;
+        newTracks_.push_back(slot);
+    }
+
+    // 卡尔曼修正批量执行（关联只依赖预测框，修正顺序不影响结果）
+    applyUpdates();
+
+    // 丢失超时的轨迹标记删除
+    for (int slot : lost_)
+    {
+        if (frame_ - frameId_[slot] > maxTimeLost_)
+        {
+            state_[slot] = kRemoved;
+            if (removedFrame_[slot] == 0)
+                removedFrame_[slot] = frame_;
+        }
+    }
+
+    // 记录本帧前在列表中的槽位，列表重建后未出现的槽位回收
+    candidates_.clear();
+    candidates_.insert(candidates_.end(), tracked_.begin(), tracked_.end());
+    candidates_.insert(candidates_.end(), lost_.begin(), lost_.end());
+    candidates_.insert(candidates_.end(), newTracks_.begin(), newTracks_.end());
+
+    // 跟踪列表：仍在跟踪的原有轨迹 + 新轨迹 + 找回的轨迹
+    scratch_.clear();
+    for (int slot : tracked_)
+    {
+        if (state_[slot] == kTracked)
+            scratch_.push_back(slot);
+    }
+    scratch_.insert(scratch_.end(), newTracks_.begin(), newTracks_.end());
+    scratch_.insert(scratch_.end(), refind_.begin(), refind_.end());
+    tracked_.swap(scratch_);
+
+    // 丢失列表：未找回的原有丢失轨迹 + 本帧丢失的轨迹，去掉之前帧已删除的，按ID排序
+    // （BYTETracker 在本帧删除的轨迹要到下一帧才从丢失列表中去掉，期间仍参与关联）
+    scratch_.clear();
+    for (int slot : lost_)
+    {
+        if (state_[slot] != kTracked)
+            scratch_.push_back(slot);
+    }
+    scratch_.insert(scratch_.end(), newLost_.begin(), newLost_.end());
+    lost_.clear();
+    for (int slot : scratch_)
+    {
+        if (removedFrame_[slot] == 0 || removedFrame_[slot] >= frame_)
+            lost_.push_back(slot);
+    }
+    std::sort(lost_.begin(), lost_.end(), [&](int a, int b) { return id_[a] < id_[b]; });
+
+    // 跟踪与丢失列表中重叠的轨迹只保留跟踪时间较长的一个
+    dupTracked_.assign(tracked_.size(), 0);
+    dupLost_.assign(lost_.size(), 0);
+    for (size_t i = 0; i < tracked_.size(); i++)
+    {
+        const int p = tracked_[i];
+        for (size_t j = 0; j < lost_.size(); j++)
+        {
+            const int q = lost_[j];
+            if (1 - iou(tlbr_[p], tlbr_[q]) < kDuplicateDistance)
+            {
+                if (frameId_[p] - startFrame_[p] > frameId_[q] - startFrame_[q])
+                    dupLost_[j] = 1;
+                else
+                    dupTracked_[i] = 1;
+            }
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < tracked_.size(); i++)
+    {
+        if (!dupTracked_[i])
+            tracked_[kept++] = tracked_[i];
+    }
+    tracked_.resize(kept);
+    kept = 0;
+    for (size_t j = 0; j < lost_.size(); j++)
+    {
+        if (!dupLost_[j])
+            lost_[kept++] = lost_[j];
+    }
+    lost_.resize(kept);
+
+    for (int slot : tracked_)
+        listedFrame_[slot] = frame_;
+    for (int slot : lost_)
+        listedFrame_[slot] = frame_;
+    removedIds_.clear();
+    for (int slot : candidates_)
+    {
+        if (listedFrame_[slot] != frame_)
+        {
+            freeSlots_.push_back(slot);
+            removedIds_.push_back(id_[slot]);
+        }
+    }
+}
+
+void FlatByteTracker::activeTracks(std::vector<TrackResult> &results)
+{
+    results.clear();
+    for (int slot : tracked_)
+    {
+        if (!activated_[slot])
+            continue;
+        TrackResult track;
+        track.track_id = id_[slot];
+        for (int k = 0; k < 4; k++)
+        {
+            track.bbox[k] = tlbr_[slot][k];
+        }
+        track.conf = score_[slot];
+        track.classId = classId_[slot];
+        track.is_new = !reported_[slot];
+        track.is_lost = false;
+        reported_[slot] = 1;
+        results.push_back(track);
+    }
+}
+
+void FlatByteTracker::filterDetections(const std::vector<Detection> &detections, std::vector<Detection> &filtered) const
+{
+    filtered.clear();
+    for (const Detection &det : detections)
+    {
+        if (params_.trackClass >= 0 && det.classId != params_.trackClass)
+            continue;
+        if ((det.bbox[2] - det.bbox[0]) * (det.bbox[3] - det.bbox[1]) < params_.minTargetArea)
+            continue;
+        filtered.push_back(det);
+    }
+}
+
+void FlatByteTracker::update(const std::vector<Detection> &detections, std::vector<TrackResult> &results)
+{
+    filterDetections(detections, filtered_);
+    step(filtered_);
+    activeTracks(results);
+}
+
+void FlatByteTracker::writeTraceFrame(std::ostream &out, uint64_t frameIndex, const std::vector<Detection> &detections)
+{
+    out << "frame " << frameIndex << " " << detections.size() << "\n";
+    for (const Detection &det : detections)
+    {
+        out << det.bbox[0] << " " << det.bbox[1] << " " << det.bbox[2] << " " << det.bbox[3] << " " << det.conf
+            << " " << det.classId << "\n";
+    }
+}
+
+bool FlatByteTracker::loadTrace(const std::string &path, std::vector<std::vector<Detection>> &frames)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        std::cerr << "[FlatByteTracker] 无法打开检测序列: " << path << std::endl;
+        return false;
+    }
+
+    frames.clear();
+    std::string tag;
+    uint64_t frameIndex = 0;
+    size_t count = 0;
+    while (in >> tag >> frameIndex >> count)
+    {
+        if (tag != "frame")
+            break;
+        std::vector<Detection> detections(count);
+        for (Detection &det : detections)
+        {
+            in >> det.bbox[0] >> det.bbox[1] >> det.bbox[2] >> det.bbox[3] >> det.conf >> det.classId;
+        }
+        if (!in)
+            break;
+        frames.push_back(std::move(detections));
+    }
+    if (!in.eof())
+    {
+        std::cerr << "[FlatByteTracker] 检测序列格式错误，第 " << frames.size() + 1 << " 帧: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+namespace
+{
+    std::vector<Object> toObjects(const std::vector<Detection> &detections)
+    {
+        std::vector<Object> objects(detections.size());
+        for (size_t i = 0; i < detections.size(); i++)
+        {
+            const Detection &det = detections[i];
+            objects[i].rect = cv::Rect_<float>(det.bbox[0], det.bbox[1], det.bbox[2] - det.bbox[0], det.bbox[3] - det.bbox[1]);
+            objects[i].label = det.classId;
+            objects[i].prob = det.conf;
+        }
+        return objects;
+    }
+}
+
+bool FlatByteTracker::compareWithByteTrack(const std::string &tracePath, const Params &params)
+{
+    std::vector<std::vector<Detection>> frames;
+    if (!loadTrace(tracePath, frames))
+        return false;
+
+    BYTETracker reference(params.frameRate, params.trackBuffer, params.trackThresh, params.highThresh, params.matchThresh,
+                          params.unconfirmedThresh, params.lowMatchThresh);
+    FlatByteTracker flat(params);
+    std::vector<TrackResult> flatTracks;
+    std::vector<Detection> filtered;
+
+    // BYTETracker 的ID从全局计数器继续编号，两者ID之差应保持不变
+    bool offsetKnown = false;
+    int idOffset = 0;
+    size_t mismatchedFrames = 0, outputs = 0;
+    float maxBoxDelta = 0.0f;
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        // 两者输入相同的过滤后检测
+        flat.filterDetections(frames[f], filtered);
+        const std::vector<STrack> refTracks = reference.update(toObjects(filtered));
+        flat.step(filtered);
+        flat.activeTracks(flatTracks);
+        outputs += flatTracks.size();
+
+        bool consistent = refTracks.size() == flatTracks.size();
+        for (size_t i = 0; consistent && i < refTracks.size(); i++)
+        {
+            if (!offsetKnown)
+            {
+                idOffset = refTracks[i].track_id - flatTracks[i].track_id;
+                offsetKnown = true;
+            }
+            if (refTracks[i].track_id != flatTracks[i].track_id + idOffset)
+            {
+                consistent = false;
+                break;
+            }
+            for (int k = 0; k < 4; k++)
+            {
+                maxBoxDelta = (std::max)(maxBoxDelta, std::fabs(refTracks[i].tlbr[k] - flatTracks[i].bbox[k]));
+            }
+        }
+        if (!consistent)
+        {
+            if (mismatchedFrames == 0)
+            {
+                std::cout << "[FlatByteTracker] 第 " << f + 1 << " 帧跟踪结果不一致（BYTETracker " << refTracks.size()
+                          << " 个, 扁平核心 " << flatTracks.size() << " 个）" << std::endl;
+            }
+            mismatchedFrames++;
+        }
+    }
+
+    std::cout << "[FlatByteTracker] 与BYTETracker对比 " << tracePath << " - 帧数: " << frames.size()
+              << ", 输出轨迹: " << outputs << ", 跟踪ID不一致的帧: " << mismatchedFrames
+              << ", 最大框偏差: " << maxBoxDelta << " px" << std::endl;
+    return mismatchedFrames == 0;
+}
+
+void FlatByteTracker::runBenchmark(const Params &params, int frames)
+{
+    const int counts[] = {10, 100, 500};
+    const float width = 1920.0f, height = 1080.0f;
+    frames = (std::max)(1, frames);
+
+    for (int count : counts)
+    {
+        // 合成场景：匀速运动的目标加位置抖动，部分帧漏检或低分，出画后从另一侧重新进入
+        std::mt19937 rng(12345);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::normal_distribution<float> jitter(0.0f, 1.0f);
+        struct Target
+        {
+            float x, y, vx, vy, w, h;
+        };
+        std::vector<Target> targets(count);
+        for (Target &t : targets)
+        {
+            t.w = 20.0f + 40.0f * uniform(rng);
+            t.h = 40.0f + 80.0f * uniform(rng);
+            t.x = (width - t.w) * uniform(rng);
+            t.y = (height - t.h) * uniform(rng);
+            t.vx = 8.0f * (uniform(rng) - 0.5f);
+            t.vy = 4.0f * (uniform(rng) - 0.5f);
+        }
+
+        std::vector<std::vector<Detection>> sequence(frames);
+        for (std::vector<Detection> &detections : sequence)
+        {
+            for (Target &t : targets)
+            {
+                t.x += t.vx;
+                t.y += t.vy;
+                if (t.x < -t.w || t.x > width)
+                    t.x = t.vx > 0 ? -t.w : width;
+                if (t.y < -t.h || t.y > height)
+                    t.y = t.vy > 0 ? -t.h : height;
+
+                const float r = uniform(rng);
+                if (r < 0.05f)
+                    continue;
+                Detection det;
+                det.bbox[0] = t.x + jitter(rng);
+                det.bbox[1] = t.y + jitter(rng);
+                det.bbox[2] = det.bbox[0] + t.w + jitter(rng);
+                det.bbox[3] = det.bbox[1] + t.h + jitter(rng);
+                det.conf = r < 0.2f ? 0.3f : 0.8f;
+                det.classId = 0;
+                detections.push_back(det);
+            }
+        }
+        std::vector<std::vector<Object>> objects(frames);
+        for (int f = 0; f < frames; f++)
+        {
+            objects[f] = toObjects(sequence[f]);
+        }
+
+        BYTETracker reference(params.frameRate, params.trackBuffer, params.trackThresh, params.highThresh, params.matchThresh,
+                              params.unconfirmedThresh, params.lowMatchThresh);
+        size_t refOutputs = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+        {
+            refOutputs += reference.update(objects[f]).size();
+        }
+        const double refUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        Params flatParams = params;
+        flatParams.capacity = (std::max)(params.capacity, count * 4);
+        FlatByteTracker flat(flatParams);
+        std::vector<TrackResult> tracks;
+        size_t flatOutputs = 0;
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+        {
+            flat.step(sequence[f]);
+            flat.activeTracks(tracks);
+            flatOutputs += tracks.size();
+        }
+        const double flatUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+
+        std::cout << "[FlatByteTracker] 追踪耗时对比 - 目标数: " << count << ", BYTETracker: " << refUs
+                  << " us/帧, 扁平核心: " << flatUs << " us/帧 (加速 " << (flatUs > 0.0 ? refUs / flatUs : 0.0)
+                  << " 倍), 输出轨迹: " << refOutputs << " / " << flatOutputs << std::endl;
+    }
+}
@@ -0,0 +1,447 @@
+﻿#include "FrameBus.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "帧总线要求共享内存中的原子变量无锁");
+static_assert(sizeof(FrameBusSlot) <= FrameBusSlot::kDataOffset, "槽位头部超出数据偏移");
+
+namespace
+{
+    constexpr size_t kPageSize = 4096;
+    constexpr int kMaxWaitSliceMs = 10; // 单次等待上限，超时后重新检查（覆盖错过唤醒与写端重启）
+
+    // 与 steadyClockUs 相同的时钟
+    int64_t nowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+#ifdef _WIN32
+    std::string objectName(const std::string &name, const char *suffix = "")
+    {
+        return "Local\\" + name + suffix;
+    }
+#elif defined(__linux__)
+    void futexWake(std::atomic<uint32_t> *word)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    void futexWait(const std::atomic<uint32_t> *word, uint32_t expected, int timeoutMs)
+    {
+        timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000;
+        syscall(SYS_futex, reinterpret_cast<const uint32_t *>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+    }
+#endif
+}
+
+// ========== 写端 ==========
+
+FrameBusWriter::~FrameBusWriter()
+{
+    release();
+}
+
+void FrameBusWriter::configure(const std::string &name, int slotCount)
+{
+    release();
+    name_ = name;
+    slotCount_ = (std::max)(slotCount, 2);
+    failed_ = false;
+}
+
+bool FrameBusWriter::create(size_t frameBytes)
+{
+    const size_t headerBytes = kPageSize;
+    const size_t slotStride = alignUp(FrameBusSlot::kDataOffset + frameBytes, kPageSize);
+    const size_t totalBytes = headerBytes + slotStride * slotCount_;
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(totalBytes) >> 32),
+                                        static_cast<DWORD>(totalBytes & 0xFFFFFFFFu), objectName(name_).c_str());
+    if (!mapping)
+    {
+        std::cerr << "[FrameBus] 创建共享内存失败: " << name_ << "，错误码 " << GetLastError() << std::endl;
+        failed_ = true;
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, totalBytes);
+    if (!view)
+    {
+        // 已有同名共享内存（读端仍持有上次运行的映射）且小于本次所需大小
+        std::cerr << "[FrameBus] 映射共享内存失败: " << name_ << "，错误码 " << GetLastError() << std::endl;
+        CloseHandle(mapping);
+        failed_ = true;
+        return false;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        events_[i] = CreateEventA(nullptr, TRUE, FALSE, objectName(name_, i == 0 ? "_ev0" : "_ev1").c_str());
+    }
+    mapping_ = mapping;
+#else
+    const std::string shmName = "/" + name_;
+    fd_ = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd_ < 0 || ftruncate(fd_, static_cast<off_t>(totalBytes)) != 0)
+    {
+        std::cerr << "[FrameBus] 创建共享内存失败: " << shmName << std::endl;
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+        failed_ = true;
+        return false;
+    }
+    void *view = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED)
+    {
+        std::cerr << "[FrameBus] 映射共享内存失败: " << shmName << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        failed_ = true;
+        return false;
+    }
+#endif
+
+    base_ = static_cast<uint8_t *>(view);
+    mappedBytes_ = totalBytes;
+    header_ = reinterpret_cast<FrameBusHeader *>(base_);
+
+    // 先标记为无效再初始化（可能复用了上次运行留下的共享内存，读端仍在映射）
+    header_->magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->version = FrameBusHeader::kVersion;
+    header_->slotCount = static_cast<uint32_t>(slotCount_);
+    header_->headerBytes = static_cast<uint32_t>(headerBytes);
+    header_->slotStride = slotStride;
+    header_->slotCapacity = slotStride - FrameBusSlot::kDataOffset;
+    header_->sessionId = static_cast<uint64_t>(nowUs());
+    header_->latestSeq.store(0, std::memory_order_relaxed);
+    header_->wakeWord.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < slotCount_; i++)
+    {
+        // 上次运行中途退出的槽位序列号可能停在奇数，调整为偶数
+        auto *slot = reinterpret_cast<FrameBusSlot *>(base_ + headerBytes + slotStride * i);
+        const uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(sequence + (sequence & 1), std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = FrameBusHeader::kMagic;
+
+    std::cout << "[FrameBus] 已创建 " << name_ << "：" << slotCount_ << " 个槽位，每槽 " << header_->slotCapacity / 1024
+              << " KB，共 " << totalBytes / (1024 * 1024) << " MB" << std::endl;
+    return true;
+}
+
+void FrameBusWriter::release()
+{
+    if (header_)
+    {
+        // 标记写端已退出并唤醒等待中的读端
+        header_->magic = 0;
+        header_->wakeWord.fetch_add(1, std::memory_order_release);
+#ifdef _WIN32
+        for (void *&event : events_)
+        {
+            if (event)
+            {
+                SetEvent(event);
+                CloseHandle(event);
+                event = nullptr;
+            }
+        }
+        UnmapViewOfFile(base_);
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+#else
+#ifdef __linux__
+        futexWake(&header_->wakeWord);
+#endif
+        munmap(base_, mappedBytes_);
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(("/" + name_).c_str());
+#endif
+        std::cout << "[FrameBus] " << name_ << " 已关闭，发布 " << published_ << " 帧，丢弃 " << dropped_ << " 帧" << std::endl;
+    }
+    header_ = nullptr;
+    base_ = nullptr;
+    mappedBytes_ = 0;
+    seq_ = 0;
+}
+
+void FrameBusWriter::publish(const cv::Mat &frame, uint64_t frameSeq, int64_t captureTimeUs)
+{
+    if (name_.empty() || frame.empty())
+        return;
+
+    const size_t rowBytes = frame.cols * frame.elemSize();
+    const size_t bytes = rowBytes * frame.rows;
+    if (!header_ && (failed_ || !create(bytes)))
+    {
+        dropped_++;
+        return;
+    }
+    if (bytes > header_->slotCapacity)
+    {
+        if (dropped_++ == 0)
+        {
+            std::cerr << "[FrameBus] " << name_ << " 帧大小 " << frame.cols << "x" << frame.rows << " 超出槽位容量，丢弃" << std::endl;
+        }
+        return;
+    }
+
+    const uint64_t seq = ++seq_;
+    auto *slot = reinterpret_cast<FrameBusSlot *>(base_ + header_->headerBytes + header_->slotStride * (seq % header_->slotCount));
+    uint8_t *data = reinterpret_cast<uint8_t *>(slot) + FrameBusSlot::kDataOffset;
+
+    // 序列锁：先置为奇数，写完数据和元数据后再置为偶数
+    const uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (frame.isContinuous())
+    {
+        std::memcpy(data, frame.data, bytes);
+    }
+    else
+    {
+        for (int y = 0; y < frame.rows; y++)
+            std::memcpy(data + rowBytes * y, frame.ptr(y), rowBytes);
+    }
+    slot->bytes = static_cast<uint32_t>(bytes);
+    slot->busSeq = seq;
+    slot->frameSeq = frameSeq;
+    slot->captureTimeUs = captureTimeUs;
+    slot->width = frame.cols;
+    slot->height = frame.rows;
+    slot->type = frame.type();
+    slot->step = static_cast<int32_t>(rowBytes);
+    slot->publishTimeUs = nowUs();
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+
+    header_->latestSeq.store(seq, std::memory_order_release);
+    header_->wakeWord.store(static_cast<uint32_t>(seq), std::memory_order_release);
+#ifdef _WIN32
+    // 置位本帧对应的事件，复位下一帧的事件（等待下一帧的读端在下一次发布时被唤醒）
+    if (events_[0] && events_[1])
+    {
+        SetEvent(events_[seq & 1]);
+        ResetEvent(events_[(seq + 1) & 1]);
+    }
+#elif defined(__linux__)
+    futexWake(&header_->wakeWord);
+#endif
+    published_++;
+}
+
+// ========== 读端 ==========
+
+FrameBusReader::~FrameBusReader()
+{
+    close();
+}
+
+bool FrameBusReader::open(const std::string &name)
+{
+    close();
+    name_ = name;
+
+    size_t mappedBytes = 0;
+    const void *view = nullptr;
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName(name).c_str());
+    if (!mapping)
+        return false;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(view, &info, sizeof(info));
+    mappedBytes = info.RegionSize;
+    mapping_ = mapping;
+    for (int i = 0; i < 2; i++)
+    {
+        events_[i] = OpenEventA(SYNCHRONIZE, FALSE, objectName(name, i == 0 ? "_ev0" : "_ev1").c_str());
+    }
+#else
+    fd_ = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+    if (fd_ < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FrameBusHeader)))
+    {
+        close();
+        return false;
+    }
+    mappedBytes = static_cast<size_t>(st.st_size);
+    view = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+#endif
+
+    base_ = static_cast<const uint8_t *>(view);
+    mappedBytes_ = mappedBytes;
+    header_ = reinterpret_cast<const FrameBusHeader *>(base_);
+
+    // 写端尚未初始化完成或布局不兼容
+    const bool valid = header_->magic == FrameBusHeader::kMagic && header_->version == FrameBusHeader::kVersion &&
+                       header_->slotCount > 0 && header_->headerBytes + header_->slotStride * header_->slotCount <= mappedBytes_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+    sessionId_ = header_->sessionId;
+    lastSeq_ = 0;
+    return true;
+}
+
+void FrameBusReader::close()
+{
+#ifdef _WIN32
+    for (void *&event : events_)
+    {
+        if (event)
+            CloseHandle(event);
+        event = nullptr;
+    }
+    if (base_)
+        UnmapViewOfFile(base_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (base_)
+        munmap(const_cast<uint8_t *>(base_), mappedBytes_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+#endif
+    header_ = nullptr;
+    base_ = nullptr;
+    mappedBytes_ = 0;
+}
+
+bool FrameBusReader::wait(int timeoutMs)
+{
+    if (!header_)
+        return false;
+
+    const int64_t deadlineUs = nowUs() + static_cast<int64_t>(timeoutMs) * 1000;
+    for (;;)
+    {
+        const uint64_t latest = header_->latestSeq.load(std::memory_order_acquire);
+        if (latest != 0 && latest != lastSeq_)
+            return true;
+        if (writerRestarted())
+            return false;
+        const int64_t remainingUs = deadlineUs - nowUs();
+        if (remainingUs <= 0)
+            return false;
+        const int sliceMs = static_cast<int>((std::min)(static_cast<int64_t>(kMaxWaitSliceMs), (remainingUs + 999) / 1000));
+#ifdef _WIN32
+        if (events_[0] && events_[1])
+            WaitForSingleObject(events_[(lastSeq_ + 1) & 1], static_cast<DWORD>(sliceMs));
+        else
+            Sleep(1);
+#elif defined(__linux__)
+        futexWait(&header_->wakeWord, static_cast<uint32_t>(latest), sliceMs);
+#else
+        usleep(1000);
+#endif
+    }
+}
+
+bool FrameBusReader::acquire(View &view)
+{
+    if (!header_ || writerRestarted())
+        return false;
+
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        const uint64_t latest = header_->latestSeq.load(std::memory_order_acquire);
+        if (latest == 0 || latest == lastSeq_)
+            return false;
+
+        const int slotIndex = static_cast<int>(latest % header_->slotCount);
+        const auto *slot = reinterpret_cast<const FrameBusSlot *>(base_ + header_->headerBytes + header_->slotStride * slotIndex);
+        const uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            torn_++;
+            continue;
+        }
+        const uint64_t busSeq = slot->busSeq;
+        const uint32_t bytes = slot->bytes;
+        const int width = slot->width, height = slot->height, type = slot->type, step = slot->step;
+        const uint64_t frameSeq = slot->frameSeq;
+        const int64_t captureTimeUs = slot->captureTimeUs;
+        const int64_t publishTimeUs = slot->publishTimeUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != sequence || busSeq != latest)
+        {
+            // 读取期间写端已绕环覆盖该槽位，重新取最新帧
+            torn_++;
+            continue;
+        }
+        if (width <= 0 || height <= 0 || static_cast<uint64_t>(step) * height > bytes || bytes > header_->slotCapacity)
+            return false;
+
+        uint8_t *data = const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(slot) + FrameBusSlot::kDataOffset);
+        view.frame = cv::Mat(height, width, type, data, static_cast<size_t>(step));
+        view.busSeq = busSeq;
+        view.frameSeq = frameSeq;
+        view.captureTimeUs = captureTimeUs;
+        view.publishTimeUs = publishTimeUs;
+        view.skipped = lastSeq_ != 0 && latest > lastSeq_ ? latest - lastSeq_ - 1 : 0;
+        view.slot = slotIndex;
+        view.sequence = sequence;
+        lastSeq_ = latest;
+        return true;
+    }
+    return false;
+}
+
+bool FrameBusReader::validate(const View &view) const
+{
+    if (!header_ || view.slot < 0)
+        return false;
+    const auto *slot = reinterpret_cast<const FrameBusSlot *>(base_ + header_->headerBytes + header_->slotStride * view.slot);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+bool FrameBusReader::writerRestarted() const
+{
+    return header_ && (header_->magic != FrameBusHeader::kMagic || header_->sessionId != sessionId_);
+}
@@ -0,0 +1,144 @@
+﻿#include "FrameOverlay.h"
+#include <algorithm>
+#include "counting_line.h"
+
+namespace
+{
+    struct LayerName
+    {
+        OverlayLayer layer;
+        const char *name;
+    };
+
+    constexpr LayerName kLayerNames[] = {
+        {kOverlayTracks, "tracks"},
+        {kOverlayCountingLine, "counting_line"},
+        {kOverlayFusion, "fusion"},
+        {kOverlayHotSpots, "hot_spots"}};
+}
+
+void FrameOverlay::draw(cv::Mat &frame, uint32_t layers) const
+{
+    if (frame.empty())
+        return;
+
+    if ((layers & kOverlayCountingLine) && countingLineY >= 0)
+    {
+        CountingLineModule::drawDetectionLine(frame, countingLineY, countingLineWidth, countingLineLabel);
+    }
+    if ((layers & kOverlayTracks) && !tracks.empty())
+    {
+        TrackerModule::drawTrackResults(frame, tracks);
+    }
+    if (layers & kOverlayFusion)
+    {
+        // 被热成像确认的可见光目标用红框标出，纯热成像目标用橙框标出
+        for (const auto &box : fusionBoxes)
+        {
+            cv::rectangle(frame, box.first, box.second, 2);
+        }
+    }
+    if (layers & kOverlayHotSpots)
+    {
+        for (const auto &vertices : hotSpots)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                cv::line(frame, vertices[i], vertices[(i + 1) % 4], cv::Scalar(0, 255, 255), 2);
+            }
+        }
+    }
+}
+
+uint32_t FrameOverlay::parseLayers(const std::vector<std::string> &names, std::string *unknown)
+{
+    uint32_t layers = kOverlayNone;
+    for (const std::string &name : names)
+    {
+        bool found = false;
+        for (const LayerName &entry : kLayerNames)
+        {
+            if (name == entry.name)
+            {
+                layers |= entry.layer;
+                found = true;
+                break;
+            }
+        }
+        if (!found && unknown)
+        {
+            if (!unknown->empty())
+                *unknown += ",";
+            *unknown += name;
+        }
+    }
+    return layers;
+}
+
+std::string FrameOverlay::layerNames(uint32_t layers)
+{
+    std::string names;
+    for (const LayerName &entry : kLayerNames)
+    {
+        if (layers & entry.layer)
+        {
+            if (!names.empty())
+                names += ",";
+            names += entry.name;
+        }
+    }
+    return names.empty() ? "无" : names;
+}
+
+cv::Mat OverlayCache::render(const cv::Mat &clean, uint64_t seq, const FrameOverlayPtr &overlay, uint32_t layers)
+{
+    if (!overlay)
+        layers = kOverlayNone;
+
+    for (const Entry &entry : entries_)
+    {
+        if (entry.seq == seq && entry.overlay == overlay && entry.layers == layers)
+        {
+            hits_++;
+            return entry.frame;
+        }
+    }
+
+    // 新的一帧：旧帧的结果转为备用缓冲区（仍被输出引用的，等引用释放后才会被复用）
+    if (!entries_.empty() && (entries_.front().seq != seq || entries_.front().overlay != overlay))
+    {
+        for (Entry &entry : entries_)
+            spare_.push_back(std::move(entry.frame));
+        entries_.clear();
+    }
+    else if (entries_.size() >= kMaxEntries)
+    {
+        spare_.push_back(std::move(entries_.front().frame));
+        entries_.erase(entries_.begin());
+    }
+
+    Entry entry;
+    entry.seq = seq;
+    entry.overlay = overlay;
+    entry.layers = layers;
+    auto reusable = std::find_if(spare_.begin(), spare_.end(), [&](const cv::Mat &m)
+                                 { return m.u && m.u->refcount == 1 && m.size() == clean.size() && m.type() == clean.type(); });
+    if (reusable != spare_.end())
+    {
+        entry.frame = std::move(*reusable);
+        spare_.erase(reusable);
+    }
+    if (spare_.size() > kMaxEntries)
+    {
+        spare_.erase(spare_.begin(), spare_.begin() + (spare_.size() - kMaxEntries));
+    }
+
+    clean.copyTo(entry.frame);
+    if (layers != kOverlayNone)
+    {
+        overlay->draw(entry.frame, layers);
+    }
+    renders_++;
+    entries_.push_back(std::move(entry));
+    return entries_.back().frame;
+}
@@ -0,0 +1,136 @@
+﻿#include "IDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include "ObjectTrackingConfig.h"
+#include "OpenCvDnnDetector.h"
+#ifdef ENABLE_TENSORRT_DETECTOR
+#include "TensorRtDetector.h"
+#endif
+
+std::vector<std::vector<Detection>> IDetector::detectBatch(const std::vector<cv::Mat *> &images)
+{
+    std::vector<std::vector<Detection>> results;
+    results.reserve(images.size());
+    for (cv::Mat *image : images)
+    {
+        results.push_back(detect(*image));
+    }
+    return results;
+}
+
+std::unique_ptr<IDetector> IDetector::create(const ObjectTrackingConfig &config, const std::string &backend)
+{
+    auto configMgr = config.getConfigManager();
+    if (!configMgr)
+    {
+        std::cerr << "[IDetector] ConfigManager未初始化" << std::endl;
+        return nullptr;
+    }
+
+    if (backend == "opencv_dnn")
+    {
+        OpenCvDnnDetector::Params params;
+        params.modelPath = config.detector.onnxPath;
+        params.inputSize = config.detector.inputSize;
+        params.confThresh = configMgr->getConfidenceThreshold();
+        params.nmsThresh = configMgr->getNmsThreshold();
+        params.numClass = configMgr->getNumClass();
+        return std::make_unique<OpenCvDnnDetector>(params);
+    }
+
+    if (backend == "tensorrt")
+    {
+#ifdef ENABLE_TENSORRT_DETECTOR
+        return std::make_unique<TensorRtDetector>(*configMgr);
+#else
+        std::cerr << "[IDetector] 未编译TensorRT检测后端（ENABLE_TENSORRT_DETECTOR=OFF）" << std::endl;
+        return nullptr;
+#endif
+    }
+
+    std::cerr << "[IDetector] 未知的检测后端: " << backend << std::endl;
+    return nullptr;
+}
+
+bool IDetector::compareBackends(IDetector &reference, IDetector &candidate, const std::string &imageDir, float tolerancePx)
+{
+    std::vector<std::string> images;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(imageDir, ec))
+    {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp"))
+        {
+            images.push_back(entry.path().string());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    if (images.empty())
+    {
+        std::cerr << "[IDetector] 对比目录中没有图像: " << imageDir << std::endl;
+        return false;
+    }
+
+    int mismatchedImages = 0;
+    size_t referenceCount = 0, candidateCount = 0;
+    float maxBoxDelta = 0.0f, maxConfDelta = 0.0f;
+    for (const std::string &path : images)
+    {
+        cv::Mat img = cv::imread(path);
+        if (img.empty())
+            continue;
+
+        const std::vector<Detection> a = reference.detect(img);
+        const std::vector<Detection> b = candidate.detect(img);
+        referenceCount += a.size();
+        candidateCount += b.size();
+
+        // 按类别与坐标最大偏差贪心匹配
+        bool consistent = a.size() == b.size();
+        std::vector<uint8_t> used(b.size(), 0);
+        for (const Detection &ra : a)
+        {
+            int best = -1;
+            float bestDelta = 0.0f;
+            for (size_t j = 0; j < b.size(); j++)
+            {
+                if (used[j] || b[j].classId != ra.classId)
+                    continue;
+                float delta = 0.0f;
+                for (int k = 0; k < 4; k++)
+                {
+                    delta = (std::max)(delta, std::fabs(ra.bbox[k] - b[j].bbox[k]));
+                }
+                if (best < 0 || delta < bestDelta)
+                {
+                    best = static_cast<int>(j);
+                    bestDelta = delta;
+                }
+            }
+            if (best < 0 || bestDelta > tolerancePx)
+            {
+                consistent = false;
+                continue;
+            }
+            used[best] = 1;
+            maxBoxDelta = (std::max)(maxBoxDelta, bestDelta);
+            maxConfDelta = (std::max)(maxConfDelta, std::fabs(ra.conf - b[best].conf));
+        }
+
+        if (!consistent)
+        {
+            mismatchedImages++;
+            std::cout << "[IDetector] 检测结果不一致: " << path << " (" << reference.name() << " " << a.size()
+                      << " 个, " << candidate.name() << " " << b.size() << " 个)" << std::endl;
+        }
+    }
+
+    std::cout << "[IDetector] 后端对比 " << reference.name() << " vs " << candidate.name() << " - 图像: " << images.size()
+              << ", 检测框: " << referenceCount << " / " << candidateCount
+              << ", 匹配框最大坐标偏差: " << maxBoxDelta << " px, 最大置信度偏差: " << maxConfDelta
+              << ", 超出容差(" << tolerancePx << " px)的图像: " << mismatchedImages << std::endl;
+    return mismatchedImages == 0;
+}
@@ -0,0 +1,231 @@
+﻿#include "InferenceRoi.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include "CountingEvaluation.h"
+#include "IDetector.h"
+
+namespace
+{
+    constexpr int kPadValue = 114;            // 拼接图未覆盖部分的填充灰度（与letterbox一致）
+    constexpr float kMergeOverlap = 0.6f;     // 交集/较小框面积超过该值的跨段检测视为同一目标
+    constexpr float kEvalMatchIou = 0.5f;     // 评估时区域内检测配对的IoU下限
+    constexpr double kEvalCrossingTolerance = 2.0; // 评估时越线事件配对的帧容差
+
+    float area(const float *b)
+    {
+        return (std::max)(0.0f, b[2] - b[0]) * (std::max)(0.0f, b[3] - b[1]);
+    }
+
+    float intersection(const float *a, const float *b)
+    {
+        const float w = (std::min)(a[2], b[2]) - (std::max)(a[0], b[0]);
+        const float h = (std::min)(a[3], b[3]) - (std::max)(a[1], b[1]);
+        return w > 0.0f && h > 0.0f ? w * h : 0.0f;
+    }
+}
+
+InferenceRoi::InferenceRoi(const Params &params)
+    : params_(params)
+{
+    params_.strips = (std::max)(1, params_.strips);
+    params_.stripOverlap = (std::max)(0, params_.stripOverlap);
+}
+
+cv::Mat &InferenceRoi::prepare(cv::Mat &frame)
+{
+    const cv::Rect frameRect(0, 0, frame.cols, frame.rows);
+    fullFrame_ = params_.fullFrameInterval > 0 && ++sinceFull_ >= params_.fullFrameInterval;
+    if (fullFrame_)
+        sinceFull_ = 0;
+
+    // 计数线附近的水平带，tracks 模式再并入活动目标
+    const int lineY = params_.lineY > 0 ? (std::min)(params_.lineY, frame.rows - 1) : frame.rows / 2;
+    cv::Rect region = cv::Rect(0, lineY - params_.bandHalfHeight, frame.cols, 2 * params_.bandHalfHeight) & frameRect;
+    if (params_.mode == "tracks")
+    {
+        cv::Rect bounds;
+        {
+            std::lock_guard<std::mutex> lock(trackMutex_);
+            bounds = trackBounds_;
+        }
+        if (bounds.area() > 0)
+        {
+            const int m = params_.trackMargin;
+            region |= cv::Rect(bounds.x - m, bounds.y - m, bounds.width + 2 * m, bounds.height + 2 * m) & frameRect;
+        }
+    }
+    if (region.area() <= 0 || region == frameRect)
+        fullFrame_ = true;
+
+    if (fullFrame_)
+    {
+        region_ = frameRect;
+        fullFrames_++;
+        return frame;
+    }
+    region_ = region;
+    roiFrames_++;
+
+    // 沿水平方向切段，纵向拼接（每段宽度相同，最后一段不足部分填充）
+    stripCount_ = params_.strips;
+    while (stripCount_ > 1 && (region.width + (stripCount_ - 1) * params_.stripOverlap) / stripCount_ <= params_.stripOverlap)
+        stripCount_--;
+    stripWidth_ = (region.width + (stripCount_ - 1) * params_.stripOverlap + stripCount_ - 1) / stripCount_;
+    const cv::Size mosaicSize(stripWidth_, region.height * stripCount_);
+    if (mosaic_.size() != mosaicSize || mosaic_.type() != frame.type())
+    {
+        mosaic_.create(mosaicSize, frame.type());
+        mosaic_.setTo(cv::Scalar::all(kPadValue));
+    }
+    for (int s = 0; s < stripCount_; s++)
+    {
+        const int x = region.x + s * (stripWidth_ - params_.stripOverlap);
+        const int width = (std::min)(stripWidth_, region.x + region.width - x);
+        cv::Mat strip = mosaic_(cv::Rect(0, s * region.height, width, region.height));
+        frame(cv::Rect(x, region.y, width, region.height)).copyTo(strip);
+        if (width < stripWidth_)
+            mosaic_(cv::Rect(width, s * region.height, stripWidth_ - width, region.height)).setTo(cv::Scalar::all(kPadValue));
+    }
+    return mosaic_;
+}
+
+void InferenceRoi::mapBack(std::vector<Detection> &detections)
+{
+    if (fullFrame_)
+        return;
+
+    // 按中心所在的段裁到段内，再平移回整帧坐标
+    const float stripHeight = static_cast<float>(region_.height);
+    stripOf_.resize(detections.size());
+    for (size_t i = 0; i < detections.size(); i++)
+    {
+        float *b = detections[i].bbox;
+        const int s = (std::max)(0, (std::min)(stripCount_ - 1, static_cast<int>((b[1] + b[3]) * 0.5f / stripHeight)));
+        const float top = s * stripHeight;
+        b[0] = (std::max)(0.0f, b[0]);
+        b[2] = (std::min)(static_cast<float>(stripWidth_), b[2]);
+        b[1] = (std::max)(top, b[1]);
+        b[3] = (std::min)(top + stripHeight, b[3]);
+
+        const float dx = static_cast<float>(region_.x + s * (stripWidth_ - params_.stripOverlap));
+        const float dy = static_cast<float>(region_.y) - top;
+        b[0] += dx;
+        b[2] += dx;
+        b[1] += dy;
+        b[3] += dy;
+        stripOf_[i] = s;
+    }
+    if (stripCount_ == 1)
+        return;
+
+    // 重叠区域的重复检测：按面积降序，抑制其他段中与之高度重叠的同类别框
+    order_.resize(detections.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) { return area(detections[a].bbox) > area(detections[b].bbox); });
+    suppressed_.assign(detections.size(), 0);
+    merged_.clear();
+    for (size_t i = 0; i < order_.size(); i++)
+    {
+        const int keep = order_[i];
+        if (suppressed_[keep])
+            continue;
+        merged_.push_back(detections[keep]);
+        for (size_t j = i + 1; j < order_.size(); j++)
+        {
+            const int other = order_[j];
+            if (suppressed_[other] || stripOf_[other] == stripOf_[keep] || detections[other].classId != detections[keep].classId)
+                continue;
+            const float smaller = area(detections[other].bbox);
+            if (smaller > 0.0f && intersection(detections[keep].bbox, detections[other].bbox) > kMergeOverlap * smaller)
+                suppressed_[other] = 1;
+        }
+    }
+    detections.swap(merged_);
+}
+
+void InferenceRoi::observe(const std::vector<TrackResult> &tracks)
+{
+    if (params_.mode != "tracks")
+        return;
+    cv::Rect bounds;
+    for (const TrackResult &track : tracks)
+    {
+        if (track.is_lost)
+            continue;
+        const cv::Rect box(cv::Point(cvFloor(track.bbox[0]), cvFloor(track.bbox[1])), cv::Point(cvCeil(track.bbox[2]), cvCeil(track.bbox[3])));
+        bounds = bounds.area() > 0 ? (bounds | box) : box;
+    }
+    std::lock_guard<std::mutex> lock(trackMutex_);
+    trackBounds_ = bounds;
+}
+
+void InferenceRoi::evaluate(IDetector &detector, const ConfigManager &config, const Params &params, const std::string &videoPath)
+{
+    Params evalParams = params;
+    evalParams.fullFrameInterval = 0;
+    InferenceRoi roi(evalParams);
+
+    double roiMs = 0.0;
+    size_t zoneFull = 0, zoneRoi = 0, zoneMatched = 0;
+    std::vector<uint8_t> used;
+
+    auto cropped = [&](cv::Mat &frame, const std::vector<Detection> &fullDetections, TrackerModule &tracker)
+    {
+        // 区域检测（拼接、推理、映射回整帧坐标）
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<Detection> roiDetections = detector.detect(roi.prepare(frame));
+        roi.mapBack(roiDetections);
+        roiMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // 区域内的检测按IoU贪心配对
+        const cv::Rect &zone = roi.region();
+        auto inZone = [&](const Detection &d)
+        { return zone.contains(cv::Point(cvRound((d.bbox[0] + d.bbox[2]) * 0.5f), cvRound((d.bbox[1] + d.bbox[3]) * 0.5f))); };
+        used.assign(roiDetections.size(), 0);
+        for (const Detection &a : fullDetections)
+        {
+            if (!inZone(a))
+                continue;
+            zoneFull++;
+            for (size_t j = 0; j < roiDetections.size(); j++)
+            {
+                const float inter = intersection(a.bbox, roiDetections[j].bbox);
+                const float uni = area(a.bbox) + area(roiDetections[j].bbox) - inter;
+                if (!used[j] && a.classId == roiDetections[j].classId && uni > 0.0f && inter / uni >= kEvalMatchIou)
+                {
+                    used[j] = 1;
+                    zoneMatched++;
+                    break;
+                }
+            }
+        }
+        for (const Detection &b : roiDetections)
+        {
+            if (inZone(b))
+                zoneRoi++;
+        }
+
+        std::vector<TrackResult> roiTracks = tracker.update(roiDetections);
+        roi.observe(roiTracks);
+        return roiTracks;
+    };
+
+    CountingEvaluation::Result result;
+    if (!CountingEvaluation::run(detector, config, videoPath, kEvalCrossingTolerance, cropped, result))
+    {
+        std::cerr << "[InferenceRoi] 无法打开评估录像: " << videoPath << std::endl;
+        return;
+    }
+    if (result.frames == 0)
+        return;
+
+    std::cout << "[InferenceRoi] 推理区域评估（" << videoPath << "，" << params.mode << "，" << params.strips << " 段）- 帧数: " << result.frames
+              << ", 每帧检测耗时 整帧/区域: " << result.referenceDetectMs / result.frames << "/" << roiMs / result.frames << " ms"
+              << ", 区域内检测 整帧/区域: " << zoneFull << "/" << zoneRoi << " (仅整帧 " << zoneFull - zoneMatched
+              << ", 仅区域 " << zoneRoi - zoneMatched << ")"
+              << ", 越线计数 整帧/区域: " << result.reference.size() << "/" << result.candidate.size()
+              << ", 漏计: " << result.missed() << ", 多计: " << result.extra() << std::endl;
+}
@@ -0,0 +1,199 @@
+﻿#include "InferenceScheduler.h"
+#include <algorithm>
+#include <iostream>
+
+InferenceScheduler::InferenceScheduler(IDetector &detector, const Params &params)
+    : detector_(detector), params_(params)
+{
+    params_.maxBatch = (std::max)(1, params_.maxBatch);
+    params_.maxWaitUs = (std::max)(0, params_.maxWaitUs);
+}
+
+InferenceScheduler::~InferenceScheduler()
+{
+    stop();
+}
+
+void InferenceScheduler::start()
+{
+    if (running_)
+        return;
+    running_ = true;
+    thread_ = std::thread(&InferenceScheduler::run, this);
+}
+
+void InferenceScheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+            return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    // 未执行的请求以空结果返回，避免提交方永久等待
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Request &request : pending_)
+    {
+        request.promise.set_value({});
+    }
+    pending_.clear();
+}
+
+std::future<std::vector<Detection>> InferenceScheduler::submit(cv::Mat &frame)
+{
+    Request request;
+    request.frame = &frame;
+    request.submitted = std::chrono::steady_clock::now();
+    std::future<std::vector<Detection>> result = request.promise.get_future();
+
+    size_t pendingCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            request.promise.set_value({});
+            return result;
+        }
+        pending_.push_back(std::move(request));
+        pendingCount = pending_.size();
+    }
+    // 第一个请求开始计时，凑满一批时立即唤醒
+    if (pendingCount == 1 || pendingCount >= static_cast<size_t>(params_.maxBatch))
+    {
+        cv_.notify_one();
+    }
+    return result;
+}
+
+void InferenceScheduler::run()
+{
+    const auto maxWait = std::chrono::microseconds(params_.maxWaitUs);
+    const size_t maxBatch = static_cast<size_t>(params_.maxBatch);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        cv_.wait(lock, [&] { return !running_ || !pending_.empty(); });
+        if (!running_)
+            break;
+
+        // 等到凑满一批或最早的请求到达等待时限
+        const auto deadline = pending_.front().submitted + maxWait;
+        cv_.wait_until(lock, deadline, [&] { return !running_ || pending_.size() >= maxBatch; });
+        if (!running_)
+            break;
+
+        const size_t count = (std::min)(maxBatch, pending_.size());
+        batch_.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            batch_.push_back(std::move(pending_.front()));
+            pending_.pop_front();
+        }
+        lock.unlock();
+
+        const auto dispatchTime = std::chrono::steady_clock::now();
+        batchFrames_.clear();
+        for (Request &request : batch_)
+        {
+            batchFrames_.push_back(request.frame);
+            totalWaitMs_ += std::chrono::duration<double, std::milli>(dispatchTime - request.submitted).count();
+        }
+
+        std::vector<std::vector<Detection>> results;
+        try
+        {
+            results = detector_.detectBatch(batchFrames_);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[InferenceScheduler] 批量推理失败: " << e.what() << std::endl;
+        }
+        results.resize(batch_.size());
+        for (size_t i = 0; i < batch_.size(); i++)
+        {
+            batch_[i].promise.set_value(std::move(results[i]));
+        }
+
+        batches_++;
+        frames_ += batch_.size();
+        if (batches_ % 3000 == 0)
+        {
+            std::cout << "[InferenceScheduler] 批次: " << batches_ << ", 帧数: " << frames_
+                      << ", 平均批大小: " << static_cast<double>(frames_) / batches_
+                      << ", 平均排队: " << totalWaitMs_ / frames_ << " ms" << std::endl;
+        }
+        lock.lock();
+    }
+}
+
+void InferenceScheduler::runBenchmark(IDetector &detector, const cv::Size &frameSize, int producers, int framesPerCase)
+{
+    const int batchSizes[] = {1, 2, 4};
+    const int waitsUs[] = {0, 2000, 5000, 10000};
+    producers = (std::max)(1, producers);
+
+    // 每路一张合成测试帧（随机噪声）
+    std::vector<cv::Mat> frames(producers);
+    for (cv::Mat &frame : frames)
+    {
+        frame.create(frameSize, CV_8UC3);
+        cv::randu(frame, cv::Scalar(0, 0, 0), cv::Scalar(255, 255, 255));
+    }
+
+    // 预热（首次推理包含内存分配等一次性开销）
+    detector.detect(frames[0]);
+
+    for (int batch : batchSizes)
+    {
+        for (int waitUs : waitsUs)
+        {
+            InferenceScheduler scheduler(detector, Params{batch, waitUs});
+            scheduler.start();
+
+            std::vector<std::vector<double>> latencies(producers);
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; p++)
+            {
+                threads.emplace_back([&, p]
+                {
+                    latencies[p].reserve(framesPerCase);
+                    for (int i = 0; i < framesPerCase; i++)
+                    {
+                        const auto submitted = std::chrono::steady_clock::now();
+                        scheduler.submit(frames[p]).get();
+                        latencies[p].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitted).count());
+                    }
+                });
+            }
+            for (std::thread &t : threads)
+            {
+                t.join();
+            }
+            const double elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            scheduler.stop();
+            const double avgBatch = scheduler.batches_ > 0 ? static_cast<double>(scheduler.frames_) / scheduler.batches_ : 0.0;
+
+            std::vector<double> all;
+            for (const auto &l : latencies)
+            {
+                all.insert(all.end(), l.begin(), l.end());
+            }
+            std::sort(all.begin(), all.end());
+            const double p50 = all.empty() ? 0.0 : all[all.size() / 2];
+            const double p99 = all.empty() ? 0.0 : all[(std::min)(all.size() - 1, all.size() * 99 / 100)];
+
+            std::cout << "[InferenceScheduler] 批处理对比（" << producers << "路，" << detector.name() << "）- 批大小: " << batch
+                      << ", 等待时限: " << waitUs / 1000.0 << " ms, 平均批大小: " << avgBatch
+                      << ", 吞吐量: " << (elapsedSec > 0.0 ? all.size() / elapsedSec : 0.0) << " 帧/秒"
+                      << ", 延迟 p50: " << p50 << " ms, p99: " << p99 << " ms" << std::endl;
+        }
+    }
+}
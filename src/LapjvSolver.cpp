@@ -0,0 +1,307 @@
+﻿#include "LapjvSolver.h"
+#include <algorithm>
+
+namespace
+{
+    constexpr double kLarge = 1000000; // 与 lapjv.h 的 LARGE 相同
+}
+
+void LapjvSolver::solveRect(const float *cost, int rows, int cols, float costLimit, std::vector<int> &rowsol, std::vector<int> &colsol)
+{
+    rowsol.assign(rows, -1);
+    colsol.assign(cols, -1);
+    if (rows == 0 || cols == 0)
+        return;
+
+    // 扩展为 (rows+cols) 方阵
+    const int n = rows + cols;
+    const float half = static_cast<float>(costLimit / 2.0);
+    n_ = n;
+    cost_.resize(static_cast<size_t>(n) * n);
+    for (int i = 0; i < n; i++)
+    {
+        double *row = cost_.data() + static_cast<size_t>(i) * n;
+        if (i < rows)
+        {
+            const float *src = cost + static_cast<size_t>(i) * cols;
+            for (int j = 0; j < cols; j++)
+                row[j] = src[j];
+            std::fill(row + cols, row + n, static_cast<double>(half));
+        }
+        else
+        {
+            std::fill(row, row + cols, static_cast<double>(half));
+            std::fill(row + cols, row + n, 0.0);
+        }
+    }
+
+    solve(n);
+
+    for (int i = 0; i < rows; i++)
+        rowsol[i] = x_[i] >= cols ? -1 : x_[i];
+    for (int j = 0; j < cols; j++)
+        colsol[j] = y_[j] >= rows ? -1 : y_[j];
+}
+
+void LapjvSolver::solve(int n)
+{
+    x_.resize(n);
+    y_.resize(n);
+    freeRows_.resize(n);
+    v_.resize(n);
+    d_.resize(n);
+    cols_.resize(n);
+    pred_.resize(n);
+    unique_.resize(n);
+
+    int ret = ccrrt(n);
+    for (int i = 0; ret > 0 && i < 2; i++)
+    {
+        ret = carr(n, ret);
+    }
+    if (ret > 0)
+    {
+        ca(n, ret);
+    }
+}
+
+// 列归约与归约转移
+int LapjvSolver::ccrrt(int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        x_[i] = -1;
+        v_[i] = kLarge;
+        y_[i] = 0;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            const double c = cost(i, j);
+            if (c < v_[j])
+            {
+                v_[j] = c;
+                y_[j] = i;
+            }
+        }
+    }
+
+    std::fill(unique_.begin(), unique_.begin() + n, static_cast<uint8_t>(1));
+    for (int j = n - 1; j >= 0; j--)
+    {
+        const int i = y_[j];
+        if (x_[i] < 0)
+        {
+            x_[i] = j;
+        }
+        else
+        {
+            unique_[i] = 0;
+            y_[j] = -1;
+        }
+    }
+
+    int nFreeRows = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (x_[i] < 0)
+        {
+            freeRows_[nFreeRows++] = i;
+        }
+        else if (unique_[i])
+        {
+            const int j = x_[i];
+            double min = kLarge;
+            for (int j2 = 0; j2 < n; j2++)
+            {
+                if (j2 == j)
+                    continue;
+                const double c = cost(i, j2) - v_[j2];
+                if (c < min)
+                    min = c;
+            }
+            v_[j] -= min;
+        }
+    }
+    return nFreeRows;
+}
+
+// 增广行归约
+int LapjvSolver::carr(int n, int nFreeRows)
+{
+    int current = 0;
+    int newFreeRows = 0;
+    unsigned rrCnt = 0;
+    while (current < nFreeRows)
+    {
+        rrCnt++;
+        const int freeI = freeRows_[current++];
+        int j1 = 0;
+        double v1 = cost(freeI, 0) - v_[0];
+        int j2 = -1;
+        double v2 = kLarge;
+        for (int j = 1; j < n; j++)
+        {
+            const double c = cost(freeI, j) - v_[j];
+            if (c < v2)
+            {
+                if (c >= v1)
+                {
+                    v2 = c;
+                    j2 = j;
+                }
+                else
+                {
+                    v2 = v1;
+                    v1 = c;
+                    j2 = j1;
+                    j1 = j;
+                }
+            }
+        }
+        int i0 = y_[j1];
+        const double v1New = v_[j1] - (v2 - v1);
+        const bool v1Lowers = v1New < v_[j1];
+        if (rrCnt < static_cast<unsigned>(current) * static_cast<unsigned>(n))
+        {
+            if (v1Lowers)
+            {
+                v_[j1] = v1New;
+            }
+            else if (i0 >= 0 && j2 >= 0)
+            {
+                j1 = j2;
+                i0 = y_[j2];
+            }
+            if (i0 >= 0)
+            {
+                if (v1Lowers)
+                    freeRows_[--current] = i0;
+                else
+                    freeRows_[newFreeRows++] = i0;
+            }
+        }
+        else if (i0 >= 0)
+        {
+            freeRows_[newFreeRows++] = i0;
+        }
+        x_[freeI] = j1;
+        y_[j1] = freeI;
+    }
+    return newFreeRows;
+}
+
+// 在 cols_[lo..n) 中找出 d 最小的列并移到 lo 开始的位置
+int LapjvSolver::findDense(int n, int lo)
+{
+    int hi = lo + 1;
+    double mind = d_[cols_[lo]];
+    for (int k = hi; k < n; k++)
+    {
+        const int j = cols_[k];
+        if (d_[j] <= mind)
+        {
+            if (d_[j] < mind)
+            {
+                hi = lo;
+                mind = d_[j];
+            }
+            cols_[k] = cols_[hi];
+            cols_[hi++] = j;
+        }
+    }
+    return hi;
+}
+
+// 用 SCAN 中的列尝试降低 TODO 中各列的 d；找到空闲列时直接返回，不回写 lo/hi（与 _scan_dense 一致）
+int LapjvSolver::scanDense(int n, int &plo, int &phi)
+{
+    int lo = plo, hi = phi;
+    while (lo != hi)
+    {
+        int j = cols_[lo++];
+        const int i = y_[j];
+        const double mind = d_[j];
+        const double h = cost(i, j) - v_[j] - mind;
+        for (int k = hi; k < n; k++)
+        {
+            j = cols_[k];
+            const double credIJ = cost(i, j) - v_[j] - h;
+            if (credIJ < d_[j])
+            {
+                d_[j] = credIJ;
+                pred_[j] = i;
+                if (credIJ == mind)
+                {
+                    if (y_[j] < 0)
+                        return j;
+                    cols_[k] = cols_[hi];
+                    cols_[hi++] = j;
+                }
+            }
+        }
+    }
+    plo = lo;
+    phi = hi;
+    return -1;
+}
+
+// 单次修正Dijkstra最短增广路，返回最近的空闲列
+int LapjvSolver::findPath(int n, int startRow)
+{
+    int lo = 0, hi = 0;
+    int finalJ = -1;
+    int nReady = 0;
+    for (int i = 0; i < n; i++)
+    {
+        cols_[i] = i;
+        pred_[i] = startRow;
+        d_[i] = cost(startRow, i) - v_[i];
+    }
+    while (finalJ == -1)
+    {
+        if (lo == hi)
+        {
+            nReady = lo;
+            hi = findDense(n, lo);
+            for (int k = lo; k < hi; k++)
+            {
+                const int j = cols_[k];
+                if (y_[j] < 0)
+                    finalJ = j;
+            }
+        }
+        if (finalJ == -1)
+        {
+            finalJ = scanDense(n, lo, hi);
+        }
+    }
+
+    const double mind = d_[cols_[lo]];
+    for (int k = 0; k < nReady; k++)
+    {
+        const int j = cols_[k];
+        v_[j] += d_[j] - mind;
+    }
+    return finalJ;
+}
+
+// 对剩余空闲行逐一增广
+void LapjvSolver::ca(int n, int nFreeRows)
+{
+    for (int f = 0; f < nFreeRows; f++)
+    {
+        const int freeI = freeRows_[f];
+        int i = -1;
+        int j = findPath(n, freeI);
+        int k = 0;
+        while (i != freeI && k < n)
+        {
+            i = pred_[j];
+            y_[j] = i;
+            std::swap(j, x_[i]);
+            k++;
+        }
+    }
+}
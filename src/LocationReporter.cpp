@@ -1,5 +1,6 @@
 ﻿#include "LocationReporter.h"
 #include "ObjectTrackingConfig.h"
+#include "EventJournal.h"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
@@ -623,6 +624,14 @@ size_t LocationReporter::getClientCount() const
     return tcpServer_ ? tcpServer_->getClientCount() : 0;
 }
 
+bool LocationReporter::getLastValidData(ParsedGYKData &data) const
+{
+    if (!hasValidData_)
+        return false;
+    data = lastValidData_;
+    return true;
+}
+
 void LocationReporter::shutdown()
 {
     // 停止TCP服务器
@@ -884,10 +893,23 @@ void LocationReporter::assembleAndSendPacket(const std::vector<uint8_t> &canPayl
     // 7. 通过 TCP 服务器广播数据给所有连接的客户端
     bool sendResult = tcpServer_->sendData(packetData);
 
-    // 8. 保存发送的数据包到文件（用于调试和前后端对比）
+    // 8. 发送的数据包写入事件日志（只入队）
+    if (eventJournal_ && (journalAllPackets_ || !sendResult || camera1_visible || camera1_thermal || camera2_visible || camera2_thermal))
+    {
+        const uint8_t flags[4] = {camera1_visible, camera1_thermal, camera2_visible, camera2_thermal};
+        eventJournal_->logReportPacket(flags, sendResult, getClientCount(), packetData);
+    }
+
+    // 9. 保存发送的数据包到文件（用于调试和前后端对比）
     // savePacketToFile(packetData, camera1_visible, camera1_thermal, camera2_visible, camera2_thermal, sendResult);
 }
 
+void LocationReporter::setEventJournal(EventJournal *journal, bool logAllPackets)
+{
+    eventJournal_ = journal;
+    journalAllPackets_ = logAllPackets;
+}
+
 uint16_t LocationReporter::calculateCRC16(const std::vector<uint8_t> &data)
 {
     uint16_t crc = 0xFFFF; // 初始值
@@ -0,0 +1,235 @@
+﻿#include "OpenCvDnnDetector.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace
+{
+    constexpr int kPadValue = 114; // letterbox填充灰度
+
+#if CV_SIMD128
+    // 16个8位像素分量归一化后写入浮点平面
+    inline void storeNormalized(const cv::v_uint8x16 &v, float *dst, const cv::v_float32x4 &k)
+    {
+        cv::v_uint16x8 lo, hi;
+        cv::v_expand(v, lo, hi);
+        cv::v_uint32x4 q0, q1, q2, q3;
+        cv::v_expand(lo, q0, q1);
+        cv::v_expand(hi, q2, q3);
+        cv::v_store(dst, cv::v_cvt_f32(cv::v_reinterpret_as_s32(q0)) * k);
+        cv::v_store(dst + 4, cv::v_cvt_f32(cv::v_reinterpret_as_s32(q1)) * k);
+        cv::v_store(dst + 8, cv::v_cvt_f32(cv::v_reinterpret_as_s32(q2)) * k);
+        cv::v_store(dst + 12, cv::v_cvt_f32(cv::v_reinterpret_as_s32(q3)) * k);
+    }
+#endif
+}
+
+OpenCvDnnDetector::OpenCvDnnDetector(const Params &params)
+    : params_(params)
+{
+    net_ = cv::dnn::readNetFromONNX(params_.modelPath);
+    if (net_.empty())
+    {
+        throw std::runtime_error("无法加载ONNX模型: " + params_.modelPath);
+    }
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+    allocateBlob(1);
+    std::cout << "[OpenCvDnnDetector] 已加载ONNX模型 " << params_.modelPath << "，输入 "
+              << params_.inputSize << "x" << params_.inputSize << "，CPU推理" << std::endl;
+}
+
+void OpenCvDnnDetector::allocateBlob(int batch)
+{
+    if (batch == blobBatch_)
+        return;
+    const int blobSize[] = {batch, 3, params_.inputSize, params_.inputSize};
+    blob_.create(4, blobSize, CV_32F);
+    blobBatch_ = batch;
+}
+
+OpenCvDnnDetector::Letterbox OpenCvDnnDetector::letterbox(const cv::Mat &img, float *dst)
+{
+    const int size = params_.inputSize;
+    const float scale = (std::min)(size / static_cast<float>(img.cols), size / static_cast<float>(img.rows));
+    const int newW = (std::min)(size, (std::max)(1, cvRound(img.cols * scale)));
+    const int newH = (std::min)(size, (std::max)(1, cvRound(img.rows * scale)));
+    const int offX = (size - newW) / 2;
+    const int offY = (size - newH) / 2;
+
+    // 填充区域只在画布首次分配时写入，之后每帧只覆盖缩放区域
+    if (canvas_.rows != size || canvas_.cols != size || canvasSource_ != img.size())
+    {
+        canvas_.create(size, size, CV_8UC3);
+        canvas_.setTo(cv::Scalar(kPadValue, kPadValue, kPadValue));
+        canvasSource_ = img.size();
+    }
+    cv::Mat roi = canvas_(cv::Rect(offX, offY, newW, newH));
+    cv::resize(img, roi, cv::Size(newW, newH), 0, 0, cv::INTER_LINEAR);
+
+    // BGR交织 → RGB三个浮点平面，归一化到[0,1]
+    const size_t planeSize = static_cast<size_t>(size) * size;
+    float *dstR = dst;
+    float *dstG = dstR + planeSize;
+    float *dstB = dstG + planeSize;
+    const float norm = 1.0f / 255.0f;
+#if CV_SIMD128
+    const cv::v_float32x4 normVec = cv::v_setall_f32(norm);
+#endif
+    for (int y = 0; y < size; y++)
+    {
+        const uchar *src = canvas_.ptr<uchar>(y);
+        const size_t rowOffset = static_cast<size_t>(y) * size;
+        int x = 0;
+#if CV_SIMD128
+        for (; x <= size - 16; x += 16)
+        {
+            cv::v_uint8x16 b, g, r;
+            cv::v_load_deinterleave(src + 3 * x, b, g, r);
+            storeNormalized(r, dstR + rowOffset + x, normVec);
+            storeNormalized(g, dstG + rowOffset + x, normVec);
+            storeNormalized(b, dstB + rowOffset + x, normVec);
+        }
+#endif
+        for (; x < size; x++)
+        {
+            dstR[rowOffset + x] = src[3 * x + 2] * norm;
+            dstG[rowOffset + x] = src[3 * x + 1] * norm;
+            dstB[rowOffset + x] = src[3 * x] * norm;
+        }
+    }
+
+    Letterbox box;
+    box.scale = scale;
+    box.padX = static_cast<float>(offX);
+    box.padY = static_cast<float>(offY);
+    return box;
+}
+
+float OpenCvDnnDetector::iou(const Detection &a, const Detection &b)
+{
+    const float ix = (std::max)(0.0f, (std::min)(a.bbox[2], b.bbox[2]) - (std::max)(a.bbox[0], b.bbox[0]));
+    const float iy = (std::max)(0.0f, (std::min)(a.bbox[3], b.bbox[3]) - (std::max)(a.bbox[1], b.bbox[1]));
+    const float inter = ix * iy;
+    const float areaA = (a.bbox[2] - a.bbox[0]) * (a.bbox[3] - a.bbox[1]);
+    const float areaB = (b.bbox[2] - b.bbox[0]) * (b.bbox[3] - b.bbox[1]);
+    const float uni = areaA + areaB - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+void OpenCvDnnDetector::decode(const float *data, int dim1, int dim2, const Letterbox &box, std::vector<Detection> &detections)
+{
+    detections.clear();
+
+    // 标准导出为 [N, 4+类别数, 候选数]，候选数远大于通道数；反之按转置布局读取
+    const bool transposed = dim2 < dim1;
+    const int channels = transposed ? dim2 : dim1;
+    const int count = transposed ? dim1 : dim2;
+    const int numClass = (std::min)(params_.numClass, channels - 4);
+    auto at = [&](int c, int i) { return transposed ? data[static_cast<size_t>(i) * channels + c] : data[static_cast<size_t>(c) * count + i]; };
+
+    // 解码：每个候选取最高类别得分
+    candidates_.clear();
+    for (int i = 0; i < count && static_cast<int>(candidates_.size()) < kMaxCandidates; i++)
+    {
+        int bestClass = 0;
+        float bestScore = at(4, i);
+        for (int c = 1; c < numClass; c++)
+        {
+            const float score = at(4 + c, i);
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestClass = c;
+            }
+        }
+        if (bestScore <= params_.confThresh)
+            continue;
+
+        const float cx = at(0, i), cy = at(1, i), w = at(2, i), h = at(3, i);
+        Detection det;
+        det.bbox[0] = cx - w * 0.5f;
+        det.bbox[1] = cy - h * 0.5f;
+        det.bbox[2] = cx + w * 0.5f;
+        det.bbox[3] = cy + h * 0.5f;
+        det.conf = bestScore;
+        det.classId = bestClass;
+        candidates_.push_back(det);
+    }
+
+    // 同类别按置信度降序贪心NMS
+    order_.resize(candidates_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) { return candidates_[a].conf > candidates_[b].conf; });
+    suppressed_.assign(candidates_.size(), 0);
+    for (size_t i = 0; i < order_.size(); i++)
+    {
+        if (suppressed_[order_[i]])
+            continue;
+        const Detection &kept = candidates_[order_[i]];
+        for (size_t j = i + 1; j < order_.size(); j++)
+        {
+            const Detection &other = candidates_[order_[j]];
+            if (!suppressed_[order_[j]] && other.classId == kept.classId && iou(kept, other) > params_.nmsThresh)
+            {
+                suppressed_[order_[j]] = 1;
+            }
+        }
+
+        Detection det = kept;
+        det.bbox[0] = (det.bbox[0] - box.padX) / box.scale;
+        det.bbox[1] = (det.bbox[1] - box.padY) / box.scale;
+        det.bbox[2] = (det.bbox[2] - box.padX) / box.scale;
+        det.bbox[3] = (det.bbox[3] - box.padY) / box.scale;
+        detections.push_back(det);
+    }
+}
+
+std::vector<Detection> OpenCvDnnDetector::detect(cv::Mat &img)
+{
+    std::vector<cv::Mat *> images{&img};
+    return std::move(detectBatch(images)[0]);
+}
+
+std::vector<std::vector<Detection>> OpenCvDnnDetector::detectBatch(const std::vector<cv::Mat *> &images)
+{
+    std::vector<std::vector<Detection>> results(images.size());
+    if (images.empty())
+        return results;
+
+    // 空图或非BGR图像不参与前向，对应结果为空
+    std::vector<int> valid;
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        if (!images[i]->empty() && images[i]->channels() == 3)
+            valid.push_back(static_cast<int>(i));
+    }
+    if (valid.empty())
+        return results;
+
+    allocateBlob(static_cast<int>(valid.size()));
+    const size_t imageSize = static_cast<size_t>(3) * params_.inputSize * params_.inputSize;
+    std::vector<Letterbox> boxes(valid.size());
+    for (size_t n = 0; n < valid.size(); n++)
+    {
+        boxes[n] = letterbox(*images[valid[n]], blob_.ptr<float>() + n * imageSize);
+    }
+
+    net_.setInput(blob_);
+    cv::Mat output = net_.forward();
+    if (output.dims != 3 || output.size[0] != static_cast<int>(valid.size()))
+    {
+        std::cerr << "[OpenCvDnnDetector] 不支持的输出形状，维度: " << output.dims << std::endl;
+        return results;
+    }
+
+    const size_t outputSize = static_cast<size_t>(output.size[1]) * output.size[2];
+    for (size_t n = 0; n < valid.size(); n++)
+    {
+        decode(output.ptr<float>() + n * outputSize, output.size[1], output.size[2], boxes[n], results[valid[n]]);
+    }
+    return results;
+}
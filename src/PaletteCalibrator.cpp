@@ -0,0 +1,143 @@
+﻿#include "PaletteCalibrator.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+PaletteCalibrator::PaletteCalibrator(const cv::Rect &paletteRoi, int sampleInterval)
+    : roi_(paletteRoi), sampleInterval_((std::max)(1, sampleInterval)), framesSinceSample_(0),
+      total_(0.0f), percentile_(0.8f), threshold_(128.0f), calibrated_(false), hasRange_(false),
+      lastMinTemp_(0.0f), lastMaxTemp_(0.0f)
+{
+    std::fill(histogram_, histogram_ + 256, 0.0f);
+}
+
+void PaletteCalibrator::setPercentile(float percentile)
+{
+    percentile = (std::max)(0.0f, (std::min)(percentile, 1.0f));
+    if (percentile == percentile_)
+    {
+        return;
+    }
+    percentile_ = percentile;
+    if (calibrated_)
+    {
+        threshold_ = percentileValue(percentile_);
+    }
+}
+
+void PaletteCalibrator::setSampleInterval(int frames)
+{
+    sampleInterval_ = (std::max)(1, frames);
+}
+
+void PaletteCalibrator::reset()
+{
+    calibrated_ = false;
+    hasRange_ = false;
+    framesSinceSample_ = 0;
+}
+
+bool PaletteCalibrator::update(const cv::Mat &frame, float minTemp, float maxTemp)
+{
+    if (frame.empty())
+    {
+        return calibrated_;
+    }
+
+    // AGC温度范围变化后调色板映射已改变，旧直方图失效
+    const bool rangeChanged = hasRange_ && (std::fabs(minTemp - lastMinTemp_) > kAgcTolerance ||
+                                            std::fabs(maxTemp - lastMaxTemp_) > kAgcTolerance);
+
+    framesSinceSample_++;
+    if (calibrated_ && !rangeChanged && framesSinceSample_ < sampleInterval_)
+    {
+        return true;
+    }
+
+    if (sample(frame, !calibrated_ || rangeChanged))
+    {
+        framesSinceSample_ = 0;
+        hasRange_ = true;
+        lastMinTemp_ = minTemp;
+        lastMaxTemp_ = maxTemp;
+        threshold_ = percentileValue(percentile_);
+        calibrated_ = true;
+    }
+    return calibrated_;
+}
+
+bool PaletteCalibrator::sample(const cv::Mat &frame, bool replace)
+{
+    if (roi_.x < 0 || roi_.y < 0 || roi_.x + roi_.width > frame.cols || roi_.y + roi_.height > frame.rows)
+    {
+        if (!calibrated_)
+        {
+            std::cerr << "[PaletteCalibrator] 标定失败：温度条区域超出图像边界" << std::endl;
+        }
+        return false;
+    }
+
+    cv::Mat paletteRoi = frame(roi_);
+    if (paletteRoi.channels() == 3)
+    {
+        cv::cvtColor(paletteRoi, grayRoi_, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        paletteRoi.copyTo(grayRoi_);
+    }
+
+    int counts[256] = {0};
+    for (int y = 0; y < grayRoi_.rows; y++)
+    {
+        const uchar *p = grayRoi_.ptr<uchar>(y);
+        for (int x = 0; x < grayRoi_.cols; x++)
+        {
+            counts[p[x]]++;
+        }
+    }
+
+    const float keep = replace ? 0.0f : (1.0f - kBlendFactor);
+    const float add = replace ? 1.0f : kBlendFactor;
+    total_ = 0.0f;
+    for (int i = 0; i < 256; i++)
+    {
+        histogram_[i] = histogram_[i] * keep + static_cast<float>(counts[i]) * add;
+        total_ += histogram_[i];
+    }
+    return total_ > 0.0f;
+}
+
+int PaletteCalibrator::valueAtRank(float rank) const
+{
+    float cumulative = 0.0f;
+    for (int i = 0; i < 256; i++)
+    {
+        cumulative += histogram_[i];
+        if (cumulative > rank)
+        {
+            return i;
+        }
+    }
+    return 255;
+}
+
+float PaletteCalibrator::percentileValue(float percentile) const
+{
+    if (total_ <= 0.0f)
+    {
+        return threshold_;
+    }
+
+    // 与排序后线性插值的定义一致：index = p * (N - 1)
+    const float index = percentile * (total_ - 1.0f);
+    const float lowerRank = std::floor(index);
+    const float weight = index - lowerRank;
+    const int lower = valueAtRank(lowerRank);
+    if (weight <= 0.0f)
+    {
+        return static_cast<float>(lower);
+    }
+    const int upper = valueAtRank(lowerRank + 1.0f);
+    return lower * (1.0f - weight) + upper * weight;
+}
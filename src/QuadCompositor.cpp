@@ -0,0 +1,85 @@
+﻿#include "QuadCompositor.h"
+#include <cstring>
+
+QuadCompositor::QuadCompositor(int width, int height)
+    : width_(width & ~3), height_(height & ~3)
+{
+    tileWidth_ = width_ / 2;
+    tileHeight_ = height_ / 2;
+
+    // 初始化为黑色（Y=16, U=V=128）
+    canvas_.create(height_ * 3 / 2, width_, CV_8UC1);
+    canvas_.rowRange(0, height_).setTo(cv::Scalar(16));
+    canvas_.rowRange(height_, height_ * 3 / 2).setTo(cv::Scalar(128));
+}
+
+bool QuadCompositor::updateTile(int tileIndex, const cv::Mat &bgr, uint64_t seq, const FrameOverlay *overlay, uint32_t layers,
+                                double scaleX, double scaleY)
+{
+    if (tileIndex < 0 || tileIndex >= kTileCount || bgr.empty() || seq == 0)
+        return false;
+
+    // 没有新帧的分块不重新绘制
+    if (seq == lastSeq_[tileIndex])
+        return false;
+
+    const cv::Mat *src = &bgr;
+    if (bgr.cols != tileWidth_ || bgr.rows != tileHeight_)
+    {
+        cv::resize(bgr, tileBgr_, cv::Size(tileWidth_, tileHeight_), 0, 0, cv::INTER_AREA);
+        src = &tileBgr_;
+    }
+    cv::cvtColor(*src, tileI420_, cv::COLOR_BGR2YUV_I420);
+
+    // 标注直接画到分块的I420数据上，坐标换算到分块分辨率
+    if (overlay && layers != kOverlayNone)
+    {
+        overlay_.draw(YuvPlanes::i420(tileI420_.ptr<uint8_t>(0), tileWidth_, tileHeight_), *overlay, layers,
+                      scaleX * tileWidth_ / bgr.cols, scaleY * tileHeight_ / bgr.rows);
+    }
+
+    blitTile(tileIndex);
+    lastSeq_[tileIndex] = seq;
+    dirtyTiles_++;
+    return true;
+}
+
+void QuadCompositor::blitTile(int tileIndex)
+{
+    const int col = tileIndex % 2;
+    const int row = tileIndex / 2;
+
+    // 分块内I420布局：Y(tileH×tileW) | U(tileH/2×tileW/2) | V(tileH/2×tileW/2)
+    const uint8_t *tileY = tileI420_.ptr<uint8_t>(0);
+    const uint8_t *tileU = tileY + tileWidth_ * tileHeight_;
+    const uint8_t *tileV = tileU + (tileWidth_ / 2) * (tileHeight_ / 2);
+
+    uint8_t *canvasY = canvas_.ptr<uint8_t>(0);
+    uint8_t *canvasU = canvasY + width_ * height_;
+    uint8_t *canvasV = canvasU + (width_ / 2) * (height_ / 2);
+
+    // 亮度平面
+    for (int y = 0; y < tileHeight_; y++)
+    {
+        uint8_t *dst = canvasY + (row * tileHeight_ + y) * width_ + col * tileWidth_;
+        std::memcpy(dst, tileY + y * tileWidth_, tileWidth_);
+    }
+
+    // 色度平面
+    const int chromaTileW = tileWidth_ / 2;
+    const int chromaTileH = tileHeight_ / 2;
+    const int chromaW = width_ / 2;
+    for (int y = 0; y < chromaTileH; y++)
+    {
+        size_t dstOffset = static_cast<size_t>(row * chromaTileH + y) * chromaW + col * chromaTileW;
+        std::memcpy(canvasU + dstOffset, tileU + y * chromaTileW, chromaTileW);
+        std::memcpy(canvasV + dstOffset, tileV + y * chromaTileW, chromaTileW);
+    }
+}
+
+int QuadCompositor::takeDirtyTileCount()
+{
+    int count = dirtyTiles_;
+    dirtyTiles_ = 0;
+    return count;
+}
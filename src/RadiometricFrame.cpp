@@ -0,0 +1,198 @@
+﻿#include "RadiometricFrame.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+RadiometricFramePool::RadiometricFramePool(const cv::Size &size, int capacity)
+    : state_(std::make_shared<State>())
+{
+    state_->size = size;
+    state_->freeFrames.reserve(capacity);
+    for (int i = 0; i < capacity; i++)
+    {
+        auto frame = std::make_unique<RadiometricFrame>();
+        frame->temperature.create(size, CV_32FC1);
+        state_->freeFrames.push_back(std::move(frame));
+    }
+}
+
+std::shared_ptr<RadiometricFrame> RadiometricFramePool::acquire()
+{
+    std::unique_ptr<RadiometricFrame> frame;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->freeFrames.empty())
+            return nullptr;
+        frame = std::move(state_->freeFrames.back());
+        state_->freeFrames.pop_back();
+    }
+
+    frame->seq = 0;
+    frame->captureTimeUs = 0;
+    frame->minTemp = 0.0f;
+    frame->maxTemp = 0.0f;
+
+    // 最后一个持有者释放时归还池中（deleter持有池状态，池对象先销毁也安全）
+    std::shared_ptr<State> state = state_;
+    return std::shared_ptr<RadiometricFrame>(frame.release(), [state](RadiometricFrame *released)
+                                             {
+                                                 std::lock_guard<std::mutex> lock(state->mutex);
+                                                 state->freeFrames.emplace_back(released); });
+}
+
+bool RadiometricParser::parse(const uint8_t *data, size_t length, int width, int height, RadiometricFrame &frame)
+{
+    if (!data || width <= 0 || height <= 0 || frame.temperature.empty() || frame.temperature.type() != CV_32FC1)
+        return false;
+
+    const size_t pixels = static_cast<size_t>(width) * height;
+    int bytesPerPixel;
+    if (length >= pixels * 4)
+        bytesPerPixel = 4;
+    else if (length >= pixels * 2)
+        bytesPerPixel = 2;
+    else
+        return false;
+
+    cv::Mat &dst = frame.temperature;
+    const bool sameSize = (width == dst.cols && height == dst.rows);
+    if (!sameSize)
+    {
+        // 分辨率与池尺寸不同：先得到原始分辨率的浮点矩阵，再缩放到池尺寸
+        if (bytesPerPixel == 4)
+        {
+            const cv::Mat source(height, width, CV_32FC1, const_cast<uint8_t *>(data));
+            cv::resize(source, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+        }
+        else
+        {
+            const cv::Mat source(height, width, CV_16UC1, const_cast<uint8_t *>(data));
+            source.convertTo(scratch_, CV_32F, options_.raw16Scale, options_.raw16Offset);
+            cv::resize(scratch_, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+        }
+    }
+
+    // 单次遍历：同尺寸时直接从负载解码写入，同时钳位无效值（含NaN）并统计最值
+    const float minValid = options_.minValid;
+    const float maxValid = options_.maxValid;
+    float minTemp = maxValid;
+    float maxTemp = minValid;
+    for (int y = 0; y < dst.rows; y++)
+    {
+        float *out = dst.ptr<float>(y);
+        if (sameSize)
+        {
+            const uint8_t *in = data + static_cast<size_t>(y) * width * bytesPerPixel;
+            if (bytesPerPixel == 4)
+            {
+                std::memcpy(out, in, static_cast<size_t>(width) * sizeof(float));
+            }
+            else
+            {
+                for (int x = 0; x < width; x++)
+                {
+                    uint16_t raw;
+                    std::memcpy(&raw, in + x * 2, sizeof(raw));
+                    out[x] = raw * options_.raw16Scale + options_.raw16Offset;
+                }
+            }
+        }
+
+        for (int x = 0; x < dst.cols; x++)
+        {
+            float v = out[x];
+            if (!(v >= minValid))
+                v = minValid;
+            else if (v > maxValid)
+                v = maxValid;
+            out[x] = v;
+            minTemp = (std::min)(minTemp, v);
+            maxTemp = (std::max)(maxTemp, v);
+        }
+    }
+
+    frame.sourceSize = cv::Size(width, height);
+    frame.minTemp = minTemp;
+    frame.maxTemp = maxTemp;
+    return true;
+}
+
+bool RadiometricParser::inferDimensions(size_t length, int &width, int &height)
+{
+    static const cv::Size kKnownSizes[] = {{640, 512}, {384, 288}, {256, 192}, {160, 120}, {1280, 1024}};
+    for (int bytesPerPixel : {4, 2})
+    {
+        for (const auto &size : kKnownSizes)
+        {
+            if (length == static_cast<size_t>(size.width) * size.height * bytesPerPixel)
+            {
+                width = size.width;
+                height = size.height;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RadiometricParser::readRecording(const std::string &path, std::vector<uint8_t> &payload, int &width, int &height)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    const std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0)
+        return false;
+    file.seekg(0);
+
+    RecordingHeader header;
+    if (fileSize > static_cast<std::streamoff>(sizeof(header)))
+    {
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (std::memcmp(header.magic, "HRAD", 4) == 0)
+        {
+            const size_t dataLength = static_cast<size_t>(fileSize) - sizeof(header);
+            if (header.dataLength != dataLength || header.width == 0 || header.height == 0)
+            {
+                std::cerr << "[RadiometricParser] 录制文件头与数据长度不一致: " << path << std::endl;
+                return false;
+            }
+            payload.resize(dataLength);
+            file.read(reinterpret_cast<char *>(payload.data()), dataLength);
+            width = static_cast<int>(header.width);
+            height = static_cast<int>(header.height);
+            return static_cast<bool>(file);
+        }
+        file.seekg(0);
+    }
+
+    // 不带文件头的原始负载
+    if (!inferDimensions(static_cast<size_t>(fileSize), width, height))
+    {
+        std::cerr << "[RadiometricParser] 无法从文件长度推断测温分辨率: " << path << " (" << fileSize << " 字节)" << std::endl;
+        return false;
+    }
+    payload.resize(static_cast<size_t>(fileSize));
+    file.read(reinterpret_cast<char *>(payload.data()), fileSize);
+    return static_cast<bool>(file);
+}
+
+bool RadiometricParser::writeRecording(const std::string &path, const uint8_t *data, size_t length, int width, int height,
+                                       int64_t captureTimeUs)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    RecordingHeader header;
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.bytesPerPixel = static_cast<uint32_t>(length / (static_cast<size_t>(width) * height));
+    header.dataLength = static_cast<uint32_t>(length);
+    header.captureTimeUs = captureTimeUs;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(data), length);
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,176 @@
+﻿#include "RadiometricIngest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+    constexpr int kMatrixWidth = 640;                      // 温度矩阵宽度
+    constexpr int kMatrixHeight = 512;                     // 温度矩阵高度
+    constexpr size_t kJpegBufferSize = 2 * 1024 * 1024;    // 热成像JPEG缓冲区
+    constexpr size_t kP2PBufferSize = 1280 * 1024 * 4;     // 全屏测温数据缓冲区（最大1280x1024浮点）
+    constexpr size_t kVisibleBufferSize = 8 * 1024 * 1024; // 双光设备附带的可见光图片缓冲区
+}
+
+RadiometricIngest::RadiometricIngest(int deviceIdx, LONG userID, SharedData &data, const RadiometricIngestConfig &config)
+    : deviceIdx_(deviceIdx),
+      userID_(userID),
+      data_(data),
+      config_(config),
+      pool_(cv::Size(kMatrixWidth, kMatrixHeight), (std::max)(2, config.poolSize))
+{
+    RadiometricParser::Options options;
+    options.raw16Scale = config_.raw16Scale;
+    options.raw16Offset = config_.raw16Offset;
+    parser_.setOptions(options);
+}
+
+RadiometricIngest::~RadiometricIngest()
+{
+    stop();
+}
+
+bool RadiometricIngest::start()
+{
+    jpegBuffer_.resize(kJpegBufferSize);
+    p2pBuffer_.resize(kP2PBufferSize);
+    visibleBuffer_.resize(kVisibleBufferSize);
+
+    running_ = true;
+    thread_ = std::thread(&RadiometricIngest::run, this);
+    std::cout << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "辐射测温采集线程已启动 ("
+              << config_.fps << " fps)" << std::endl;
+    return true;
+}
+
+void RadiometricIngest::stop()
+{
+    running_ = false;
+    if (thread_.joinable())
+    {
+        thread_.join();
+        std::cout << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "辐射测温采集线程已退出，共 " << seq_
+                  << " 帧，失败 " << failedCaptures_ << " 次，缓冲池耗尽丢弃 " << droppedFrames_ << " 帧" << std::endl;
+    }
+}
+
+bool RadiometricIngest::captureFromSdk(const uint8_t *&payload, size_t &length, int &width, int &height)
+{
+    NET_DVR_JPEGPICTURE_WITH_APPENDDATA picture;
+    memset(&picture, 0, sizeof(picture));
+    picture.dwSize = sizeof(picture);
+    picture.pJpegPicBuff = jpegBuffer_.data();
+    picture.pP2PDataBuff = p2pBuffer_.data();
+    picture.pVisiblePicBuff = visibleBuffer_.data();
+
+    if (!NET_DVR_CaptureJPEGPicture_WithAppendData(userID_, config_.channel, &picture))
+    {
+        if (failedCaptures_++ % 50 == 0)
+        {
+            std::cerr << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "抓取测温数据失败，错误码: "
+                      << NET_DVR_GetLastError() << std::endl;
+        }
+        return false;
+    }
+    if (picture.dwP2PDataLen == 0 || picture.dwP2PDataLen > p2pBuffer_.size())
+    {
+        if (failedCaptures_++ % 50 == 0)
+        {
+            std::cerr << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "测温数据长度无效: " << picture.dwP2PDataLen << std::endl;
+        }
+        return false;
+    }
+
+    payload = reinterpret_cast<const uint8_t *>(p2pBuffer_.data());
+    length = picture.dwP2PDataLen;
+    width = static_cast<int>(picture.dwJpegPicWidth);
+    height = static_cast<int>(picture.dwJpegPicHeight);
+
+    // 测温数据分辨率与JPEG不一致时按长度推断
+    const size_t pixels = static_cast<size_t>(width) * height;
+    if (pixels == 0 || (length != pixels * 4 && length != pixels * 2))
+    {
+        RadiometricParser::inferDimensions(length, width, height);
+    }
+    return true;
+}
+
+void RadiometricIngest::recordPayload(const uint8_t *payload, size_t length, int width, int height, int64_t captureTimeUs)
+{
+    if (config_.recordDir.empty() || recordedFrames_ >= config_.recordFrames)
+        return;
+
+    const std::filesystem::path dir = std::filesystem::path(config_.recordDir) / ("device" + std::to_string(deviceIdx_ + 1));
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06d.hrad", recordedFrames_);
+    if (RadiometricParser::writeRecording((dir / name).string(), payload, length, width, height, captureTimeUs))
+    {
+        recordedFrames_++;
+        if (recordedFrames_ == config_.recordFrames)
+        {
+            std::cout << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "已录制 " << recordedFrames_ << " 帧测温数据到 " << dir.string() << std::endl;
+        }
+    }
+}
+
+void RadiometricIngest::run()
+{
+    const auto period = std::chrono::microseconds(static_cast<int64_t>(1e6 / (std::max)(0.1f, config_.fps)));
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (running_ && data_.isRunning)
+    {
+        nextTick += period;
+
+        const uint8_t *payload = nullptr;
+        size_t length = 0;
+        int width = 0, height = 0;
+        const bool captured = captureFromSdk(payload, length, width, height);
+        const int64_t captureTimeUs = steadyClockUs();
+
+        if (captured)
+        {
+            recordPayload(payload, length, width, height, captureTimeUs);
+
+            std::shared_ptr<RadiometricFrame> frame = pool_.acquire();
+            if (!frame)
+            {
+                droppedFrames_++;
+            }
+            else if (parser_.parse(payload, length, width, height, *frame))
+            {
+                frame->seq = ++seq_;
+                frame->captureTimeUs = captureTimeUs;
+                if (seq_ == 1)
+                {
+                    std::cout << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "首帧测温数据: " << width << "x" << height
+                              << ", " << (length / (static_cast<size_t>(width) * height)) << " 字节/像素, 温度范围 "
+                              << frame->minTemp << " ~ " << frame->maxTemp << "°C" << std::endl;
+                }
+
+                RadiometricFramePtr published = std::move(frame);
+                std::lock_guard<std::mutex> lock(deviceIdx_ == 0 ? data_.thermalmatrix_mutex_1 : data_.thermalmatrix_mutex_2);
+                (deviceIdx_ == 0 ? data_.radiometricFrame_1 : data_.radiometricFrame_2) = std::move(published);
+            }
+            else if (failedCaptures_++ % 50 == 0)
+            {
+                std::cerr << "[RadiometricIngest] 设备" << (deviceIdx_ + 1) << "测温数据解析失败: " << width << "x" << height
+                          << ", " << length << " 字节" << std::endl;
+            }
+        }
+
+        // 抓图耗时超过周期时不追赶，从当前时间重新计时
+        const auto now = std::chrono::steady_clock::now();
+        if (nextTick < now)
+        {
+            nextTick = now;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
@@ -0,0 +1,947 @@
+﻿#include "RtspServer.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+#pragma comment(lib, "ws2_32.lib")
+
+// ========== 内部工具函数 ==========
+
+static bool ensureWinsockInitialized()
+{
+    static std::atomic<bool> inited{false};
+    static std::mutex initMutex;
+    if (inited.load())
+        return true;
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (inited.load())
+        return true;
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        std::cerr << "[RtspServer] Winsock初始化失败" << std::endl;
+        return false;
+    }
+    inited.store(true);
+    return true;
+}
+
+static uint32_t randomU32()
+{
+    static std::mt19937 rng(std::random_device{}());
+    static std::mutex rngMutex;
+    std::lock_guard<std::mutex> lock(rngMutex);
+    return rng();
+}
+
+static std::string base64Encode(const uint8_t *data, size_t len)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < len)
+            v |= data[i + 1] << 8;
+        if (i + 2 < len)
+            v |= data[i + 2];
+        out.push_back(table[(v >> 18) & 0x3F]);
+        out.push_back(table[(v >> 12) & 0x3F]);
+        out.push_back(i + 1 < len ? table[(v >> 6) & 0x3F] : '=');
+        out.push_back(i + 2 < len ? table[v & 0x3F] : '=');
+    }
+    return out;
+}
+
+/**
+ * @brief 遍历Annex B码流中的NAL单元（去除起始码）
+ */
+static void splitAnnexB(const uint8_t *data, size_t size, std::vector<std::pair<const uint8_t *, size_t>> &nals)
+{
+    nals.clear();
+    size_t i = 0;
+    size_t nalStart = SIZE_MAX;
+    while (i + 3 <= size)
+    {
+        bool sc3 = data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1;
+        bool sc4 = i + 4 <= size && data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 0 && data[i + 3] == 1;
+        if (sc3 || sc4)
+        {
+            if (nalStart != SIZE_MAX && i > nalStart)
+                nals.emplace_back(data + nalStart, i - nalStart);
+            i += sc4 ? 4 : 3;
+            nalStart = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    if (nalStart != SIZE_MAX && nalStart < size)
+        nals.emplace_back(data + nalStart, size - nalStart);
+    else if (nalStart == SIZE_MAX && size > 0)
+        nals.emplace_back(data, size); // 无起始码，按单个NAL处理
+}
+
+static std::string toLower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+static std::string trim(const std::string &s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n");
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+}
+
+// ========== RtspClientSession ==========
+
+RtspClientSession::RtspClientSession(RtspServer &server, SOCKET socket, const sockaddr_in &addr, size_t sendWindow)
+    : server_(server), socket_(socket), addr_(addr), sendWindow_(sendWindow)
+{
+    std::ostringstream oss;
+    oss << std::hex << std::uppercase << randomU32() << randomU32();
+    sessionId_ = oss.str();
+}
+
+RtspClientSession::~RtspClientSession()
+{
+    close();
+    join();
+    if (socket_ != INVALID_SOCKET)
+    {
+        closesocket(socket_);
+        socket_ = INVALID_SOCKET;
+    }
+}
+
+void RtspClientSession::start()
+{
+    recvThread_ = std::thread(&RtspClientSession::recvLoop, this);
+    sendThread_ = std::thread(&RtspClientSession::sendLoop, this);
+}
+
+void RtspClientSession::close()
+{
+    if (closed_.exchange(true))
+        return;
+    // 只shutdown不closesocket，避免句柄在其他线程仍使用时被复用
+    if (socket_ != INVALID_SOCKET)
+        shutdown(socket_, SD_BOTH);
+    // 经过队列锁再通知：发送线程在检查 closed_ 与进入等待之间持有该锁，通知不会丢失
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+    }
+    queueCv_.notify_all();
+}
+
+void RtspClientSession::join()
+{
+    if (recvThread_.joinable())
+        recvThread_.join();
+    if (sendThread_.joinable())
+        sendThread_.join();
+}
+
+void RtspClientSession::enqueue(const RtpPacketGroupPtr &group)
+{
+    if (closed_ || !group)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (waitKeyFrame_)
+        {
+            if (!group->keyFrame)
+                return;
+            waitKeyFrame_ = false;
+        }
+
+        // 发送窗口已满：客户端消费过慢，丢弃积压数据并等待下一个关键帧
+        if (queue_.size() >= sendWindow_)
+        {
+            droppedGroups_ += queue_.size();
+            queue_.clear();
+            if (!group->keyFrame)
+            {
+                waitKeyFrame_ = true;
+                return;
+            }
+        }
+        queue_.push_back(group);
+    }
+    queueCv_.notify_one();
+}
+
+bool RtspClientSession::sendAll(const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        int n = send(socket_, data, static_cast<int>(len), 0);
+        if (n == SOCKET_ERROR || n == 0)
+            return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool RtspClientSession::sendInterleaved(uint8_t channel, const uint8_t *data, size_t len)
+{
+    uint8_t header[4] = {'$', channel, static_cast<uint8_t>((len >> 8) & 0xFF), static_cast<uint8_t>(len & 0xFF)};
+
+    // 头部与负载分两段提交，负载直接引用共享的RTP包缓冲区
+    WSABUF bufs[2];
+    bufs[0].buf = reinterpret_cast<char *>(header);
+    bufs[0].len = sizeof(header);
+    bufs[1].buf = reinterpret_cast<char *>(const_cast<uint8_t *>(data));
+    bufs[1].len = static_cast<ULONG>(len);
+
+    std::lock_guard<std::mutex> lock(socketSendMutex_);
+    DWORD sent = 0;
+    if (WSASend(socket_, bufs, 2, &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+        return false;
+    if (sent == sizeof(header) + len)
+        return true;
+
+    // 部分发送（阻塞socket上很少见），补发剩余部分
+    size_t total = sizeof(header) + len;
+    std::vector<char> rest;
+    rest.reserve(total);
+    rest.insert(rest.end(), header, header + sizeof(header));
+    rest.insert(rest.end(), data, data + len);
+    return sendAll(rest.data() + sent, total - sent);
+}
+
+bool RtspClientSession::sendResponse(int code, const std::string &reason, int cseq, const std::string &headers,
+                                     const std::string &body)
+{
+    std::ostringstream oss;
+    oss << "RTSP/1.0 " << code << " " << reason << "\r\n"
+        << "CSeq: " << cseq << "\r\n"
+        << "Server: Identify-RTSP\r\n"
+        << headers;
+    if (!body.empty())
+        oss << "Content-Length: " << body.size() << "\r\n";
+    oss << "\r\n"
+        << body;
+
+    std::string resp = oss.str();
+    std::lock_guard<std::mutex> lock(socketSendMutex_);
+    return sendAll(resp.data(), resp.size());
+}
+
+void RtspClientSession::recvLoop()
+{
+    char buffer[4096];
+    std::string acc;
+
+    while (!closed_)
+    {
+        int n = recv(socket_, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            break;
+        acc.append(buffer, buffer + n);
+
+        bool keepAlive = true;
+        while (keepAlive && !acc.empty())
+        {
+            // TCP交织模式下客户端发来的RTCP包（RR），直接跳过
+            if (acc[0] == '$')
+            {
+                if (acc.size() < 4)
+                    break;
+                size_t len = (static_cast<uint8_t>(acc[2]) << 8) | static_cast<uint8_t>(acc[3]);
+                if (acc.size() < 4 + len)
+                    break;
+                acc.erase(0, 4 + len);
+                continue;
+            }
+
+            size_t headerEnd = acc.find("\r\n\r\n");
+            if (headerEnd == std::string::npos)
+                break;
+
+            // 处理可能存在的消息体（如SET_PARAMETER）
+            size_t contentLength = 0;
+            std::string lowerHeader = toLower(acc.substr(0, headerEnd));
+            size_t clPos = lowerHeader.find("content-length:");
+            if (clPos != std::string::npos)
+                contentLength = static_cast<size_t>(std::atoi(lowerHeader.c_str() + clPos + 15));
+            if (acc.size() < headerEnd + 4 + contentLength)
+                break;
+
+            std::string request = acc.substr(0, headerEnd + 4);
+            acc.erase(0, headerEnd + 4 + contentLength);
+            keepAlive = handleRequest(request);
+        }
+
+        if (!keepAlive)
+            break;
+    }
+
+    server_.unsubscribe(this);
+    close();
+}
+
+void RtspClientSession::sendLoop()
+{
+    while (!closed_)
+    {
+        RtpPacketGroupPtr group;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCv_.wait(lock, [this]
+                          { return closed_ || !queue_.empty(); });
+            if (closed_)
+                break;
+            group = queue_.front();
+            queue_.pop_front();
+        }
+
+        for (const auto &pkt : group->packets)
+        {
+            const uint8_t *data = group->buffer.data() + pkt.first;
+            bool ok;
+            if (useTcp_)
+            {
+                ok = sendInterleaved(rtpChannel_, data, pkt.second);
+            }
+            else
+            {
+                ok = sendto(server_.udpRtpSocket_, reinterpret_cast<const char *>(data), static_cast<int>(pkt.second), 0,
+                            reinterpret_cast<const sockaddr *>(&udpDest_), sizeof(udpDest_)) != SOCKET_ERROR;
+            }
+            if (!ok)
+            {
+                close();
+                break;
+            }
+        }
+    }
+
+    if (droppedGroups_ > 0)
+    {
+        std::cout << "[RtspServer] 客户端 " << inet_ntoa(addr_.sin_addr) << " 因发送窗口溢出累计丢弃 "
+                  << droppedGroups_ << " 帧" << std::endl;
+    }
+}
+
+bool RtspClientSession::handleRequest(const std::string &request)
+{
+    std::istringstream iss(request);
+    std::string requestLine;
+    std::getline(iss, requestLine);
+    requestLine = trim(requestLine);
+
+    std::string method, url, version;
+    {
+        std::istringstream rl(requestLine);
+        rl >> method >> url >> version;
+    }
+
+    // 解析请求头（键转小写）
+    std::map<std::string, std::string> headers;
+    std::string line;
+    while (std::getline(iss, line))
+    {
+        line = trim(line);
+        if (line.empty())
+            break;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        headers[toLower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+    int cseq = headers.count("cseq") ? std::atoi(headers["cseq"].c_str()) : 0;
+    std::string sessionHeader = "Session: " + sessionId_ + ";timeout=60\r\n";
+
+    if (method == "OPTIONS")
+    {
+        return sendResponse(200, "OK", cseq, "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n");
+    }
+
+    if (method == "DESCRIBE")
+    {
+        auto stream = server_.findStream(RtspServer::pathFromUrl(url));
+        if (!stream)
+        {
+            std::cout << "[RtspServer] DESCRIBE 未找到流: " << url << std::endl;
+            return sendResponse(404, "Not Found", cseq, "");
+        }
+
+        sockaddr_in local{};
+        int localLen = sizeof(local);
+        getsockname(socket_, reinterpret_cast<sockaddr *>(&local), &localLen);
+        std::string sdp = server_.buildSdp(stream, inet_ntoa(local.sin_addr));
+        if (sdp.empty())
+        {
+            // 编码器尚未输出SPS/PPS
+            return sendResponse(503, "Service Unavailable", cseq, "");
+        }
+
+        std::string base = url;
+        if (base.empty() || base.back() != '/')
+            base += "/";
+        return sendResponse(200, "OK", cseq,
+                            "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n", sdp);
+    }
+
+    if (method == "SETUP")
+    {
+        streamPath_ = RtspServer::pathFromUrl(url);
+        if (!server_.findStream(streamPath_))
+            return sendResponse(404, "Not Found", cseq, "");
+
+        std::string transport = headers["transport"];
+        std::string lowerTransport = toLower(transport);
+        std::ostringstream respTransport;
+
+        if (lowerTransport.find("rtp/avp/tcp") != std::string::npos)
+        {
+            useTcp_ = true;
+            int ch0 = 0, ch1 = 1;
+            size_t pos = lowerTransport.find("interleaved=");
+            if (pos != std::string::npos)
+                sscanf(lowerTransport.c_str() + pos, "interleaved=%d-%d", &ch0, &ch1);
+            rtpChannel_ = static_cast<uint8_t>(ch0);
+            respTransport << "RTP/AVP/TCP;unicast;interleaved=" << ch0 << "-" << ch1;
+        }
+        else
+        {
+            if (server_.udpRtpSocket_ == INVALID_SOCKET)
+                return sendResponse(461, "Unsupported Transport", cseq, "");
+
+            int p0 = 0, p1 = 0;
+            size_t pos = lowerTransport.find("client_port=");
+            if (pos == std::string::npos ||
+                sscanf(lowerTransport.c_str() + pos, "client_port=%d-%d", &p0, &p1) < 1)
+                return sendResponse(461, "Unsupported Transport", cseq, "");
+            if (p1 == 0)
+                p1 = p0 + 1;
+
+            useTcp_ = false;
+            udpDest_ = addr_;
+            udpDest_.sin_port = htons(static_cast<u_short>(p0));
+            respTransport << "RTP/AVP;unicast;client_port=" << p0 << "-" << p1
+                          << ";server_port=" << server_.rtpPort_ << "-" << (server_.rtpPort_ + 1);
+        }
+
+        return sendResponse(200, "OK", cseq, "Transport: " + respTransport.str() + "\r\n" + sessionHeader);
+    }
+
+    if (method == "PLAY")
+    {
+        auto stream = server_.findStream(streamPath_.empty() ? RtspServer::pathFromUrl(url) : streamPath_);
+        if (!stream)
+            return sendResponse(454, "Session Not Found", cseq, "");
+
+        uint16_t seq;
+        uint32_t rtptime;
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            seq = stream->nextSeq;
+            rtptime = stream->lastTimestamp;
+        }
+
+        std::string base = url;
+        if (!base.empty() && base.back() == '/')
+            base.pop_back();
+        std::ostringstream extra;
+        extra << sessionHeader << "Range: npt=0.000-\r\n"
+              << "RTP-Info: url=" << base << "/trackID=0;seq=" << seq << ";rtptime=" << rtptime << "\r\n";
+        if (!sendResponse(200, "OK", cseq, extra.str()))
+            return false;
+
+        // 响应发送后再订阅，保证客户端先收到PLAY应答再收到RTP数据
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            waitKeyFrame_ = true;
+            playing_ = true;
+        }
+        server_.subscribe(stream->path, shared_from_this());
+        std::cout << "[RtspServer] 客户端 " << inet_ntoa(addr_.sin_addr) << " 开始播放 /" << stream->path
+                  << (useTcp_ ? " (TCP交织)" : " (UDP)") << std::endl;
+        return true;
+    }
+
+    if (method == "TEARDOWN")
+    {
+        sendResponse(200, "OK", cseq, sessionHeader);
+        return false;
+    }
+
+    if (method == "GET_PARAMETER" || method == "SET_PARAMETER")
+    {
+        // 客户端保活
+        return sendResponse(200, "OK", cseq, sessionHeader);
+    }
+
+    return sendResponse(501, "Not Implemented", cseq, "");
+}
+
+// ========== RtspServer ==========
+
+RtspServer::RtspServer()
+{
+}
+
+RtspServer::~RtspServer()
+{
+    stop();
+}
+
+bool RtspServer::start(uint16_t port, uint16_t rtpPort, size_t sendWindow)
+{
+    if (!ensureWinsockInitialized())
+        return false;
+
+    stop();
+    port_ = port;
+    rtpPort_ = rtpPort;
+    sendWindow_ = (std::max)(static_cast<size_t>(2), sendWindow);
+
+    listenSocket_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket_ == INVALID_SOCKET)
+    {
+        std::cerr << "[RtspServer] 创建监听socket失败, err=" << WSAGetLastError() << std::endl;
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port_);
+    if (bind(listenSocket_, (sockaddr *)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        listen(listenSocket_, SOMAXCONN) == SOCKET_ERROR)
+    {
+        std::cerr << "[RtspServer] 绑定/监听端口 " << port_ << " 失败, err=" << WSAGetLastError() << std::endl;
+        closesocket(listenSocket_);
+        listenSocket_ = INVALID_SOCKET;
+        return false;
+    }
+
+    // UDP传输：绑定RTP/RTCP端口对，失败时仅支持TCP交织
+    udpRtpSocket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    udpRtcpSocket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in rtpAddr = addr;
+    rtpAddr.sin_port = htons(rtpPort_);
+    sockaddr_in rtcpAddr = addr;
+    rtcpAddr.sin_port = htons(static_cast<u_short>(rtpPort_ + 1));
+    if (udpRtpSocket_ == INVALID_SOCKET || udpRtcpSocket_ == INVALID_SOCKET ||
+        bind(udpRtpSocket_, (sockaddr *)&rtpAddr, sizeof(rtpAddr)) == SOCKET_ERROR ||
+        bind(udpRtcpSocket_, (sockaddr *)&rtcpAddr, sizeof(rtcpAddr)) == SOCKET_ERROR)
+    {
+        std::cerr << "[RtspServer] UDP端口 " << rtpPort_ << "-" << (rtpPort_ + 1)
+                  << " 绑定失败，仅支持TCP交织传输" << std::endl;
+        if (udpRtpSocket_ != INVALID_SOCKET)
+            closesocket(udpRtpSocket_);
+        if (udpRtcpSocket_ != INVALID_SOCKET)
+            closesocket(udpRtcpSocket_);
+        udpRtpSocket_ = INVALID_SOCKET;
+        udpRtcpSocket_ = INVALID_SOCKET;
+    }
+    else
+    {
+        int sndBuf = 4 * 1024 * 1024;
+        setsockopt(udpRtpSocket_, SOL_SOCKET, SO_SNDBUF, (char *)&sndBuf, sizeof(sndBuf));
+    }
+
+    running_ = true;
+    acceptThread_ = std::thread(&RtspServer::acceptLoop, this);
+    std::cout << "[RtspServer] 内嵌RTSP服务器已启动，端口: " << port_ << "，RTP/UDP端口: " << rtpPort_ << std::endl;
+    return true;
+}
+
+void RtspServer::stop()
+{
+    if (!running_.exchange(false))
+        return;
+
+    if (listenSocket_ != INVALID_SOCKET)
+    {
+        closesocket(listenSocket_);
+        listenSocket_ = INVALID_SOCKET;
+    }
+    if (acceptThread_.joinable())
+        acceptThread_.join();
+
+    // 先从所有流中移除订阅者，再关闭会话
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex_);
+        for (auto &kv : streams_)
+        {
+            std::lock_guard<std::mutex> streamLock(kv.second->mutex);
+            kv.second->subscribers.clear();
+        }
+    }
+
+    std::vector<std::shared_ptr<RtspClientSession>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        sessions.swap(sessions_);
+    }
+    // 等待所有会话线程退出后再释放，服务器析构后不会再有会话线程访问它
+    for (auto &s : sessions)
+        s->close();
+    for (auto &s : sessions)
+        s->join();
+    sessions.clear();
+
+    if (udpRtpSocket_ != INVALID_SOCKET)
+    {
+        closesocket(udpRtpSocket_);
+        udpRtpSocket_ = INVALID_SOCKET;
+    }
+    if (udpRtcpSocket_ != INVALID_SOCKET)
+    {
+        closesocket(udpRtcpSocket_);
+        udpRtcpSocket_ = INVALID_SOCKET;
+    }
+    std::cout << "[RtspServer] 内嵌RTSP服务器已停止" << std::endl;
+}
+
+void RtspServer::acceptLoop()
+{
+    while (running_)
+    {
+        sockaddr_in caddr;
+        int clen = sizeof(caddr);
+        SOCKET cs = accept(listenSocket_, (sockaddr *)&caddr, &clen);
+        if (cs == INVALID_SOCKET)
+        {
+            if (running_)
+            {
+                std::cerr << "[RtspServer] accept错误, err=" << WSAGetLastError() << std::endl;
+            }
+            continue;
+        }
+
+        int noDelay = 1;
+        setsockopt(cs, IPPROTO_TCP, TCP_NODELAY, (char *)&noDelay, sizeof(noDelay));
+
+        reapClosedSessions();
+
+        auto session = std::make_shared<RtspClientSession>(*this, cs, caddr, sendWindow_);
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex_);
+            sessions_.push_back(session);
+        }
+        session->start();
+    }
+}
+
+void RtspServer::reapClosedSessions()
+{
+    std::vector<std::shared_ptr<RtspClientSession>> closed;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        auto it = std::partition(sessions_.begin(), sessions_.end(), [](const std::shared_ptr<RtspClientSession> &s)
+                                 { return !s->isClosed(); });
+        closed.assign(it, sessions_.end());
+        sessions_.erase(it, sessions_.end());
+    }
+    // 锁外等待会话线程退出（推流线程可能仍持有引用，析构时线程已结束）
+    for (auto &s : closed)
+        s->join();
+}
+
+std::shared_ptr<RtspMediaStream> RtspServer::findStream(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(streamsMutex_);
+    auto it = streams_.find(path);
+    return it != streams_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<RtspMediaStream> RtspServer::getOrCreateStream(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(streamsMutex_);
+    auto &stream = streams_[path];
+    if (!stream)
+    {
+        stream = std::make_shared<RtspMediaStream>();
+        stream->path = path;
+        stream->ssrc = randomU32();
+        stream->nextSeq = static_cast<uint16_t>(randomU32());
+    }
+    return stream;
+}
+
+void RtspServer::subscribe(const std::string &path, const std::shared_ptr<RtspClientSession> &session)
+{
+    auto stream = findStream(path);
+    if (!stream)
+        return;
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (std::find(stream->subscribers.begin(), stream->subscribers.end(), session) == stream->subscribers.end())
+        stream->subscribers.push_back(session);
+}
+
+void RtspServer::unsubscribe(const RtspClientSession *session)
+{
+    std::lock_guard<std::mutex> lock(streamsMutex_);
+    for (auto &kv : streams_)
+    {
+        std::lock_guard<std::mutex> streamLock(kv.second->mutex);
+        auto &subs = kv.second->subscribers;
+        subs.erase(std::remove_if(subs.begin(), subs.end(), [session](const std::shared_ptr<RtspClientSession> &s)
+                                  { return s.get() == session; }),
+                   subs.end());
+    }
+}
+
+size_t RtspServer::getSubscriberCount(const std::string &path)
+{
+    auto stream = findStream(path);
+    if (!stream)
+        return 0;
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    return static_cast<size_t>(std::count_if(stream->subscribers.begin(), stream->subscribers.end(),
+                                             [](const std::shared_ptr<RtspClientSession> &s)
+                                             { return !s->isClosed(); }));
+}
+
+std::string RtspServer::pathFromUrl(const std::string &url)
+{
+    std::string path = url;
+    size_t scheme = path.find("://");
+    if (scheme != std::string::npos)
+    {
+        size_t slash = path.find('/', scheme + 3);
+        path = (slash == std::string::npos) ? std::string() : path.substr(slash + 1);
+    }
+    while (!path.empty() && path.front() == '/')
+        path.erase(0, 1);
+
+    // 去除查询参数与SETUP中的轨道后缀（/trackID=0）
+    size_t query = path.find('?');
+    if (query != std::string::npos)
+        path.erase(query);
+    size_t track = path.find("/trackID=");
+    if (track != std::string::npos)
+        path.erase(track);
+    while (!path.empty() && path.back() == '/')
+        path.pop_back();
+    return path;
+}
+
+void RtspServer::setStreamParameters(const std::string &path, const uint8_t *extradata, int size)
+{
+    auto stream = getOrCreateStream(path);
+    if (!extradata || size <= 0)
+        return;
+
+    std::vector<uint8_t> sps, pps;
+    if (extradata[0] == 1 && size > 7)
+    {
+        // avcC格式
+        int pos = 5;
+        int numSps = extradata[pos++] & 0x1F;
+        for (int i = 0; i < numSps && pos + 2 <= size; i++)
+        {
+            int len = (extradata[pos] << 8) | extradata[pos + 1];
+            pos += 2;
+            if (pos + len > size)
+                break;
+            if (sps.empty())
+                sps.assign(extradata + pos, extradata + pos + len);
+            pos += len;
+        }
+        int numPps = pos < size ? extradata[pos++] : 0;
+        for (int i = 0; i < numPps && pos + 2 <= size; i++)
+        {
+            int len = (extradata[pos] << 8) | extradata[pos + 1];
+            pos += 2;
+            if (pos + len > size)
+                break;
+            if (pps.empty())
+                pps.assign(extradata + pos, extradata + pos + len);
+            pos += len;
+        }
+    }
+    else
+    {
+        // Annex B格式（libx264 + AV_CODEC_FLAG_GLOBAL_HEADER）
+        std::vector<std::pair<const uint8_t *, size_t>> nals;
+        splitAnnexB(extradata, static_cast<size_t>(size), nals);
+        for (const auto &nal : nals)
+        {
+            int type = nal.first[0] & 0x1F;
+            if (type == 7 && sps.empty())
+                sps.assign(nal.first, nal.first + nal.second);
+            else if (type == 8 && pps.empty())
+                pps.assign(nal.first, nal.first + nal.second);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (!sps.empty())
+        stream->sps = sps;
+    if (!pps.empty())
+        stream->pps = pps;
+    std::cout << "[RtspServer] 注册流 /" << path << " (SPS " << stream->sps.size() << "B, PPS "
+              << stream->pps.size() << "B)" << std::endl;
+}
+
+std::string RtspServer::buildSdp(const std::shared_ptr<RtspMediaStream> &stream, const std::string &localIp)
+{
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (stream->sps.size() < 4 || stream->pps.empty())
+        return std::string();
+
+    std::ostringstream sdp;
+    sdp << "v=0\r\n"
+        << "o=- " << stream->ssrc << " 1 IN IP4 " << localIp << "\r\n"
+        << "s=" << stream->path << "\r\n"
+        << "c=IN IP4 0.0.0.0\r\n"
+        << "t=0 0\r\n"
+        << "a=control:*\r\n"
+        << "m=video 0 RTP/AVP 96\r\n"
+        << "a=rtpmap:96 H264/90000\r\n"
+        << "a=fmtp:96 packetization-mode=1;profile-level-id="
+        << std::hex << std::setfill('0') << std::uppercase
+        << std::setw(2) << static_cast<int>(stream->sps[1])
+        << std::setw(2) << static_cast<int>(stream->sps[2])
+        << std::setw(2) << static_cast<int>(stream->sps[3])
+        << std::dec << ";sprop-parameter-sets="
+        << base64Encode(stream->sps.data(), stream->sps.size()) << ","
+        << base64Encode(stream->pps.data(), stream->pps.size()) << "\r\n"
+        << "a=control:trackID=0\r\n";
+    return sdp.str();
+}
+
+void RtspServer::packetizeNal(RtspMediaStream &stream, RtpPacketGroup &group, const uint8_t *nal, size_t len,
+                              bool lastNalOfAu)
+{
+    auto writeHeader = [&](bool marker)
+    {
+        size_t off = group.buffer.size();
+        group.buffer.resize(off + 12);
+        uint8_t *h = group.buffer.data() + off;
+        uint16_t seq = stream.nextSeq++;
+        h[0] = 0x80;
+        h[1] = static_cast<uint8_t>((marker ? 0x80 : 0x00) | 96);
+        h[2] = static_cast<uint8_t>(seq >> 8);
+        h[3] = static_cast<uint8_t>(seq & 0xFF);
+        h[4] = static_cast<uint8_t>(group.rtpTimestamp >> 24);
+        h[5] = static_cast<uint8_t>(group.rtpTimestamp >> 16);
+        h[6] = static_cast<uint8_t>(group.rtpTimestamp >> 8);
+        h[7] = static_cast<uint8_t>(group.rtpTimestamp);
+        h[8] = static_cast<uint8_t>(stream.ssrc >> 24);
+        h[9] = static_cast<uint8_t>(stream.ssrc >> 16);
+        h[10] = static_cast<uint8_t>(stream.ssrc >> 8);
+        h[11] = static_cast<uint8_t>(stream.ssrc);
+        return off;
+    };
+
+    if (len == 0)
+        return;
+
+    if (len <= kMaxRtpPayload)
+    {
+        // 单NAL单元包
+        size_t off = writeHeader(lastNalOfAu);
+        group.buffer.insert(group.buffer.end(), nal, nal + len);
+        group.packets.emplace_back(off, 12 + len);
+        return;
+    }
+
+    // FU-A分片
+    uint8_t nalHeader = nal[0];
+    const uint8_t *payload = nal + 1;
+    size_t remaining = len - 1;
+    bool first = true;
+    while (remaining > 0)
+    {
+        size_t chunk = (std::min)(remaining, kMaxRtpPayload - 2);
+        bool last = (chunk == remaining);
+        size_t off = writeHeader(last && lastNalOfAu);
+        group.buffer.push_back(static_cast<uint8_t>((nalHeader & 0xE0) | 28));
+        group.buffer.push_back(static_cast<uint8_t>((first ? 0x80 : 0x00) | (last ? 0x40 : 0x00) | (nalHeader & 0x1F)));
+        group.buffer.insert(group.buffer.end(), payload, payload + chunk);
+        group.packets.emplace_back(off, 12 + 2 + chunk);
+        payload += chunk;
+        remaining -= chunk;
+        first = false;
+    }
+}
+
+void RtspServer::publishPacket(const std::string &path, const uint8_t *data, int size, int64_t pts90k, bool keyFrame)
+{
+    if (!running_ || !data || size <= 0)
+        return;
+
+    auto stream = getOrCreateStream(path);
+
+    std::vector<std::pair<const uint8_t *, size_t>> nals;
+    splitAnnexB(data, static_cast<size_t>(size), nals);
+    if (nals.empty())
+        return;
+
+    auto group = std::make_shared<RtpPacketGroup>();
+    group->rtpTimestamp = static_cast<uint32_t>(pts90k);
+    group->keyFrame = keyFrame;
+    group->buffer.reserve(static_cast<size_t>(size) + (size / kMaxRtpPayload + 4) * 14 + 64);
+
+    std::vector<std::shared_ptr<RtspClientSession>> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+
+        // 码流内带SPS/PPS时更新缓存；关键帧缺少参数集时补发，保证中途加入的客户端能解码
+        bool hasInbandSps = false;
+        for (const auto &nal : nals)
+        {
+            int type = nal.first[0] & 0x1F;
+            if (type == 7)
+            {
+                stream->sps.assign(nal.first, nal.first + nal.second);
+                hasInbandSps = true;
+            }
+            else if (type == 8)
+            {
+                stream->pps.assign(nal.first, nal.first + nal.second);
+            }
+        }
+        if (keyFrame && !hasInbandSps && !stream->sps.empty() && !stream->pps.empty())
+        {
+            packetizeNal(*stream, *group, stream->sps.data(), stream->sps.size(), false);
+            packetizeNal(*stream, *group, stream->pps.data(), stream->pps.size(), false);
+        }
+
+        // 标记位打在实际发送的最后一个NAL上（访问单元可能以AUD结尾）
+        size_t lastSent = nals.size();
+        for (size_t i = 0; i < nals.size(); i++)
+        {
+            if ((nals[i].first[0] & 0x1F) != 9)
+                lastSent = i;
+        }
+        for (size_t i = 0; i < nals.size(); i++)
+        {
+            int type = nals[i].first[0] & 0x1F;
+            if (type == 9) // AUD无需发送
+                continue;
+            packetizeNal(*stream, *group, nals[i].first, nals[i].second, i == lastSent);
+        }
+        stream->lastTimestamp = group->rtpTimestamp;
+
+        if (stream->subscribers.empty())
+            return;
+        subscribers = stream->subscribers;
+    }
+
+    // 扇出：各客户端仅持有同一包组的引用
+    RtpPacketGroupPtr shared = group;
+    for (auto &s : subscribers)
+        s->enqueue(shared);
+}
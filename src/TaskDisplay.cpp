@@ -71,11 +71,13 @@ void TaskDisplay::run()
             std::string deviceInfo = "";
 
             // 优先显示设备1的数据，如果没有则显示设备2的数据
+            // 标注经渲染缓存绘制，与推流输出取用相同图层时共用同一次绘制
             {
                 std::lock_guard<std::mutex> lock(data_.processed_thermal_mutex_1);
                 if (!data_.processed_thermal_frame_1.empty())
                 {
-                    data_.processed_thermal_frame_1.copyTo(displayFrame);
+                    displayFrame = data_.processed_thermal_render_1.render(data_.processed_thermal_frame_1, data_.processed_thermal_meta_1.seq,
+                                                                           data_.processed_thermal_overlay_1, data_.overlayRenderConfig.displayLayers);
                     deviceInfo = " - 设备1(一位端)热成像";
                 }
             }
@@ -86,7 +88,8 @@ void TaskDisplay::run()
                 std::lock_guard<std::mutex> lock(data_.processed_thermal_mutex_2);
                 if (!data_.processed_thermal_frame_2.empty())
                 {
-                    data_.processed_thermal_frame_2.copyTo(displayFrame);
+                    displayFrame = data_.processed_thermal_render_2.render(data_.processed_thermal_frame_2, data_.processed_thermal_meta_2.seq,
+                                                                           data_.processed_thermal_overlay_2, data_.overlayRenderConfig.displayLayers);
                     deviceInfo = " - 设备2(二位端)热成像";
                 }
             }
@@ -124,48 +127,32 @@ void TaskDisplay::run()
 // 处理视频帧和温度数据（核心处理逻辑）
 void TaskDisplay::processVideoFrames()
 {
-    cv::Mat displayFrame, thermalMatrix;
-    cv::Mat displayFrame2, thermalMatrix2;
+    cv::Mat displayFrame, displayFrame2;
+    FrameMeta frameMeta, frameMeta2; // 原始帧元数据，随处理后帧一并发布
+    std::vector<cv::Rect> hotRects, hotRects2; // 高温区域外接矩形（用于ROI编码）
+    ThermalAnalysisResultPtr analysis, analysis2; // 热成像线程发布的高温区域分析结果
 
     // 处理第一路热成像视频
     
     std::lock_guard<std::mutex> lock1(data_.thermal_mutex_1);
     std::lock_guard<std::mutex> lock2(data_.thermalmatrix_mutex_1);
+    frameMeta = data_.thermal_video_meta_1;
 
     // 测试模式，无温度数据
-    if (!data_.thermal_video_frame_1.empty() && data_.thermalMatrix_1.empty())
+    if (!data_.thermal_video_frame_1.empty() && data_.thermalMask_1.empty())
         {
             std::cout << "process fake TemperatureData" << std::endl;
-            data_.thermal_video_frame_1.copyTo(displayFrame);
-
-            // 创建虚假温度矩阵 (640x512 对应热成像分辨率)
-            data_.thermalMatrix_1 = cv::Mat::zeros(512, 640, CV_32F);
-            cv::randu(data_.thermalMatrix_1, cv::Scalar(20.0f), cv::Scalar(35.0f));
-
-            // 添加模拟的高温区域
-            std::vector<cv::Point> hotSpots = {
-                cv::Point(150, 120), cv::Point(350, 250), cv::Point(500, 380)};
-
-            for (size_t i = 0; i < hotSpots.size(); ++i)
-            {
-                const auto &spot = hotSpots[i];
-                float hotTemp = 45.0f + (i * 5.0f) + (rand() % 10);
-                cv::circle(data_.thermalMatrix_1, spot, 25 + (i * 5), cv::Scalar(hotTemp), -1);
-                cv::circle(data_.thermalMatrix_1, spot, 35 + (i * 5), cv::Scalar(hotTemp - 5.0f), 3);
-            }
-
-            // 添加噪声
-            cv::Mat noise(512, 640, CV_32F);
-            cv::randu(noise, cv::Scalar(-2.0f), cv::Scalar(2.0f));
-            data_.thermalMatrix_1 += noise;
-            data_.thermalMatrix_1.copyTo(thermalMatrix);
+            generateFakeThermalMask(data_.thermalMask_1,
+                                    {cv::Point(150, 120), cv::Point(350, 250), cv::Point(500, 380)}, 20.0f, 45.0f);
+            data_.thermalAnalysis_1 = fakeAnalyzer_.analyze(data_.thermalMask_1, currentAlarmThreshold(),
+                                                           frameMeta.seq, frameMeta.captureTimeUs);
         }
 
     // 真实模式，有温度数据
-    if (!data_.thermal_video_frame_1.empty() && !data_.thermalMatrix_1.empty())
+    if (!data_.thermal_video_frame_1.empty() && data_.thermalAnalysis_1)
     {
         data_.thermal_video_frame_1.copyTo(displayFrame);
-        data_.thermalMatrix_1.copyTo(thermalMatrix);
+        analysis = data_.thermalAnalysis_1;
     }
 
 
@@ -173,60 +160,91 @@ void TaskDisplay::processVideoFrames()
     
     std::lock_guard<std::mutex> lock3(data_.thermal_mutex_2);
     std::lock_guard<std::mutex> lock4(data_.thermalmatrix_mutex_2);
+    frameMeta2 = data_.thermal_video_meta_2;
 
     // 测试模式，生成第二路虚假温度数据
-    if (!data_.thermal_video_frame_2.empty() && data_.thermalMatrix_2.empty())
+    if (!data_.thermal_video_frame_2.empty() && data_.thermalMask_2.empty())
         {
             std::cout << "process fake TemperatureData2" << std::endl;
-            data_.thermalMatrix_2 = cv::Mat::zeros(512, 640, CV_32F);
-            cv::randu(data_.thermalMatrix_2, cv::Scalar(22.0f), cv::Scalar(37.0f));
-
-            std::vector<cv::Point> hotSpots2 = {
-                cv::Point(200, 180), cv::Point(400, 300), cv::Point(100, 420)};
-
-            for (size_t i = 0; i < hotSpots2.size(); ++i)
-            {
-                const auto &spot = hotSpots2[i];
-                float hotTemp = 48.0f + (i * 6.0f) + (rand() % 8);
-                cv::circle(data_.thermalMatrix_2, spot, 20 + (i * 4), cv::Scalar(hotTemp), -1);
-                cv::circle(data_.thermalMatrix_2, spot, 30 + (i * 4), cv::Scalar(hotTemp - 4.0f), 2);
-            }
-
-            cv::Mat noise2(512, 640, CV_32F);
-            cv::randu(noise2, cv::Scalar(-1.5f), cv::Scalar(1.5f));
-            data_.thermalMatrix_2 += noise2;
+            generateFakeThermalMask(data_.thermalMask_2,
+                                    {cv::Point(200, 180), cv::Point(400, 300), cv::Point(100, 420)}, 22.0f, 48.0f);
+            data_.thermalAnalysis_2 = fakeAnalyzer_.analyze(data_.thermalMask_2, currentAlarmThreshold(),
+                                                           frameMeta2.seq, frameMeta2.captureTimeUs);
         }
         
     // 真实模式，有温度数据
-    if (!data_.thermal_video_frame_2.empty() && !data_.thermalMatrix_2.empty())
+    if (!data_.thermal_video_frame_2.empty() && data_.thermalAnalysis_2)
     {
         data_.thermal_video_frame_2.copyTo(displayFrame2);
-        data_.thermalMatrix_2.copyTo(thermalMatrix2);
+        analysis2 = data_.thermalAnalysis_2;
     }
     
 
-    // 处理第一路显示和RTSP输出
-    if (!displayFrame.empty() && !thermalMatrix.empty())
+    // 处理第一路显示和RTSP输出（帧不带标注，高温区域作为标注数据一并发布）
+    if (!displayFrame.empty() && analysis)
     {
         // std::cout << "process True TemperatureData1" << std::endl;
-        processTemperatureData(thermalMatrix, displayFrame);
+        auto overlay = std::make_shared<FrameOverlay>();
+        processTemperatureData(*analysis, displayFrame, hotRects, *overlay);
+        // 共享内存帧总线（在锁外复制，未启用时直接返回）
+        data_.processed_thermal_bus_1.publish(displayFrame, frameMeta.seq, frameMeta.captureTimeUs);
         // RTSP 输出 - 复制处理后的第一路热成像帧
         std::lock_guard<std::mutex> lock5(data_.processed_thermal_mutex_1);
         displayFrame.copyTo(data_.processed_thermal_frame_1);
+        data_.processed_thermal_overlay_1 = std::move(overlay);
+        data_.processed_thermal_meta_1 = frameMeta;
+        data_.processed_thermal_rois_1.swap(hotRects);
     }
 
     // 处理第二路显示和RTSP输出
 
-    if (!displayFrame2.empty() && !thermalMatrix2.empty())
+    if (!displayFrame2.empty() && analysis2)
     {
         // std::cout << "process True TemperatureData2" << std::endl;  
-        processTemperatureData(thermalMatrix2, displayFrame2);
+        auto overlay2 = std::make_shared<FrameOverlay>();
+        processTemperatureData(*analysis2, displayFrame2, hotRects2, *overlay2);
+        data_.processed_thermal_bus_2.publish(displayFrame2, frameMeta2.seq, frameMeta2.captureTimeUs);
         // RTSP 输出 - 复制处理后的第二路热成像帧
         std::lock_guard<std::mutex> lock6(data_.processed_thermal_mutex_2);
         displayFrame2.copyTo(data_.processed_thermal_frame_2);
+        data_.processed_thermal_overlay_2 = std::move(overlay2);
+        data_.processed_thermal_meta_2 = frameMeta2;
+        data_.processed_thermal_rois_2.swap(hotRects2);
     }
 }
 
+// 测试模式：生成带模拟高温区域的温度矩阵，并按报警阈值打包为高温掩码
+void TaskDisplay::generateFakeThermalMask(ThermalBitMask &mask, const std::vector<cv::Point> &hotSpots,
+                                          float baseTemp, float hotTemp)
+{
+    // 创建虚假温度矩阵 (640x512 对应热成像分辨率)
+    cv::Mat fakeMatrix = cv::Mat::zeros(512, 640, CV_32F);
+    cv::randu(fakeMatrix, cv::Scalar(baseTemp), cv::Scalar(baseTemp + 15.0f));
+
+    // 添加模拟的高温区域
+    for (size_t i = 0; i < hotSpots.size(); ++i)
+    {
+        const auto &spot = hotSpots[i];
+        float spotTemp = hotTemp + (i * 5.0f) + (rand() % 10);
+        cv::circle(fakeMatrix, spot, 25 + (i * 5), cv::Scalar(spotTemp), -1);
+        cv::circle(fakeMatrix, spot, 35 + (i * 5), cv::Scalar(spotTemp - 5.0f), 3);
+    }
+
+    // 添加噪声
+    cv::Mat noise(512, 640, CV_32F);
+    cv::randu(noise, cv::Scalar(-2.0f), cv::Scalar(2.0f));
+    fakeMatrix += noise;
+
+    mask.packFrom(fakeMatrix, currentAlarmThreshold());
+}
+
+// 读取当前报警阈值
+float TaskDisplay::currentAlarmThreshold()
+{
+    std::lock_guard<std::mutex> lock(data_.alarmThresholdMutex);
+    return data_.g_alarmThreshold;
+}
+
 // 初始化显示窗口
 void TaskDisplay::initializeDisplay()
 {
@@ -257,51 +275,33 @@ void TaskDisplay::cleanupDisplay()
     }
 }
 
-// 处理温度数据，在视频帧上绘制高温区域
-void TaskDisplay::processTemperatureData(const cv::Mat &tempMatrix, cv::Mat &frame)
+// 把热成像线程分析得到的高温区域换算到视频帧坐标，记入标注数据
+void TaskDisplay::processTemperatureData(const ThermalAnalysisResult &analysis, const cv::Mat &frame, std::vector<cv::Rect> &hotRects,
+                                         FrameOverlay &overlay)
 {
-    float scaleX = 1280.0f / 640.0f;
-    float scaleY = 720.0f / 512.0f;
+    hotRects.clear();
 
-    if (tempMatrix.empty() || frame.empty())
+    if (frame.empty() || analysis.matrixSize.area() <= 0)
         return;
 
-    float alarmThreshold;
-    {
-        std::lock_guard<std::mutex> lock3(data_.alarmThresholdMutex);
-        alarmThreshold = data_.g_alarmThreshold;
-    }
-
-    // 温度阈值分割
-    cv::Mat thresholdMask;
-    cv::threshold(tempMatrix, thresholdMask, alarmThreshold, 255, cv::THRESH_BINARY);
-    thresholdMask.convertTo(thresholdMask, CV_8UC1);
+    // 温度矩阵坐标 -> 视频帧坐标
+    float scaleX = static_cast<float>(frame.cols) / analysis.matrixSize.width;
+    float scaleY = static_cast<float>(frame.rows) / analysis.matrixSize.height;
 
-    // 形态学滤波
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5));
-    cv::morphologyEx(thresholdMask, thresholdMask, cv::MORPH_OPEN, kernel);
-
-    // 查找高温区域轮廓
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(thresholdMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    // 绘制最小外接矩形
-    for (const auto &contour : contours)
+    // 记录最小外接矩形
+    for (const auto &blob : analysis.blobs)
     {
-        if (cv::contourArea(contour) > 100)
+        const cv::Rect &box = blob.boundingBox;
+        hotRects.emplace_back(cvRound(box.x * scaleX), cvRound(box.y * scaleY),
+                              cvRound(box.width * scaleX), cvRound(box.height * scaleY));
+
+        std::array<cv::Point2f, 4> vertices;
+        blob.orientedBox.points(vertices.data());
+        for (auto &v : vertices)
         {
-            std::vector<cv::Point> scaledContour;
-            for (const auto &pt : contour)
-            {
-                scaledContour.emplace_back(cvRound(pt.x * scaleX), cvRound(pt.y * scaleY));
-            }
-            cv::RotatedRect rect = cv::minAreaRect(scaledContour);
-            cv::Point2f vertices[4];
-            rect.points(vertices);
-            for (int i = 0; i < 4; i++)
-            {
-                cv::line(frame, vertices[i], vertices[(i + 1) % 4], cv::Scalar(0, 255, 255), 2);
-            }
+            v.x *= scaleX;
+            v.y *= scaleY;
         }
+        overlay.hotSpots.push_back(vertices);
     }
-}
\ No newline at end of file
+}
@@ -45,6 +45,7 @@ void TaskLocationReporter::start()
             locationReporter_.reset();
             return;
         }
+        locationReporter_->setEventJournal(data_.eventJournal, data_.eventJournalConfig.logAllPackets);
 
         // 3. Start reporting thread
         isRunning_ = true;
@@ -132,6 +133,13 @@ void TaskLocationReporter::run()
             {
                 locationReporter_->reportLocation(camera1_visible, camera1_thermal,
                                                   camera2_visible, camera2_thermal);
+
+                // Publish the latest train speed (used by the detection cadence in object tracking)
+                ParsedGYKData gykData;
+                if (locationReporter_->getLastValidData(gykData))
+                {
+                    data_.trainSpeedKmh = static_cast<float>(gykData.actualSpeed);
+                }
             }
 
             // 3. Output debug info (only when targets are detected)
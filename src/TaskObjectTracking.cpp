@@ -9,14 +9,38 @@
 
 // 包含yolo_track库的头文件
 #include "config_manager.h"
-#include "infer.h"
+#include "IDetector.h"
+#include "InferenceRoi.h"
+#include "InferenceScheduler.h"
+#include "CadenceController.h"
+#include "FlatByteTracker.h"
 #include "tracker.h"
 #include "counting_line.h"
 
+// 在流水线阶段之间传递的单帧任务
+struct TaskObjectTracking::FrameJob
+{
+    int cameraId = 0;                            // 摄像头ID (1或2)
+    cv::Mat frame;                               // 检测输入，原样发布为处理后帧（缓冲区随任务复用）
+    FrameMeta meta;                              // 原始帧元数据
+    bool detected = false;                       // 本帧是否运行了检测（否则使用预测位置）
+    std::future<std::vector<Detection>> pending; // 已提交的检测
+    std::vector<Detection> detections;           // 检测结果（检测阶段填写）
+    std::vector<TrackResult> tracks;             // 追踪结果（追踪阶段填写）
+    std::vector<int> removedTracks;              // 本帧被追踪器移除的跟踪ID（追踪阶段填写，用于清理计数状态）
+    std::vector<cv::Rect> trackRects;            // 未丢失的跟踪框（输出阶段填写，用于ROI编码）
+    std::shared_ptr<FrameOverlay> overlay;       // 本帧标注数据（输出阶段填写，随处理后帧发布）
+    double detectTime = 0.0;                     // 检测耗时（毫秒，含批处理排队）
+    double trackTime = 0.0;                      // 追踪耗时（毫秒）
+};
+
 // 构造函数，初始化目标追踪任务
 TaskObjectTracking::TaskObjectTracking(SharedData &data, const ObjectTrackingConfig &config)
     : data_(data),
       config_(config),
+      freeJobs_(kJobPoolSize),
+      trackQueue_(kStageQueueDepth),
+      outputQueue_(kStageQueueDepth),
       frameCount_(0),
       totalDetectTime_(0.0),
       totalTrackTime_(0.0),
@@ -47,9 +71,10 @@ void TaskObjectTracking::start()
         return;
     }
 
-    if (!std::filesystem::exists(configMgr->getEnginePath()))
+    const std::string modelPath = config_.detector.backend == "opencv_dnn" ? config_.detector.onnxPath : configMgr->getEnginePath();
+    if (!std::filesystem::exists(modelPath))
     {
-        std::cerr << "[TaskObjectTracking] 错误：找不到模型文件 " << configMgr->getEnginePath() << std::endl;
+        std::cerr << "[TaskObjectTracking] 错误：找不到模型文件 " << modelPath << std::endl;
         return;
     }
 
@@ -61,6 +86,7 @@ void TaskObjectTracking::start()
 void TaskObjectTracking::stop()
 {
     data_.isRunning = false;
+    data_.visibleFrameCv.notify_all();
     std::cout << "[TaskObjectTracking] 目标追踪线程已退出" << std::endl;
 
     if (thread_.joinable())
@@ -68,12 +94,27 @@ void TaskObjectTracking::stop()
         thread_.join();
     }
 
-    // 释放资源
+    // 释放资源（调度器先于检测器停止）
+    if (scheduler_)
+    {
+        scheduler_->stop();
+        scheduler_.reset();
+    }
     detector_.reset();
     tracker1_.reset();
     tracker2_.reset();
+    flatTracker_[0].reset();
+    flatTracker_[1].reset();
+    if (traceOut_.is_open())
+    {
+        traceOut_.close();
+    }
     counter1_.reset();
     counter2_.reset();
+    cadence_[0].reset();
+    cadence_[1].reset();
+    roi_[0].reset();
+    roi_[1].reset();
 }
 
 /**
@@ -91,18 +132,134 @@ bool TaskObjectTracking::initializeModules()
             return false;
         }
 
-        // 1. 初始化YOLO检测器（使用ConfigManager）
-        detector_ = std::make_unique<YoloDetector>(*configMgr);
-        std::cout << "[TaskObjectTracking] YOLO检测器初始化完成" << std::endl;
+        // 1. 初始化YOLO检测器（按配置选择TensorRT或CPU后端）
+        detector_ = IDetector::create(config_, config_.detector.backend);
+        if (!detector_)
+        {
+            std::cerr << "[TaskObjectTracking] YOLO检测器创建失败，后端: " << config_.detector.backend << std::endl;
+            return false;
+        }
+        std::cout << "[TaskObjectTracking] YOLO检测器初始化完成，后端: " << detector_->name() << std::endl;
 
-        // 2. 初始化两个ByteTrack追踪器（使用ConfigManager）
-        tracker1_ = std::make_unique<TrackerModule>(*configMgr);
-        tracker2_ = std::make_unique<TrackerModule>(*configMgr);
-        std::cout << "[TaskObjectTracking] ByteTrack追踪器初始化完成" << std::endl;
+        // 批处理调度：可选的启动时吞吐量/延迟测量，然后启动调度线程
+        if (config_.scheduler.benchmarkFrames > 0)
+        {
+            InferenceScheduler::runBenchmark(*detector_, cv::Size(config_.videoWidth, config_.videoHeight),
+                                             config_.scheduler.benchmarkProducers, config_.scheduler.benchmarkFrames);
+        }
+        if (config_.scheduler.enable)
+        {
+            InferenceScheduler::Params schedulerParams;
+            schedulerParams.maxBatch = config_.scheduler.maxBatch;
+            schedulerParams.maxWaitUs = static_cast<int>(config_.scheduler.maxWaitMs * 1000.0f);
+            scheduler_ = std::make_unique<InferenceScheduler>(*detector_, schedulerParams);
+            scheduler_->start();
+            std::cout << "[TaskObjectTracking] 批处理调度已启动，最大批 " << schedulerParams.maxBatch
+                      << "，等待时限 " << config_.scheduler.maxWaitMs << " ms" << std::endl;
+        }
+
+        // 2. 初始化两路追踪器（使用ConfigManager中的ByteTrack参数）
+        FlatByteTracker::Params trackerParams;
+        trackerParams.frameRate = configMgr->getFrameRate();
+        trackerParams.trackBuffer = configMgr->getTrackBuffer();
+        trackerParams.trackThresh = configMgr->getTrackThresh();
+        trackerParams.highThresh = configMgr->getHighThresh();
+        trackerParams.matchThresh = configMgr->getMatchThresh();
+        trackerParams.unconfirmedThresh = configMgr->getUnconfirmedThresh();
+        trackerParams.lowMatchThresh = configMgr->getLowMatchThresh();
+        trackerParams.capacity = config_.trackerCore.capacity;
+        trackerParams.trackClass = configMgr->getTrackClass();
+        trackerParams.minTargetArea = static_cast<float>(configMgr->getMinTargetArea());
+        if (!config_.trackerCore.parityTrace.empty())
+        {
+            FlatByteTracker::compareWithByteTrack(config_.trackerCore.parityTrace, trackerParams);
+        }
+        if (config_.trackerCore.benchmarkFrames > 0)
+        {
+            FlatByteTracker::runBenchmark(trackerParams, config_.trackerCore.benchmarkFrames);
+        }
+        if (config_.trackerCore.backend == "flat")
+        {
+            flatTracker_[0] = std::make_unique<FlatByteTracker>(trackerParams);
+            flatTracker_[1] = std::make_unique<FlatByteTracker>(trackerParams);
+        }
+        else
+        {
+            tracker1_ = std::make_unique<TrackerModule>(*configMgr);
+            tracker2_ = std::make_unique<TrackerModule>(*configMgr);
+        }
+        if (!config_.trackerCore.recordTrace.empty())
+        {
+            traceOut_.open(config_.trackerCore.recordTrace, std::ios::out | std::ios::trunc);
+            if (!traceOut_.is_open())
+            {
+                std::cerr << "[TaskObjectTracking] 无法创建检测序列文件: " << config_.trackerCore.recordTrace << std::endl;
+            }
+        }
+        std::cout << "[TaskObjectTracking] ByteTrack追踪器初始化完成，核心: " << config_.trackerCore.backend << std::endl;
+
+        // 自适应检测间隔：可选的启动时录像评估，然后为每路创建控制器
+        CadenceController::Params cadenceParams;
+        cadenceParams.maxInterval = config_.cadence.maxInterval;
+        cadenceParams.maxPredictPx = config_.cadence.maxPredictPx;
+        cadenceParams.minTrackHits = config_.cadence.minTrackHits;
+        cadenceParams.stationarySpeedKmh = config_.cadence.stationarySpeedKmh;
+        cadenceParams.fullRateSpeedKmh = config_.cadence.fullRateSpeedKmh;
+        cadenceParams.newObjectConf = configMgr->getHighThresh();
+        cadenceParams.trackClass = configMgr->getTrackClass();
+        if (!config_.cadence.evaluationVideo.empty())
+        {
+            CadenceController::evaluate(*detector_, *configMgr, cadenceParams, config_.cadence.evaluationVideo);
+        }
+        if (config_.cadence.enable)
+        {
+            cadence_[0] = std::make_unique<CadenceController>(cadenceParams, "camera_1");
+            cadence_[1] = std::make_unique<CadenceController>(cadenceParams, "camera_2");
+            std::cout << "[TaskObjectTracking] 自适应检测间隔已启用，最大间隔 " << cadenceParams.maxInterval << " 帧" << std::endl;
+        }
+
+        // 推理区域：可选的启动时录像评估，然后为每路创建
+        InferenceRoi::Params roiParams;
+        roiParams.mode = config_.inferenceRoi.mode;
+        roiParams.lineY = configMgr->getDetectionLineY();
+        roiParams.bandHalfHeight = config_.inferenceRoi.bandHalfHeight;
+        roiParams.trackMargin = config_.inferenceRoi.trackMargin;
+        roiParams.strips = config_.inferenceRoi.strips;
+        roiParams.stripOverlap = config_.inferenceRoi.stripOverlap;
+        roiParams.fullFrameInterval = config_.inferenceRoi.fullFrameInterval;
+        if (!config_.inferenceRoi.evaluationVideo.empty())
+        {
+            InferenceRoi::evaluate(*detector_, *configMgr, roiParams, config_.inferenceRoi.evaluationVideo);
+        }
+        if (config_.inferenceRoi.enable)
+        {
+            roi_[0] = std::make_unique<InferenceRoi>(roiParams);
+            roi_[1] = std::make_unique<InferenceRoi>(roiParams);
+            std::cout << "[TaskObjectTracking] 推理区域已启用，模式 " << roiParams.mode << "，计数线上下 " << roiParams.bandHalfHeight
+                      << " px，" << roiParams.strips << " 段" << std::endl;
+        }
 
         // 3. 初始化计数模块（如果启用）
+        if (config_.countingState.soakHours > 0.0)
+        {
+            CountingLineModule::runSoakTest(config_.videoWidth, config_.videoHeight, config_.processingFps, config_.countingState.soakHours);
+        }
         if (configMgr->isCountingEnabled())
         {
+            // 计数状态保留帧数：追踪器保留丢失轨迹的帧数，按自适应检测的最大间隔放大（间隔帧不更新追踪器）
+            const int maxTimeLost = static_cast<int>(configMgr->getFrameRate() / 30.0 * configMgr->getTrackBuffer());
+            const int trackTtl = (maxTimeLost + 1) * (config_.cadence.enable ? config_.cadence.maxInterval : 1);
+
+            // 启用事件日志时越线记录只入队，由日志线程写盘
+            auto journalSink = [journal = data_.eventJournal](int cameraId)
+            {
+                return [journal, cameraId](const CountingRecord &record)
+                {
+                    journal->logCrossing(cameraId, record.track_id, record.sequence_id, record.real_processing_time_ms,
+                                         record.current_frame_time_ms, record.real_time_ms);
+                };
+            };
+
             // 一位端计数器
             counter1_ = std::make_unique<CountingLineModule>(
                 config_.videoWidth,
@@ -110,6 +267,12 @@ bool TaskObjectTracking::initializeModules()
                 config_.processingFps,
                 *configMgr,
                 "camera_1");
+            counter1_->setCapacity(config_.countingState.trackCapacity, config_.countingState.recordCapacity);
+            counter1_->setTrackTtl(trackTtl);
+            if (data_.eventJournal)
+            {
+                counter1_->setRecordSink(journalSink(1));
+            }
             counter1_->startCounting();
 
             // 二位端计数器
@@ -119,11 +282,20 @@ bool TaskObjectTracking::initializeModules()
                 config_.processingFps,
                 *configMgr,
                 "camera_2");
+            counter2_->setCapacity(config_.countingState.trackCapacity, config_.countingState.recordCapacity);
+            counter2_->setTrackTtl(trackTtl);
+            if (data_.eventJournal)
+            {
+                counter2_->setRecordSink(journalSink(2));
+            }
             counter2_->startCounting();
 
             std::cout << "[TaskObjectTracking] 虚拟检测线计数模块初始化完成" << std::endl;
         }
 
+        // 4. 初始化热成像-可见光融合（如果启用）
+        initializeFusion();
+
         std::cout << "[TaskObjectTracking] 目标追踪模块初始化完成" << std::endl;
         initialized_ = true;
         return true;
@@ -144,111 +316,255 @@ void TaskObjectTracking::run()
         return;
     }
 
-    // 创建显示窗口 (默认启用)
-    if (config_.enableDisplay)
+    // 预分配帧任务，全部放入空闲队列
+    jobPool_.clear();
+    for (size_t i = 0; i < kJobPoolSize; i++)
     {
-        cv::namedWindow(config_.windowName, cv::WINDOW_NORMAL);
-        cv::resizeWindow(config_.windowName, config_.windowWidth, config_.windowHeight);
+        jobPool_.push_back(std::make_unique<FrameJob>());
+        freeJobs_.tryPush(jobPool_.back().get());
+    }
+    for (auto &busy : stageBusyUs_)
+    {
+        busy = 0;
     }
 
-    // 性能统计初始化
-    lastStatsTime_ = std::chrono::steady_clock::now();
+    // 追踪与输出阶段各占一个线程，本线程执行检测阶段
+    std::thread trackStage(&TaskObjectTracking::runTrackStage, this);
+    std::thread outputStage(&TaskObjectTracking::runOutputStage, this);
+    runDetectStage();
+
+    // 结束标志沿流水线传递，后续阶段处理完队列中剩余的帧后退出
+    while (!trackQueue_.push(nullptr, std::chrono::milliseconds(config_.threadSleepMs)))
+    {
+    }
+    trackStage.join();
+    outputStage.join();
+
+    // 完成计数统计
+    auto configMgr = config_.getConfigManager();
+    if (configMgr && configMgr->isCountingEnabled())
+    {
+        if (counter1_)
+            counter1_->finishCounting(frameCount_);
+        if (counter2_)
+            counter2_->finishCounting(frameCount_);
+    }
+}
 
-    cv::Mat visibleFrame1, visibleFrame2;     // 输入帧缓冲区
-    cv::Mat processedFrame1, processedFrame2; // 输出帧缓冲区
+// 检测阶段
+void TaskObjectTracking::runDetectStage()
+{
+    const auto waitTimeout = std::chrono::milliseconds(config_.threadSleepMs);
+    uint64_t seenVersion = 0;
+    uint64_t lastSeq[2] = {0, 0}; // 每路已提交的最新帧序号
+    FrameJob *jobs[2] = {nullptr, nullptr}; // 每路持有的空闲任务（帧未更新时留到下一轮复用）
 
     while (data_.isRunning && initialized_)
     {
+        // ========== 等待采集线程发布新的可见光帧（超时后检查停止标志） ==========
+        {
+            std::unique_lock<std::mutex> lock(data_.visibleFrameNotifyMutex);
+            if (!data_.visibleFrameCv.wait_for(lock, waitTimeout, [&] { return !data_.isRunning || data_.visibleFrameVersion != seenVersion; }))
+                continue;
+            seenVersion = data_.visibleFrameVersion;
+        }
+
+        const auto busyStart = std::chrono::steady_clock::now();
 
-        // ========== 处理一位端可见光视频流 ==========
+        // ========== 复制两路新帧（序号未变化的一路跳过） ==========
+        bool fresh[2] = {false, false};
+        for (int i = 0; i < 2 && data_.isRunning; i++)
         {
-            std::lock_guard<std::mutex> lock(data_.visible_mutex_1);
-            if (!data_.visible_video_frame_1.empty())
+            while (!jobs[i] && data_.isRunning)
             {
-                data_.visible_video_frame_1.copyTo(visibleFrame1);
+                freeJobs_.pop(jobs[i], waitTimeout);
             }
+            if (!jobs[i])
+                break;
+
+            std::lock_guard<std::mutex> lock(i == 0 ? data_.visible_mutex_1 : data_.visible_mutex_2);
+            const cv::Mat &source = i == 0 ? data_.visible_video_frame_1 : data_.visible_video_frame_2;
+            const FrameMeta &meta = i == 0 ? data_.visible_video_meta_1 : data_.visible_video_meta_2;
+            if (source.empty() || (meta.seq != 0 && meta.seq == lastSeq[i]))
+                continue;
+            source.copyTo(jobs[i]->frame);
+            jobs[i]->meta = meta;
+            jobs[i]->cameraId = i + 1;
+            lastSeq[i] = meta.seq;
+            fresh[i] = true;
         }
 
-        if (!visibleFrame1.empty())
+        // ========== 两路同时提交检测（调度器合并为一个批次），自适应间隔跳过的帧不推理 ==========
+        const float trainSpeedKmh = data_.trainSpeedKmh;
+        const auto detectStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < 2; i++)
         {
-            int objectCount1 = processFrame(visibleFrame1, processedFrame1, 1);
+            if (!fresh[i])
+                continue;
+            jobs[i]->detected = !cadence_[i] || cadence_[i]->shouldDetect(trainSpeedKmh);
+            jobs[i]->detections.clear();
+            jobs[i]->detectTime = 0.0;
+            if (jobs[i]->detected)
+                jobs[i]->pending = submitDetection(roi_[i] ? roi_[i]->prepare(jobs[i]->frame) : jobs[i]->frame);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            if (!fresh[i] || !jobs[i]->detected)
+                continue;
+            jobs[i]->detections = jobs[i]->pending.get();
+            if (roi_[i])
+                roi_[i]->mapBack(jobs[i]->detections);
+            jobs[i]->detectTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - detectStart).count();
+        }
+        stageBusyUs_[kDetectStage] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - busyStart).count();
 
-            // 将处理后的帧写入共享数据
+        // 交给追踪阶段（队列满时等待，即后续阶段的反压）
+        for (int i = 0; i < 2; i++)
+        {
+            if (!fresh[i])
+                continue;
+            while (!trackQueue_.push(jobs[i], waitTimeout) && data_.isRunning)
             {
-                std::lock_guard<std::mutex> lock(data_.processed_visible_mutex_1);
-                processedFrame1.copyTo(data_.processed_visible_frame_1);
             }
+            jobs[i] = nullptr;
+        }
+    }
+}
 
-            // 更新检测目标数量
-            data_.detectedObjectCount_1 = objectCount1;
+// 追踪阶段
+void TaskObjectTracking::runTrackStage()
+{
+    const auto waitTimeout = std::chrono::milliseconds(config_.threadSleepMs);
+    FrameJob *job = nullptr;
+    for (;;)
+    {
+        if (!trackQueue_.pop(job, waitTimeout))
+            continue;
+        if (!job)
+            break;
+
+        const auto trackStart = std::chrono::steady_clock::now();
+        job->removedTracks.clear();
+        TrackerModule *tracker = job->cameraId == 1 ? tracker1_.get() : tracker2_.get();
+        FlatByteTracker *flatTracker = flatTracker_[job->cameraId == 1 ? 0 : 1].get();
+        CadenceController *cadence = cadence_[job->cameraId == 1 ? 0 : 1].get();
+        InferenceRoi *roi = roi_[job->cameraId == 1 ? 0 : 1].get();
+        if (!job->detected && cadence)
+        {
+            // 未检测帧：ByteTrack不更新，输出卡尔曼预测位置
+            cadence->predict(job->tracks);
         }
-        // ========== 处理二位端可见光视频流 ==========
+        else if (flatTracker || tracker)
         {
-            std::lock_guard<std::mutex> lock(data_.visible_mutex_2);
-            if (!data_.visible_video_frame_2.empty())
+            if (flatTracker)
             {
-                data_.visible_video_frame_2.copyTo(visibleFrame2);
+                flatTracker->update(job->detections, job->tracks);
+                job->removedTracks = flatTracker->removedTracks();
             }
+            else
+                job->tracks = tracker->update(job->detections);
+            if (job->cameraId == 1 && traceOut_.is_open())
+                FlatByteTracker::writeTraceFrame(traceOut_, traceFrames_++, job->detections);
+            if (cadence)
+                cadence->observe(job->detections, job->tracks);
         }
-        if (!visibleFrame2.empty())
+        else
         {
-            int objectCount2 = processFrame(visibleFrame2, processedFrame2, 2);
-
-            // 将处理后的帧写入共享数据
-            {
-                std::lock_guard<std::mutex> lock(data_.processed_visible_mutex_2);
-                processedFrame2.copyTo(data_.processed_visible_frame_2);
-            }
+            job->tracks.clear();
+        }
+        if (roi)
+            roi->observe(job->tracks);
+        const auto trackTime = std::chrono::steady_clock::now() - trackStart;
+        job->trackTime = std::chrono::duration<double, std::milli>(trackTime).count();
+        stageBusyUs_[kTrackStage] += std::chrono::duration_cast<std::chrono::microseconds>(trackTime).count();
 
-            // 更新检测目标数量
-            data_.detectedObjectCount_2 = objectCount2;
+        while (!outputQueue_.push(job, waitTimeout))
+        {
         }
+    }
+    while (!outputQueue_.push(nullptr, waitTimeout))
+    {
+    }
+}
 
-        // ========== 显示处理结果 (如果启用) ==========
-        if (config_.enableDisplay)
+// 输出阶段
+void TaskObjectTracking::runOutputStage()
+{
+    const auto waitTimeout = std::chrono::milliseconds(config_.threadSleepMs);
+
+    // 显示窗口在本线程创建，与 imshow/waitKey 同一线程
+    if (config_.enableDisplay)
+    {
+        cv::namedWindow(config_.windowName, cv::WINDOW_NORMAL);
+        cv::resizeWindow(config_.windowName, config_.windowWidth, config_.windowHeight);
+    }
+
+    // 性能统计初始化
+    lastStatsTime_ = std::chrono::steady_clock::now();
+    lastOccupancyTime_ = lastStatsTime_;
+    bool camera1Seen = false; // 优先显示设备1，没有设备1的帧时显示设备2
+
+    FrameJob *job = nullptr;
+    for (;;)
+    {
+        if (!outputQueue_.pop(job, waitTimeout))
         {
-            cv::Mat displayFrame;
-            std::string windowTitle = config_.windowName;
+            reportStageOccupancy();
+            continue;
+        }
+        if (!job)
+            break;
 
-            // 优先显示设备1的数据，如果没有则显示设备2的数据
-            if (!processedFrame1.empty())
-            {
-                displayFrame = processedFrame1.clone();
-                windowTitle += " - 设备1(一位端)";
-            }
-            else if (!processedFrame2.empty())
+        const auto busyStart = std::chrono::steady_clock::now();
+        const int cameraId = job->cameraId;
+        int objectCount = processFrame(*job);
+        fuseWithThermal(cameraId, job->frame, job->meta, job->trackRects, *job->overlay);
+
+        // 显示窗口只显示一路：优先设备1，没有设备1的帧时显示设备2
+        camera1Seen = camera1Seen || cameraId == 1;
+        const bool display = config_.enableDisplay && (cameraId == 1 || !camera1Seen);
+        cv::Mat displayFrame;
+
+        // 将处理后的帧（不带标注）与标注数据写入共享数据，标注由需要的输出端绘制
+        {
+            std::lock_guard<std::mutex> lock(cameraId == 1 ? data_.processed_visible_mutex_1 : data_.processed_visible_mutex_2);
+            cv::Mat &processed = cameraId == 1 ? data_.processed_visible_frame_1 : data_.processed_visible_frame_2;
+            FrameOverlayPtr &overlay = cameraId == 1 ? data_.processed_visible_overlay_1 : data_.processed_visible_overlay_2;
+            job->frame.copyTo(processed);
+            overlay = std::move(job->overlay);
+            (cameraId == 1 ? data_.processed_visible_meta_1 : data_.processed_visible_meta_2) = job->meta;
+            (cameraId == 1 ? data_.processed_visible_rois_1 : data_.processed_visible_rois_2).swap(job->trackRects);
+            if (display)
             {
-                displayFrame = processedFrame2.clone();
-                windowTitle += " - 设备2(二位端)";
+                displayFrame = (cameraId == 1 ? data_.processed_visible_render_1 : data_.processed_visible_render_2)
+                                   .render(processed, job->meta.seq, overlay, data_.overlayRenderConfig.displayLayers);
             }
+        }
+
+        // 共享内存帧总线（在锁外复制，未启用时直接返回）
+        (cameraId == 1 ? data_.processed_visible_bus_1 : data_.processed_visible_bus_2)
+            .publish(job->frame, job->meta.seq, job->meta.captureTimeUs);
 
-            if (!displayFrame.empty())
+        // 更新检测目标数量
+        (cameraId == 1 ? data_.detectedObjectCount_1 : data_.detectedObjectCount_2) = objectCount;
+
+        // ========== 显示处理结果 (如果启用) ==========
+        if (display)
+        {
+            // 更新窗口标题以显示当前显示的是哪个设备
+            cv::setWindowTitle(config_.windowName, config_.windowName + (cameraId == 1 ? " - 设备1(一位端)" : " - 设备2(二位端)"));
+            cv::imshow(config_.windowName, displayFrame);
+
+            // 检查窗口是否被关闭（ESC键退出，本阶段继续处理完已在流水线中的帧）
+            if (cv::waitKey(1) == 27)
             {
-                // 更新窗口标题以显示当前显示的是哪个设备
-                cv::setWindowTitle(config_.windowName, windowTitle);
-                cv::imshow(config_.windowName, displayFrame);
-
-                // 检查窗口是否被关闭
-                if (cv::waitKey(1) == 27)
-                { // ESC键退出
-                    data_.isRunning = false;
-                    break;
-                }
+                data_.isRunning = false;
             }
         }
 
-        // 控制处理频率，避免过度占用CPU
-        std::this_thread::sleep_for(std::chrono::milliseconds(config_.threadSleepMs));
-    }
-
-    // 完成计数统计
-    auto configMgr = config_.getConfigManager();
-    if (configMgr && configMgr->isCountingEnabled())
-    {
-        if (counter1_)
-            counter1_->finishCounting(frameCount_);
-        if (counter2_)
-            counter2_->finishCounting(frameCount_);
+        stageBusyUs_[kOutputStage] += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - busyStart).count();
+        freeJobs_.tryPush(job);
+        reportStageOccupancy();
     }
 
     // 关闭显示窗口
@@ -258,40 +574,58 @@ void TaskObjectTracking::run()
     }
 }
 
-// 处理单帧视频
-int TaskObjectTracking::processFrame(const cv::Mat &inputFrame, cv::Mat &outputFrame, int cameraId)
+// 输出各阶段占用率
+void TaskObjectTracking::reportStageOccupancy()
 {
-    if (inputFrame.empty())
-        return 0;
+    const auto now = std::chrono::steady_clock::now();
+    const double wallUs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(now - lastOccupancyTime_).count());
+    if (wallUs < 10e6)
+        return;
 
-    // 复制输入帧到输出帧
-    inputFrame.copyTo(outputFrame);
+    double occupancy[kStageCount];
+    for (int i = 0; i < kStageCount; i++)
+    {
+        const uint64_t busy = stageBusyUs_[i];
+        occupancy[i] = 100.0 * (busy - lastStageBusyUs_[i]) / wallUs;
+        lastStageBusyUs_[i] = busy;
+    }
+    lastOccupancyTime_ = now;
 
-    auto frameStartTime = std::chrono::steady_clock::now();
+    std::cout << "[TaskObjectTracking] 流水线占用率 - 检测: " << std::fixed << std::setprecision(1) << occupancy[kDetectStage]
+              << "%, 追踪: " << occupancy[kTrackStage] << "%, 计数/发布: " << occupancy[kOutputStage]
+              << "%, 队列深度 追踪: " << trackQueue_.size() << "/" << trackQueue_.capacity()
+              << ", 输出: " << outputQueue_.size() << "/" << outputQueue_.capacity() << std::endl;
+}
 
-    // ========== 1. YOLO目标检测 ==========
-    auto detectStart = std::chrono::steady_clock::now();
-    std::vector<Detection> detections = detector_->inference(outputFrame);
-    auto detectEnd = std::chrono::steady_clock::now();
+// 提交一帧检测
+std::future<std::vector<Detection>> TaskObjectTracking::submitDetection(cv::Mat &frame)
+{
+    if (scheduler_)
+    {
+        return scheduler_->submit(frame);
+    }
 
-    double detectTime = std::chrono::duration<double, std::milli>(detectEnd - detectStart).count();
-    totalDetectTime_ += detectTime;
+    // 未启用批处理调度时同步检测
+    std::promise<std::vector<Detection>> result;
+    result.set_value(detector_->detect(frame));
+    return result.get_future();
+}
 
-    // ========== 2. ByteTrack目标追踪 ==========
-    auto trackStart = std::chrono::steady_clock::now();
-    std::vector<TrackResult> tracks;
+// 处理单帧的计数，并记录本帧的标注数据
+int TaskObjectTracking::processFrame(FrameJob &job)
+{
+    job.overlay = std::make_shared<FrameOverlay>();
+    if (job.frame.empty())
+        return 0;
 
-    if (cameraId == 1 && tracker1_)
-    {
-        tracks = tracker1_->update(detections);
-    }
-    else if (cameraId == 2 && tracker2_)
-    {
-        tracks = tracker2_->update(detections);
-    }
+    FrameOverlay &overlay = *job.overlay;
+    const int cameraId = job.cameraId;
+    const std::vector<TrackResult> &tracks = job.tracks;
 
-    auto trackEnd = std::chrono::steady_clock::now();
-    double trackTime = std::chrono::duration<double, std::milli>(trackEnd - trackStart).count();
+    // ========== 1. YOLO目标检测与 2. ByteTrack目标追踪（由前两个阶段完成） ==========
+    const double detectTime = job.detectTime;
+    const double trackTime = job.trackTime;
+    totalDetectTime_ += detectTime;
     totalTrackTime_ += trackTime;
 
     // ========== 3. 虚拟检测线计数 ==========
@@ -306,7 +640,9 @@ int TaskObjectTracking::processFrame(const cv::Mat &inputFrame, cv::Mat &outputF
         if (cameraId == 1 && counter1_)
         {
             int newCrossings = counter1_->updateCounting(tracks, currentFrameTime, realProcessingTime);
-            counter1_->drawDetectionLine(outputFrame);
+            counter1_->removeTracks(job.removedTracks);
+            overlay.countingLineY = counter1_->getDetectionLineY();
+            overlay.countingLineLabel = counter1_->getShowLabel();
             totalCount = counter1_->getTotalCount();
 
             // 检测到新目标时设置检测标志位
@@ -318,7 +654,9 @@ int TaskObjectTracking::processFrame(const cv::Mat &inputFrame, cv::Mat &outputF
         else if (cameraId == 2 && counter2_)
         {
             int newCrossings = counter2_->updateCounting(tracks, currentFrameTime, realProcessingTime);
-            counter2_->drawDetectionLine(outputFrame);
+            counter2_->removeTracks(job.removedTracks);
+            overlay.countingLineY = counter2_->getDetectionLineY();
+            overlay.countingLineLabel = counter2_->getShowLabel();
             totalCount = counter2_->getTotalCount();
 
             // 检测到新目标时设置检测标志位
@@ -329,19 +667,92 @@ int TaskObjectTracking::processFrame(const cv::Mat &inputFrame, cv::Mat &outputF
         }
     }
 
-    // ========== 4. 绘制追踪结果 ==========
-    TrackerModule::drawTrackResults(outputFrame, tracks);
+    overlay.countingLineWidth = config_.videoWidth;
+
+    // ========== 4. 记录追踪结果（由需要带标注画面的输出端绘制） ==========
+    overlay.tracks = tracks;
+
+    job.trackRects.clear();
+    for (const auto &t : tracks)
+    {
+        if (t.is_lost)
+            continue;
+        job.trackRects.emplace_back(cv::Point(cvRound(t.bbox[0]), cvRound(t.bbox[1])),
+                                    cv::Point(cvRound(t.bbox[2]), cvRound(t.bbox[3])));
+    }
 
     // ========== 5. 显示性能统计 (如果启用) ==========
     if (config_.enablePerformanceStats)
     {
-        drawPerformanceStats(outputFrame, detectTime, trackTime, tracks.size(), totalCount);
+        drawPerformanceStats(job.frame, detectTime, trackTime, tracks.size(), totalCount);
     }
 
     frameCount_++;
     return static_cast<int>(tracks.size());
 }
 
+// 初始化热成像-可见光配准
+void TaskObjectTracking::initializeFusion()
+{
+    const ThermalVisibleFusionConfig &fusionConfig = data_.thermalVisibleFusionConfig;
+    fusionEnabled_ = fusionConfig.enable;
+    if (!fusionEnabled_)
+        return;
+
+    ThermalVisibleFusion::Params params;
+    params.cellSize = fusionConfig.cellSize;
+    params.minHotFraction = fusionConfig.minHotFraction;
+    params.maxSkewUs = static_cast<int64_t>(fusionConfig.maxTimeSkewMs) * 1000;
+
+    for (int i = 0; i < 2; i++)
+    {
+        fusion_[i].setParams(params);
+
+        // 标定点对优先，其次为直接配置的单应矩阵，都没有时视为两路视场重合
+        bool registered = false;
+        if (!fusionConfig.thermalPoints[i].empty())
+        {
+            registered = fusion_[i].calibrate(fusionConfig.thermalPoints[i], fusionConfig.visiblePoints[i]);
+        }
+        if (!registered && fusionConfig.homography[i].size() == 9)
+        {
+            std::array<double, 9> h;
+            std::copy(fusionConfig.homography[i].begin(), fusionConfig.homography[i].end(), h.begin());
+            registered = fusion_[i].setHomography(h);
+        }
+
+        std::cout << "[TaskObjectTracking] 设备" << (i + 1) << "热成像-可见光配准: "
+                  << (registered ? "已标定" : "未标定，按视场重合处理") << std::endl;
+    }
+}
+
+// 将跟踪框与时间最接近的热成像帧融合
+void TaskObjectTracking::fuseWithThermal(int cameraId, const cv::Mat &frame, const FrameMeta &meta,
+                                         const std::vector<cv::Rect> &trackRects, FrameOverlay &overlay)
+{
+    if (!fusionEnabled_ || frame.empty())
+        return;
+
+    ThermalVisibleFusion &fusion = fusion_[cameraId == 1 ? 0 : 1];
+    ThermalAnalysisResultPtr thermal;
+    {
+        std::lock_guard<std::mutex> lock(cameraId == 1 ? data_.thermalmatrix_mutex_1 : data_.thermalmatrix_mutex_2);
+        thermal = ThermalVisibleFusion::pairNearest(cameraId == 1 ? data_.thermalHistory_1 : data_.thermalHistory_2,
+                                                    meta.captureTimeUs, fusion.params().maxSkewUs);
+    }
+
+    FusedDetectionListPtr fused = fusion.fuse(frame.size(), meta.seq, meta.captureTimeUs, trackRects, thermal);
+
+    // 被热成像确认的可见光目标用红框标出，纯热成像目标用橙框标出
+    for (const auto &detection : fused->detections)
+    {
+        if (!detection.hot)
+            continue;
+        const cv::Scalar color = detection.visible ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 165, 255);
+        overlay.fusionBoxes.emplace_back(detection.box, color);
+    }
+}
+
 // 显示性能统计信息到视频帧上
 void TaskObjectTracking::drawPerformanceStats(cv::Mat &frame, double detectTime, double trackTime,
                                               int objectCount, int totalCount)
@@ -1,8 +1,13 @@
 ﻿#include "TaskRTSPStream.h"
 #include <iostream>
 #include "PushStream.cuh"
+#include "RtspServer.h"
+#include "QuadCompositor.h"
 #include <thread>
 #include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
 
 #ifdef _WIN32
 #define POPEN _popen
@@ -13,8 +18,10 @@
 #endif
 
 // 构造函数，初始化RTSP流对象和共享数据
-TaskRTSPStream::TaskRTSPStream(SharedData &data, const std::vector<std::string> &rtspUrls, int streamWidth, int streamHeight, int streamFps)
-    : data_(data), rtspUrls_(rtspUrls), streamWidth_(streamWidth), streamHeight_(streamHeight), streamFps_(streamFps)
+TaskRTSPStream::TaskRTSPStream(SharedData &data, const std::vector<std::string> &rtspUrls, int streamWidth, int streamHeight, int streamFps,
+                               RtspServer *embeddedServer)
+    : data_(data), rtspUrls_(rtspUrls), streamWidth_(streamWidth), streamHeight_(streamHeight), streamFps_(streamFps),
+      embeddedServer_(embeddedServer)
 {
 }
 
@@ -41,9 +48,100 @@ void TaskRTSPStream::stop()
     writer_.release();
 }
 
+// 单路推流输出的状态
+struct StreamOutput
+{
+    FFmpegRtspPusher *pusher;
+    std::mutex *mutex;      // 对应的processed帧锁
+    const cv::Mat *source;  // SharedData中的processed帧
+    const FrameMeta *meta;  // SharedData中的processed帧元数据
+    const std::vector<cv::Rect> *rois; // SharedData中的processed帧目标区域
+    const FrameOverlayPtr *overlay; // SharedData中的processed帧标注数据
+    OverlayCache *render;   // 该路processed帧的标注渲染缓存（与显示窗口等共用）
+    int fps;                // 该路最大编码帧率
+    bool enabled;           // 推流器是否打开成功
+
+    cv::Mat frame;             // 最近一次取到的帧（已缩放到推流分辨率；BGR绘制时已带标注）
+    FrameOverlayPtr frameOverlay;    // 最近一次取到的帧的标注数据（YUV绘制时使用）
+    double overlayScaleX = 1.0;      // 标注坐标到 frame 坐标的缩放比例
+    double overlayScaleY = 1.0;
+    std::vector<cv::Rect> frameRois; // 最近一次取到的帧的目标区域（推流分辨率坐标）
+    uint64_t lastSeq = 0;      // 最近一次取到的帧序号
+    int64_t lastEncodeUs = 0;  // 最近一次编码的时间
+    int64_t lastPtsUs = 0;     // 最近一次编码使用的时间戳
+
+    std::string path;                // 流路径（查询内嵌服务器的订阅数）
+    uint32_t layers = kOverlayNone;  // 取帧时绘制的图层，无人观看时为空
+    uint64_t overlayFrames = 0;      // 带标注取到的帧数
+    uint64_t plainFrames = 0;        // 不带标注取到的帧数
+};
+
+// 检查一路输出：有新帧且未超过帧率上限时编码；空闲超过保活间隔时重复上一帧
+// yuvOverlay 为true时取干净帧，标注由推流器在转换后的YUV平面上绘制
+static void pollStreamOutput(StreamOutput &out, int64_t nowUs, const cv::Size &streamSize, int64_t keepaliveIntervalUs, bool yuvOverlay)
+{
+    if (out.lastEncodeUs > 0 && nowUs - out.lastEncodeUs < 1000000 / out.fps)
+        return;
+
+    FrameMeta meta;
+    cv::Mat rendered; // 渲染缓存中的帧（只读，可能与其他输出共用）
+    bool fresh = false;
+    {
+        std::lock_guard<std::mutex> lock(*out.mutex);
+        if (out.meta->seq != out.lastSeq && !out.source->empty())
+        {
+            rendered = out.render->render(*out.source, out.meta->seq, *out.overlay, yuvOverlay ? kOverlayNone : out.layers);
+            out.frameOverlay = yuvOverlay && out.layers != kOverlayNone ? *out.overlay : nullptr;
+            meta = *out.meta;
+            out.frameRois = *out.rois;
+            fresh = true;
+        }
+    }
+
+    if (fresh)
+    {
+        (out.layers != kOverlayNone ? out.overlayFrames : out.plainFrames)++;
+
+        // 调整图像尺寸到配置分辨率
+        out.overlayScaleX = static_cast<double>(streamSize.width) / rendered.cols;
+        out.overlayScaleY = static_cast<double>(streamSize.height) / rendered.rows;
+        if (rendered.size() != streamSize)
+        {
+            // 目标区域随图像一起缩放
+            const double sx = static_cast<double>(streamSize.width) / rendered.cols;
+            const double sy = static_cast<double>(streamSize.height) / rendered.rows;
+            for (auto &r : out.frameRois)
+            {
+                r = cv::Rect(cvRound(r.x * sx), cvRound(r.y * sy), cvRound(r.width * sx), cvRound(r.height * sy));
+            }
+            cv::resize(rendered, out.frame, streamSize, 0, 0, cv::INTER_LINEAR);
+        }
+        else
+        {
+            out.frame = rendered;
+        }
+        out.lastSeq = meta.seq;
+        out.lastPtsUs = meta.captureTimeUs > 0 ? meta.captureTimeUs : nowUs;
+        out.lastEncodeUs = nowUs;
+        if (out.enabled)
+        {
+            out.pusher->setRegionsOfInterest(out.frameRois);
+            out.pusher->setOverlay(out.frameOverlay, out.layers, out.overlayScaleX, out.overlayScaleY);
+            out.pusher->pushFrame(out.frame, out.lastPtsUs);
+        }
+    }
+    else if (out.enabled && keepaliveIntervalUs > 0 && !out.frame.empty() &&
+             nowUs - out.lastEncodeUs >= keepaliveIntervalUs)
+    {
+        // 空闲保活：重复上一帧，时间戳按实际经过的时间推进
+        out.lastPtsUs += nowUs - out.lastEncodeUs;
+        out.lastEncodeUs = nowUs;
+        out.pusher->pushFrame(out.frame, out.lastPtsUs);
+    }
+}
+
 void TaskRTSPStream::run()
 {
-    cv::Mat frameT1, frameT2, frameV1, frameV2;
     int frameWidth = 0, frameHeight = 0;
     int fps = streamFps_;
 
@@ -157,11 +255,40 @@ void TaskRTSPStream::run()
         return;
     }
 
+    // 热成像与可见光可使用不同的最大帧率
+    const StreamPacingConfig &pacing = data_.streamPacingConfig;
+    int thermalFps = pacing.thermalFps > 0 ? pacing.thermalFps : fps;
+    int visibleFps = pacing.visibleFps > 0 ? pacing.visibleFps : fps;
+    std::cout << "[TaskRTSPStream] 帧率上限 - 热成像: " << thermalFps << ", 可见光: " << visibleFps
+              << ", 空闲保活: " << pacing.keepaliveFps << " fps" << std::endl;
+
     // 创建双摄像头RTSP推流器
-    auto pusherT1 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[0], frameWidth, frameHeight, fps); // 设备1热成像
-    auto pusherV1 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[1], frameWidth, frameHeight, fps); // 设备1可见光
-    auto pusherT2 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[2], frameWidth, frameHeight, fps); // 设备2热成像
-    auto pusherV2 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[3], frameWidth, frameHeight, fps); // 设备2可见光
+    auto pusherT1 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[0], frameWidth, frameHeight, thermalFps); // 设备1热成像
+    auto pusherV1 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[1], frameWidth, frameHeight, visibleFps); // 设备1可见光
+    auto pusherT2 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[2], frameWidth, frameHeight, thermalFps); // 设备2热成像
+    auto pusherV2 = std::make_unique<FFmpegRtspPusher>(rtspUrls_[3], frameWidth, frameHeight, visibleFps); // 设备2可见光
+    if (embeddedServer_)
+    {
+        // 内嵌服务器模式：编码输出直接交给进程内RTSP服务器，省去推流到外部服务器的一跳
+        pusherT1->attachEmbeddedServer(embeddedServer_);
+        pusherV1->attachEmbeddedServer(embeddedServer_);
+        pusherT2->attachEmbeddedServer(embeddedServer_);
+        pusherV2->attachEmbeddedServer(embeddedServer_);
+        std::cout << "[TaskRTSPStream] 使用内嵌RTSP服务器分发" << std::endl;
+    }
+    if (data_.multicastOutputConfig.enable)
+    {
+        // 组播输出：每路编码流只发送一次，任意数量的显示端直接加入组播组接收
+        pusherT1->enableMulticast(data_.multicastOutputConfig);
+        pusherV1->enableMulticast(data_.multicastOutputConfig);
+        pusherT2->enableMulticast(data_.multicastOutputConfig);
+        pusherV2->enableMulticast(data_.multicastOutputConfig);
+    }
+    // ROI编码：跟踪框与高温区域使用更低的QP，背景使用更高的QP
+    pusherT1->setRoiEncoding(data_.roiEncodingConfig);
+    pusherV1->setRoiEncoding(data_.roiEncodingConfig);
+    pusherT2->setRoiEncoding(data_.roiEncodingConfig);
+    pusherV2->setRoiEncoding(data_.roiEncodingConfig);
     std::cout << "[TaskRTSPStream]尝试打开RTSP推流器" << std::endl;
     // 尝试打开所有推流器
     bool pusher1Success = pusherT1->open() && pusherV1->open();
@@ -177,91 +304,137 @@ void TaskRTSPStream::run()
     if (pusher2Success)
         std::cout << "[TaskRTSPStream] 设备2 RTSP推流器创建成功" << std::endl;
 
-    while (data_.isRunning)
+    // 四分屏合成流（可选）：四路画面拼接后只编码一次，作为第五路流
+    std::unique_ptr<QuadCompositor> quadCompositor;
+    std::unique_ptr<FFmpegRtspPusher> pusherQuad;
+    const QuadViewConfig &quadConfig = data_.quadViewConfig;
+    if (quadConfig.enable && rtspUrls_.size() > 4)
     {
-        // ========== 处理设备1数据 ==========
-        if (pusher1Success)
+        quadCompositor = std::make_unique<QuadCompositor>(quadConfig.width, quadConfig.height);
+        pusherQuad = std::make_unique<FFmpegRtspPusher>(rtspUrls_[4], quadCompositor->width(), quadCompositor->height(), fps);
+        if (embeddedServer_)
+            pusherQuad->attachEmbeddedServer(embeddedServer_);
+        if (data_.multicastOutputConfig.enable)
+            pusherQuad->enableMulticast(data_.multicastOutputConfig);
+        pusherQuad->setRoiEncoding(data_.roiEncodingConfig);
+        if (pusherQuad->open())
         {
-            {
-                std::lock_guard<std::mutex> lock(data_.processed_thermal_mutex_1);
-                if (!data_.processed_thermal_frame_1.empty())
-                    data_.processed_thermal_frame_1.copyTo(frameT1);
-            }
+            std::cout << "[TaskRTSPStream] 四分屏推流器创建成功: " << rtspUrls_[4] << " ("
+                      << quadCompositor->width() << "x" << quadCompositor->height() << ")" << std::endl;
+        }
+        else
+        {
+            std::cout << "[TaskRTSPStream] 四分屏推流器创建失败" << std::endl;
+            pusherQuad.reset();
+            quadCompositor.reset();
+        }
+    }
 
-            {
-                std::lock_guard<std::mutex> lock(data_.processed_visible_mutex_1);
-                if (!data_.processed_visible_frame_1.empty())
-                    data_.processed_visible_frame_1.copyTo(frameV1);
-            }
+    // 每路输出独立维护帧序号与编码时间：只在有新采集帧时编码，空闲时按保活帧率重复上一帧
+    StreamOutput outputs[4] = {
+        {pusherT1.get(), &data_.processed_thermal_mutex_1, &data_.processed_thermal_frame_1, &data_.processed_thermal_meta_1, &data_.processed_thermal_rois_1,
+         &data_.processed_thermal_overlay_1, &data_.processed_thermal_render_1, thermalFps, pusher1Success},
+        {pusherV1.get(), &data_.processed_visible_mutex_1, &data_.processed_visible_frame_1, &data_.processed_visible_meta_1, &data_.processed_visible_rois_1,
+         &data_.processed_visible_overlay_1, &data_.processed_visible_render_1, visibleFps, pusher1Success},
+        {pusherT2.get(), &data_.processed_thermal_mutex_2, &data_.processed_thermal_frame_2, &data_.processed_thermal_meta_2, &data_.processed_thermal_rois_2,
+         &data_.processed_thermal_overlay_2, &data_.processed_thermal_render_2, thermalFps, pusher2Success},
+        {pusherV2.get(), &data_.processed_visible_mutex_2, &data_.processed_visible_frame_2, &data_.processed_visible_meta_2, &data_.processed_visible_rois_2,
+         &data_.processed_visible_overlay_2, &data_.processed_visible_render_2, visibleFps, pusher2Success}};
+    for (int i = 0; i < 4; i++)
+        outputs[i].path = RtspServer::pathFromUrl(rtspUrls_[i]);
+    const int64_t keepaliveIntervalUs = pacing.keepaliveFps > 0 ? 1000000 / pacing.keepaliveFps : 0;
+    const cv::Size streamSize(frameWidth, frameHeight);
+
+    int64_t quadLastEncodeUs = 0;
+    const int64_t quadIntervalUs = 1000000 / fps;
+
+    // 标注只在有人观看时绘制：订阅数只有内嵌服务器可查询，推送到外部服务器或启用组播时按始终有人观看处理
+    const OverlayRenderConfig &overlayConfig = data_.overlayRenderConfig;
+    const bool followSubscribers = overlayConfig.lazy && embeddedServer_ && !data_.multicastOutputConfig.enable;
+    const std::string quadPath = pusherQuad ? RtspServer::pathFromUrl(rtspUrls_[4]) : std::string();
+    const int64_t subscriberCheckIntervalUs = 200000;
+    int64_t lastSubscriberCheckUs = 0;
+    std::cout << "[TaskRTSPStream] 推流标注图层: " << FrameOverlay::layerNames(overlayConfig.streamLayers)
+              << (followSubscribers ? "，仅在有订阅者时绘制" : "，始终绘制")
+              << (overlayConfig.yuvStreams ? "，编码前画到YUV平面" : "，画到BGR帧") << std::endl;
 
-            if (!frameT1.empty())
-            {
-                // 调整热成像图像尺寸到配置分辨率
-                if (frameT1.cols != frameWidth || frameT1.rows != frameHeight)
-                {
-                    cv::resize(frameT1, frameT1, cv::Size(frameWidth, frameHeight), 0, 0, cv::INTER_LINEAR);
-                }
-                pusherT1->pushFrame(frameT1);
-            }
+    while (data_.isRunning)
+    {
+        const int64_t nowUs = steadyClockUs();
 
-            if (!frameV1.empty())
+        // 按订阅情况更新各路的标注图层（四分屏有人观看时四路都需要带标注）
+        if (nowUs - lastSubscriberCheckUs >= subscriberCheckIntervalUs)
+        {
+            lastSubscriberCheckUs = nowUs;
+            const bool quadWatched = pusherQuad && (!followSubscribers || embeddedServer_->getSubscriberCount(quadPath) > 0);
+            for (auto &out : outputs)
             {
-                // 调整可见光图像尺寸到配置分辨率
-                if (frameV1.cols != frameWidth || frameV1.rows != frameHeight)
+                const bool watched = quadWatched || (out.enabled && (!followSubscribers || embeddedServer_->getSubscriberCount(out.path) > 0));
+                const uint32_t layers = watched ? overlayConfig.streamLayers : kOverlayNone;
+                if (layers != out.layers && followSubscribers)
                 {
-                    cv::resize(frameV1, frameV1, cv::Size(frameWidth, frameHeight), 0, 0, cv::INTER_LINEAR);
+                    std::cout << "[TaskRTSPStream] /" << out.path << (watched ? " 有订阅者，开始绘制标注" : " 无订阅者，停止绘制标注") << std::endl;
                 }
-                pusherV1->pushFrame(frameV1);
+                out.layers = layers;
             }
         }
 
-        // ========== 处理设备2数据 ==========
-        if (pusher2Success)
+        for (auto &out : outputs)
         {
-            {
-                std::lock_guard<std::mutex> lock(data_.processed_thermal_mutex_2);
-                if (!data_.processed_thermal_frame_2.empty())
-                    data_.processed_thermal_frame_2.copyTo(frameT2);
-            }
-
-            {
-                std::lock_guard<std::mutex> lock(data_.processed_visible_mutex_2);
-                if (!data_.processed_visible_frame_2.empty())
-                    data_.processed_visible_frame_2.copyTo(frameV2);
-            }
-
-            if (!frameT2.empty())
-            {
-                // 调整热成像图像尺寸到配置分辨率
-                if (frameT2.cols != frameWidth || frameT2.rows != frameHeight)
-                {
-                    cv::resize(frameT2, frameT2, cv::Size(frameWidth, frameHeight), 0, 0, cv::INTER_LINEAR);
-                }
-                pusherT2->pushFrame(frameT2);
-            }
+            // 启用四分屏时，未推流的输出仍需取帧供合成使用
+            if (out.enabled || quadCompositor)
+                pollStreamOutput(out, nowUs, streamSize, keepaliveIntervalUs, overlayConfig.yuvStreams);
+        }
 
-            if (!frameV2.empty())
+        // ========== 四分屏合成 ==========
+        if (quadCompositor && nowUs - quadLastEncodeUs >= quadIntervalUs)
+        {
+            // 只重绘有新帧的分块，全部分块都没有新帧时不编码（保活除外）
+            for (int i = 0; i < QuadCompositor::kTileCount; i++)
+                quadCompositor->updateTile(i, outputs[i].frame, outputs[i].lastSeq, outputs[i].frameOverlay.get(), outputs[i].layers,
+                                           outputs[i].overlayScaleX, outputs[i].overlayScaleY);
+            bool dirty = quadCompositor->takeDirtyTileCount() > 0;
+            bool keepalive = keepaliveIntervalUs > 0 && quadLastEncodeUs > 0 &&
+                             nowUs - quadLastEncodeUs >= keepaliveIntervalUs;
+            if (dirty || keepalive)
             {
-                // 调整可见光图像尺寸到配置分辨率
-                if (frameV2.cols != frameWidth || frameV2.rows != frameHeight)
+                // 各分块的目标区域映射到合成画面坐标
+                std::vector<cv::Rect> quadRois;
+                const int tileW = quadCompositor->width() / 2;
+                const int tileH = quadCompositor->height() / 2;
+                const double sx = static_cast<double>(tileW) / frameWidth;
+                const double sy = static_cast<double>(tileH) / frameHeight;
+                for (int i = 0; i < QuadCompositor::kTileCount; i++)
                 {
-                    cv::resize(frameV2, frameV2, cv::Size(frameWidth, frameHeight), 0, 0, cv::INTER_LINEAR);
+                    const int ox = (i % 2) * tileW;
+                    const int oy = (i / 2) * tileH;
+                    for (const auto &r : outputs[i].frameRois)
+                    {
+                        quadRois.emplace_back(ox + cvRound(r.x * sx), oy + cvRound(r.y * sy),
+                                              cvRound(r.width * sx), cvRound(r.height * sy));
+                    }
                 }
-                pusherV2->pushFrame(frameV2);
+                pusherQuad->setRegionsOfInterest(quadRois);
+                pusherQuad->pushI420(quadCompositor->canvas(), nowUs);
+                quadLastEncodeUs = nowUs;
             }
         }
 
-        // 基于时间戳的精确帧率控制，移除固定延迟 [[memory:852229]]
-        static auto last_frame_time = std::chrono::steady_clock::now();
-        auto current_time = std::chrono::steady_clock::now();
-        auto frame_duration = std::chrono::milliseconds(1000 / fps);
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_frame_time);
+        // 短轮询：编码时机由各路新帧决定，不再使用全局固定帧间隔
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
 
-        if (elapsed < frame_duration)
+    // 标注绘制统计：各路取到的帧中带标注与不带标注的数量，以及渲染缓存的绘制与复用次数
+    for (auto &out : outputs)
+    {
+        uint64_t renders = 0, hits = 0;
         {
-            std::this_thread::sleep_for(frame_duration - elapsed);
+            std::lock_guard<std::mutex> lock(*out.mutex);
+            renders = out.render->renders();
+            hits = out.render->hits();
         }
-        last_frame_time = std::chrono::steady_clock::now();
+        std::cout << "[TaskRTSPStream] /" << out.path << " 标注 - 带标注帧: " << out.overlayFrames
+                  << ", 未绘制帧: " << out.plainFrames << ", 渲染缓存 绘制: " << renders << " 次, 复用: " << hits << " 次" << std::endl;
     }
 
     // 关闭所有推流器
@@ -278,16 +451,57 @@ void TaskRTSPStream::run()
         pusherV2->close();
         std::cout << "[TaskRTSPStream] 设备2推流器已关闭" << std::endl;
     }
+
+    if (pusherQuad)
+    {
+        pusherQuad->close();
+        std::cout << "[TaskRTSPStream] 四分屏推流器已关闭" << std::endl;
+    }
 }
 
 // FFmpeg推流器构造函数
 FFmpegRtspPusher::FFmpegRtspPusher(const std::string &rtspUrl, int width, int height, int fps)
     : rtspUrl_(rtspUrl), width_(width), height_(height), fps_(fps), frameIndex_(0),
+      baseTimestampUs_(-1), lastPts_(-1),
       ofmt_ctx_(nullptr), video_st_(nullptr), codec_ctx_(nullptr), sws_ctx_(nullptr),
+      embeddedServer_(nullptr), streamPath_(RtspServer::pathFromUrl(rtspUrl)),
+      multicastEnabled_(false), mcast_ctx_(nullptr), mcast_st_(nullptr), mcastErrors_(0),
+      statsStartUs_(0), statsBytes_(0), statsFrames_(0), statsRoiCount_(0),
+      overlayLayers_(kOverlayNone), overlayScaleX_(1.0), overlayScaleY_(1.0),
       clientDisconnected_(false), consecutiveErrors_(0)
 {
 }
 
+// 附加内嵌RTSP服务器，流路径取自推流URL
+void FFmpegRtspPusher::attachEmbeddedServer(RtspServer *server)
+{
+    embeddedServer_ = server;
+}
+
+// 设置ROI编码与码率统计参数
+void FFmpegRtspPusher::setRoiEncoding(const RoiEncodingConfig &config)
+{
+    roiConfig_ = config;
+}
+
+// 设置后续编码帧的标注，保持到下一次设置（保活重复的帧同样带标注）
+void FFmpegRtspPusher::setOverlay(const FrameOverlayPtr &overlay, uint32_t layers, double scaleX, double scaleY)
+{
+    overlay_ = overlay;
+    overlayLayers_ = overlay ? layers : kOverlayNone;
+    overlayScaleX_ = scaleX;
+    overlayScaleY_ = scaleY;
+}
+
+// 启用组播输出，仅对配置了组播组的流路径生效
+void FFmpegRtspPusher::enableMulticast(const MulticastOutputConfig &config)
+{
+    if (!config.enable || config.groups.find(streamPath_) == config.groups.end())
+        return;
+    multicastConfig_ = config;
+    multicastEnabled_ = true;
+}
+
 // FFmpeg推流器析构函数
 FFmpegRtspPusher::~FFmpegRtspPusher()
 {
@@ -302,6 +516,9 @@ bool FFmpegRtspPusher::open()
 
     // 重置连接状态，允许重新推流
     resetConnectionState();
+    frameIndex_ = 0;
+    baseTimestampUs_ = -1;
+    lastPts_ = -1;
 
     try
     {
@@ -310,14 +527,18 @@ bool FFmpegRtspPusher::open()
         // 完全屏蔽FFmpeg日志输出
         av_log_set_level(AV_LOG_QUIET);
 
-        // 分配输出上下文
-        int ret = avformat_alloc_output_context2(&ofmt_ctx_, nullptr, "rtsp", rtspUrl_.c_str());
-        if (ret < 0 || !ofmt_ctx_)
+        // 分配输出上下文（内嵌服务器模式下不需要RTSP muxer）
+        int ret = 0;
+        if (!embeddedServer_)
         {
-            char errbuf[AV_ERROR_MAX_STRING_SIZE];
-            av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-            std::cout << "[TaskRTSPStream] 分配输出上下文失败: " << errbuf << std::endl;
-            return false;
+            ret = avformat_alloc_output_context2(&ofmt_ctx_, nullptr, "rtsp", rtspUrl_.c_str());
+            if (ret < 0 || !ofmt_ctx_)
+            {
+                char errbuf[AV_ERROR_MAX_STRING_SIZE];
+                av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+                std::cout << "[TaskRTSPStream] 分配输出上下文失败: " << errbuf << std::endl;
+                return false;
+            }
         }
 
         // 查找H.264编码器
@@ -345,7 +566,7 @@ bool FFmpegRtspPusher::open()
         codec_ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
         codec_ctx_->width = width_;
         codec_ctx_->height = height_;
-        codec_ctx_->time_base = AVRational{1, fps_};
+        codec_ctx_->time_base = AVRational{1, 90000}; // PTS来自采集时间戳，使用90kHz时钟
         codec_ctx_->framerate = AVRational{fps_, 1};
         codec_ctx_->gop_size = fps_;
         codec_ctx_->max_b_frames = 0;
@@ -358,8 +579,18 @@ bool FFmpegRtspPusher::open()
         av_opt_set(codec_ctx_->priv_data, "tune", "zerolatency", 0);
         av_opt_set(codec_ctx_->priv_data, "profile", "baseline", 0);
 
+        if (roiConfig_.enable)
+        {
+            // ultrafast预设关闭了自适应量化，libx264只有在aq-mode开启时才应用ROI量化偏移
+            av_opt_set_int(codec_ctx_->priv_data, "aq-mode", 1, 0);
+            if (roiConfig_.crf > 0)
+                av_opt_set_double(codec_ctx_->priv_data, "crf", roiConfig_.crf, 0);
+            std::cout << "[TaskRTSPStream] 启用ROI编码: 目标区域qoffset=" << roiConfig_.roiQOffset
+                      << ", 背景qoffset=" << roiConfig_.backgroundQOffset << std::endl;
+        }
+
         // FFmpeg 7.1版本兼容性：设置全局头标志
-        if (ofmt_ctx_->oformat->flags & AVFMT_GLOBALHEADER)
+        if (ofmt_ctx_ && (ofmt_ctx_->oformat->flags & AVFMT_GLOBALHEADER))
         {
             codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
         }
@@ -373,6 +604,20 @@ bool FFmpegRtspPusher::open()
             return false;
         }
 
+        // 组播输出失败不影响RTSP推流
+        if (multicastEnabled_ && !openMulticast())
+        {
+            std::cout << "[TaskRTSPStream] 组播输出打开失败，仅使用RTSP输出: /" << streamPath_ << std::endl;
+        }
+
+        if (embeddedServer_)
+        {
+            // SPS/PPS从全局头中获取，供DESCRIBE生成SDP
+            embeddedServer_->setStreamParameters(streamPath_, codec_ctx_->extradata, codec_ctx_->extradata_size);
+            std::cout << "[TaskRTSPStream] 内嵌RTSP流就绪: /" << streamPath_ << std::endl;
+            return true;
+        }
+
         // 创建视频流
         std::cout << "[TaskRTSPStream] 创建视频流" << std::endl;
         video_st_ = avformat_new_stream(ofmt_ctx_, nullptr);
@@ -445,13 +690,9 @@ bool FFmpegRtspPusher::open()
 }
 
 // 推送一帧到RTSP流
-void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr)
+void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr, int64_t timestampUs)
 {
-    if (!ofmt_ctx_ || !codec_ctx_ || !video_st_ || bgr.empty())
-        return;
-
-    // 如果客户端已断开，跳过推流避免崩溃
-    if (clientDisconnected_)
+    if (bgr.empty() || !readyToPush())
         return;
 
     // 自动调整尺寸
@@ -461,15 +702,100 @@ void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr)
         cv::resize(bgr, frame_to_encode, cv::Size(width_, height_), 0, 0, cv::INTER_LINEAR);
     }
 
+    AVFrame *frame = allocFrame(timestampUs);
+    if (!frame)
+        return;
+
+    // CUDA BGR到YUV转换
+    std::vector<uint8_t> yuv(width_ * height_ * 3 / 2);
+    cudaBGR2YUV420P(frame_to_encode, yuv.data(), width_, height_);
+
+    // 复制YUV数据到frame
+    int y_size = width_ * height_;
+    int uv_size = y_size / 4;
+
+    memcpy(frame->data[0], yuv.data(), y_size);
+    memcpy(frame->data[1], yuv.data() + y_size, uv_size);
+    memcpy(frame->data[2], yuv.data() + y_size + uv_size, uv_size);
+
+    // 标注直接画到编码帧的YUV平面上
+    if (overlayLayers_ != kOverlayNone)
+    {
+        YuvPlanes planes;
+        planes.y = frame->data[0];
+        planes.u = frame->data[1];
+        planes.v = frame->data[2];
+        planes.yStride = frame->linesize[0];
+        planes.uvStride = frame->linesize[1];
+        planes.width = width_;
+        planes.height = height_;
+        yuvOverlay_.draw(planes, *overlay_, overlayLayers_, overlayScaleX_, overlayScaleY_);
+    }
+
+    encodeAndSend(frame);
+}
+
+// 推送一帧已转换好的I420数据（如四分屏合成画布），跳过BGR到YUV的转换
+void FFmpegRtspPusher::pushI420(const cv::Mat &i420, int64_t timestampUs)
+{
+    if (i420.empty() || !readyToPush())
+        return;
+    if (!i420.isContinuous() || i420.cols != width_ || i420.rows != height_ * 3 / 2)
+        return;
+
+    AVFrame *frame = allocFrame(timestampUs);
+    if (!frame)
+        return;
+
+    int y_size = width_ * height_;
+    int uv_size = y_size / 4;
+    const uint8_t *src = i420.ptr<uint8_t>(0);
+
+    memcpy(frame->data[0], src, y_size);
+    memcpy(frame->data[1], src + y_size, uv_size);
+    memcpy(frame->data[2], src + y_size + uv_size, uv_size);
+
+    encodeAndSend(frame);
+}
+
+// 检查推流器是否可以推送数据
+bool FFmpegRtspPusher::readyToPush() const
+{
+    if (!codec_ctx_)
+        return false;
+    if (!embeddedServer_ && (!ofmt_ctx_ || !video_st_))
+        return false;
+
+    // 如果客户端已断开，跳过推流避免崩溃
+    return !clientDisconnected_;
+}
+
+// 分配一个待编码的YUV420P帧并设置时间戳与关键帧标志
+AVFrame *FFmpegRtspPusher::allocFrame(int64_t timestampUs)
+{
     // 分配AVFrame
     AVFrame *frame = av_frame_alloc();
     if (!frame)
-        return;
+        return nullptr;
+
+    // PTS = 采集时间相对第一帧的偏移（90kHz），编码器要求严格递增
+    if (timestampUs < 0)
+        timestampUs = steadyClockUs();
+    if (baseTimestampUs_ < 0)
+        baseTimestampUs_ = timestampUs;
+    int64_t pts = av_rescale(timestampUs - baseTimestampUs_, 90000, 1000000);
+    if (pts <= lastPts_)
+        pts = lastPts_ + 1;
+    lastPts_ = pts;
 
     frame->format = AV_PIX_FMT_YUV420P;
     frame->width = width_;
     frame->height = height_;
-    frame->pts = frameIndex_++;
+    frame->pts = pts;
+    frameIndex_++;
+
+    if (roiConfig_.enable)
+        attachRegionsOfInterest(frame);
 
     if (frameIndex_ % codec_ctx_->gop_size == 1)
     {
@@ -480,26 +806,19 @@ void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr)
     if (av_frame_get_buffer(frame, 32) < 0)
     {
         av_frame_free(&frame);
-        return;
+        return nullptr;
     }
 
-    // CUDA BGR到YUV转换
-    std::vector<uint8_t> yuv(width_ * height_ * 3 / 2);
-    cudaBGR2YUV420P(frame_to_encode, yuv.data(), width_, height_);
-
     // 设置YUV420P格式的stride
     frame->linesize[0] = width_;
     frame->linesize[1] = width_ / 2;
     frame->linesize[2] = width_ / 2;
+    return frame;
+}
 
-    // 复制YUV数据到frame
-    int y_size = width_ * height_;
-    int uv_size = y_size / 4;
-
-    memcpy(frame->data[0], yuv.data(), y_size);
-    memcpy(frame->data[1], yuv.data() + y_size, uv_size);
-    memcpy(frame->data[2], yuv.data() + y_size + uv_size, uv_size);
-
+// 编码一帧并输出所有数据包，调用后释放frame
+void FFmpegRtspPusher::encodeAndSend(AVFrame *frame)
+{
     // 编码并推流，增加错误处理
     int ret = avcodec_send_frame(codec_ctx_, frame);
     if (ret >= 0)
@@ -507,38 +826,13 @@ void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr)
         AVPacket *pkt = av_packet_alloc();
         while (avcodec_receive_packet(codec_ctx_, pkt) >= 0)
         {
-            av_packet_rescale_ts(pkt, codec_ctx_->time_base, video_st_->time_base);
-            pkt->stream_index = video_st_->index;
-
-            // 写入数据包并检查错误
-            int write_ret = av_interleaved_write_frame(ofmt_ctx_, pkt);
-            if (write_ret < 0)
-            {
-                consecutiveErrors_++;
-                char errbuf[AV_ERROR_MAX_STRING_SIZE];
-                av_strerror(write_ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-
-                // 检查是否为连接断开错误
-                if (write_ret == AVERROR(EPIPE) || write_ret == AVERROR(ECONNRESET) ||
-                    write_ret == AVERROR_EOF || consecutiveErrors_ > 5)
-                {
-                    std::cout << "[FFmpegRtspPusher] 客户端断开连接: " << errbuf
-                              << " (连续错误: " << consecutiveErrors_ << ") URL: " << rtspUrl_ << std::endl;
-                    clientDisconnected_ = true;
-                    av_packet_unref(pkt);
-                    av_packet_free(&pkt);
-                    av_frame_free(&frame);
-                    return;
-                }
-                else
-                {
-                    std::cout << "[FFmpegRtspPusher] 写入错误: " << errbuf << std::endl;
-                }
-            }
-            else
+            updateBitrateStats(pkt->size, steadyClockUs());
+            if (!writePacket(pkt))
             {
-                // 写入成功，重置错误计数
-                consecutiveErrors_ = 0;
+                av_packet_unref(pkt);
+                av_packet_free(&pkt);
+                av_frame_free(&frame);
+                return;
             }
             av_packet_unref(pkt);
         }
@@ -553,6 +847,248 @@ void FFmpegRtspPusher::pushFrame(const cv::Mat &bgr)
     av_frame_free(&frame);
 }
 
+// 输出一个编码后的数据包，返回false表示客户端已断开
+bool FFmpegRtspPusher::writePacket(AVPacket *pkt)
+{
+    // 组播输出使用数据包副本，时间戳仍为编码器时间基
+    if (mcast_ctx_)
+        writeMulticast(pkt);
+
+    if (embeddedServer_)
+    {
+        // 内嵌服务器：时间戳换算到RTP的90kHz时钟，服务器内部打包并分发
+        int64_t pts90k = av_rescale_q(pkt->pts, codec_ctx_->time_base, AVRational{1, 90000});
+        embeddedServer_->publishPacket(streamPath_, pkt->data, pkt->size, pts90k,
+                                       (pkt->flags & AV_PKT_FLAG_KEY) != 0);
+        return true;
+    }
+
+    av_packet_rescale_ts(pkt, codec_ctx_->time_base, video_st_->time_base);
+    pkt->stream_index = video_st_->index;
+
+    // 写入数据包并检查错误
+    int write_ret = av_interleaved_write_frame(ofmt_ctx_, pkt);
+    if (write_ret < 0)
+    {
+        consecutiveErrors_++;
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(write_ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+
+        // 检查是否为连接断开错误
+        if (write_ret == AVERROR(EPIPE) || write_ret == AVERROR(ECONNRESET) ||
+            write_ret == AVERROR_EOF || consecutiveErrors_ > 5)
+        {
+            std::cout << "[FFmpegRtspPusher] 客户端断开连接: " << errbuf
+                      << " (连续错误: " << consecutiveErrors_ << ") URL: " << rtspUrl_ << std::endl;
+            clientDisconnected_ = true;
+            return false;
+        }
+        else
+        {
+            std::cout << "[FFmpegRtspPusher] 写入错误: " << errbuf << std::endl;
+        }
+    }
+    else
+    {
+        // 写入成功，重置错误计数
+        consecutiveErrors_ = 0;
+    }
+    return true;
+}
+
+// 附加ROI边信息：目标区域在前，全画面背景区域在后（libx264对每个宏块使用第一个包含它的区域）
+void FFmpegRtspPusher::attachRegionsOfInterest(AVFrame *frame)
+{
+    const size_t regionCount = (std::min)(rois_.size(), static_cast<size_t>((std::max)(0, roiConfig_.maxRegions)));
+    const bool withBackground = roiConfig_.backgroundQOffset != 0.0f;
+    const size_t total = regionCount + (withBackground ? 1 : 0);
+    statsRoiCount_ += static_cast<int64_t>(regionCount);
+    if (total == 0)
+        return;
+
+    AVFrameSideData *sd = av_frame_new_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+                                                 total * sizeof(AVRegionOfInterest));
+    if (!sd)
+        return;
+
+    auto toQ = [](float v)
+    {
+        v = (std::max)(-1.0f, (std::min)(1.0f, v));
+        return av_make_q(static_cast<int>(v * 1000.0f), 1000);
+    };
+
+    AVRegionOfInterest *roi = reinterpret_cast<AVRegionOfInterest *>(sd->data);
+    const cv::Rect frameRect(0, 0, width_, height_);
+    size_t k = 0;
+    for (size_t i = 0; i < regionCount; i++)
+    {
+        const cv::Rect &r = rois_[i];
+        cv::Rect expanded(r.x - roiConfig_.marginPx, r.y - roiConfig_.marginPx,
+                          r.width + 2 * roiConfig_.marginPx, r.height + 2 * roiConfig_.marginPx);
+        expanded &= frameRect;
+        if (expanded.empty())
+            continue;
+        roi[k].self_size = sizeof(AVRegionOfInterest);
+        roi[k].top = expanded.y;
+        roi[k].bottom = expanded.y + expanded.height;
+        roi[k].left = expanded.x;
+        roi[k].right = expanded.x + expanded.width;
+        roi[k].qoffset = toQ(roiConfig_.roiQOffset);
+        k++;
+    }
+    if (withBackground)
+    {
+        roi[k].self_size = sizeof(AVRegionOfInterest);
+        roi[k].top = 0;
+        roi[k].bottom = height_;
+        roi[k].left = 0;
+        roi[k].right = width_;
+        roi[k].qoffset = toQ(roiConfig_.backgroundQOffset);
+        k++;
+    }
+
+    // 被裁剪掉的区域不计入，缩短边信息
+    if (k == 0)
+        av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+    else
+        sd->size = k * sizeof(AVRegionOfInterest);
+}
+
+// 统计输出码率，按配置间隔输出日志
+void FFmpegRtspPusher::updateBitrateStats(int packetBytes, int64_t nowUs)
+{
+    if (roiConfig_.statsIntervalSec <= 0)
+        return;
+    if (statsStartUs_ == 0)
+        statsStartUs_ = nowUs;
+    statsBytes_ += packetBytes;
+    statsFrames_++;
+
+    int64_t elapsedUs = nowUs - statsStartUs_;
+    if (elapsedUs < static_cast<int64_t>(roiConfig_.statsIntervalSec) * 1000000)
+        return;
+
+    double seconds = elapsedUs / 1e6;
+    std::cout << "[FFmpegRtspPusher] /" << streamPath_ << " 码率: " << static_cast<int>(statsBytes_ * 8 / seconds / 1000)
+              << " kbps, 帧率: " << (statsFrames_ / seconds)
+              << ", ROI: " << (roiConfig_.enable ? "开" : "关")
+              << ", 平均目标区域数: " << (statsFrames_ > 0 ? static_cast<double>(statsRoiCount_) / statsFrames_ : 0.0)
+              << std::endl;
+    statsStartUs_ = nowUs;
+    statsBytes_ = 0;
+    statsFrames_ = 0;
+    statsRoiCount_ = 0;
+}
+
+// 打开组播输出：RTP(H.264)、RTP(MPEG-TS) 或 UDP(MPEG-TS)，RTP格式同时生成SDP文件
+bool FFmpegRtspPusher::openMulticast()
+{
+    const std::string &group = multicastConfig_.groups[streamPath_];
+    const std::string &format = multicastConfig_.format;
+    bool isRtp = (format == "rtp" || format == "rtp_mpegts");
+    if (!isRtp && format != "mpegts")
+    {
+        std::cout << "[TaskRTSPStream] 不支持的组播格式: " << format << std::endl;
+        return false;
+    }
+
+    std::string url = (isRtp ? "rtp://" : "udp://") + group +
+                      "?ttl=" + std::to_string(multicastConfig_.ttl) +
+                      "&pkt_size=" + std::to_string(multicastConfig_.pktSize);
+    if (!multicastConfig_.localAddress.empty())
+        url += "&localaddr=" + multicastConfig_.localAddress;
+
+    int ret = avformat_alloc_output_context2(&mcast_ctx_, nullptr, format.c_str(), url.c_str());
+    if (ret < 0 || !mcast_ctx_)
+    {
+        mcast_ctx_ = nullptr;
+        return false;
+    }
+
+    mcast_st_ = avformat_new_stream(mcast_ctx_, nullptr);
+    if (!mcast_st_ || avcodec_parameters_from_context(mcast_st_->codecpar, codec_ctx_) < 0)
+    {
+        avformat_free_context(mcast_ctx_);
+        mcast_ctx_ = nullptr;
+        mcast_st_ = nullptr;
+        return false;
+    }
+    mcast_st_->time_base = codec_ctx_->time_base;
+
+    ret = avio_open2(&mcast_ctx_->pb, url.c_str(), AVIO_FLAG_WRITE, nullptr, nullptr);
+    if (ret >= 0)
+        ret = avformat_write_header(mcast_ctx_, nullptr);
+    if (ret < 0)
+    {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        std::cout << "[TaskRTSPStream] 组播输出打开失败: " << errbuf << " URL: " << url << std::endl;
+        if (mcast_ctx_->pb)
+            avio_closep(&mcast_ctx_->pb);
+        avformat_free_context(mcast_ctx_);
+        mcast_ctx_ = nullptr;
+        mcast_st_ = nullptr;
+        return false;
+    }
+
+    // RTP输出生成SDP文件，显示端使用 ffplay -protocol_whitelist file,udp,rtp <path>.sdp 接收
+    if (isRtp)
+    {
+        char sdp[4096];
+        AVFormatContext *ctxs[1] = {mcast_ctx_};
+        if (av_sdp_create(ctxs, 1, sdp, sizeof(sdp)) == 0)
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(multicastConfig_.sdpDir, ec);
+            std::string sdpPath = multicastConfig_.sdpDir + "/" + streamPath_ + ".sdp";
+            std::ofstream sdpFile(sdpPath, std::ios::binary | std::ios::trunc);
+            if (sdpFile.is_open())
+            {
+                sdpFile << sdp;
+                std::cout << "[TaskRTSPStream] 组播SDP已生成: " << sdpPath << std::endl;
+            }
+        }
+    }
+
+    mcastErrors_ = 0;
+    std::cout << "[TaskRTSPStream] 组播输出已打开: /" << streamPath_ << " -> " << url << std::endl;
+    return true;
+}
+
+// 写入一个数据包到组播输出
+void FFmpegRtspPusher::writeMulticast(const AVPacket *pkt)
+{
+    AVPacket *mpkt = av_packet_clone(pkt);
+    if (!mpkt)
+        return;
+
+    av_packet_rescale_ts(mpkt, codec_ctx_->time_base, mcast_st_->time_base);
+    mpkt->stream_index = mcast_st_->index;
+    int ret = av_interleaved_write_frame(mcast_ctx_, mpkt);
+    av_packet_free(&mpkt);
+
+    // UDP发送无连接状态，错误只做限频日志
+    if (ret < 0 && (mcastErrors_++ % 100) == 0)
+    {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        std::cout << "[FFmpegRtspPusher] 组播写入错误: " << errbuf << " (累计 " << mcastErrors_ << ")" << std::endl;
+    }
+}
+
+// 关闭组播输出
+void FFmpegRtspPusher::closeMulticast()
+{
+    if (!mcast_ctx_)
+        return;
+    av_write_trailer(mcast_ctx_);
+    if (mcast_ctx_->pb)
+        avio_closep(&mcast_ctx_->pb);
+    avformat_free_context(mcast_ctx_);
+    mcast_ctx_ = nullptr;
+    mcast_st_ = nullptr;
+}
+
 // 关闭RTSP推流器
 void FFmpegRtspPusher::close()
 {
@@ -568,6 +1104,8 @@ void FFmpegRtspPusher::close()
 // 清理FFmpeg资源
 void FFmpegRtspPusher::cleanup()
 {
+    closeMulticast();
+
     if (codec_ctx_)
     {
         avcodec_free_context(&codec_ctx_);
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
 
 // 构造函数：初始化设备用户ID和共享数据
 TaskThermalCapture::TaskThermalCapture(const std::vector<LONG> &userIDs, SharedData &data)
@@ -21,10 +22,8 @@ TaskThermalCapture::TaskThermalCapture(const std::vector<LONG> &userIDs, SharedD
 	frameCount_ = 0;
 	totalProcessingTime_ = 0;
 
-	// 初始化调色板缓存
-	paletteInitialized_ = false;
-	thresholdGrayValue_ = 128.0f; // 默认阈值
-	percentileThreshold_ = 0.8f;  // 默认80%分位数
+	// 默认80%分位数，两台设备各自标定调色板
+	percentileThreshold_ = 0.8f;
 }
 
 // 析构函数：确保线程安全退出
@@ -36,7 +35,26 @@ TaskThermalCapture::~TaskThermalCapture()
 // 启动热成像数据捕获线程
 void TaskThermalCapture::start()
 {
-	std::cout << "[TaskThermalCapture] 启动基于颜色分析的温度数据捕获线程..." << std::endl;
+	// 启用辐射测温采集时，每个设备一个采集线程
+	const RadiometricIngestConfig &radiometricConfig = data_.radiometricIngestConfig;
+	if (radiometricConfig.enable)
+	{
+		for (int i = 0; i < 2 && i < static_cast<int>(userIDs_.size()); i++)
+		{
+			auto ingest = std::make_unique<RadiometricIngest>(i, userIDs_[i], data_, radiometricConfig);
+			if (ingest->start())
+			{
+				radiometric_[i] = std::move(ingest);
+				radiometricEnabled_ = true;
+			}
+		}
+		if (!radiometricEnabled_)
+		{
+			std::cerr << "[TaskThermalCapture] 辐射测温采集未能启动，回退到调色板颜色分析" << std::endl;
+		}
+	}
+
+	std::cout << "[TaskThermalCapture] 启动" << (radiometricEnabled_ ? "基于辐射测温数据" : "基于颜色分析") << "的温度数据捕获线程..." << std::endl;
 	thread_ = std::thread(&TaskThermalCapture::run, this);
 }
 
@@ -49,6 +67,13 @@ void TaskThermalCapture::stop()
 	{
 		thread_.join();
 	}
+	for (auto &ingest : radiometric_)
+	{
+		if (ingest)
+		{
+			ingest->stop();
+		}
+	}
 
 	// 输出性能统计
 	if (frameCount_ > 0)
@@ -75,8 +100,8 @@ bool TaskThermalCapture::setPercentileThreshold(float percentile)
 		return false;
 	}
 
+	// 下一帧由各设备的标定器在现有直方图上重新查找，无需重新采样
 	percentileThreshold_ = percentile;
-	paletteInitialized_ = false; // 重置初始化标志，强制重新计算阈值
 
 	std::cout << "[TaskThermalCapture] 百分位数阈值已更新为: " << (percentile * 100) << "%" << std::endl;
 	return true;
@@ -143,171 +168,383 @@ bool TaskThermalCapture::getCachedTemperatureRange(int deviceIdx, float &minTemp
 }
 
 /**
- * @brief 计算向量的指定百分位数值
- * @param values 输入数值向量
- * @param percentile 百分位数 (0.0-1.0)
- * @return 百分位数对应的值
+ * @brief 从温度条区域读取调色板颜色范围（已简化）
+ * @param frame 热成像视频帧
+ * @return 调色板的灰度值向量，从低温到高温排列
  */
-float TaskThermalCapture::calculatePercentile(std::vector<float> &values, float percentile)
+std::vector<float> TaskThermalCapture::extractTemperaturePalette(const cv::Mat &frame)
 {
-	if (values.empty())
-	{
-		return 0.0f;
-	}
+	// 已简化：不再提取复杂调色板，直接返回空向量
+	// 调色板阈值由每个设备的PaletteCalibrator维护
+	return std::vector<float>();
+}
+
+/**
+ * @brief 创建屏蔽区域掩码
+ * @param frame 热成像视频帧
+ * @return 屏蔽掩码（255=有效区域，0=屏蔽区域）
+ */
+cv::Mat TaskThermalCapture::createMaskRegions(const cv::Mat &frame)
+{
+	cv::Mat mask = cv::Mat::ones(frame.size(), CV_8UC1) * 255;
+
+	// 屏蔽区域1：(1090,90) 到 (1235,145)
+	cv::rectangle(mask, cv::Point(1090, 90), cv::Point(1235, 145), cv::Scalar(0), -1);
 
-	// 排序向量
-	std::sort(values.begin(), values.end());
+	// 屏蔽区域2：(1090,625) 到 (1235,670)
+	cv::rectangle(mask, cv::Point(1090, 625), cv::Point(1235, 670), cv::Scalar(0), -1);
 
-	// 计算百分位数对应的索引
-	float index = percentile * (values.size() - 1);
-	int lowerIndex = static_cast<int>(floor(index));
-	int upperIndex = static_cast<int>(ceil(index));
+	// 屏蔽区域3：(1235,90) 到 (1280,625)
+	cv::rectangle(mask, cv::Point(1235, 90), cv::Point(1280, 625), cv::Scalar(0), -1);
 
-	// 边界检查
-	lowerIndex = (std::max)(0, (std::min)(lowerIndex, static_cast<int>(values.size() - 1)));
-	upperIndex = (std::max)(0, (std::min)(upperIndex, static_cast<int>(values.size() - 1)));
+	return mask;
+}
 
-	// 线性插值
-	if (lowerIndex == upperIndex)
+/**
+ * @brief 按输入分辨率准备缩放表和静态屏蔽掩码
+ * @param frame 热成像视频帧
+ */
+void TaskThermalCapture::prepareMatrixTables(const cv::Mat &frame)
+{
+	if (frame.size() == tableSourceSize_ && !staticValid_.empty())
 	{
-		return values[lowerIndex];
+		return;
 	}
-	else
+
+	// 区域平均缩放表：输出像素i覆盖源像素 [i*S/N, (i+1)*S/N)，至少一个像素
+	auto buildTable = [](int srcLen, int dstLen, std::vector<int> &starts, std::vector<int> &ends)
 	{
-		float weight = index - lowerIndex;
-		return values[lowerIndex] * (1.0f - weight) + values[upperIndex] * weight;
+		starts.resize(dstLen);
+		ends.resize(dstLen);
+		for (int i = 0; i < dstLen; i++)
+		{
+			int s = static_cast<int>(static_cast<int64_t>(i) * srcLen / dstLen);
+			int e = static_cast<int>(static_cast<int64_t>(i + 1) * srcLen / dstLen);
+			s = (std::min)(s, srcLen - 1);
+			starts[i] = s;
+			ends[i] = (std::max)(e, s + 1);
+		}
+	};
+	buildTable(frame.cols, MATRIX_WIDTH, colStart_, colEnd_);
+	buildTable(frame.rows, MATRIX_HEIGHT, rowStart_, rowEnd_);
+
+	// 屏蔽掩码只与分辨率有关，按相同的缩放表归约到输出分辨率：
+	// 覆盖区域完全位于屏蔽区内的输出像素视为屏蔽
+	cv::Mat sourceMask = createMaskRegions(frame);
+	// 按位打包，掩码生成时与阈值比较结果按64位字相与
+	staticValid_.create(MATRIX_WIDTH, MATRIX_HEIGHT);
+	for (int y = 0; y < MATRIX_HEIGHT; y++)
+	{
+		for (int x = 0; x < MATRIX_WIDTH; x++)
+		{
+			bool anyValid = false;
+			for (int sy = rowStart_[y]; sy < rowEnd_[y] && !anyValid; sy++)
+			{
+				const uchar *m = sourceMask.ptr<uchar>(sy);
+				for (int sx = colStart_[x]; sx < colEnd_[x]; sx++)
+				{
+					if (m[sx])
+					{
+						anyValid = true;
+						break;
+					}
+				}
+			}
+			if (anyValid)
+			{
+				staticValid_.set(x, y);
+			}
+		}
+	}
+
+	tableSourceSize_ = frame.size();
+	std::cout << "[TaskThermalCapture] 已为 " << frame.cols << "x" << frame.rows
+			  << " 输入构建缩放表和静态屏蔽掩码" << std::endl;
+}
+
+namespace
+{
+	/**
+	 * @brief 源行 [sx0, sx1) 区间转换为灰度，BGR按与cv::cvtColor(BGR2GRAY)相同的定点系数（Q14）
+	 */
+	inline void convertGrayRow(const uchar *src, int sx0, int sx1, bool isColor, int *gray)
+	{
+		int sx = sx0;
+#if CV_SIMD128
+		// 每次16个像素：扩展到32位后乘加，结果与标量路径逐像素相同
+		if (isColor)
+		{
+			const cv::v_uint32x4 kb = cv::v_setall_u32(1868), kg = cv::v_setall_u32(9617), kr = cv::v_setall_u32(4899);
+			const cv::v_uint32x4 half = cv::v_setall_u32(8192);
+			auto store8 = [&](const cv::v_uint16x8 &b, const cv::v_uint16x8 &g, const cv::v_uint16x8 &r, int *dst)
+			{
+				cv::v_uint32x4 b0, b1, g0, g1, r0, r1;
+				cv::v_expand(b, b0, b1);
+				cv::v_expand(g, g0, g1);
+				cv::v_expand(r, r0, r1);
+				cv::v_store(dst, cv::v_reinterpret_as_s32(cv::v_shr<14>(b0 * kb + g0 * kg + r0 * kr + half)));
+				cv::v_store(dst + 4, cv::v_reinterpret_as_s32(cv::v_shr<14>(b1 * kb + g1 * kg + r1 * kr + half)));
+			};
+			for (; sx + 16 <= sx1; sx += 16)
+			{
+				cv::v_uint8x16 b, g, r;
+				cv::v_load_deinterleave(src + 3 * sx, b, g, r);
+				cv::v_uint16x8 b0, b1, g0, g1, r0, r1;
+				cv::v_expand(b, b0, b1);
+				cv::v_expand(g, g0, g1);
+				cv::v_expand(r, r0, r1);
+				store8(b0, g0, r0, gray + sx);
+				store8(b1, g1, r1, gray + sx + 8);
+			}
+		}
+		else
+		{
+			for (; sx + 16 <= sx1; sx += 16)
+			{
+				cv::v_uint16x8 lo, hi;
+				cv::v_expand(cv::v_load(src + sx), lo, hi);
+				cv::v_uint32x4 q0, q1, q2, q3;
+				cv::v_expand(lo, q0, q1);
+				cv::v_expand(hi, q2, q3);
+				cv::v_store(gray + sx, cv::v_reinterpret_as_s32(q0));
+				cv::v_store(gray + sx + 4, cv::v_reinterpret_as_s32(q1));
+				cv::v_store(gray + sx + 8, cv::v_reinterpret_as_s32(q2));
+				cv::v_store(gray + sx + 12, cv::v_reinterpret_as_s32(q3));
+			}
+		}
+#endif
+		if (isColor)
+		{
+			for (; sx < sx1; sx++)
+			{
+				gray[sx] = (src[3 * sx] * 1868 + src[3 * sx + 1] * 9617 + src[3 * sx + 2] * 4899 + 8192) >> 14;
+			}
+		}
+		else
+		{
+			for (; sx < sx1; sx++)
+			{
+				gray[sx] = src[sx];
+			}
+		}
 	}
 }
 
 /**
- * @brief 一次性初始化调色板并计算阈值灰度值
- * @param frame 热成像视频帧
- * @return 是否初始化成功
+ * @brief 从热成像视频帧生成按位打包的高温掩码
+ * @param frame 热成像视频帧（1280x720）
+ * @param thresholdGray 该设备的高温阈值灰度值
+ * @param mask 输出高温掩码（640x512，1=HIGH_TEMP，0=LOW_TEMP）
+ * @param tiles 分块变化检测结果，为空时全帧计算；非空时只重新计算变化分块所在的64位字，其余字保留上一帧结果
+ * @return 是否生成成功
  */
-bool TaskThermalCapture::initializePalette(const cv::Mat &frame)
+bool TaskThermalCapture::generateTemperatureMask(const cv::Mat &frame, float thresholdGray, ThermalBitMask &mask, const TileChangeDetector *tiles)
 {
-	if (paletteInitialized_)
+	if (frame.empty())
 	{
-		return true; // 已经初始化过了
+		std::cerr << "[TaskThermalCapture] 输入视频帧为空" << std::endl;
+		return false;
 	}
 
-	// 温度条区域：左上角(1242,101)，宽35像素，高517像素
-	const int palette_x = 1242;
-	const int palette_y = 101;
-	const int palette_width = 35;
-	const int palette_height = 517;
-
-	// 检查边界
-	if (palette_x + palette_width > frame.cols || palette_y + palette_height > frame.rows)
+	// 只支持BGR和灰度输入，其他格式先转为灰度
+	cv::Mat source = frame;
+	if (frame.channels() != 3 && frame.channels() != 1)
 	{
-		std::cerr << "[TaskThermalCapture] 初始化失败：温度条区域超出图像边界" << std::endl;
-		return false;
+		cv::cvtColor(frame, source, cv::COLOR_BGRA2GRAY);
 	}
 
-	// 提取温度条区域
-	cv::Mat paletteROI = frame(cv::Rect(palette_x, palette_y, palette_width, palette_height));
+	prepareMatrixTables(source);
 
-	// 转为灰度图像
-	cv::Mat grayPalette;
-	if (paletteROI.channels() == 3)
+	if (mask.width() != MATRIX_WIDTH || mask.height() != MATRIX_HEIGHT)
 	{
-		cv::cvtColor(paletteROI, grayPalette, cv::COLOR_BGR2GRAY);
+		mask.create(MATRIX_WIDTH, MATRIX_HEIGHT);
+		tiles = nullptr; // 新分配的掩码没有上一帧结果可沿用
 	}
-	else
+	if (tiles && tiles->fullRefresh())
 	{
-		grayPalette = paletteROI.clone();
+		tiles = nullptr;
 	}
+	mask.highValue = HIGH_TEMP;
+	mask.lowValue = LOW_TEMP;
 
-	// 收集所有像素值用于百分位数计算
-	std::vector<float> pixelValues;
-	pixelValues.reserve(palette_width * palette_height);
+	const bool isColor = source.channels() == 3;
+	const float threshold = thresholdGray;
+	const int wordsPerRow = mask.wordsPerRow();
 
-	for (int y = 0; y < grayPalette.rows; y++)
+	// 每个输出行独立：累加其覆盖的源行灰度到列和，再与 阈值×像素数 比较（避免除法），结果直接写入该行的64位字
+	// 增量模式下只处理变化的连续字区间，灰度转换也只覆盖该区间对应的源列
+	cv::parallel_for_(cv::Range(0, MATRIX_HEIGHT), [&](const cv::Range &range)
 	{
-		for (int x = 0; x < grayPalette.cols; x++)
+		std::vector<int> grayRow(source.cols);
+		std::vector<int> colSum(MATRIX_WIDTH);
+
+		for (int y = range.start; y < range.end; y++)
 		{
-			pixelValues.push_back(static_cast<float>(grayPalette.at<uchar>(y, x)));
-		}
-	}
+			const int tileRow = y / TileChangeDetector::kTileSize;
+			if (tiles && !tiles->rowDirty(tileRow))
+			{
+				continue;
+			}
+			const uint8_t *dirtyWords = tiles ? tiles->dirtyWords(tileRow) : nullptr;
+			const int rowCount = rowEnd_[y] - rowStart_[y];
+			const uint64_t *valid = staticValid_.row(y);
+			uint64_t *dst = mask.row(y);
 
-	// 计算不同百分位数值用于参考
-	float percentile70 = calculatePercentile(pixelValues, 0.7f);
-	float percentile80 = calculatePercentile(pixelValues, 0.8f);
-	float percentile90 = calculatePercentile(pixelValues, 0.9f);
+			for (int wordBegin = 0; wordBegin < wordsPerRow;)
+			{
+				if (dirtyWords && !dirtyWords[wordBegin])
+				{
+					wordBegin++;
+					continue;
+				}
+				int wordEnd = wordBegin + 1;
+				while (wordEnd < wordsPerRow && (!dirtyWords || dirtyWords[wordEnd]))
+				{
+					wordEnd++;
+				}
 
-	// 使用指定百分位数作为阈值
-	thresholdGrayValue_ = calculatePercentile(pixelValues, percentileThreshold_);
+				const int x0 = wordBegin * 64;
+				const int x1 = (std::min)(wordEnd * 64, MATRIX_WIDTH);
+				const int sx0 = colStart_[x0];
+				const int sx1 = colEnd_[x1 - 1];
+				std::fill(colSum.begin() + x0, colSum.begin() + x1, 0);
 
-	paletteInitialized_ = true;
-	// std::cout << "[TaskThermalCapture] 调色板初始化成功，百分位数阈值分析:" << std::endl;
-	// std::cout << "  - 70%分位数: " << percentile70 << " (适中敏感度)" << std::endl;
-	// std::cout << "  - 80%分位数: " << percentile80 << " (推荐默认)" << std::endl;
-	// std::cout << "  - 90%分位数: " << percentile90 << " (严格检测)" << std::endl;
-	// std::cout << "  - 当前使用: " << thresholdGrayValue_ << " (" << (percentileThreshold_ * 100) << "%分位数)" << std::endl;
+				for (int sy = rowStart_[y]; sy < rowEnd_[y]; sy++)
+				{
+					const uchar *src = source.ptr<uchar>(sy);
+					convertGrayRow(src, sx0, sx1, isColor, grayRow.data());
+
+					for (int x = x0; x < x1; x++)
+					{
+						int sum = 0;
+						for (int sx = colStart_[x]; sx < colEnd_[x]; sx++)
+						{
+							sum += grayRow[sx];
+						}
+						colSum[x] += sum;
+					}
+				}
+
+				for (int wi = wordBegin; wi < wordEnd; wi++)
+				{
+					const int base = wi * 64;
+					const int count = (std::min)(64, MATRIX_WIDTH - base);
+					uint64_t word = 0;
+					int b = 0;
+#if CV_SIMD128
+					// 每次4列：列和与 阈值×像素数 比较，比较结果的符号位直接拼入64位字
+					const cv::v_int32x4 vRowCount = cv::v_setall_s32(rowCount);
+					const cv::v_float32x4 vThreshold = cv::v_setall_f32(threshold);
+					for (; b + 4 <= count; b += 4)
+					{
+						const int x = base + b;
+						const cv::v_int32x4 pixels = (cv::v_load(colEnd_.data() + x) - cv::v_load(colStart_.data() + x)) * vRowCount;
+						const cv::v_float32x4 sum = cv::v_cvt_f32(cv::v_load(colSum.data() + x));
+						word |= static_cast<uint64_t>(cv::v_signmask(sum > cv::v_cvt_f32(pixels) * vThreshold)) << b;
+					}
+#endif
+					for (; b < count; b++)
+					{
+						const int x = base + b;
+						const float limit = threshold * static_cast<float>(rowCount * (colEnd_[x] - colStart_[x]));
+						word |= static_cast<uint64_t>(static_cast<float>(colSum[x]) > limit) << b;
+					}
+					dst[wi] = word & valid[wi];
+				}
+				wordBegin = wordEnd;
+			}
+		}
+	});
 
 	return true;
 }
 
 /**
- * @brief 从温度条区域读取调色板颜色范围（已简化）
- * @param frame 热成像视频帧
- * @return 调色板的灰度值向量，从低温到高温排列
+ * @brief 更新分块变化检测统计，每300帧输出一次脏块比例和掩码生成耗时
+ * @param tiles 本帧的分块变化检测结果
+ * @param maskMs 本帧掩码生成耗时（毫秒）
  */
-std::vector<float> TaskThermalCapture::extractTemperaturePalette(const cv::Mat &frame)
+void TaskThermalCapture::recordTileStats(const TileChangeDetector &tiles, double maskMs)
 {
-	// 已简化：不再提取复杂调色板，直接返回空向量
-	// 调色板初始化由initializePalette()函数处理
-	return std::vector<float>();
+	tileStats_.frames++;
+	tileStats_.dirtyTiles += tiles.dirtyTileCount();
+	tileStats_.totalTiles += tiles.tileCount();
+	tileStats_.maskMs += maskMs;
+	if (tiles.fullRefresh())
+	{
+		// 全帧刷新的耗时作为未启用分块检测时的参考
+		tileStats_.fullFrameMs = tileStats_.fullFrameMs > 0.0 ? tileStats_.fullFrameMs * 0.8 + maskMs * 0.2 : maskMs;
+	}
+
+	if (tileStats_.frames % 300 == 0 && tileStats_.totalTiles > 0)
+	{
+		const double dirtyRatio = static_cast<double>(tileStats_.dirtyTiles) / tileStats_.totalTiles;
+		const double avgMs = tileStats_.maskMs / tileStats_.frames;
+		const double saved = tileStats_.fullFrameMs > 0.0 ? (std::max)(0.0, 1.0 - avgMs / tileStats_.fullFrameMs) : 0.0;
+		std::cout << "[TaskThermalCapture] 分块变化检测 - 脏块比例: " << (dirtyRatio * 100.0)
+				  << "%, 掩码生成平均: " << avgMs << " ms/帧 (全帧: " << tileStats_.fullFrameMs
+				  << " ms), 节省约: " << (saved * 100.0) << "%, 复用连通区域: "
+				  << (analyzers_[0].reusedFrames() + analyzers_[1].reusedFrames()) << " 帧" << std::endl;
+		tileStats_ = TileStats{tileStats_.fullFrameMs};
+	}
 }
 
-/**
- * @brief 创建屏蔽区域掩码
- * @param frame 热成像视频帧
- * @return 屏蔽掩码（255=有效区域，0=屏蔽区域）
- */
-cv::Mat TaskThermalCapture::createMaskRegions(const cv::Mat &frame)
+// 处理一帧辐射测温数据（真实温度）
+bool TaskThermalCapture::processRadiometricFrame(int deviceIdx, float alarmThreshold, float environmentTempThreshold)
 {
-	cv::Mat mask = cv::Mat::ones(frame.size(), CV_8UC1) * 255;
+	std::mutex &matrixMutex = deviceIdx == 0 ? data_.thermalmatrix_mutex_1 : data_.thermalmatrix_mutex_2;
+	RadiometricFramePtr frame;
+	{
+		std::lock_guard<std::mutex> lock(matrixMutex);
+		frame = deviceIdx == 0 ? data_.radiometricFrame_1 : data_.radiometricFrame_2;
+	}
+	if (!frame || frame->seq == lastRadiometricSeq_[deviceIdx])
+	{
+		return false;
+	}
+	lastRadiometricSeq_[deviceIdx] = frame->seq;
 
-	// 屏蔽区域1：(1090,90) 到 (1235,145)
-	cv::rectangle(mask, cv::Point(1090, 90), cv::Point(1235, 145), cv::Scalar(0), -1);
+	// 全帧最高温度未达到环境温度阈值时跳过
+	if (frame->maxTemp < environmentTempThreshold)
+	{
+		return false;
+	}
 
-	// 屏蔽区域2：(1090,625) 到 (1235,670)
-	cv::rectangle(mask, cv::Point(1090, 625), cv::Point(1235, 670), cv::Scalar(0), -1);
+	auto matrixStart = std::chrono::steady_clock::now();
 
-	// 屏蔽区域3：(1235,90) 到 (1280,625)
-	cv::rectangle(mask, cv::Point(1235, 90), cv::Point(1280, 625), cv::Scalar(0), -1);
+	// 置位像素的温度超过报警阈值（按全帧最高温度记录），清零像素不超过报警阈值
+	rawMask_[deviceIdx].packFrom(frame->temperature, alarmThreshold);
+	rawMask_[deviceIdx].highValue = frame->maxTemp;
+	rawMask_[deviceIdx].lowValue = alarmThreshold;
+	persistence_[deviceIdx].update(rawMask_[deviceIdx], filteredMask_[deviceIdx]);
 
-	return mask;
-}
+	frameCount_++;
+	totalProcessingTime_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - matrixStart).count();
 
-/**
- * @brief 极简化二值化温度映射（性能优化）
- * @param grayValue 像素灰度值（0-255）
- * @return 高温或低温值
- */
-float TaskThermalCapture::mapGrayToTemperature(float grayValue, const std::vector<float> &palette,
-											   float minTemp, float maxTemp)
-{
-	// 极简化：直接进行阈值比较，返回二值化温度
-	return (grayValue > thresholdGrayValue_) ? HIGH_TEMP : LOW_TEMP;
+	ThermalAnalysisResultPtr analysis = analyzers_[deviceIdx].analyze(filteredMask_[deviceIdx], alarmThreshold, frame->seq, frame->captureTimeUs);
+
+	std::lock_guard<std::mutex> lock(matrixMutex);
+	ThermalBitMask &sharedMask = deviceIdx == 0 ? data_.thermalMask_1 : data_.thermalMask_2;
+	std::deque<ThermalAnalysisResultPtr> &history = deviceIdx == 0 ? data_.thermalHistory_1 : data_.thermalHistory_2;
+	ThermalAnalysisResultPtr &latest = deviceIdx == 0 ? data_.thermalAnalysis_1 : data_.thermalAnalysis_2;
+	sharedMask = filteredMask_[deviceIdx];
+	history.push_back(analysis);
+	if (history.size() > SharedData::kThermalHistoryDepth)
+	{
+		history.pop_front();
+	}
+	latest = std::move(analysis);
+	return true;
 }
 
 /**
- * @brief 从热成像视频帧生成温度矩阵
- * @param frame 热成像视频帧（1280x720）
- * @param minTemp 最低温度
- * @param maxTemp 最高温度
+ * @brief 旧版温度矩阵生成，仅用于性能对比
+ * @param frame 热成像视频帧
+ * @param thresholdGray 高温阈值灰度值
  * @return 温度矩阵（640x512，CV_32FC1）
  */
-cv::Mat TaskThermalCapture::generateTemperatureMatrix(const cv::Mat &frame, float minTemp, float maxTemp)
+cv::Mat TaskThermalCapture::generateTemperatureMatrixLegacy(const cv::Mat &frame, float thresholdGray)
 {
-	if (frame.empty())
-	{
-		std::cerr << "[TaskThermalCapture] 输入视频帧为空" << std::endl;
-		return cv::Mat();
-	}
-
 	// 创建屏蔽掩码
 	cv::Mat mask = createMaskRegions(frame);
 
@@ -330,19 +567,18 @@ cv::Mat TaskThermalCapture::generateTemperatureMatrix(const cv::Mat &frame, floa
 	// 创建温度矩阵
 	cv::Mat temperatureMatrix(512, 640, CV_32FC1);
 
-	// 极简化像素遍历：直接阈值比较
 	for (int y = 0; y < 512; y++)
 	{
 		for (int x = 0; x < 640; x++)
 		{
 			if (resizedMask.at<uchar>(y, x) == 0)
 			{
-				temperatureMatrix.at<float>(y, x) = LOW_TEMP; // 屏蔽区域为低温
+				temperatureMatrix.at<float>(y, x) = LOW_TEMP;
 			}
 			else
 			{
 				float grayValue = static_cast<float>(resizedGray.at<uchar>(y, x));
-				temperatureMatrix.at<float>(y, x) = (grayValue > thresholdGrayValue_) ? HIGH_TEMP : LOW_TEMP;
+				temperatureMatrix.at<float>(y, x) = (grayValue > thresholdGray) ? HIGH_TEMP : LOW_TEMP;
 			}
 		}
 	}
@@ -350,6 +586,57 @@ cv::Mat TaskThermalCapture::generateTemperatureMatrix(const cv::Mat &frame, floa
 	return temperatureMatrix;
 }
 
+/**
+ * @brief 对比旧版与单次遍历版本的耗时和输出一致性
+ * @param frame 热成像视频帧
+ * @param thresholdGray 高温阈值灰度值
+ * @param iterations 每种实现的运行次数
+ */
+void TaskThermalCapture::benchmarkTemperatureMatrix(const cv::Mat &frame, float thresholdGray, int iterations)
+{
+	if (frame.empty() || iterations <= 0)
+	{
+		return;
+	}
+
+	cv::Mat legacyResult;
+	ThermalBitMask fusedResult;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		legacyResult = generateTemperatureMatrixLegacy(frame, thresholdGray);
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		generateTemperatureMask(frame, thresholdGray, fusedResult);
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	double legacyMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+	double fusedMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+
+	// 两者缩放插值方式不同（双线性 vs 区域平均），阈值边缘处允许少量差异
+	int mismatches = 0;
+	for (int y = 0; y < MATRIX_HEIGHT; y++)
+	{
+		const float *a = legacyResult.ptr<float>(y);
+		for (int x = 0; x < MATRIX_WIDTH; x++)
+		{
+			if ((a[x] == HIGH_TEMP) != fusedResult.test(x, y))
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	std::cout << "[TaskThermalCapture] 温度矩阵性能对比（" << frame.cols << "x" << frame.rows
+			  << "，" << iterations << "次）- 旧版: " << legacyMs << " ms/帧, 单次遍历: " << fusedMs
+			  << " ms/帧, 加速比: " << (fusedMs > 0.0 ? legacyMs / fusedMs : 0.0)
+			  << ", 差异像素: " << mismatches << "/" << (MATRIX_WIDTH * MATRIX_HEIGHT) << std::endl;
+}
+
 // 线程主函数：循环从热成像视频流分析温度数据
 void TaskThermalCapture::run()
 {
@@ -362,10 +649,40 @@ void TaskThermalCapture::run()
 		// 检查热成像处理是否启用
 		bool thermalProcessingEnabled = true;
 		float environmentTempThreshold = 50.0f;
+		int benchmarkIterations = 0;
+		int persistenceFrames = 1, persistenceWindow = 1;
+		int paletteSampleInterval = 25;
+		ThermalAnalyzer::Method blobMethod = ThermalAnalyzer::Method::RunLength;
+		TileChangeDetector::Params tileParams;
 		{
 			std::lock_guard<std::mutex> lock(data_.thermalProcessingConfigMutex);
 			thermalProcessingEnabled = data_.thermalProcessingConfig.enableThermalProcessing;
 			environmentTempThreshold = data_.thermalProcessingConfig.environmentTempThreshold;
+			benchmarkIterations = data_.thermalProcessingConfig.matrixBenchmarkIterations;
+			persistenceFrames = data_.thermalProcessingConfig.persistenceFrames;
+			persistenceWindow = data_.thermalProcessingConfig.persistenceWindow;
+			paletteSampleInterval = data_.thermalProcessingConfig.paletteSampleInterval;
+			blobMethod = ThermalAnalyzer::parseMethod(data_.thermalProcessingConfig.blobExtraction);
+			tileParams.enable = data_.thermalProcessingConfig.tileChangeDetection;
+			tileParams.threshold = data_.thermalProcessingConfig.tileChangeThreshold;
+			tileParams.fullRefreshFrames = data_.thermalProcessingConfig.tileFullRefreshFrames;
+		}
+
+		float alarmThreshold;
+		{
+			std::lock_guard<std::mutex> lock(data_.alarmThresholdMutex);
+			alarmThreshold = data_.g_alarmThreshold;
+		}
+
+		const float percentile = percentileThreshold_;
+		for (int i = 0; i < 2; i++)
+		{
+			persistence_[i].configure(persistenceFrames, persistenceWindow);
+			calibrators_[i].setSampleInterval(paletteSampleInterval);
+			calibrators_[i].setPercentile(percentile);
+			analyzers_[i].setMethod(blobMethod);
+			analyzers_[i].setReuseUnchanged(tileParams.enable);
+			tileDetectors_[i].setParams(tileParams);
 		}
 
 		// 如果热成像处理被禁用，跳过所有处理
@@ -375,18 +692,38 @@ void TaskThermalCapture::run()
 			continue;
 		}
 
+		// 辐射测温数据可用时按真实温度生成掩码，不再分析彩色视频帧
+		if (radiometricEnabled_)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				if (radiometric_[i] && processRadiometricFrame(i, alarmThreshold, environmentTempThreshold))
+				{
+					processedAnyFrame = true;
+				}
+			}
+			if (!processedAnyFrame)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			continue;
+		}
+
 		// 处理设备1（一位端）
 		if (userIDs_.size() > 0)
 		{
 			cv::Mat thermalFrame;
+			FrameMeta frameMeta;
 			float minTemp = 20.0f, maxTemp = 60.0f;
 
-			// 获取热成像视频帧
+			// 获取热成像视频帧（只处理新帧，序号未变化时跳过）
 			{
 				std::lock_guard<std::mutex> lock(data_.thermal_mutex_1);
-				if (!data_.thermal_video_frame_1.empty())
+				frameMeta = data_.thermal_video_meta_1;
+				if (!data_.thermal_video_frame_1.empty() && (frameMeta.seq == 0 || frameMeta.seq != lastFrameSeq_[0]))
 				{
 					data_.thermal_video_frame_1.copyTo(thermalFrame);
+					lastFrameSeq_[0] = frameMeta.seq;
 				}
 			}
 
@@ -406,19 +743,49 @@ void TaskThermalCapture::run()
 			else
 			{
 				// 环境温度足够高，进行热成像处理
-				if (!thermalFrame.empty())
+				// 按该设备的温度条直方图更新阈值（每K帧采样一次，AGC范围变化时立即重新采样）
+				if (!thermalFrame.empty() && calibrators_[0].update(thermalFrame, minTemp, maxTemp))
 				{
-					if (!paletteInitialized_)
+					const float thresholdGray = calibrators_[0].threshold();
+
+					if (!benchmarkDone_ && benchmarkIterations > 0)
 					{
-						initializePalette(thermalFrame);
+						benchmarkTemperatureMatrix(thermalFrame, thresholdGray, benchmarkIterations);
+						benchmarkDone_ = true;
 					}
 
-					cv::Mat temperatureMatrix = generateTemperatureMatrix(thermalFrame, minTemp, maxTemp);
+					// 阈值变化时上一帧的掩码失效，本帧全帧刷新
+					if (thresholdGray != lastThresholdGray_[0])
+					{
+						tileDetectors_[0].invalidate();
+						lastThresholdGray_[0] = thresholdGray;
+					}
 
-					if (!temperatureMatrix.empty())
+					auto matrixStart = std::chrono::steady_clock::now();
+					tileDetectors_[0].update(thermalFrame, cv::Size(MATRIX_WIDTH, MATRIX_HEIGHT));
+					bool generated = generateTemperatureMask(thermalFrame, thresholdGray, rawMask_[0], &tileDetectors_[0]);
+					const double maskMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - matrixStart).count();
+					if (generated)
 					{
+						recordTileStats(tileDetectors_[0], maskMs);
+						persistence_[0].update(rawMask_[0], filteredMask_[0]);
+					}
+					frameCount_++;
+					totalProcessingTime_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - matrixStart).count();
+
+					if (generated)
+					{
+						// 每个新帧只分析一次，定位线程和显示线程共享同一份结果
+						ThermalAnalysisResultPtr analysis = analyzers_[0].analyze(filteredMask_[0], alarmThreshold, frameMeta.seq, frameMeta.captureTimeUs);
+
 						std::lock_guard<std::mutex> lock(data_.thermalmatrix_mutex_1);
-						temperatureMatrix.copyTo(data_.thermalMatrix_1);
+						data_.thermalMask_1 = filteredMask_[0];
+						data_.thermalHistory_1.push_back(analysis);
+						if (data_.thermalHistory_1.size() > SharedData::kThermalHistoryDepth)
+						{
+							data_.thermalHistory_1.pop_front();
+						}
+						data_.thermalAnalysis_1 = std::move(analysis);
 						processedAnyFrame = true;
 					}
 				}
@@ -429,14 +796,17 @@ void TaskThermalCapture::run()
 		if (userIDs_.size() > 1)
 		{
 			cv::Mat thermalFrame2;
+			FrameMeta frameMeta2;
 			float minTemp2 = 20.0f, maxTemp2 = 60.0f;
 
-			// 获取热成像视频帧
+			// 获取热成像视频帧（只处理新帧，序号未变化时跳过）
 			{
 				std::lock_guard<std::mutex> lock(data_.thermal_mutex_2);
-				if (!data_.thermal_video_frame_2.empty())
+				frameMeta2 = data_.thermal_video_meta_2;
+				if (!data_.thermal_video_frame_2.empty() && (frameMeta2.seq == 0 || frameMeta2.seq != lastFrameSeq_[1]))
 				{
 					data_.thermal_video_frame_2.copyTo(thermalFrame2);
+					lastFrameSeq_[1] = frameMeta2.seq;
 				}
 			}
 
@@ -456,19 +826,43 @@ void TaskThermalCapture::run()
 			else
 			{
 				// 环境温度足够高，进行热成像处理
-				if (!thermalFrame2.empty())
+				// 按该设备的温度条直方图更新阈值（每K帧采样一次，AGC范围变化时立即重新采样）
+				if (!thermalFrame2.empty() && calibrators_[1].update(thermalFrame2, minTemp2, maxTemp2))
 				{
-					if (!paletteInitialized_)
+					const float thresholdGray2 = calibrators_[1].threshold();
+
+					// 阈值变化时上一帧的掩码失效，本帧全帧刷新
+					if (thresholdGray2 != lastThresholdGray_[1])
 					{
-						initializePalette(thermalFrame2);
+						tileDetectors_[1].invalidate();
+						lastThresholdGray_[1] = thresholdGray2;
 					}
 
-					cv::Mat temperatureMatrix2 = generateTemperatureMatrix(thermalFrame2, minTemp2, maxTemp2);
+					auto matrixStart = std::chrono::steady_clock::now();
+					tileDetectors_[1].update(thermalFrame2, cv::Size(MATRIX_WIDTH, MATRIX_HEIGHT));
+					bool generated = generateTemperatureMask(thermalFrame2, thresholdGray2, rawMask_[1], &tileDetectors_[1]);
+					const double maskMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - matrixStart).count();
+					if (generated)
+					{
+						recordTileStats(tileDetectors_[1], maskMs);
+						persistence_[1].update(rawMask_[1], filteredMask_[1]);
+					}
+					frameCount_++;
+					totalProcessingTime_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - matrixStart).count();
 
-					if (!temperatureMatrix2.empty())
+					if (generated)
 					{
+						// 每个新帧只分析一次，定位线程和显示线程共享同一份结果
+						ThermalAnalysisResultPtr analysis = analyzers_[1].analyze(filteredMask_[1], alarmThreshold, frameMeta2.seq, frameMeta2.captureTimeUs);
+
 						std::lock_guard<std::mutex> lock(data_.thermalmatrix_mutex_2);
-						temperatureMatrix2.copyTo(data_.thermalMatrix_2);
+						data_.thermalMask_2 = filteredMask_[1];
+						data_.thermalHistory_2.push_back(analysis);
+						if (data_.thermalHistory_2.size() > SharedData::kThermalHistoryDepth)
+						{
+							data_.thermalHistory_2.pop_front();
+						}
+						data_.thermalAnalysis_2 = std::move(analysis);
 						processedAnyFrame = true;
 					}
 				}
@@ -44,6 +44,8 @@ TaskVideoCapture::TaskVideoCapture(int cameraCount, const std::vector<nlohmann::
 	playPorts_.resize(cameraCount_);
 	frameBuffers_.resize(cameraCount_);
 	frameMutexes_.resize(cameraCount_);
+	frameMetas_.resize(cameraCount_);
+	publishedSeqs_.resize(cameraCount_, {0, 0});
 
 	// 初始化测温相关数据结构
 	thermometryHandles_.resize(cameraCount_, -1);
@@ -804,23 +806,36 @@ void TaskVideoCapture::run()
 						std::lock_guard<std::mutex> frameLock(*frameMutexes_[deviceIdx][channelIdx]);
 						if (!frameBuffers_[deviceIdx][channelIdx].empty())
 						{
-							cv::Mat frame = frameBuffers_[deviceIdx][channelIdx].clone();
 							hasData = true;
 
+							// 没有新解码帧时不重复复制
+							const FrameMeta meta = frameMetas_[deviceIdx][channelIdx];
+							if (meta.seq == publishedSeqs_[deviceIdx][channelIdx])
+							{
+								continue;
+							}
+							publishedSeqs_[deviceIdx][channelIdx] = meta.seq;
+							cv::Mat frame = frameBuffers_[deviceIdx][channelIdx].clone();
+
 							// 根据设备和通道分发到对应的SharedData字段
 							if (deviceIdx == 0) // 第一个设备
 							{
 								if (channelIdx == 0) // 通道1（可见光）
 								{
-									std::lock_guard<std::mutex> lock(data_.visible_mutex_1);
-									frame.copyTo(data_.visible_video_frame_1);
-									// 保存一帧图片
-									cv::imwrite("visible_frame_1.jpg", data_.visible_video_frame_1);
+									{
+										std::lock_guard<std::mutex> lock(data_.visible_mutex_1);
+										frame.copyTo(data_.visible_video_frame_1);
+										data_.visible_video_meta_1 = meta;
+										// 保存一帧图片
+										cv::imwrite("visible_frame_1.jpg", data_.visible_video_frame_1);
+									}
+									data_.notifyVisibleFrame();
 								}
 								else // 通道2（热成像）
 								{
 									std::lock_guard<std::mutex> lock(data_.thermal_mutex_1);
 									frame.copyTo(data_.thermal_video_frame_1);
+									data_.thermal_video_meta_1 = meta;
 									cv::imwrite("thermal_frame_1.jpg", data_.thermal_video_frame_1);
 								}
 							}
@@ -828,13 +843,18 @@ void TaskVideoCapture::run()
 							{
 								if (channelIdx == 0) // 通道1（可见光）
 								{
-									std::lock_guard<std::mutex> lock(data_.visible_mutex_2);
-									frame.copyTo(data_.visible_video_frame_2);
+									{
+										std::lock_guard<std::mutex> lock(data_.visible_mutex_2);
+										frame.copyTo(data_.visible_video_frame_2);
+										data_.visible_video_meta_2 = meta;
+									}
+									data_.notifyVisibleFrame();
 								}
 								else // 通道2（热成像）
 								{
 									std::lock_guard<std::mutex> lock(data_.thermal_mutex_2);
 									frame.copyTo(data_.thermal_video_frame_2);
+									data_.thermal_video_meta_2 = meta;
 								}
 							}
 						}
@@ -1014,6 +1034,9 @@ void CALLBACK TaskVideoCapture::decodeCallback(long nPort, char *pBuf, long nSiz
 			return;
 		}
 
+		// 采集时间戳取解码回调入口时间，作为推流PTS的来源
+		const int64_t captureTimeUs = steadyClockUs();
+
 		// 创建YUV Mat
 		cv::Mat yuvMat(pFrameInfo->nHeight + pFrameInfo->nHeight / 2,
 					   pFrameInfo->nWidth, CV_8UC1, (uchar *)pBuf);
@@ -1033,6 +1056,9 @@ void CALLBACK TaskVideoCapture::decodeCallback(long nPort, char *pBuf, long nSiz
 		{
 			std::lock_guard<std::mutex> lock(*instance->frameMutexes_[deviceIdx][channelIdx]);
 			instance->frameBuffers_[deviceIdx][channelIdx] = bgrMat.clone();
+			FrameMeta &meta = instance->frameMetas_[deviceIdx][channelIdx];
+			meta.seq++;
+			meta.captureTimeUs = captureTimeUs;
 		}
 	}
 	catch (const cv::Exception &e)
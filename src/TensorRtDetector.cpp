@@ -0,0 +1,15 @@
+﻿#include "TensorRtDetector.h"
+#include "config_manager.h"
+#include "infer.h"
+
+TensorRtDetector::TensorRtDetector(const ConfigManager &config)
+    : detector_(std::make_unique<YoloDetector>(config))
+{
+}
+
+TensorRtDetector::~TensorRtDetector() = default;
+
+std::vector<Detection> TensorRtDetector::detect(cv::Mat &img)
+{
+    return detector_->inference(img);
+}
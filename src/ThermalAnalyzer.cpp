@@ -0,0 +1,303 @@
+﻿#include "ThermalAnalyzer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // 最低置位的位置（v != 0）
+    inline int lowestSetBit(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    // Σx，x ∈ [a, b]
+    inline double sumRange(int a, int b)
+    {
+        return 0.5 * (static_cast<double>(a) + b) * (b - a + 1);
+    }
+
+    // Σx²，x ∈ [a, b]
+    inline double sumSquaresRange(int a, int b)
+    {
+        auto s = [](double n) { return n * (n + 1) * (2 * n + 1) / 6.0; };
+        return s(b) - s(a - 1.0);
+    }
+}
+
+ThermalAnalyzer::ThermalAnalyzer(float minArea, int openKernelSize, Method method)
+    : minArea_(minArea), openRadius_(openKernelSize > 1 ? openKernelSize / 2 : 0), method_(method)
+{
+    if (openKernelSize > 1)
+    {
+        kernel_ = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(openKernelSize, openKernelSize));
+    }
+}
+
+ThermalAnalyzer::Method ThermalAnalyzer::parseMethod(const std::string &name)
+{
+    return name == "contours" ? Method::Contours : Method::RunLength;
+}
+
+ThermalAnalysisResultPtr ThermalAnalyzer::analyze(const ThermalBitMask &mask, float alarmThreshold,
+                                                  uint64_t seq, int64_t captureTimeUs)
+{
+    if (reuseUnchanged_ && last_ && last_->alarmThreshold == alarmThreshold && last_->mask.sameBits(mask))
+    {
+        auto reused = std::make_shared<ThermalAnalysisResult>(*last_);
+        reused->seq = seq;
+        reused->captureTimeUs = captureTimeUs;
+        reusedFrames_++;
+        last_ = reused;
+        return reused;
+    }
+
+    auto result = std::make_shared<ThermalAnalysisResult>();
+    result->seq = seq;
+    result->captureTimeUs = captureTimeUs;
+    result->matrixSize = cv::Size(mask.width(), mask.height());
+    result->alarmThreshold = alarmThreshold;
+    result->mask = mask;
+
+    if (mask.empty())
+    {
+        return result;
+    }
+
+    if (method_ == Method::Contours)
+    {
+        extractContours(mask, alarmThreshold, result->blobs);
+    }
+    else
+    {
+        extractRunLength(mask, alarmThreshold, result->blobs);
+    }
+    if (reuseUnchanged_)
+    {
+        last_ = result;
+    }
+    return result;
+}
+
+void ThermalAnalyzer::extractContours(const ThermalBitMask &mask, float alarmThreshold, std::vector<ThermalBlob> &blobs)
+{
+    // 按报警阈值展开掩码并做开运算去噪
+    mask.unpack(binary_, alarmThreshold);
+    if (!kernel_.empty())
+    {
+        cv::morphologyEx(binary_, binary_, cv::MORPH_OPEN, kernel_);
+    }
+
+    // 查找高温区域轮廓
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(binary_, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    blobs.reserve(contours.size());
+    for (const auto &contour : contours)
+    {
+        double area = cv::contourArea(contour);
+        if (area <= minArea_)
+        {
+            continue;
+        }
+
+        cv::Moments m = cv::moments(contour);
+        ThermalBlob blob;
+        blob.area = static_cast<float>(area);
+        blob.centroid = cv::Point2f(static_cast<float>(m.m10 / m.m00), static_cast<float>(m.m01 / m.m00));
+        blob.boundingBox = cv::boundingRect(contour);
+        blob.orientedBox = cv::minAreaRect(contour);
+        blobs.push_back(blob);
+    }
+}
+
+int ThermalAnalyzer::findRoot(int label)
+{
+    while (parent_[label] != label)
+    {
+        parent_[label] = parent_[parent_[label]]; // 路径减半
+        label = parent_[label];
+    }
+    return label;
+}
+
+void ThermalAnalyzer::extractRunLength(const ThermalBitMask &mask, float alarmThreshold, std::vector<ThermalBlob> &blobs)
+{
+    // 1. 在打包掩码上按阈值选择高温位并做开运算（腐蚀+膨胀，逐字运算）
+    mask.selectHot(hot_, alarmThreshold);
+    const ThermalBitMask *source = &hot_;
+    if (openRadius_ > 0)
+    {
+        hot_.erode(eroded_, openRadius_);
+        eroded_.dilate(opened_, openRadius_);
+        source = &opened_;
+    }
+
+    // 2. 逐行提取游程，与上一行重叠（8连通）的游程合并，统计量按临时标签累加
+    runs_.clear();
+    parent_.clear();
+    stats_.clear();
+
+    const int width = source->width();
+    const int wordsPerRow = source->wordsPerRow();
+    size_t prevBegin = 0, prevEnd = 0;
+
+    for (int y = 0; y < source->height(); y++)
+    {
+        const uint64_t *words = source->row(y);
+        const size_t rowBegin = runs_.size();
+        size_t scan = prevBegin; // 上一行游程的扫描位置（两行游程均按列递增）
+        int runStart = -1;
+
+        for (int wi = 0; wi <= wordsPerRow; wi++)
+        {
+            // 末尾追加一个全零字以结束最后一个游程
+            uint64_t w = wi < wordsPerRow ? words[wi] : 0ULL;
+            const int base = wi * 64;
+            int bit = 0;
+            while (bit < 64)
+            {
+                if (runStart < 0)
+                {
+                    uint64_t ones = bit ? (w >> bit) : w;
+                    if (!ones)
+                        break;
+                    bit += lowestSetBit(ones);
+                    runStart = base + bit;
+                }
+                else
+                {
+                    uint64_t zeros = bit ? (~w >> bit) : ~w;
+                    if (!zeros)
+                        break;
+                    bit += lowestSetBit(zeros);
+                    const int x0 = runStart;
+                    const int x1 = (std::min)(base + bit, width) - 1;
+                    runStart = -1;
+
+                    // 新游程：分配临时标签并累加统计量
+                    const int label = static_cast<int>(parent_.size());
+                    parent_.push_back(label);
+                    stats_.emplace_back();
+                    BlobStats &st = stats_.back();
+                    const int len = x1 - x0 + 1;
+                    const double sx = sumRange(x0, x1);
+                    st.area = len;
+                    st.sumX = sx;
+                    st.sumY = static_cast<double>(y) * len;
+                    st.sumXX = sumSquaresRange(x0, x1);
+                    st.sumYY = static_cast<double>(y) * y * len;
+                    st.sumXY = y * sx;
+                    st.minX = x0;
+                    st.maxX = x1;
+                    st.minY = st.maxY = y;
+                    runs_.push_back({y, x0, x1, label});
+
+                    // 与上一行中列范围 [x0-1, x1+1] 重叠的游程合并
+                    while (scan < prevEnd && runs_[scan].x1 < x0 - 1)
+                        scan++;
+                    for (size_t k = scan; k < prevEnd && runs_[k].x0 <= x1 + 1; k++)
+                    {
+                        int a = findRoot(runs_[k].label);
+                        int b = findRoot(label);
+                        if (a != b)
+                            parent_[(std::max)(a, b)] = (std::min)(a, b);
+                    }
+                    // 上一行最后一个重叠游程可能也与本行下一个游程重叠，不前移scan
+                }
+            }
+        }
+
+        prevBegin = rowBegin;
+        prevEnd = runs_.size();
+    }
+
+    // 3. 折叠统计量到根标签，并按面积下限过滤
+    for (size_t label = 0; label < parent_.size(); label++)
+    {
+        const int root = findRoot(static_cast<int>(label));
+        if (root == static_cast<int>(label))
+            continue;
+        BlobStats &dst = stats_[root];
+        const BlobStats &src = stats_[label];
+        dst.area += src.area;
+        dst.sumX += src.sumX;
+        dst.sumY += src.sumY;
+        dst.sumXX += src.sumXX;
+        dst.sumYY += src.sumYY;
+        dst.sumXY += src.sumXY;
+        dst.minX = (std::min)(dst.minX, src.minX);
+        dst.minY = (std::min)(dst.minY, src.minY);
+        dst.maxX = (std::max)(dst.maxX, src.maxX);
+        dst.maxY = (std::max)(dst.maxY, src.maxY);
+    }
+
+    // 根标签 -> 输出区域索引（-1 表示被过滤）
+    std::vector<int> blobIndex(parent_.size(), -1);
+    std::vector<double> axisCos, axisSin;
+    for (size_t label = 0; label < parent_.size(); label++)
+    {
+        if (parent_[label] != static_cast<int>(label))
+            continue;
+        const BlobStats &st = stats_[label];
+        if (static_cast<float>(st.area) <= minArea_)
+            continue;
+
+        const double n = static_cast<double>(st.area);
+        const double cx = st.sumX / n;
+        const double cy = st.sumY / n;
+        const double mu20 = st.sumXX / n - cx * cx;
+        const double mu02 = st.sumYY / n - cy * cy;
+        const double mu11 = st.sumXY / n - cx * cy;
+        const double theta = 0.5 * std::atan2(2.0 * mu11, mu20 - mu02);
+
+        ThermalBlob blob;
+        blob.area = static_cast<float>(st.area);
+        blob.centroid = cv::Point2f(static_cast<float>(cx), static_cast<float>(cy));
+        blob.boundingBox = cv::Rect(st.minX, st.minY, st.maxX - st.minX + 1, st.maxY - st.minY + 1);
+        blob.orientedBox.angle = static_cast<float>(theta * 180.0 / CV_PI);
+
+        blobIndex[label] = static_cast<int>(blobs.size());
+        blobs.push_back(blob);
+        axisCos.push_back(std::cos(theta));
+        axisSin.push_back(std::sin(theta));
+    }
+
+    // 4. 旋转矩形：沿主轴方向投影各游程端点（投影对x线性，极值必在端点）
+    const size_t count = blobs.size();
+    std::vector<double> minU(count, 1e18), maxU(count, -1e18), minV(count, 1e18), maxV(count, -1e18);
+    for (const Run &run : runs_)
+    {
+        const int idx = blobIndex[findRoot(run.label)];
+        if (idx < 0)
+            continue;
+        const double c = axisCos[idx], s = axisSin[idx];
+        for (int x : {run.x0, run.x1})
+        {
+            const double u = x * c + run.y * s;
+            const double v = -x * s + run.y * c;
+            minU[idx] = (std::min)(minU[idx], u);
+            maxU[idx] = (std::max)(maxU[idx], u);
+            minV[idx] = (std::min)(minV[idx], v);
+            maxV[idx] = (std::max)(maxV[idx], v);
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const double c = axisCos[i], s = axisSin[i];
+        const double u = 0.5 * (minU[i] + maxU[i]);
+        const double v = 0.5 * (minV[i] + maxV[i]);
+        ThermalBlob &blob = blobs[i];
+        blob.orientedBox.center = cv::Point2f(static_cast<float>(u * c - v * s), static_cast<float>(u * s + v * c));
+        blob.orientedBox.size = cv::Size2f(static_cast<float>(maxU[i] - minU[i]), static_cast<float>(maxV[i] - minV[i]));
+    }
+}
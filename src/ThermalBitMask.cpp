@@ -0,0 +1,364 @@
+﻿#include "ThermalBitMask.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    inline int popcount64(uint64_t v)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<int>(__popcnt64(v));
+#elif defined(__GNUC__)
+        return __builtin_popcountll(v);
+#else
+        int count = 0;
+        while (v)
+        {
+            v &= v - 1;
+            count++;
+        }
+        return count;
+#endif
+    }
+}
+
+void ThermalBitMask::create(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        width_ = height_ = wordsPerRow_ = 0;
+        words_.clear();
+        return;
+    }
+    width_ = width;
+    height_ = height;
+    wordsPerRow_ = (width + 63) / 64;
+    words_.assign(static_cast<size_t>(wordsPerRow_) * height_, 0);
+}
+
+void ThermalBitMask::clear()
+{
+    std::fill(words_.begin(), words_.end(), 0);
+}
+
+size_t ThermalBitMask::countSet() const
+{
+    size_t count = 0;
+    for (uint64_t w : words_)
+    {
+        count += popcount64(w);
+    }
+    return count;
+}
+
+bool ThermalBitMask::sameBits(const ThermalBitMask &other) const
+{
+    return width_ == other.width_ && height_ == other.height_ &&
+           highValue == other.highValue && lowValue == other.lowValue &&
+           words_ == other.words_;
+}
+
+void ThermalBitMask::unpack(cv::Mat &dst, float threshold) const
+{
+    dst.create(height_, width_, CV_8UC1);
+
+    bool setIsHot, clearIsHot;
+    classify(threshold, setIsHot, clearIsHot);
+    if (setIsHot == clearIsHot)
+    {
+        dst.setTo(cv::Scalar(setIsHot ? 255 : 0));
+        return;
+    }
+
+    // 置位像素为高温时直接展开，否则展开取反后的结果
+    const uint64_t invert = setIsHot ? 0ULL : ~0ULL;
+    for (int y = 0; y < height_; y++)
+    {
+        const uint64_t *src = row(y);
+        uchar *out = dst.ptr<uchar>(y);
+        for (int wi = 0; wi < wordsPerRow_; wi++)
+        {
+            uint64_t w = src[wi] ^ invert;
+            const int base = wi * 64;
+            const int count = (std::min)(64, width_ - base);
+            for (int b = 0; b < count; b++)
+            {
+                out[base + b] = static_cast<uchar>(-static_cast<int>((w >> b) & 1ULL));
+            }
+        }
+    }
+}
+
+void ThermalBitMask::selectHot(ThermalBitMask &dst, float threshold) const
+{
+    if (dst.width_ != width_ || dst.height_ != height_)
+    {
+        dst.create(width_, height_);
+    }
+    dst.highValue = highValue;
+    dst.lowValue = lowValue;
+
+    bool setIsHot, clearIsHot;
+    classify(threshold, setIsHot, clearIsHot);
+    if (setIsHot == clearIsHot)
+    {
+        std::fill(dst.words_.begin(), dst.words_.end(), setIsHot ? ~0ULL : 0ULL);
+    }
+    else
+    {
+        const uint64_t invert = setIsHot ? 0ULL : ~0ULL;
+        for (size_t i = 0; i < words_.size(); i++)
+        {
+            dst.words_[i] = words_[i] ^ invert;
+        }
+    }
+    dst.clearPadding();
+}
+
+void ThermalBitMask::clearPadding()
+{
+    const int tailBits = width_ & 63;
+    if (tailBits == 0)
+    {
+        return;
+    }
+    const uint64_t keep = (1ULL << tailBits) - 1;
+    for (int y = 0; y < height_; y++)
+    {
+        row(y)[wordsPerRow_ - 1] &= keep;
+    }
+}
+
+void ThermalBitMask::erode(ThermalBitMask &dst, int radius) const
+{
+    morph(dst, radius, true);
+}
+
+void ThermalBitMask::dilate(ThermalBitMask &dst, int radius) const
+{
+    morph(dst, radius, false);
+}
+
+void ThermalBitMask::morph(ThermalBitMask &dst, int radius, bool isErode) const
+{
+    if (dst.width_ != width_ || dst.height_ != height_)
+    {
+        dst.create(width_, height_);
+    }
+    dst.highValue = highValue;
+    dst.lowValue = lowValue;
+    if (empty())
+    {
+        return;
+    }
+    radius = (std::max)(0, (std::min)(radius, 63));
+
+    const int W = wordsPerRow_;
+    const uint64_t fill = isErode ? ~0ULL : 0ULL;
+    const int tailBits = width_ & 63;
+    const uint64_t tailMask = tailBits ? ((1ULL << tailBits) - 1) : ~0ULL;
+
+    // 水平方向：输出位x = 输入位 x-r..x+r 的与/或；行外的位按边界值填充
+    std::vector<uint64_t> horizontal(words_.size());
+    std::vector<uint64_t> padded(W + 2);
+    for (int y = 0; y < height_; y++)
+    {
+        const uint64_t *src = row(y);
+        padded[0] = fill;
+        for (int i = 0; i < W; i++)
+        {
+            padded[i + 1] = src[i];
+        }
+        padded[W] = (padded[W] & tailMask) | (fill & ~tailMask);
+        padded[W + 1] = fill;
+
+        uint64_t *out = horizontal.data() + static_cast<size_t>(y) * W;
+        for (int i = 0; i < W; i++)
+        {
+            const uint64_t prev = padded[i];
+            const uint64_t cur = padded[i + 1];
+            const uint64_t next = padded[i + 2];
+            uint64_t acc = cur;
+            for (int d = 1; d <= radius; d++)
+            {
+                const uint64_t right = (cur >> d) | (next << (64 - d)); // 位 x+d
+                const uint64_t left = (cur << d) | (prev >> (64 - d));  // 位 x-d
+                acc = isErode ? (acc & right & left) : (acc | right | left);
+            }
+            out[i] = acc;
+        }
+    }
+
+    // 垂直方向：行外按边界值处理（腐蚀忽略越界行，膨胀同样忽略）
+    for (int y = 0; y < height_; y++)
+    {
+        const int y0 = (std::max)(0, y - radius);
+        const int y1 = (std::min)(height_ - 1, y + radius);
+        uint64_t *out = dst.row(y);
+        for (int i = 0; i < W; i++)
+        {
+            uint64_t acc = horizontal[static_cast<size_t>(y0) * W + i];
+            for (int yy = y0 + 1; yy <= y1; yy++)
+            {
+                const uint64_t w = horizontal[static_cast<size_t>(yy) * W + i];
+                acc = isErode ? (acc & w) : (acc | w);
+            }
+            out[i] = acc;
+        }
+    }
+    dst.clearPadding();
+}
+
+void ThermalBitMask::packFrom(const cv::Mat &temperature, float threshold)
+{
+    if (temperature.empty() || temperature.type() != CV_32FC1)
+    {
+        create(0, 0);
+        return;
+    }
+    if (temperature.cols != width_ || temperature.rows != height_)
+    {
+        create(temperature.cols, temperature.rows);
+    }
+
+    for (int y = 0; y < height_; y++)
+    {
+        const float *src = temperature.ptr<float>(y);
+        uint64_t *dst = row(y);
+        for (int wi = 0; wi < wordsPerRow_; wi++)
+        {
+            const int base = wi * 64;
+            const int count = (std::min)(64, width_ - base);
+            uint64_t w = 0;
+            for (int b = 0; b < count; b++)
+            {
+                w |= static_cast<uint64_t>(src[base + b] > threshold) << b;
+            }
+            dst[wi] = w;
+        }
+    }
+}
+
+void ThermalPersistenceFilter::configure(int n, int m)
+{
+    m = (std::max)(1, (std::min)(m, 15));
+    n = (std::max)(1, (std::min)(n, m));
+    if (n == n_ && m == m_ && !history_.empty())
+    {
+        return;
+    }
+    n_ = n;
+    m_ = m;
+    planes_ = 1;
+    while ((1 << planes_) <= m_)
+    {
+        planes_++;
+    }
+    history_.clear();
+    width_ = height_ = 0;
+    reset();
+}
+
+void ThermalPersistenceFilter::reset()
+{
+    head_ = 0;
+    filled_ = 0;
+    for (auto &h : history_)
+    {
+        h.clear();
+    }
+    for (auto &plane : counterPlanes_)
+    {
+        std::fill(plane.begin(), plane.end(), 0);
+    }
+}
+
+void ThermalPersistenceFilter::update(const ThermalBitMask &raw, ThermalBitMask &out)
+{
+    if (raw.empty())
+    {
+        out.create(0, 0);
+        return;
+    }
+
+    // 分辨率变化时重新分配历史和计数
+    if (raw.width() != width_ || raw.height() != height_ || history_.size() != static_cast<size_t>(m_))
+    {
+        width_ = raw.width();
+        height_ = raw.height();
+        history_.assign(m_, ThermalBitMask(width_, height_));
+        for (auto &plane : counterPlanes_)
+        {
+            plane.assign(raw.wordCount(), 0);
+        }
+        head_ = 0;
+        filled_ = 0;
+    }
+
+    if (out.width() != width_ || out.height() != height_)
+    {
+        out.create(width_, height_);
+    }
+    out.highValue = raw.highValue;
+    out.lowValue = raw.lowValue;
+
+    ThermalBitMask &slot = history_[head_];
+    const bool evict = filled_ == m_;
+    const size_t words = raw.wordCount();
+    const uint64_t *incoming = raw.data();
+    const uint64_t *outgoing = slot.data();
+    uint64_t *result = out.data();
+
+    for (size_t i = 0; i < words; i++)
+    {
+        // 先减去出窗帧位（逐平面借位），保证计数不超过M
+        if (evict)
+        {
+            uint64_t borrow = outgoing[i];
+            for (int p = 0; p < planes_ && borrow; p++)
+            {
+                uint64_t c = counterPlanes_[p][i];
+                counterPlanes_[p][i] = c ^ borrow;
+                borrow &= ~c;
+            }
+        }
+
+        // 计数 += 新帧位（逐平面进位）
+        uint64_t carry = incoming[i];
+        for (int p = 0; p < planes_ && carry; p++)
+        {
+            uint64_t c = counterPlanes_[p][i];
+            counterPlanes_[p][i] = c ^ carry;
+            carry &= c;
+        }
+
+        // 计数 >= N：从最高位开始逐位比较
+        uint64_t ge = 0;
+        uint64_t eq = ~0ULL;
+        for (int p = planes_ - 1; p >= 0; p--)
+        {
+            const uint64_t c = counterPlanes_[p][i];
+            if ((n_ >> p) & 1)
+            {
+                eq &= c;
+            }
+            else
+            {
+                ge |= eq & c;
+                eq &= ~c;
+            }
+        }
+        result[i] = ge | eq;
+    }
+
+    std::memcpy(slot.data(), incoming, words * sizeof(uint64_t));
+    head_ = (head_ + 1) % m_;
+    if (filled_ < m_)
+    {
+        filled_++;
+    }
+}
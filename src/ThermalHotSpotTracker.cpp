@@ -0,0 +1,206 @@
+﻿#include "ThermalHotSpotTracker.h"
+#include "lapjv.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    constexpr double kInfeasibleCost = 1e6; // 超出门限的配对代价
+    constexpr double kMaxMatchCost = 2.0;   // 可接受配对的最大代价（IoU代价<1，距离代价<2）
+
+    /**
+     * @brief 轨迹自最近一次关联以来经过的秒数
+     */
+    inline float secondsSinceSeen(const ThermalHotSpotTracker::Track &track, int64_t nowUs)
+    {
+        const int64_t elapsedUs = nowUs - track.lastSeenUs;
+        return elapsedUs > 0 ? static_cast<float>(elapsedUs) * 1e-6f : 0.0f;
+    }
+
+    inline float iou(const cv::Rect2f &a, const cv::Rect2f &b)
+    {
+        const float x0 = (std::max)(a.x, b.x);
+        const float y0 = (std::max)(a.y, b.y);
+        const float x1 = (std::min)(a.x + a.width, b.x + b.width);
+        const float y1 = (std::min)(a.y + a.height, b.y + b.height);
+        if (x1 <= x0 || y1 <= y0)
+            return 0.0f;
+        const float inter = (x1 - x0) * (y1 - y0);
+        return inter / (a.width * a.height + b.width * b.height - inter);
+    }
+}
+
+float ThermalHotSpotTracker::associationCost(const Track &track, const cv::Point2f &predicted, const ThermalBlob &blob) const
+{
+    // 预测框：最近一次的框随质心平移
+    cv::Rect2f predictedBox = track.box;
+    predictedBox.x += predicted.x - track.center.x;
+    predictedBox.y += predicted.y - track.center.y;
+
+    const float overlap = iou(predictedBox, cv::Rect2f(blob.boundingBox));
+    if (overlap > 0.0f)
+    {
+        return 1.0f - overlap;
+    }
+
+    const float dx = blob.centroid.x - predicted.x;
+    const float dy = blob.centroid.y - predicted.y;
+    const float distance = std::sqrt(dx * dx + dy * dy);
+    if (distance < params_.gateDistance)
+    {
+        return 1.0f + distance / params_.gateDistance;
+    }
+    return -1.0f;
+}
+
+int ThermalHotSpotTracker::update(const ThermalAnalysisResult &analysis, std::vector<int> *newEvents)
+{
+    const int64_t nowUs = analysis.captureTimeUs > 0
+                              ? analysis.captureTimeUs
+                              : std::chrono::duration_cast<std::chrono::microseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    // 1. 释放超过最大丢失时间的轨迹
+    trackSlots_.clear();
+    for (int i = 0; i < kMaxTracks; i++)
+    {
+        Track &t = tracks_[i];
+        if (t.active && nowUs - t.lastSeenUs > params_.maxAgeUs)
+        {
+            t.active = false;
+        }
+        if (t.active)
+        {
+            trackSlots_.push_back(i);
+        }
+    }
+
+    // 2. 参与关联的高温区域：按面积取最大的 kMaxDetections 个
+    const int blobCount = static_cast<int>(analysis.blobs.size());
+    detectionOrder_.resize(blobCount);
+    for (int i = 0; i < blobCount; i++)
+        detectionOrder_[i] = i;
+    if (blobCount > kMaxDetections)
+    {
+        std::partial_sort(detectionOrder_.begin(), detectionOrder_.begin() + kMaxDetections, detectionOrder_.end(),
+                          [&](int a, int b) { return analysis.blobs[a].area > analysis.blobs[b].area; });
+        detectionOrder_.resize(kMaxDetections);
+    }
+
+    const int numTracks = static_cast<int>(trackSlots_.size());
+    const int numDets = static_cast<int>(detectionOrder_.size());
+    std::vector<int> detToTrack(numDets, -1);
+
+    // 3. LAPJV 最优分配（方阵，不足部分以不可行代价填充）
+    if (numTracks > 0 && numDets > 0)
+    {
+        const int n = (std::max)(numTracks, numDets);
+        costData_.assign(static_cast<size_t>(n) * n, kInfeasibleCost);
+        costRows_.resize(n);
+        for (int r = 0; r < n; r++)
+            costRows_[r] = costData_.data() + static_cast<size_t>(r) * n;
+
+        for (int r = 0; r < numTracks; r++)
+        {
+            const Track &t = tracks_[trackSlots_[r]];
+            // 按该轨迹自身的丢失时长外推，漏检若干帧的轨迹预测位置相应更远
+            const cv::Point2f predicted = t.center + t.velocity * secondsSinceSeen(t, nowUs);
+            for (int c = 0; c < numDets; c++)
+            {
+                const float cost = associationCost(t, predicted, analysis.blobs[detectionOrder_[c]]);
+                if (cost >= 0.0f)
+                    costRows_[r][c] = cost;
+            }
+        }
+
+        rowSolution_.assign(n, -1);
+        colSolution_.assign(n, -1);
+        lapjv_internal(static_cast<uint_t>(n), costRows_.data(), rowSolution_.data(), colSolution_.data());
+
+        for (int r = 0; r < numTracks; r++)
+        {
+            const int c = rowSolution_[r];
+            if (c < 0 || c >= numDets || costRows_[r][c] > kMaxMatchCost)
+                continue;
+
+            Track &t = tracks_[trackSlots_[r]];
+            const ThermalBlob &blob = analysis.blobs[detectionOrder_[c]];
+            const float dtSec = secondsSinceSeen(t, nowUs);
+            if (dtSec > 0.0f)
+            {
+                const cv::Point2f measured = (blob.centroid - t.center) * (1.0f / dtSec);
+                t.velocity = t.velocity * 0.5f + measured * 0.5f;
+            }
+            t.center = blob.centroid;
+            t.box = cv::Rect2f(blob.boundingBox);
+            t.lastSeenUs = nowUs;
+            t.hits++;
+            detToTrack[c] = trackSlots_[r];
+        }
+    }
+
+    // 4. 未关联的高温区域创建新轨迹；容量已满时替换最久未出现的轨迹
+    for (int c = 0; c < numDets; c++)
+    {
+        if (detToTrack[c] >= 0)
+            continue;
+
+        int slot = -1;
+        int64_t oldest = INT64_MAX;
+        for (int i = 0; i < kMaxTracks; i++)
+        {
+            if (!tracks_[i].active)
+            {
+                slot = i;
+                break;
+            }
+            if (tracks_[i].lastSeenUs < oldest && tracks_[i].lastSeenUs < nowUs)
+            {
+                oldest = tracks_[i].lastSeenUs;
+                slot = i;
+            }
+        }
+        if (slot < 0)
+            break; // 所有轨迹本帧均已关联，剩余高温区域不建轨迹（detToTrack 保持 -1）
+
+        const ThermalBlob &blob = analysis.blobs[detectionOrder_[c]];
+        Track &t = tracks_[slot];
+        t = Track();
+        t.active = true;
+        t.id = nextId_++;
+        t.center = blob.centroid;
+        t.box = cv::Rect2f(blob.boundingBox);
+        t.lastSeenUs = nowUs;
+        t.hits = 1;
+        detToTrack[c] = slot;
+    }
+
+    // 5. 轨迹达到确认帧数时产生一次事件
+    int events = 0;
+    for (int c = 0; c < numDets; c++)
+    {
+        if (detToTrack[c] < 0)
+            continue;
+        Track &t = tracks_[detToTrack[c]];
+        if (!t.reported && t.hits >= params_.minHits)
+        {
+            t.reported = true;
+            events++;
+            if (newEvents)
+                newEvents->push_back(t.id);
+        }
+    }
+    return events;
+}
+
+int ThermalHotSpotTracker::activeCount() const
+{
+    int count = 0;
+    for (const auto &t : tracks_)
+    {
+        if (t.active)
+            count++;
+    }
+    return count;
+}
@@ -0,0 +1,296 @@
+﻿#include "ThermalVisibleFusion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+    // 归一化坐标的单应变换，分母接近0（映射到无穷远）时返回false
+    inline bool applyHomography(const std::array<double, 9> &h, double x, double y, double &outX, double &outY)
+    {
+        const double w = h[6] * x + h[7] * y + h[8];
+        if (std::abs(w) < 1e-12)
+            return false;
+        outX = (h[0] * x + h[1] * y + h[2]) / w;
+        outY = (h[3] * x + h[4] * y + h[5]) / w;
+        return true;
+    }
+
+    // 3x3矩阵求逆（伴随矩阵法），矩阵奇异时返回false
+    bool invert3x3(const std::array<double, 9> &m, std::array<double, 9> &inv)
+    {
+        const double c00 = m[4] * m[8] - m[5] * m[7];
+        const double c01 = m[5] * m[6] - m[3] * m[8];
+        const double c02 = m[3] * m[7] - m[4] * m[6];
+        const double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+        if (std::abs(det) < 1e-12)
+            return false;
+
+        const double invDet = 1.0 / det;
+        inv[0] = c00 * invDet;
+        inv[1] = (m[2] * m[7] - m[1] * m[8]) * invDet;
+        inv[2] = (m[1] * m[5] - m[2] * m[4]) * invDet;
+        inv[3] = c01 * invDet;
+        inv[4] = (m[0] * m[8] - m[2] * m[6]) * invDet;
+        inv[5] = (m[2] * m[3] - m[0] * m[5]) * invDet;
+        inv[6] = c02 * invDet;
+        inv[7] = (m[1] * m[6] - m[0] * m[7]) * invDet;
+        inv[8] = (m[0] * m[4] - m[1] * m[3]) * invDet;
+        return true;
+    }
+
+    constexpr std::array<double, 9> kIdentity = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+}
+
+ThermalVisibleFusion::ThermalVisibleFusion()
+    : homography_(kIdentity), inverse_(kIdentity)
+{
+}
+
+ThermalVisibleFusion::ThermalVisibleFusion(const Params &params)
+    : params_(params), homography_(kIdentity), inverse_(kIdentity)
+{
+    params_.cellSize = (std::max)(1, params_.cellSize);
+}
+
+void ThermalVisibleFusion::setParams(const Params &params)
+{
+    if (params.cellSize != params_.cellSize)
+    {
+        tablesValid_ = false;
+    }
+    params_ = params;
+    params_.cellSize = (std::max)(1, params_.cellSize);
+}
+
+bool ThermalVisibleFusion::setHomography(const std::array<double, 9> &h)
+{
+    std::array<double, 9> inv;
+    if (!invert3x3(h, inv))
+    {
+        std::cerr << "[ThermalVisibleFusion] 单应矩阵不可逆，保持原配准" << std::endl;
+        return false;
+    }
+    homography_ = h;
+    inverse_ = inv;
+    tablesValid_ = false;
+    return true;
+}
+
+bool ThermalVisibleFusion::calibrate(const std::vector<cv::Point2f> &thermalPoints, const std::vector<cv::Point2f> &visiblePoints)
+{
+    if (thermalPoints.size() < 4 || thermalPoints.size() != visiblePoints.size())
+    {
+        std::cerr << "[ThermalVisibleFusion] 标定点对不足4对或数量不一致" << std::endl;
+        return false;
+    }
+
+    cv::Mat h = cv::findHomography(thermalPoints, visiblePoints, 0);
+    if (h.empty())
+    {
+        std::cerr << "[ThermalVisibleFusion] 单应矩阵求解失败" << std::endl;
+        return false;
+    }
+
+    std::array<double, 9> values;
+    for (int i = 0; i < 9; i++)
+    {
+        values[i] = h.at<double>(i / 3, i % 3);
+    }
+    return setHomography(values);
+}
+
+ThermalAnalysisResultPtr ThermalVisibleFusion::pairNearest(const std::deque<ThermalAnalysisResultPtr> &history,
+                                                           int64_t visibleTimeUs, int64_t maxSkewUs)
+{
+    ThermalAnalysisResultPtr best;
+    int64_t bestSkew = maxSkewUs;
+    for (const auto &entry : history)
+    {
+        if (!entry)
+            continue;
+        const int64_t skew = std::llabs(visibleTimeUs - entry->captureTimeUs);
+        if (skew <= bestSkew)
+        {
+            bestSkew = skew;
+            best = entry;
+        }
+    }
+    return best;
+}
+
+void ThermalVisibleFusion::prepareTables(const cv::Size &visibleSize, const cv::Size &thermalSize)
+{
+    if (tablesValid_ && visibleSize == visibleSize_ && thermalSize == thermalSize_)
+        return;
+
+    visibleSize_ = visibleSize;
+    thermalSize_ = thermalSize;
+    const int cell = params_.cellSize;
+    gridCols_ = (visibleSize.width + cell - 1) / cell;
+    gridRows_ = (visibleSize.height + cell - 1) / cell;
+    lutX_.assign(static_cast<size_t>(gridCols_) * gridRows_, -1);
+    lutY_.assign(static_cast<size_t>(gridCols_) * gridRows_, -1);
+    integral_.assign(static_cast<size_t>(gridCols_ + 1) * (gridRows_ + 1), 0);
+
+    // 每个网格中心逆映射到热成像矩阵，记录对应像素
+    int covered = 0;
+    for (int gy = 0; gy < gridRows_; gy++)
+    {
+        const int cy = (std::min)(gy * cell + cell / 2, visibleSize.height - 1);
+        const double v = (cy + 0.5) / visibleSize.height;
+        for (int gx = 0; gx < gridCols_; gx++)
+        {
+            const int cx = (std::min)(gx * cell + cell / 2, visibleSize.width - 1);
+            const double u = (cx + 0.5) / visibleSize.width;
+
+            double tu, tv;
+            if (!applyHomography(inverse_, u, v, tu, tv))
+                continue;
+            const int tx = static_cast<int>(std::floor(tu * thermalSize.width));
+            const int ty = static_cast<int>(std::floor(tv * thermalSize.height));
+            if (tx < 0 || ty < 0 || tx >= thermalSize.width || ty >= thermalSize.height)
+                continue;
+
+            const size_t index = static_cast<size_t>(gy) * gridCols_ + gx;
+            lutX_[index] = static_cast<int16_t>(tx);
+            lutY_[index] = static_cast<int16_t>(ty);
+            covered++;
+        }
+    }
+    tablesValid_ = true;
+
+    std::cout << "[ThermalVisibleFusion] 配准查找表已生成: 可见光 " << visibleSize.width << "x" << visibleSize.height
+              << " -> 热成像 " << thermalSize.width << "x" << thermalSize.height
+              << ", 网格 " << gridCols_ << "x" << gridRows_ << ", 热成像覆盖 "
+              << (gridCols_ * gridRows_ > 0 ? covered * 100 / (gridCols_ * gridRows_) : 0) << "%" << std::endl;
+}
+
+void ThermalVisibleFusion::sampleHotCells(const ThermalBitMask &hot)
+{
+    const int stride = gridCols_ + 1;
+    for (int gy = 0; gy < gridRows_; gy++)
+    {
+        const int16_t *xs = lutX_.data() + static_cast<size_t>(gy) * gridCols_;
+        const int16_t *ys = lutY_.data() + static_cast<size_t>(gy) * gridCols_;
+        const int *above = integral_.data() + static_cast<size_t>(gy) * stride;
+        int *current = integral_.data() + static_cast<size_t>(gy + 1) * stride;
+
+        int rowSum = 0;
+        for (int gx = 0; gx < gridCols_; gx++)
+        {
+            if (xs[gx] >= 0 && hot.test(xs[gx], ys[gx]))
+            {
+                rowSum++;
+            }
+            current[gx + 1] = above[gx + 1] + rowSum;
+        }
+    }
+}
+
+float ThermalVisibleFusion::hotFraction(const cv::Rect &box) const
+{
+    const cv::Rect clipped = box & cv::Rect(0, 0, visibleSize_.width, visibleSize_.height);
+    if (clipped.width <= 0 || clipped.height <= 0)
+        return 0.0f;
+
+    const int cell = params_.cellSize;
+    const int gx0 = clipped.x / cell;
+    const int gy0 = clipped.y / cell;
+    const int gx1 = (clipped.x + clipped.width - 1) / cell + 1;
+    const int gy1 = (clipped.y + clipped.height - 1) / cell + 1;
+    const int stride = gridCols_ + 1;
+
+    const int hotCells = integral_[gy1 * stride + gx1] - integral_[gy0 * stride + gx1] -
+                         integral_[gy1 * stride + gx0] + integral_[gy0 * stride + gx0];
+    const int totalCells = (gx1 - gx0) * (gy1 - gy0);
+    return static_cast<float>(hotCells) / totalCells;
+}
+
+cv::Rect ThermalVisibleFusion::toVisible(const cv::Rect &thermalBox) const
+{
+    const double corners[4][2] = {
+        {static_cast<double>(thermalBox.x), static_cast<double>(thermalBox.y)},
+        {static_cast<double>(thermalBox.x + thermalBox.width), static_cast<double>(thermalBox.y)},
+        {static_cast<double>(thermalBox.x), static_cast<double>(thermalBox.y + thermalBox.height)},
+        {static_cast<double>(thermalBox.x + thermalBox.width), static_cast<double>(thermalBox.y + thermalBox.height)}};
+
+    double minX = 1e9, minY = 1e9, maxX = -1e9, maxY = -1e9;
+    for (const auto &corner : corners)
+    {
+        double u, v;
+        if (!applyHomography(homography_, corner[0] / thermalSize_.width, corner[1] / thermalSize_.height, u, v))
+            return cv::Rect();
+        minX = (std::min)(minX, u * visibleSize_.width);
+        minY = (std::min)(minY, v * visibleSize_.height);
+        maxX = (std::max)(maxX, u * visibleSize_.width);
+        maxY = (std::max)(maxY, v * visibleSize_.height);
+    }
+
+    const cv::Rect mapped(cvFloor(minX), cvFloor(minY), cvCeil(maxX - minX), cvCeil(maxY - minY));
+    return mapped & cv::Rect(0, 0, visibleSize_.width, visibleSize_.height);
+}
+
+FusedDetectionListPtr ThermalVisibleFusion::fuse(const cv::Size &visibleSize, uint64_t visibleSeq, int64_t visibleTimeUs,
+                                                 const std::vector<cv::Rect> &trackRects, const ThermalAnalysisResultPtr &thermal)
+{
+    auto result = std::make_shared<FusedDetectionList>();
+    result->visibleSeq = visibleSeq;
+    result->detections.reserve(trackRects.size());
+
+    const bool paired = thermal && !thermal->mask.empty() && visibleSize.area() > 0;
+    if (paired)
+    {
+        result->thermalSeq = thermal->seq;
+        result->skewUs = visibleTimeUs - thermal->captureTimeUs;
+
+        prepareTables(visibleSize, thermal->matrixSize);
+        thermal->mask.selectHot(hot_, thermal->alarmThreshold);
+        sampleHotCells(hot_);
+    }
+
+    // 可见光目标：按高温比例判断是否被热成像确认
+    for (const auto &rect : trackRects)
+    {
+        FusedDetection detection;
+        detection.box = rect;
+        detection.visible = true;
+        if (paired)
+        {
+            detection.hotFraction = hotFraction(rect);
+            detection.hot = detection.hotFraction >= params_.minHotFraction;
+        }
+        result->detections.push_back(detection);
+    }
+
+    if (!paired)
+        return result;
+
+    // 纯热成像目标：与任何可见光框都不重叠的高温区域
+    for (const auto &blob : thermal->blobs)
+    {
+        const cv::Rect mapped = toVisible(blob.boundingBox);
+        if (mapped.width <= 0 || mapped.height <= 0)
+            continue;
+
+        bool overlapsVisible = false;
+        for (const auto &rect : trackRects)
+        {
+            if ((mapped & rect).area() > 0)
+            {
+                overlapsVisible = true;
+                break;
+            }
+        }
+        if (overlapsVisible)
+            continue;
+
+        FusedDetection detection;
+        detection.box = mapped;
+        detection.hotFraction = hotFraction(mapped);
+        detection.hot = true;
+        result->detections.push_back(detection);
+    }
+    return result;
+}
@@ -17,7 +17,8 @@ ThreadManager::ThreadManager(int cameraCount,
 							 const ObjectTrackingConfig &trackingConfig,
 							 int streamWidth,
 							 int streamHeight,
-							 int streamFps)
+							 int streamFps,
+							 RtspServer *embeddedServer)
 	: sharedData_(sharedData) // 保存共享数据引用
 {
 	std::cout << "[ThreadManager] 初始化多线程管理器，摄像头数量: " << cameraCount << std::endl;
@@ -35,7 +36,7 @@ ThreadManager::ThreadManager(int cameraCount,
 	taskDisplay_ = std::make_unique<TaskDisplay>(sharedData);
 
 	// 4. RTSP推流任务：将处理后的视频通过FFmpeg推送到本地RTSP服务器
-	taskRTSPStream_ = std::make_unique<TaskRTSPStream>(sharedData, rtspUrls, streamWidth, streamHeight, streamFps);
+	taskRTSPStream_ = std::make_unique<TaskRTSPStream>(sharedData, rtspUrls, streamWidth, streamHeight, streamFps, embeddedServer);
 
 	// 5. 热成像检测任务：检测高温物体并设置标志位（移除上报逻辑）
 	taskLocating_ = std::make_unique<TaskLocating>(sharedData);
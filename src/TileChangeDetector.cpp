@@ -0,0 +1,150 @@
+﻿#include "TileChangeDetector.h"
+#include <algorithm>
+#include <cstdlib>
+
+void TileChangeDetector::prepare(const cv::Size &sourceSize, const cv::Size &matrixSize)
+{
+    sourceSize_ = sourceSize;
+    matrixSize_ = matrixSize;
+    tileCols_ = (matrixSize.width + kTileSize - 1) / kTileSize;
+    tileRows_ = (matrixSize.height + kTileSize - 1) / kTileSize;
+    wordsPerRow_ = (matrixSize.width + 63) / 64;
+
+    // 采样点取每个分块内均匀分布的输出像素中心，再映射到源帧坐标
+    auto buildSamples = [](int tiles, int matrixLen, int sourceLen, std::vector<int> &samples)
+    {
+        samples.resize(static_cast<size_t>(tiles) * kSamplesPerAxis);
+        for (int t = 0; t < tiles; t++)
+        {
+            const int tileStart = t * kTileSize;
+            const int tileLen = (std::min)(kTileSize, matrixLen - tileStart);
+            for (int i = 0; i < kSamplesPerAxis; i++)
+            {
+                const double matrixPos = tileStart + (i + 0.5) * tileLen / kSamplesPerAxis;
+                const int sourcePos = static_cast<int>(matrixPos * sourceLen / matrixLen);
+                samples[static_cast<size_t>(t) * kSamplesPerAxis + i] = (std::min)(sourcePos, sourceLen - 1);
+            }
+        }
+    };
+    buildSamples(tileCols_, matrixSize.width, sourceSize.width, sampleX_);
+    buildSamples(tileRows_, matrixSize.height, sourceSize.height, sampleY_);
+
+    luma_.assign(sampleX_.size() * sampleY_.size(), 0);
+    referenceLuma_.assign(luma_.size(), 0);
+    changed_.assign(static_cast<size_t>(tileCols_) * tileRows_, 0);
+    dirty_.assign(changed_.size(), 0);
+    dirtyWords_.assign(static_cast<size_t>(tileRows_) * wordsPerRow_, 0);
+    rowDirty_.assign(tileRows_, 0);
+    forceFull_ = true;
+}
+
+void TileChangeDetector::update(const cv::Mat &frame, const cv::Size &matrixSize)
+{
+    if (frame.empty())
+        return;
+    if (frame.size() != sourceSize_ || matrixSize != matrixSize_)
+    {
+        prepare(frame.size(), matrixSize);
+    }
+
+    // 采样亮度（BGR/BGRA按与cv::cvtColor相同的Q14系数转换）
+    const int channels = frame.channels();
+    const size_t sampleCols = sampleX_.size();
+    for (size_t j = 0; j < sampleY_.size(); j++)
+    {
+        const uchar *src = frame.ptr<uchar>(sampleY_[j]);
+        uint8_t *dst = luma_.data() + j * sampleCols;
+        for (size_t i = 0; i < sampleCols; i++)
+        {
+            const uchar *px = src + static_cast<size_t>(sampleX_[i]) * channels;
+            dst[i] = channels >= 3 ? static_cast<uint8_t>((px[0] * 1868 + px[1] * 9617 + px[2] * 4899 + 8192) >> 14)
+                                   : px[0];
+        }
+    }
+
+    fullRefresh_ = forceFull_ || !params_.enable ||
+                   (params_.fullRefreshFrames > 0 && framesSinceFull_ >= params_.fullRefreshFrames);
+    forceFull_ = false;
+    framesSinceFull_ = fullRefresh_ ? 0 : framesSinceFull_ + 1;
+
+    // 分块SAD
+    const int sadLimit = static_cast<int>(params_.threshold * kSamplesPerAxis * kSamplesPerAxis);
+    changedTiles_ = 0;
+    for (int ty = 0; ty < tileRows_; ty++)
+    {
+        for (int tx = 0; tx < tileCols_; tx++)
+        {
+            bool tileChanged = fullRefresh_;
+            if (!tileChanged)
+            {
+                int sad = 0;
+                for (int j = 0; j < kSamplesPerAxis; j++)
+                {
+                    const size_t offset = (static_cast<size_t>(ty) * kSamplesPerAxis + j) * sampleCols + static_cast<size_t>(tx) * kSamplesPerAxis;
+                    for (int i = 0; i < kSamplesPerAxis; i++)
+                    {
+                        sad += std::abs(static_cast<int>(luma_[offset + i]) - static_cast<int>(referenceLuma_[offset + i]));
+                    }
+                }
+                tileChanged = sad > sadLimit;
+            }
+            changed_[static_cast<size_t>(ty) * tileCols_ + tx] = tileChanged ? 1 : 0;
+            changedTiles_ += tileChanged ? 1 : 0;
+        }
+    }
+
+    // 扩展到8邻域：跨分块边界的高温区域在相邻分块中同样重新计算
+    dirtyTiles_ = 0;
+    for (int ty = 0; ty < tileRows_; ty++)
+    {
+        for (int tx = 0; tx < tileCols_; tx++)
+        {
+            bool tileDirty = false;
+            for (int ny = (std::max)(0, ty - 1); ny <= (std::min)(tileRows_ - 1, ty + 1) && !tileDirty; ny++)
+            {
+                for (int nx = (std::max)(0, tx - 1); nx <= (std::min)(tileCols_ - 1, tx + 1); nx++)
+                {
+                    if (changed_[static_cast<size_t>(ny) * tileCols_ + nx])
+                    {
+                        tileDirty = true;
+                        break;
+                    }
+                }
+            }
+            dirty_[static_cast<size_t>(ty) * tileCols_ + tx] = tileDirty ? 1 : 0;
+            dirtyTiles_ += tileDirty ? 1 : 0;
+        }
+    }
+
+    // 分块标志转换为64位字标志（一个字覆盖 64/kTileSize 个分块）
+    for (int ty = 0; ty < tileRows_; ty++)
+    {
+        uint8_t *words = dirtyWords_.data() + static_cast<size_t>(ty) * wordsPerRow_;
+        uint8_t anyDirty = 0;
+        for (int wi = 0; wi < wordsPerRow_; wi++)
+        {
+            const int firstTile = wi * 64 / kTileSize;
+            const int lastTile = (std::min)(tileCols_ - 1, (wi * 64 + 63) / kTileSize);
+            uint8_t wordDirty = 0;
+            for (int tx = firstTile; tx <= lastTile; tx++)
+            {
+                wordDirty |= dirty_[static_cast<size_t>(ty) * tileCols_ + tx];
+            }
+            words[wi] = wordDirty;
+            anyDirty |= wordDirty;
+
+            // 该字覆盖的分块将被重新计算，以当前采样作为新的参考
+            if (wordDirty)
+            {
+                const size_t first = static_cast<size_t>(firstTile) * kSamplesPerAxis;
+                const size_t count = static_cast<size_t>(lastTile - firstTile + 1) * kSamplesPerAxis;
+                for (int j = 0; j < kSamplesPerAxis; j++)
+                {
+                    const size_t offset = (static_cast<size_t>(ty) * kSamplesPerAxis + j) * sampleCols + first;
+                    std::copy_n(luma_.begin() + offset, count, referenceLuma_.begin() + offset);
+                }
+            }
+        }
+        rowDirty_[ty] = anyDirty;
+    }
+}
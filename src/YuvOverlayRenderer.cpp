@@ -0,0 +1,525 @@
+﻿#include "YuvOverlayRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace
+{
+    constexpr int kFontFace = cv::FONT_HERSHEY_SIMPLEX;
+    constexpr int kFirstGlyph = 32; // ' '
+    constexpr int kLastGlyph = 126; // '~'
+    constexpr int kMaskPad = 16;    // 掩码行尾填充，SIMD整块读取不越界
+
+    inline uint8_t clampByte(float v)
+    {
+        return static_cast<uint8_t>((std::min)(255.0f, (std::max)(0.0f, v)));
+    }
+
+    // 色度按覆盖的亮度像素数（0~4）混合
+    inline void blendChroma(uint8_t &dst, uint8_t value, int covered)
+    {
+        dst = covered >= 4 ? value : static_cast<uint8_t>((dst * (4 - covered) + value * covered + 2) >> 2);
+    }
+}
+
+YuvPlanes YuvPlanes::i420(uint8_t *data, int width, int height)
+{
+    YuvPlanes planes;
+    planes.y = data;
+    planes.u = data + static_cast<size_t>(width) * height;
+    planes.v = planes.u + static_cast<size_t>(width / 2) * (height / 2);
+    planes.yStride = width;
+    planes.uvStride = width / 2;
+    planes.uvStep = 1;
+    planes.width = width;
+    planes.height = height;
+    return planes;
+}
+
+YuvPlanes YuvPlanes::nv12(uint8_t *data, int width, int height)
+{
+    YuvPlanes planes;
+    planes.y = data;
+    planes.u = data + static_cast<size_t>(width) * height;
+    planes.v = planes.u + 1;
+    planes.yStride = width;
+    planes.uvStride = width;
+    planes.uvStep = 2;
+    planes.width = width;
+    planes.height = height;
+    return planes;
+}
+
+YuvOverlayRenderer::YuvOverlayRenderer(ColorMatrix matrix)
+    : matrix_(matrix)
+{
+}
+
+YuvOverlayRenderer::Color YuvOverlayRenderer::color(const cv::Scalar &bgr) const
+{
+    const float b = static_cast<float>(bgr[0]);
+    const float g = static_cast<float>(bgr[1]);
+    const float r = static_cast<float>(bgr[2]);
+    Color c;
+    if (matrix_ == kBt601Limited)
+    {
+        // cv::COLOR_BGR2YUV_I420 的定点系数（ITU-R BT.601，20位小数）
+        const int ri = cvRound(r), gi = cvRound(g), bi = cvRound(b);
+        const int half = 1 << 19;
+        c.y = cv::saturate_cast<uint8_t>((269484 * ri + 528482 * gi + 102760 * bi + half + (16 << 20)) >> 20);
+        c.u = cv::saturate_cast<uint8_t>((-155188 * ri - 305135 * gi + 460324 * bi + half + (128 << 20)) >> 20);
+        c.v = cv::saturate_cast<uint8_t>((460324 * ri - 385875 * gi - 74448 * bi + half + (128 << 20)) >> 20);
+    }
+    else
+    {
+        // 与 cudaBGR2YUV420P 相同
+        c.y = clampByte(0.299f * r + 0.587f * g + 0.114f * b);
+        c.u = clampByte(-0.14713f * r - 0.28886f * g + 0.436f * b + 128.0f);
+        c.v = clampByte(0.615f * r - 0.51499f * g - 0.10001f * b + 128.0f);
+    }
+    return c;
+}
+
+void YuvOverlayRenderer::addSpan(int y, int x0, int x1)
+{
+    if (y < 0 || y >= clipH_)
+        return;
+    x0 = (std::max)(x0, 0);
+    x1 = (std::min)(x1, clipW_);
+    if (x0 < x1)
+        spans_.push_back({y, x0, x1});
+}
+
+// 凸多边形扫描线填充（像素中心位于整数坐标，与OpenCV一致）
+void YuvOverlayRenderer::addConvex(const cv::Point2f *pts, int count)
+{
+    float minY = pts[0].y, maxY = pts[0].y;
+    for (int i = 1; i < count; i++)
+    {
+        minY = (std::min)(minY, pts[i].y);
+        maxY = (std::max)(maxY, pts[i].y);
+    }
+    const int y0 = (std::max)(0, static_cast<int>(std::ceil(minY)));
+    const int y1 = (std::min)(clipH_ - 1, static_cast<int>(std::floor(maxY)));
+    for (int y = y0; y <= y1; y++)
+    {
+        const float fy = static_cast<float>(y);
+        float xl = 1e9f, xr = -1e9f;
+        for (int i = 0; i < count; i++)
+        {
+            const cv::Point2f &p = pts[i];
+            const cv::Point2f &q = pts[(i + 1) % count];
+            if ((fy < p.y && fy < q.y) || (fy > p.y && fy > q.y))
+                continue;
+            if (p.y == q.y)
+            {
+                xl = (std::min)(xl, (std::min)(p.x, q.x));
+                xr = (std::max)(xr, (std::max)(p.x, q.x));
+                continue;
+            }
+            const float x = p.x + (fy - p.y) * (q.x - p.x) / (q.y - p.y);
+            xl = (std::min)(xl, x);
+            xr = (std::max)(xr, x);
+        }
+        if (xl <= xr)
+            addSpan(y, static_cast<int>(std::ceil(xl - 1e-4f)), static_cast<int>(std::floor(xr + 1e-4f)) + 1);
+    }
+}
+
+void YuvOverlayRenderer::addDisc(const cv::Point2f &center, int radius)
+{
+    const int cx = cvRound(center.x);
+    const int cy = cvRound(center.y);
+    for (int dy = -radius; dy <= radius; dy++)
+    {
+        const int half = static_cast<int>(std::sqrt(static_cast<float>(radius * radius - dy * dy)));
+        addSpan(cy + dy, cx - half, cx + half + 1);
+    }
+}
+
+// 线宽为1时按8连通Bresenham逐点生成，否则为加宽的四边形加两端的圆（与 cv::line 的粗线画法相同）
+void YuvOverlayRenderer::addLine(const cv::Point2f &a, const cv::Point2f &b, int thickness)
+{
+    if (thickness <= 1)
+    {
+        int x0 = cvRound(a.x), y0 = cvRound(a.y);
+        const int x1 = cvRound(b.x), y1 = cvRound(b.y);
+        if (y0 == y1)
+        {
+            addSpan(y0, (std::min)(x0, x1), (std::max)(x0, x1) + 1);
+            return;
+        }
+        const int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        const int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        int err = dx + dy;
+        for (;;)
+        {
+            addSpan(y0, x0, x0 + 1);
+            if (x0 == x1 && y0 == y1)
+                break;
+            const int e2 = 2 * err;
+            if (e2 >= dy)
+            {
+                err += dy;
+                x0 += sx;
+            }
+            if (e2 <= dx)
+            {
+                err += dx;
+                y0 += sy;
+            }
+        }
+        return;
+    }
+
+    const int capRadius = (thickness + 1) / 2;
+    const cv::Point2f d = b - a;
+    const float len = std::sqrt(d.x * d.x + d.y * d.y);
+    if (len > 1e-3f)
+    {
+        const float h = thickness * 0.5f / len;
+        const cv::Point2f n(-d.y * h, d.x * h);
+        const cv::Point2f quad[4] = {a + n, b + n, b - n, a - n};
+        addConvex(quad, 4);
+    }
+    addDisc(a, capRadius);
+    addDisc(b, capRadius);
+}
+
+void YuvOverlayRenderer::flushSpans(const YuvPlanes &planes, const Color &c)
+{
+    if (spans_.empty())
+        return;
+
+    // 同一图元的区间按行合并，重叠部分只计一次覆盖
+    std::sort(spans_.begin(), spans_.end(), [](const Span &l, const Span &r)
+              { return l.y != r.y ? l.y < r.y : l.x0 < r.x0; });
+    size_t merged = 0;
+    for (size_t i = 1; i < spans_.size(); i++)
+    {
+        Span &last = spans_[merged];
+        if (spans_[i].y == last.y && spans_[i].x0 <= last.x1)
+            last.x1 = (std::max)(last.x1, spans_[i].x1);
+        else
+            spans_[++merged] = spans_[i];
+    }
+    spans_.resize(merged + 1);
+
+    // 亮度
+    for (const Span &s : spans_)
+    {
+        std::memset(planes.y + static_cast<size_t>(s.y) * planes.yStride + s.x0, c.y, s.x1 - s.x0);
+    }
+
+    // 色度：每两行亮度区间累加到色度列覆盖计数，再按计数混合
+    const int chromaW = (planes.width + 1) / 2;
+    const int chromaH = planes.height / 2;
+    if (coverage_.size() < static_cast<size_t>(chromaW))
+        coverage_.assign(chromaW, 0);
+    size_t i = 0;
+    while (i < spans_.size())
+    {
+        const int cy = spans_[i].y >> 1;
+        size_t end = i;
+        while (end < spans_.size() && (spans_[end].y >> 1) == cy)
+            end++;
+        if (cy >= chromaH)
+            break;
+
+        for (size_t k = i; k < end; k++)
+        {
+            int x0 = spans_[k].x0, x1 = spans_[k].x1;
+            if (x0 & 1)
+                coverage_[x0++ >> 1]++;
+            if ((x1 & 1) && x1 > x0)
+                coverage_[--x1 >> 1]++;
+            for (int cx = x0 >> 1; cx < (x1 >> 1); cx++)
+                coverage_[cx] += 2;
+        }
+        uint8_t *u = planes.u + static_cast<size_t>(cy) * planes.uvStride;
+        uint8_t *v = planes.v + static_cast<size_t>(cy) * planes.uvStride;
+        for (size_t k = i; k < end; k++)
+        {
+            const int last = (spans_[k].x1 - 1) >> 1;
+            for (int cx = spans_[k].x0 >> 1; cx <= last; cx++)
+            {
+                const int covered = coverage_[cx];
+                if (!covered)
+                    continue;
+                blendChroma(u[cx * planes.uvStep], c.u, covered);
+                blendChroma(v[cx * planes.uvStep], c.v, covered);
+                coverage_[cx] = 0;
+            }
+        }
+        i = end;
+    }
+    spans_.clear();
+}
+
+void YuvOverlayRenderer::blitMask(const YuvPlanes &planes, const uint8_t *mask, int maskStride, int maskW, int maskH, int x, int y,
+                                  const Color &c)
+{
+    // 裁剪到平面范围
+    const int left = (std::max)(0, -x), top = (std::max)(0, -y);
+    const int right = (std::min)(maskW, planes.width - x), bottom = (std::min)(maskH, planes.height - y);
+    if (left >= right || top >= bottom)
+        return;
+
+    // 亮度：按掩码选择写入，16像素一组
+#if CV_SIMD128
+    const cv::v_uint8x16 value = cv::v_setall_u8(c.y);
+#endif
+    for (int row = top; row < bottom; row++)
+    {
+        const uint8_t *m = mask + static_cast<size_t>(row) * maskStride;
+        uint8_t *dst = planes.y + static_cast<size_t>(y + row) * planes.yStride + x;
+        int col = left;
+#if CV_SIMD128
+        // 整组写回不超出本行：组内超出掩码宽度的部分掩码为0，写回原值
+        for (; col + 16 <= right || (col < right && x + col + 16 <= planes.width); col += 16)
+        {
+            const cv::v_uint8x16 sel = cv::v_load(m + col);
+            cv::v_store(dst + col, cv::v_select(sel, value, cv::v_load(dst + col)));
+        }
+#endif
+        for (; col < right; col++)
+        {
+            if (m[col])
+                dst[col] = c.y;
+        }
+    }
+
+    // 色度：按每个2×2块内被覆盖的像素数混合
+    const int chromaW = (planes.width + 1) / 2;
+    const int chromaH = planes.height / 2;
+    if (coverage_.size() < static_cast<size_t>(chromaW))
+        coverage_.assign(chromaW, 0);
+    const int cx0 = (x + left) >> 1, cx1 = (x + right - 1) >> 1;
+    for (int cy = (y + top) >> 1; cy <= (y + bottom - 1) >> 1 && cy < chromaH; cy++)
+    {
+        for (int py = 2 * cy; py < 2 * cy + 2; py++)
+        {
+            const int row = py - y;
+            if (row < top || row >= bottom)
+                continue;
+            const uint8_t *m = mask + static_cast<size_t>(row) * maskStride;
+            for (int col = left; col < right; col++)
+            {
+                coverage_[(x + col) >> 1] += m[col] & 1;
+            }
+        }
+        uint8_t *u = planes.u + static_cast<size_t>(cy) * planes.uvStride;
+        uint8_t *v = planes.v + static_cast<size_t>(cy) * planes.uvStride;
+        for (int cx = cx0; cx <= cx1; cx++)
+        {
+            const int covered = coverage_[cx];
+            if (!covered)
+                continue;
+            blendChroma(u[cx * planes.uvStep], c.u, covered);
+            blendChroma(v[cx * planes.uvStep], c.v, covered);
+            coverage_[cx] = 0;
+        }
+    }
+}
+
+void YuvOverlayRenderer::fillRect(const YuvPlanes &planes, const cv::Rect &rect, const cv::Scalar &bgr)
+{
+    clipW_ = planes.width;
+    clipH_ = planes.height;
+    for (int y = rect.y; y < rect.y + rect.height; y++)
+        addSpan(y, rect.x, rect.x + rect.width);
+    flushSpans(planes, color(bgr));
+}
+
+void YuvOverlayRenderer::drawRect(const YuvPlanes &planes, const cv::Rect &rect, const cv::Scalar &bgr, int thickness)
+{
+    clipW_ = planes.width;
+    clipH_ = planes.height;
+    if (rect.width <= 0 || rect.height <= 0)
+        return;
+    if (thickness < 0)
+    {
+        fillRect(planes, rect, bgr);
+        return;
+    }
+
+    // 与 cv::rectangle 相同：四个角为 (x, y) 与 (x+w-1, y+h-1)，四条边按线段绘制
+    const cv::Point2f corners[4] = {
+        cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y)),
+        cv::Point2f(static_cast<float>(rect.x + rect.width - 1), static_cast<float>(rect.y)),
+        cv::Point2f(static_cast<float>(rect.x + rect.width - 1), static_cast<float>(rect.y + rect.height - 1)),
+        cv::Point2f(static_cast<float>(rect.x), static_cast<float>(rect.y + rect.height - 1))};
+    for (int i = 0; i < 4; i++)
+        addLine(corners[i], corners[(i + 1) % 4], thickness);
+    flushSpans(planes, color(bgr));
+}
+
+void YuvOverlayRenderer::drawLine(const YuvPlanes &planes, const cv::Point2f &a, const cv::Point2f &b, const cv::Scalar &bgr,
+                                  int thickness)
+{
+    clipW_ = planes.width;
+    clipH_ = planes.height;
+    addLine(a, b, thickness);
+    flushSpans(planes, color(bgr));
+}
+
+void YuvOverlayRenderer::drawRotatedRect(const YuvPlanes &planes, const std::array<cv::Point2f, 4> &vertices, const cv::Scalar &bgr,
+                                         int thickness)
+{
+    clipW_ = planes.width;
+    clipH_ = planes.height;
+    for (int i = 0; i < 4; i++)
+        addLine(vertices[i], vertices[(i + 1) % 4], thickness);
+    flushSpans(planes, color(bgr));
+}
+
+const YuvOverlayRenderer::GlyphAtlas &YuvOverlayRenderer::atlas(double fontScale, int thickness)
+{
+    const std::pair<int, int> key(cvRound(fontScale * 1000), thickness);
+    auto it = atlases_.find(key);
+    if (it == atlases_.end())
+    {
+        it = atlases_.emplace(key, buildAtlas(key.first / 1000.0, thickness)).first;
+    }
+    return it->second;
+}
+
+// 用 cv::putText 把每个可打印字符画到单独的画布上，裁剪出非零区域作为字形掩码
+YuvOverlayRenderer::GlyphAtlas YuvOverlayRenderer::buildAtlas(double fontScale, int thickness)
+{
+    GlyphAtlas atlas;
+    for (int ch = kFirstGlyph; ch <= kLastGlyph; ch++)
+    {
+        const std::string text(1, static_cast<char>(ch));
+        int baseline = 0;
+        const cv::Size size = cv::getTextSize(text, kFontFace, fontScale, thickness, &baseline);
+        const int pad = thickness + 2;
+        const cv::Point origin(pad, pad + size.height);
+        cv::Mat canvas = cv::Mat::zeros(size.height + baseline + 2 * pad, size.width + 2 * pad, CV_8UC1);
+        cv::putText(canvas, text, origin, kFontFace, fontScale, cv::Scalar(255), thickness, cv::LINE_8);
+
+        // 字宽：16个相同字符的总宽度去掉线宽后取平均，保留小数
+        const cv::Size run = cv::getTextSize(std::string(16, static_cast<char>(ch)), kFontFace, fontScale, thickness, &baseline);
+        atlas.advance[ch - kFirstGlyph] = (run.width - thickness) / 16.0f;
+
+        GlyphAtlas::Glyph &glyph = atlas.glyphs[ch - kFirstGlyph];
+        const cv::Rect box = cv::boundingRect(canvas);
+        if (box.area() <= 0)
+            continue;
+        glyph.offsetX = box.x - origin.x;
+        glyph.offsetY = box.y - origin.y;
+        glyph.width = box.width;
+        glyph.height = box.height;
+        glyph.offset = atlas.masks.size();
+        for (int row = 0; row < box.height; row++)
+        {
+            const uint8_t *src = canvas.ptr<uint8_t>(box.y + row) + box.x;
+            for (int col = 0; col < box.width; col++)
+                atlas.masks.push_back(src[col] ? 0xFF : 0);
+        }
+    }
+    return atlas;
+}
+
+void YuvOverlayRenderer::drawText(const YuvPlanes &planes, const std::string &text, const cv::Point &origin, double fontScale,
+                                  int thickness, const cv::Scalar &bgr)
+{
+    if (text.empty())
+        return;
+    const GlyphAtlas &glyphs = atlas(fontScale, thickness);
+
+    // 逐字排版，求出整段文字的掩码范围（相对于原点）
+    int minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+    float pen = 0.0f;
+    for (char ch : text)
+    {
+        const int index = (std::min)((std::max)(static_cast<int>(static_cast<uint8_t>(ch)), kFirstGlyph), kLastGlyph) - kFirstGlyph;
+        const GlyphAtlas::Glyph &g = glyphs.glyphs[index];
+        if (g.width > 0)
+        {
+            const int gx = cvRound(pen) + g.offsetX;
+            minX = (std::min)(minX, gx);
+            maxX = (std::max)(maxX, gx + g.width);
+            minY = (std::min)(minY, g.offsetY);
+            maxY = (std::max)(maxY, g.offsetY + g.height);
+        }
+        pen += glyphs.advance[index];
+    }
+    if (minX >= maxX)
+        return;
+
+    // 拼接字形掩码（行尾留出SIMD读取的填充）
+    const int maskW = maxX - minX, maskH = maxY - minY;
+    const int stride = maskW + kMaskPad;
+    textMask_.assign(static_cast<size_t>(stride) * maskH, 0);
+    pen = 0.0f;
+    for (char ch : text)
+    {
+        const int index = (std::min)((std::max)(static_cast<int>(static_cast<uint8_t>(ch)), kFirstGlyph), kLastGlyph) - kFirstGlyph;
+        const GlyphAtlas::Glyph &g = glyphs.glyphs[index];
+        const int gx = cvRound(pen) + g.offsetX - minX;
+        const int gy = g.offsetY - minY;
+        for (int row = 0; row < g.height; row++)
+        {
+            const uint8_t *src = glyphs.masks.data() + g.offset + static_cast<size_t>(row) * g.width;
+            uint8_t *dst = textMask_.data() + static_cast<size_t>(gy + row) * stride + gx;
+            for (int col = 0; col < g.width; col++)
+                dst[col] |= src[col];
+        }
+        pen += glyphs.advance[index];
+    }
+
+    blitMask(planes, textMask_.data(), stride, maskW, maskH, origin.x + minX, origin.y + minY, color(bgr));
+}
+
+void YuvOverlayRenderer::draw(const YuvPlanes &planes, const FrameOverlay &overlay, uint32_t layers, double scaleX, double scaleY)
+{
+    auto px = [&](float x) { return static_cast<float>(x * scaleX); };
+    auto py = [&](float y) { return static_cast<float>(y * scaleY); };
+    auto width = [&](int t) { return (std::max)(1, cvRound(t * scaleY)); };
+    auto scaled = [&](const cv::Rect &r)
+    {
+        return cv::Rect(cvRound(r.x * scaleX), cvRound(r.y * scaleY), cvRound(r.width * scaleX), cvRound(r.height * scaleY));
+    };
+
+    if ((layers & kOverlayCountingLine) && overlay.countingLineY >= 0)
+    {
+        const cv::Scalar yellow(0, 255, 255);
+        const float y = py(static_cast<float>(overlay.countingLineY));
+        drawLine(planes, cv::Point2f(0.0f, y), cv::Point2f(px(static_cast<float>(overlay.countingLineWidth)), y), yellow, width(3));
+        if (overlay.countingLineLabel)
+        {
+            drawText(planes, "Detection Line", cv::Point(cvRound(px(10.0f)), cvRound(py(static_cast<float>(overlay.countingLineY - 10)))),
+                     0.7 * scaleY, width(2), yellow);
+        }
+    }
+    if (layers & kOverlayTracks)
+    {
+        for (const TrackResult &t : overlay.tracks)
+        {
+            if (t.is_lost)
+                continue;
+            const cv::Scalar c = TrackerModule::getClassColor(t.classId);
+            const cv::Rect box(cv::Point(cvRound(px(t.bbox[0])), cvRound(py(t.bbox[1]))),
+                               cv::Point(cvRound(px(t.bbox[2])), cvRound(py(t.bbox[3]))));
+            drawRect(planes, box, c, width(2));
+            drawText(planes, std::to_string(t.track_id), cv::Point(box.x, box.y - width(5)), 0.6 * scaleY, width(2), c);
+        }
+    }
+    if (layers & kOverlayFusion)
+    {
+        for (const auto &box : overlay.fusionBoxes)
+            drawRect(planes, scaled(box.first), box.second, width(2));
+    }
+    if (layers & kOverlayHotSpots)
+    {
+        for (const auto &vertices : overlay.hotSpots)
+        {
+            std::array<cv::Point2f, 4> v;
+            for (int i = 0; i < 4; i++)
+                v[i] = cv::Point2f(px(vertices[i].x), py(vertices[i].y));
+            drawRotatedRect(planes, v, cv::Scalar(0, 255, 255), width(2));
+        }
+    }
+}
@@ -3,12 +3,14 @@
 #include "SharedData.h"
 #include "ObjectTrackingConfig.h" // 包含目标追踪配置头文件
 #include <opencv2/opencv.hpp>
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <nlohmann/json.hpp>
 #include <mutex>
 #include <atomic>
 #include "ControlServer.h"
+#include "RtspServer.h"
 
 using json = nlohmann::json;
 bool loadConfig(json &config);
@@ -24,13 +26,31 @@ int main()
 		return -1;
 	}
 
-	// 启动 rtsp-simple-server.exe
-	std::string cmd = "start \"\" \"" +
-					  config["rtsp_server"]["exe_path"].get<std::string>() + "\" \"" +
-					  config["rtsp_server"]["config_path"].get<std::string>() + "\"";
-	std::cout << "[Main] 启动RTSP服务器: " << cmd << std::endl;
-	system(cmd.c_str());
-	std::cout << "[Main] RTSP服务器已启动" << std::endl;
+	// RTSP服务器模式：embedded 使用进程内RTSP服务器；external 启动 rtsp-simple-server.exe
+	std::string rtspServerMode = config["rtsp_server"].value("mode", "embedded");
+	bool useEmbeddedServer = (rtspServerMode != "external");
+	RtspServer embeddedServer;
+	if (useEmbeddedServer)
+	{
+		uint16_t rtspPort = static_cast<uint16_t>(config["stream_urls"]["rtsp_port"].get<int>());
+		uint16_t rtpPort = static_cast<uint16_t>(config["rtsp_server"].value("rtp_port", 8000));
+		size_t sendWindow = config["rtsp_server"].value("send_window", 64);
+		if (!embeddedServer.start(rtspPort, rtpPort, sendWindow))
+		{
+			std::cerr << "[Main] 内嵌RTSP服务器启动失败，端口: " << rtspPort << std::endl;
+			return -1;
+		}
+	}
+	else
+	{
+		// 启动 rtsp-simple-server.exe
+		std::string cmd = "start \"\" \"" +
+						  config["rtsp_server"]["exe_path"].get<std::string>() + "\" \"" +
+						  config["rtsp_server"]["config_path"].get<std::string>() + "\"";
+		std::cout << "[Main] 启动RTSP服务器: " << cmd << std::endl;
+		system(cmd.c_str());
+		std::cout << "[Main] RTSP服务器已启动" << std::endl;
+	}
 
 	// 获取摄像头数量配置
 	int cameraCount = config["camera_count"].get<int>();
@@ -103,7 +123,7 @@ int main()
 
 	std::cout << "[Main] 最终使用的设备配置数量: " << deviceConfigs.size() << std::endl;
 
-	// 生成推流地址
+	// 生成推流地址（启用四分屏时追加第五路）
 	std::vector<std::string> rtspUrls = generateStreamUrls(config);
 
 	// 从配置文件加载目标追踪参数
@@ -154,16 +174,192 @@ int main()
 		const auto &thermalConfig = config["thermal_processing"];
 		sharedData.thermalProcessingConfig.enableThermalProcessing = thermalConfig.value("enable_thermal_processing", true);
 		sharedData.thermalProcessingConfig.environmentTempThreshold = thermalConfig.value("environment_temp_threshold", 50.0f);
+		sharedData.thermalProcessingConfig.matrixBenchmarkIterations = thermalConfig.value("matrix_benchmark_iterations", 0);
+		sharedData.thermalProcessingConfig.persistenceFrames = thermalConfig.value("persistence_frames", 2);
+		sharedData.thermalProcessingConfig.persistenceWindow = thermalConfig.value("persistence_window", 3);
+		sharedData.thermalProcessingConfig.paletteSampleInterval = thermalConfig.value("palette_sample_interval", 25);
+		sharedData.thermalProcessingConfig.blobExtraction = thermalConfig.value("blob_extraction", std::string("runlength"));
+		sharedData.thermalProcessingConfig.hotSpotGateDistance = thermalConfig.value("hot_spot_gate_px", 50.0f);
+		sharedData.thermalProcessingConfig.hotSpotMaxAgeMs = thermalConfig.value("hot_spot_max_age_ms", 2000);
+		sharedData.thermalProcessingConfig.hotSpotMinHits = thermalConfig.value("hot_spot_min_hits", 1);
+		sharedData.thermalProcessingConfig.tileChangeDetection = thermalConfig.value("tile_change_detection", true);
+		sharedData.thermalProcessingConfig.tileChangeThreshold = thermalConfig.value("tile_change_threshold", 6.0f);
+		sharedData.thermalProcessingConfig.tileFullRefreshFrames = thermalConfig.value("tile_full_refresh_frames", 250);
 
 		std::cout << "[Main] Thermal processing configuration loaded:" << std::endl;
 		std::cout << "  - Enabled: " << (sharedData.thermalProcessingConfig.enableThermalProcessing ? "Yes" : "No") << std::endl;
 		std::cout << "  - Environment temp threshold: " << sharedData.thermalProcessingConfig.environmentTempThreshold << "°C" << std::endl;
+		std::cout << "  - Hot pixel persistence: " << sharedData.thermalProcessingConfig.persistenceFrames
+				  << " of " << sharedData.thermalProcessingConfig.persistenceWindow << " frames" << std::endl;
+		std::cout << "  - Blob extraction: " << sharedData.thermalProcessingConfig.blobExtraction << std::endl;
+		std::cout << "  - Hot spot tracking: gate " << sharedData.thermalProcessingConfig.hotSpotGateDistance
+				  << " px, max age " << sharedData.thermalProcessingConfig.hotSpotMaxAgeMs
+				  << " ms, min hits " << sharedData.thermalProcessingConfig.hotSpotMinHits << std::endl;
+		std::cout << "  - Tile change detection: " << (sharedData.thermalProcessingConfig.tileChangeDetection ? "Yes" : "No")
+				  << " (threshold " << sharedData.thermalProcessingConfig.tileChangeThreshold
+				  << ", full refresh every " << sharedData.thermalProcessingConfig.tileFullRefreshFrames << " frames)" << std::endl;
+		if (sharedData.thermalProcessingConfig.matrixBenchmarkIterations > 0)
+		{
+			std::cout << "  - Matrix benchmark iterations: " << sharedData.thermalProcessingConfig.matrixBenchmarkIterations << std::endl;
+		}
+
+		// 辐射测温采集（真实温度，替代调色板颜色分析）
+		if (thermalConfig.contains("radiometric"))
+		{
+			const auto &radiometricConfig = thermalConfig["radiometric"];
+			auto &rc = sharedData.radiometricIngestConfig;
+			rc.enable = radiometricConfig.value("enable", false);
+			rc.channel = radiometricConfig.value("channel", 2);
+			rc.fps = radiometricConfig.value("fps", 5.0f);
+			rc.poolSize = radiometricConfig.value("pool_size", 4);
+			rc.recordDir = radiometricConfig.value("record_dir", std::string());
+			rc.recordFrames = radiometricConfig.value("record_frames", 0);
+			rc.raw16Scale = radiometricConfig.value("raw16_scale", 0.1f);
+			rc.raw16Offset = radiometricConfig.value("raw16_offset", -273.15f);
+			std::cout << "  - Radiometric ingest: " << (rc.enable ? "Yes" : "No") << ", " << rc.fps << " fps" << std::endl;
+		}
 	}
 	else
 	{
 		std::cout << "[Main] Thermal processing configuration not found, using default settings" << std::endl;
 	}
 
+	// 加载组播输出配置
+	if (config.contains("multicast_output"))
+	{
+		const auto &mcastConfig = config["multicast_output"];
+		auto &mc = sharedData.multicastOutputConfig;
+		mc.enable = mcastConfig.value("enable", false);
+		mc.format = mcastConfig.value("format", "rtp");
+		mc.ttl = mcastConfig.value("ttl", 1);
+		mc.pktSize = mcastConfig.value("pkt_size", 1316);
+		mc.localAddress = mcastConfig.value("local_address", "");
+		mc.sdpDir = mcastConfig.value("sdp_dir", "./sdp");
+		if (mcastConfig.contains("groups"))
+		{
+			for (auto it = mcastConfig["groups"].begin(); it != mcastConfig["groups"].end(); ++it)
+			{
+				mc.groups[it.key()] = it.value().get<std::string>();
+			}
+		}
+
+		std::cout << "[Main] Multicast output configuration loaded:" << std::endl;
+		std::cout << "  - Enabled: " << (mc.enable ? "Yes" : "No") << std::endl;
+		std::cout << "  - Format: " << mc.format << ", TTL: " << mc.ttl << std::endl;
+		for (const auto &kv : mc.groups)
+		{
+			std::cout << "  - " << kv.first << " -> " << kv.second << std::endl;
+		}
+	}
+
+	// 加载热成像-可见光融合配置（每个设备的配准参数）
+	if (config.contains("thermal_visible_fusion"))
+	{
+		const auto &fusionConfig = config["thermal_visible_fusion"];
+		auto &fc = sharedData.thermalVisibleFusionConfig;
+		fc.enable = fusionConfig.value("enable", false);
+		fc.maxTimeSkewMs = fusionConfig.value("max_time_skew_ms", 80);
+		fc.minHotFraction = fusionConfig.value("min_hot_fraction", 0.05f);
+		fc.cellSize = fusionConfig.value("cell_size", 8);
+		if (fusionConfig.contains("devices"))
+		{
+			const auto &devices = fusionConfig["devices"];
+			for (size_t i = 0; i < devices.size() && i < 2; i++)
+			{
+				const auto &device = devices[i];
+				if (device.contains("homography"))
+				{
+					fc.homography[i] = device["homography"].get<std::vector<double>>();
+				}
+				if (device.contains("point_pairs"))
+				{
+					// 每个点对为 [热成像x, 热成像y, 可见光x, 可见光y]（归一化坐标）
+					for (const auto &pair : device["point_pairs"])
+					{
+						fc.thermalPoints[i].emplace_back(pair[0].get<float>(), pair[1].get<float>());
+						fc.visiblePoints[i].emplace_back(pair[2].get<float>(), pair[3].get<float>());
+					}
+				}
+			}
+		}
+
+		std::cout << "[Main] 热成像-可见光融合: " << (fc.enable ? "启用" : "禁用")
+				  << ", 最大时间差: " << fc.maxTimeSkewMs << " ms, 高温比例下限: " << fc.minHotFraction
+				  << ", 网格: " << fc.cellSize << " px" << std::endl;
+	}
+
+	// 加载事件日志配置（越线计数、热成像检测、上报数据包写入同一个二进制日志）
+	EventJournal eventJournal;
+	if (config.contains("event_journal"))
+	{
+		const auto &journalConfig = config["event_journal"];
+		auto &ej = sharedData.eventJournalConfig;
+		ej.enable = journalConfig.value("enable", false);
+		ej.path = journalConfig.value("path", std::string("events.journal"));
+		ej.queueCapacity = journalConfig.value("queue_capacity", 4096);
+		ej.fsyncIntervalMs = journalConfig.value("fsync_interval_ms", 1000);
+		ej.logAllPackets = journalConfig.value("log_all_packets", false);
+		if (ej.enable)
+		{
+			EventJournal::Params params;
+			params.path = ej.path;
+			params.queueCapacity = static_cast<size_t>((std::max)(ej.queueCapacity, 16));
+			params.fsyncIntervalMs = (std::max)(ej.fsyncIntervalMs, 10);
+			if (eventJournal.start(params))
+			{
+				sharedData.eventJournal = &eventJournal;
+			}
+			else
+			{
+				std::cerr << "[Main] 事件日志启动失败，越线记录改写计数文件" << std::endl;
+			}
+		}
+	}
+
+	// 加载标注绘制配置（处理后帧不带标注，各输出按需绘制）
+	if (config.contains("overlay_rendering"))
+	{
+		const auto &overlayConfig = config["overlay_rendering"];
+		auto &oc = sharedData.overlayRenderConfig;
+		oc.lazy = overlayConfig.value("lazy", true);
+		const std::vector<std::string> allLayers = {"tracks", "counting_line", "fusion", "hot_spots"};
+		std::string unknown;
+		oc.streamLayers = FrameOverlay::parseLayers(overlayConfig.value("stream_layers", allLayers), &unknown);
+		oc.displayLayers = FrameOverlay::parseLayers(overlayConfig.value("display_layers", allLayers), &unknown);
+		if (!unknown.empty())
+		{
+			std::cerr << "[Main] 未知的标注图层: " << unknown << std::endl;
+		}
+		const std::string streamRenderer = overlayConfig.value("stream_renderer", std::string("yuv"));
+		if (streamRenderer != "yuv" && streamRenderer != "bgr")
+		{
+			std::cerr << "[Main] 未知的推流标注绘制方式: " << streamRenderer << "，使用 yuv" << std::endl;
+		}
+		oc.yuvStreams = streamRenderer != "bgr";
+		std::cout << "[Main] 标注绘制 - 推流图层: " << FrameOverlay::layerNames(oc.streamLayers)
+				  << ", 显示图层: " << FrameOverlay::layerNames(oc.displayLayers)
+				  << ", 无订阅者时跳过: " << (oc.lazy ? "是" : "否")
+				  << ", 推流绘制: " << (oc.yuvStreams ? "YUV平面" : "BGR帧") << std::endl;
+	}
+
+	// 加载共享内存帧总线配置（处理后帧发布给本机的显示/分析进程）
+	if (config.contains("frame_bus"))
+	{
+		const auto &busConfig = config["frame_bus"];
+		auto &fb = sharedData.frameBusConfig;
+		fb.enable = busConfig.value("enable", false);
+		fb.namePrefix = busConfig.value("name_prefix", std::string("HikFrameBus"));
+		fb.slots = (std::max)(busConfig.value("slots", 4), 2);
+		if (fb.enable)
+		{
+			sharedData.processed_thermal_bus_1.configure(fb.namePrefix + "_T1", fb.slots);
+			sharedData.processed_visible_bus_1.configure(fb.namePrefix + "_V1", fb.slots);
+			sharedData.processed_thermal_bus_2.configure(fb.namePrefix + "_T2", fb.slots);
+			sharedData.processed_visible_bus_2.configure(fb.namePrefix + "_V2", fb.slots);
+			std::cout << "[Main] 共享内存帧总线已启用: " << fb.namePrefix << "_T1/_V1/_T2/_V2，每路 " << fb.slots << " 个槽位" << std::endl;
+		}
+	}
+
 	std::cout << "[Main] 系统运行在生产模式，摄像头数量: " << cameraCount << std::endl;
 
 	// 启动控制服务器（独立文本协议，用于端点切换）
@@ -174,6 +370,25 @@ int main()
 		std::cerr << "[Main] ControlServer start failed on port " << controlPort << std::endl;
 	}
 
+	// 读取四分屏合成流配置
+	if (config.contains("rtsp_streaming") && config["rtsp_streaming"].contains("quad_view"))
+	{
+		const auto &quadConfig = config["rtsp_streaming"]["quad_view"];
+		auto &qc = sharedData.quadViewConfig;
+		qc.enable = quadConfig.value("enable", false);
+		qc.width = quadConfig.value("width", 1280);
+		qc.height = quadConfig.value("height", 720);
+		qc.path = quadConfig.value("path", "quad");
+		if (qc.enable)
+		{
+			std::string ip = config["stream_urls"]["local_ip1"];
+			int port = config["stream_urls"]["rtsp_port"].get<int>();
+			rtspUrls.push_back("rtsp://" + ip + ":" + std::to_string(port) + "/" + qc.path); // 四分屏合成
+		}
+		std::cout << "[Main] 四分屏合成流: " << (qc.enable ? "启用" : "禁用") << " "
+				  << qc.width << "x" << qc.height << " /" << qc.path << std::endl;
+	}
+
 	// 读取RTSP推流配置参数
 	int streamWidth = 0, streamHeight = 0, streamFps = 25;
 	if (config.contains("rtsp_streaming"))
@@ -188,12 +403,36 @@ int main()
 		{
 			streamFps = rtspConfig["fps"].get<int>();
 		}
+		auto &pacing = sharedData.streamPacingConfig;
+		pacing.thermalFps = rtspConfig.value("thermal_fps", 0);
+		pacing.visibleFps = rtspConfig.value("visible_fps", 0);
+		pacing.keepaliveFps = rtspConfig.value("keepalive_fps", 1);
 		std::cout << "[Main] RTSP推流配置 - 分辨率: " << streamWidth << "x" << streamHeight
-				  << " (0表示使用原始分辨率), 帧率: " << streamFps << std::endl;
+				  << " (0表示使用原始分辨率), 帧率: " << streamFps
+				  << ", 热成像帧率: " << pacing.thermalFps << ", 可见光帧率: " << pacing.visibleFps
+				  << " (0表示使用fps), 保活帧率: " << pacing.keepaliveFps << std::endl;
+
+		// ROI编码配置（跟踪框/高温区域降低QP，背景提高QP）
+		if (rtspConfig.contains("roi_encoding"))
+		{
+			const auto &roiConfig = rtspConfig["roi_encoding"];
+			auto &roi = sharedData.roiEncodingConfig;
+			roi.enable = roiConfig.value("enable", false);
+			roi.roiQOffset = roiConfig.value("roi_qoffset", -0.3f);
+			roi.backgroundQOffset = roiConfig.value("background_qoffset", 0.2f);
+			roi.marginPx = roiConfig.value("margin_px", 16);
+			roi.maxRegions = roiConfig.value("max_regions", 32);
+			roi.statsIntervalSec = roiConfig.value("stats_interval_sec", 10);
+			roi.crf = roiConfig.value("crf", 0);
+			std::cout << "[Main] ROI编码: " << (roi.enable ? "启用" : "禁用")
+					  << ", 目标qoffset: " << roi.roiQOffset << ", 背景qoffset: " << roi.backgroundQOffset
+					  << ", CRF: " << roi.crf << std::endl;
+		}
 	}
 
 	// 创建线程管理器（SDK登录逻辑已移至TaskVideoCapture）
-	ThreadManager manager(cameraCount, deviceConfigs, sharedData, rtspUrls, trackingConfig, streamWidth, streamHeight, streamFps);
+	ThreadManager manager(cameraCount, deviceConfigs, sharedData, rtspUrls, trackingConfig, streamWidth, streamHeight, streamFps,
+						  useEmbeddedServer ? &embeddedServer : nullptr);
 
 	// 启动所有线程
 	std::cout << "[Main] 启动所有任务线程..." << std::endl;
@@ -211,13 +450,26 @@ int main()
 	sharedData.isRunning = false; // 确保在停止线程前设置标志
 	manager.stopAll();
 
+	// 所有生产线程已退出，写完剩余事件后关闭日志
+	sharedData.eventJournal = nullptr;
+	eventJournal.stop();
+
 	// 停止控制服务器
 	controlServer.stop();
 
+	// 停止RTSP服务器
+	if (useEmbeddedServer)
+	{
+		embeddedServer.stop();
+	}
+	else
+	{
+		std::system("taskkill /FI \"WINDOWTITLE eq rtsp-simple-server\" /F"); // 关闭rtsp-simple-server.exe
+	}
+
 	// 清理资源
-	rtspUrls.clear();													  // 清空推流地址列表
-	cv::destroyAllWindows();											  // 关闭所有OpenCV窗口
-	std::system("taskkill /FI \"WINDOWTITLE eq rtsp-simple-server\" /F"); // 关闭rtsp-simple-server.exe
+	rtspUrls.clear();		 // 清空推流地址列表
+	cv::destroyAllWindows(); // 关闭所有OpenCV窗口
 
 	std::cout << "[Main] 程序已正常退出" << std::endl;
 	return 0;
@@ -0,0 +1,58 @@
+﻿#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "IDetector.h"
+#include "ObjectTrackingConfig.h"
+
+/**
+ * @brief 检测后端对比工具
+ *
+ * 用法: DetectorParity <config.json> <图像目录> [容差像素]
+ * 按 config.json 的 object_tracking 配置（ConfigManager 读取当前目录下的 tracking_config.json）
+ * 同时创建 tensorrt 与 opencv_dnn 两个后端，在图像目录上逐图对比检测结果。
+ * 全部图像在容差内退出码为0，存在不一致为1，无法运行为2。
+ */
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "用法: " << argv[0] << " <config.json> <图像目录> [容差像素]" << std::endl;
+        return 2;
+    }
+    const std::string configPath = argv[1];
+    const std::string imageDir = argv[2];
+    const float tolerancePx = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 2.0f;
+
+    std::ifstream file(configPath);
+    if (!file.is_open())
+    {
+        std::cerr << "[DetectorParity] 无法打开配置文件: " << configPath << std::endl;
+        return 2;
+    }
+    nlohmann::json config;
+    try
+    {
+        file >> config;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[DetectorParity] 配置文件解析失败: " << e.what() << std::endl;
+        return 2;
+    }
+
+    ObjectTrackingConfig trackingConfig;
+    if (!trackingConfig.loadFromJson(config))
+        return 2;
+
+    std::unique_ptr<IDetector> reference = IDetector::create(trackingConfig, "tensorrt");
+    std::unique_ptr<IDetector> candidate = IDetector::create(trackingConfig, "opencv_dnn");
+    if (!reference || !candidate)
+    {
+        std::cerr << "[DetectorParity] 需要两个后端都可用（TensorRT后端需以 ENABLE_TENSORRT_DETECTOR=ON 构建）" << std::endl;
+        return 2;
+    }
+    return IDetector::compareBackends(*reference, *candidate, imageDir, tolerancePx) ? 0 : 1;
+}
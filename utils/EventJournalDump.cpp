@@ -0,0 +1,161 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "EventJournal.h"
+
+/**
+ * @brief 事件日志导出工具
+ *
+ * 用法: EventJournalDump <日志文件> [csv|json]
+ * csv 输出一行表头和每条记录一行（各类型共用列，不适用的列留空）；json 每条记录输出一行JSON对象。
+ */
+namespace
+{
+    std::string formatTime(int64_t timeUs)
+    {
+        const std::time_t seconds = static_cast<std::time_t>(timeUs / 1000000);
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        std::ostringstream out;
+        out << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "." << std::setfill('0') << std::setw(3) << (timeUs / 1000) % 1000;
+        return out.str();
+    }
+
+    std::string toHex(const uint8_t *data, size_t size)
+    {
+        std::ostringstream out;
+        for (size_t i = 0; i < size; i++)
+        {
+            out << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<int>(data[i]);
+        }
+        return out.str();
+    }
+
+    template <typename T>
+    bool loadPayload(const EventJournal::Record &record, T &payload)
+    {
+        if (record.size < sizeof(T))
+            return false;
+        std::memcpy(&payload, record.payload, sizeof(T));
+        return true;
+    }
+
+    nlohmann::ordered_json toJson(const EventJournal::Record &record)
+    {
+        nlohmann::ordered_json j;
+        j["seq"] = record.seq;
+        j["time_us"] = record.timeUs;
+        j["time"] = formatTime(record.timeUs);
+        j["type"] = EventJournal::typeName(record.type);
+
+        EventJournal::CrossingEvent crossing;
+        EventJournal::ThermalDetectionEvent thermal;
+        EventJournal::ReportPacketEvent packet;
+        if (record.type == EventJournal::EventType::Crossing && loadPayload(record, crossing))
+        {
+            j["camera"] = crossing.cameraId;
+            j["track_id"] = crossing.trackId;
+            j["sequence_id"] = crossing.sequenceId;
+            j["processing_ms"] = crossing.processingTimeMs;
+            j["frame_time_ms"] = crossing.frameTimeMs;
+            j["real_time_ms"] = crossing.realTimeMs;
+        }
+        else if (record.type == EventJournal::EventType::ThermalDetection && loadPayload(record, thermal))
+        {
+            j["camera"] = thermal.cameraId;
+            j["spot_id"] = thermal.spotId;
+            j["frame_seq"] = thermal.frameSeq;
+            j["box"] = {thermal.x, thermal.y, thermal.w, thermal.h};
+            j["alarm_threshold"] = thermal.alarmThreshold;
+        }
+        else if (record.type == EventJournal::EventType::ReportPacket && loadPayload(record, packet))
+        {
+            j["flags"] = {packet.flags[0], packet.flags[1], packet.flags[2], packet.flags[3]};
+            j["sent"] = packet.sent != 0;
+            j["clients"] = packet.clientCount;
+            j["packet_size"] = packet.packetSize;
+            j["packet"] = toHex(packet.packet, (std::min)(static_cast<size_t>(packet.packetSize), sizeof(packet.packet)));
+        }
+        return j;
+    }
+
+    void writeCsv(std::ostream &out, const EventJournal::Record &record)
+    {
+        // seq,time_us,time,type,camera,id,sequence_id,processing_ms,frame_time_ms,real_time_ms,frame_seq,x,y,w,h,alarm_threshold,flags,sent,clients,packet
+        out << record.seq << "," << record.timeUs << "," << formatTime(record.timeUs) << "," << EventJournal::typeName(record.type) << ",";
+        EventJournal::CrossingEvent crossing;
+        EventJournal::ThermalDetectionEvent thermal;
+        EventJournal::ReportPacketEvent packet;
+        if (record.type == EventJournal::EventType::Crossing && loadPayload(record, crossing))
+        {
+            out << static_cast<int>(crossing.cameraId) << "," << crossing.trackId << "," << crossing.sequenceId << ","
+                << std::fixed << std::setprecision(2) << crossing.processingTimeMs << "," << crossing.frameTimeMs << ","
+                << crossing.realTimeMs << std::defaultfloat << ",,,,,,,,,,";
+        }
+        else if (record.type == EventJournal::EventType::ThermalDetection && loadPayload(record, thermal))
+        {
+            out << static_cast<int>(thermal.cameraId) << "," << thermal.spotId << ",,,,," << thermal.frameSeq << ","
+                << thermal.x << "," << thermal.y << "," << thermal.w << "," << thermal.h << "," << thermal.alarmThreshold << ",,,,";
+        }
+        else if (record.type == EventJournal::EventType::ReportPacket && loadPayload(record, packet))
+        {
+            out << ",,,,,,,,,,,," << static_cast<int>(packet.flags[0]) << static_cast<int>(packet.flags[1])
+                << static_cast<int>(packet.flags[2]) << static_cast<int>(packet.flags[3]) << "," << static_cast<int>(packet.sent)
+                << "," << packet.clientCount << ","
+                << toHex(packet.packet, (std::min)(static_cast<size_t>(packet.packetSize), sizeof(packet.packet)));
+        }
+        else
+        {
+            out << ",,,,,,,,,,,,,,,";
+        }
+        out << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "用法: " << argv[0] << " <日志文件> [csv|json]" << std::endl;
+        return 1;
+    }
+    const std::string path = argv[1];
+    const std::string format = argc > 2 ? argv[2] : "csv";
+    if (format != "csv" && format != "json")
+    {
+        std::cerr << "[EventJournalDump] 未知的输出格式: " << format << std::endl;
+        return 1;
+    }
+
+    if (format == "csv")
+    {
+        std::cout << "seq,time_us,time,type,camera,id,sequence_id,processing_ms,frame_time_ms,real_time_ms,"
+                     "frame_seq,x,y,w,h,alarm_threshold,flags,sent,clients,packet\n";
+    }
+    uint64_t records = 0;
+    const bool ok = EventJournal::read(path, [&](const EventJournal::Record &record)
+    {
+        if (format == "csv")
+            writeCsv(std::cout, record);
+        else
+            std::cout << toJson(record).dump() << "\n";
+        records++;
+    });
+    if (!ok)
+    {
+        std::cerr << "[EventJournalDump] 无法读取事件日志: " << path << std::endl;
+        return 1;
+    }
+    std::cerr << "[EventJournalDump] 共 " << records << " 条记录" << std::endl;
+    return 0;
+}
@@ -0,0 +1,200 @@
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "FrameBus.h"
+
+/**
+ * @brief 帧总线参考读端与跨进程延迟测试工具
+ *
+ * 用法:
+ *   FrameBusTool read <总线名称> [--show]         持续读取，每秒输出帧率与延迟；--show 用 cv::imshow 显示（不复制）
+ *   FrameBusTool bench <总线名称> [帧数]           统计发布到读端取到帧的延迟分布（默认1000帧）
+ *   FrameBusTool publish <总线名称> <宽> <高> [fps] 模拟写端发布合成帧，便于没有相机时做跨进程测试
+ * 总线名称为配置中的 name_prefix 加路名，如 HikFrameBus_V1。
+ */
+namespace
+{
+    std::atomic<bool> g_running{true};
+
+    int64_t nowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 等待写端创建总线（写端在第一次发布时才创建共享内存）
+    bool openReader(FrameBusReader &reader, const std::string &name)
+    {
+        bool announced = false;
+        while (g_running)
+        {
+            if (reader.open(name))
+            {
+                std::cerr << "[FrameBusTool] 已打开 " << name << std::endl;
+                return true;
+            }
+            if (!announced)
+            {
+                std::cerr << "[FrameBusTool] 等待写端创建 " << name << " ..." << std::endl;
+                announced = true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+        return false;
+    }
+
+    double percentile(std::vector<int64_t> &samples, double p)
+    {
+        if (samples.empty())
+            return 0.0;
+        const size_t index = (std::min)(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return static_cast<double>(samples[index]);
+    }
+
+    int runRead(const std::string &name, bool show)
+    {
+        FrameBusReader reader;
+        if (!openReader(reader, name))
+            return 1;
+
+        uint64_t frames = 0, skipped = 0, overwritten = 0;
+        int64_t latencySumUs = 0, latencyMaxUs = 0, captureSumUs = 0;
+        int64_t windowStartUs = nowUs();
+        while (g_running)
+        {
+            if (reader.writerRestarted())
+            {
+                std::cerr << "[FrameBusTool] 写端已退出或重启，重新打开" << std::endl;
+                if (!openReader(reader, name))
+                    break;
+            }
+            FrameBusReader::View view;
+            if (reader.wait(1000) && reader.acquire(view))
+            {
+                const int64_t latencyUs = nowUs() - view.publishTimeUs;
+                frames++;
+                skipped += view.skipped;
+                latencySumUs += latencyUs;
+                latencyMaxUs = (std::max)(latencyMaxUs, latencyUs);
+                if (view.captureTimeUs > 0)
+                    captureSumUs += nowUs() - view.captureTimeUs;
+                if (show)
+                {
+                    cv::imshow(name, view.frame);
+                    if (cv::waitKey(1) == 27)
+                        g_running = false;
+                }
+                // 使用期间被写端覆盖的帧（显示内容可能撕裂）
+                if (!reader.validate(view))
+                    overwritten++;
+            }
+
+            const int64_t elapsedUs = nowUs() - windowStartUs;
+            if (elapsedUs >= 1000000)
+            {
+                std::cout << "[FrameBusTool] " << name << " " << std::fixed << std::setprecision(1) << frames * 1e6 / elapsedUs << " fps"
+                          << "，发布→取帧 平均 " << (frames ? latencySumUs / static_cast<double>(frames) : 0.0) << " us / 最大 "
+                          << latencyMaxUs << " us，采集→取帧 平均 " << (frames ? captureSumUs / 1000.0 / frames : 0.0) << " ms"
+                          << "，跳过 " << skipped << "，使用中被覆盖 " << overwritten << "，读冲突 " << reader.torn() << std::endl;
+                frames = skipped = overwritten = 0;
+                latencySumUs = latencyMaxUs = captureSumUs = 0;
+                windowStartUs = nowUs();
+            }
+        }
+        return 0;
+    }
+
+    int runBench(const std::string &name, int count)
+    {
+        FrameBusReader reader;
+        if (!openReader(reader, name))
+            return 1;
+
+        std::vector<int64_t> samples;
+        samples.reserve(count);
+        uint64_t skipped = 0;
+        const int64_t startUs = nowUs();
+        while (g_running && static_cast<int>(samples.size()) < count)
+        {
+            FrameBusReader::View view;
+            if (reader.wait(1000) && reader.acquire(view))
+            {
+                samples.push_back(nowUs() - view.publishTimeUs);
+                skipped += view.skipped;
+            }
+            else if (reader.writerRestarted())
+            {
+                std::cerr << "[FrameBusTool] 写端已退出" << std::endl;
+                break;
+            }
+        }
+        if (samples.empty())
+            return 1;
+
+        const double seconds = (nowUs() - startUs) / 1e6;
+        std::cout << "[FrameBusTool] " << name << " 共 " << samples.size() << " 帧（" << std::fixed << std::setprecision(1)
+                  << samples.size() / seconds << " fps），跳过 " << skipped << " 帧，读冲突 " << reader.torn() << std::endl;
+        std::cout << "[FrameBusTool] 发布→取帧延迟 p50 " << percentile(samples, 0.50) << " us，p90 " << percentile(samples, 0.90)
+                  << " us，p99 " << percentile(samples, 0.99) << " us，最大 " << *std::max_element(samples.begin(), samples.end())
+                  << " us" << std::endl;
+        return 0;
+    }
+
+    int runPublish(const std::string &name, int width, int height, int fps)
+    {
+        FrameBusWriter writer;
+        writer.configure(name, 4);
+        cv::Mat frame(height, width, CV_8UC3);
+        const int64_t intervalUs = 1000000 / (std::max)(fps, 1);
+        int64_t nextUs = nowUs();
+        uint64_t seq = 0;
+        std::cerr << "[FrameBusTool] 发布 " << name << " " << width << "x" << height << " @" << fps << " fps，Ctrl+C 结束" << std::endl;
+        while (g_running)
+        {
+            // 合成帧：整帧亮度随帧序号变化，便于目视确认刷新
+            const int64_t captureUs = nowUs();
+            std::fill(frame.data, frame.data + frame.step * frame.rows, static_cast<uint8_t>(seq * 7));
+            writer.publish(frame, ++seq, captureUs);
+            nextUs += intervalUs;
+            const int64_t sleepUs = nextUs - nowUs();
+            if (sleepUs > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+            else
+                nextUs = nowUs();
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "用法: " << argv[0] << " read <总线名称> [--show]\n"
+                  << "      " << argv[0] << " bench <总线名称> [帧数]\n"
+                  << "      " << argv[0] << " publish <总线名称> <宽> <高> [fps]" << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { g_running = false; });
+    std::signal(SIGTERM, [](int) { g_running = false; });
+
+    const std::string command = argv[1];
+    const std::string name = argv[2];
+    if (command == "read")
+        return runRead(name, argc > 3 && std::string(argv[3]) == "--show");
+    if (command == "bench")
+        return runBench(name, argc > 3 ? (std::max)(1, std::atoi(argv[3])) : 1000);
+    if (command == "publish" && argc > 4)
+        return runPublish(name, std::atoi(argv[3]), std::atoi(argv[4]), argc > 5 ? std::atoi(argv[5]) : 25);
+
+    std::cerr << "[FrameBusTool] 未知的命令或参数不足: " << command << std::endl;
+    return 1;
+}
@@ -0,0 +1,76 @@
+﻿#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <opencv2/opencv.hpp>
+#include "ThermalAnalyzer.h"
+
+/**
+ * @brief 高温区域提取方式对比工具
+ *
+ * 用法: ThermalBlobBench [迭代次数]
+ * 在合成掩码（1/10/50/100/200个随机实心圆）上分别运行游程（runlength）与轮廓（contours）两种提取方式，
+ * 输出每种情形的平均耗时与加速比。两种方式提取的区域数量全部一致时退出码为0，否则为1。
+ */
+int main(int argc, char **argv)
+{
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    if (iterations <= 0)
+    {
+        std::cerr << "用法: " << argv[0] << " [迭代次数]" << std::endl;
+        return 1;
+    }
+
+    const int width = 640, height = 512;
+    std::mt19937 rng(12345);
+    ThermalAnalyzer runLength(100.0f, 5, ThermalAnalyzer::Method::RunLength);
+    ThermalAnalyzer contours(100.0f, 5, ThermalAnalyzer::Method::Contours);
+
+    bool consistent = true;
+    for (int blobCount : {1, 10, 50, 100, 200})
+    {
+        // 合成掩码：随机位置的实心圆（半径8~14，面积均超过下限）
+        cv::Mat canvas = cv::Mat::zeros(height, width, CV_8UC1);
+        std::uniform_int_distribution<int> px(16, width - 17), py(16, height - 17), pr(8, 14);
+        for (int i = 0; i < blobCount; i++)
+        {
+            cv::circle(canvas, cv::Point(px(rng), py(rng)), pr(rng), cv::Scalar(255), -1);
+        }
+        ThermalBitMask mask(width, height);
+        for (int y = 0; y < height; y++)
+        {
+            const uchar *p = canvas.ptr<uchar>(y);
+            for (int x = 0; x < width; x++)
+            {
+                if (p[x])
+                    mask.set(x, y);
+            }
+        }
+
+        size_t runLengthBlobs = 0, contourBlobs = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            runLengthBlobs = runLength.analyze(mask, 40.0f, 0, 0)->blobs.size();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            contourBlobs = contours.analyze(mask, 40.0f, 0, 0)->blobs.size();
+        }
+        auto t2 = std::chrono::steady_clock::now();
+
+        const double runLengthMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+        const double contourMs = std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+        std::cout << "[ThermalBlobBench] 合成区域: " << blobCount
+                  << ", 游程: " << runLengthMs << " ms (" << runLengthBlobs << "个)"
+                  << ", 轮廓: " << contourMs << " ms (" << contourBlobs << "个)"
+                  << ", 加速比: " << (runLengthMs > 0.0 ? contourMs / runLengthMs : 0.0) << std::endl;
+        if (runLengthBlobs != contourBlobs)
+        {
+            std::cerr << "[ThermalBlobBench] 两种方式提取的区域数量不一致" << std::endl;
+            consistent = false;
+        }
+    }
+    return consistent ? 0 : 1;
+}
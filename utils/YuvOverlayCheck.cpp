@@ -0,0 +1,269 @@
+﻿#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "YuvOverlayRenderer.h"
+
+namespace
+{
+    // 同一组图元分别用OpenCV和YUV渲染器绘制
+    struct Scene
+    {
+        const char *name;
+        std::function<void(cv::Mat &)> drawBgr;
+        std::function<void(YuvOverlayRenderer &, const YuvPlanes &)> drawYuv;
+    };
+
+    std::vector<Scene> makeScenes(int width, int height, int count)
+    {
+        std::vector<cv::Rect> rects;
+        std::vector<std::pair<cv::Point, cv::Point>> lines;
+        std::vector<std::array<cv::Point2f, 4>> rotated;
+        std::vector<std::pair<std::string, cv::Point>> labels;
+        cv::RNG rng(20240611);
+        for (int i = 0; i < count; i++)
+        {
+            const int w = rng.uniform(20, width / 6), h = rng.uniform(20, height / 6);
+            const cv::Rect r(rng.uniform(0, width - w), rng.uniform(20, height - h), w, h);
+            rects.push_back(r);
+            lines.emplace_back(cv::Point(rng.uniform(0, width), rng.uniform(0, height)),
+                               cv::Point(rng.uniform(0, width), rng.uniform(0, height)));
+            cv::Point2f v[4];
+            cv::RotatedRect(cv::Point2f(r.x + w * 0.5f, r.y + h * 0.5f), cv::Size2f(static_cast<float>(w), static_cast<float>(h)),
+                            static_cast<float>(rng.uniform(0, 180)))
+                .points(v);
+            rotated.push_back({v[0], v[1], v[2], v[3]});
+            labels.emplace_back(std::to_string(rng.uniform(1, 100000)), cv::Point(r.x, r.y - 5));
+        }
+        labels.emplace_back("Detection Line", cv::Point(10, height / 2 - 10));
+
+        const cv::Scalar red(0, 0, 255), yellow(0, 255, 255), green(0, 255, 0);
+        std::vector<Scene> scenes;
+        scenes.push_back({"rect",
+                          [=](cv::Mat &img)
+                          {
+                              for (size_t i = 0; i < rects.size(); i++)
+                                  cv::rectangle(img, rects[i], red, 1 + static_cast<int>(i % 3));
+                          },
+                          [=](YuvOverlayRenderer &r, const YuvPlanes &p)
+                          {
+                              for (size_t i = 0; i < rects.size(); i++)
+                                  r.drawRect(p, rects[i], red, 1 + static_cast<int>(i % 3));
+                          }});
+        scenes.push_back({"line",
+                          [=](cv::Mat &img)
+                          {
+                              for (size_t i = 0; i < lines.size(); i++)
+                                  cv::line(img, lines[i].first, lines[i].second, yellow, i % 2 ? 3 : 1);
+                          },
+                          [=](YuvOverlayRenderer &r, const YuvPlanes &p)
+                          {
+                              for (size_t i = 0; i < lines.size(); i++)
+                                  r.drawLine(p, lines[i].first, lines[i].second, yellow, i % 2 ? 3 : 1);
+                          }});
+        scenes.push_back({"rotated_rect",
+                          [=](cv::Mat &img)
+                          {
+                              for (const auto &v : rotated)
+                                  for (int j = 0; j < 4; j++)
+                                      cv::line(img, v[j], v[(j + 1) % 4], green, 2);
+                          },
+                          [=](YuvOverlayRenderer &r, const YuvPlanes &p)
+                          {
+                              for (const auto &v : rotated)
+                                  r.drawRotatedRect(p, v, green, 2);
+                          }});
+        scenes.push_back({"text",
+                          [=](cv::Mat &img)
+                          {
+                              for (const auto &l : labels)
+                                  cv::putText(img, l.first, l.second, cv::FONT_HERSHEY_SIMPLEX, 0.6, red, 2, cv::LINE_8);
+                          },
+                          [=](YuvOverlayRenderer &r, const YuvPlanes &p)
+                          {
+                              for (const auto &l : labels)
+                                  r.drawText(p, l.first, l.second, 0.6, 2, red);
+                          }});
+        return scenes;
+    }
+
+    // 参考转换：逐像素按渲染器的系数换算，色度取2×2块的平均
+    void convertReference(const YuvOverlayRenderer &renderer, const cv::Mat &bgr, std::vector<uint8_t> &out)
+    {
+        const int w = bgr.cols, h = bgr.rows;
+        out.resize(static_cast<size_t>(w) * h * 3 / 2);
+        const YuvPlanes planes = YuvPlanes::i420(out.data(), w, h);
+        std::vector<int> sumU(w / 2), sumV(w / 2);
+        for (int y = 0; y < h; y++)
+        {
+            const uint8_t *src = bgr.ptr<uint8_t>(y);
+            for (int x = 0; x < w; x++)
+            {
+                const YuvOverlayRenderer::Color c = renderer.color(cv::Scalar(src[3 * x], src[3 * x + 1], src[3 * x + 2]));
+                planes.y[static_cast<size_t>(y) * planes.yStride + x] = c.y;
+                if (x / 2 < w / 2)
+                {
+                    sumU[x / 2] += c.u;
+                    sumV[x / 2] += c.v;
+                }
+            }
+            if (y & 1)
+            {
+                for (int cx = 0; cx < w / 2; cx++)
+                {
+                    planes.u[static_cast<size_t>(y / 2) * planes.uvStride + cx] = static_cast<uint8_t>((sumU[cx] + 2) >> 2);
+                    planes.v[static_cast<size_t>(y / 2) * planes.uvStride + cx] = static_cast<uint8_t>((sumV[cx] + 2) >> 2);
+                    sumU[cx] = sumV[cx] = 0;
+                }
+            }
+        }
+    }
+
+    double elapsedUs(std::chrono::steady_clock::time_point start, int iterations)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    /**
+     * @brief 与OpenCV绘制结果逐像素对比：每种图元分别用OpenCV画到BGR帧再按相同系数转换并按面积下采样，
+     *        与直接在YUV平面上绘制的结果比较，输出各平面差异超过1级的像素数与最大差异
+     * @return 所有图元的差异像素比例都在容差内返回true
+     */
+    bool compareWithOpenCv(int width, int height)
+    {
+        width &= ~1;
+        height &= ~1;
+        const cv::Mat background(height, width, CV_8UC3, cv::Scalar(90, 110, 130));
+        const size_t lumaSize = static_cast<size_t>(width) * height;
+        const char *planeNames[3] = {"Y", "U", "V"};
+        bool passed = true;
+
+        for (YuvOverlayRenderer::ColorMatrix matrix : {YuvOverlayRenderer::kPushStream, YuvOverlayRenderer::kBt601Limited})
+        {
+            YuvOverlayRenderer renderer(matrix);
+            std::vector<uint8_t> base, expected, actual;
+            convertReference(renderer, background, base);
+            for (const Scene &scene : makeScenes(width, height, 40))
+            {
+                cv::Mat reference = background.clone();
+                scene.drawBgr(reference);
+                convertReference(renderer, reference, expected);
+                actual = base;
+                scene.drawYuv(renderer, YuvPlanes::i420(actual.data(), width, height));
+
+                size_t drawn = 0;
+                for (size_t i = 0; i < lumaSize; i++)
+                    drawn += expected[i] != base[i];
+
+                // 文字拼接按整像素对齐字形，与 cv::putText 的亚像素笔位存在少量差异，容差放宽
+                const double tolerance = std::strcmp(scene.name, "text") == 0 ? 0.15 : 0.02;
+                std::ostringstream line;
+                line << "[YuvOverlayCheck] 对比 " << scene.name << "（" << (matrix == YuvOverlayRenderer::kPushStream ? "推流系数" : "BT.601")
+                     << "）：绘制像素 " << drawn;
+                bool scenePassed = true;
+                size_t planeStart[4] = {0, lumaSize, lumaSize + lumaSize / 4, lumaSize + lumaSize / 2};
+                for (int p = 0; p < 3; p++)
+                {
+                    size_t mismatched = 0;
+                    int maxDiff = 0;
+                    for (size_t i = planeStart[p]; i < planeStart[p + 1]; i++)
+                    {
+                        const int diff = std::abs(static_cast<int>(expected[i]) - static_cast<int>(actual[i]));
+                        mismatched += diff > 1;
+                        maxDiff = (std::max)(maxDiff, diff);
+                    }
+                    // 色度平面的像素数是亮度的1/4
+                    const double limit = tolerance * drawn / (p == 0 ? 1.0 : 4.0) + 4;
+                    scenePassed = scenePassed && mismatched <= limit;
+                    line << "，" << planeNames[p] << "差异 " << mismatched << "（最大 " << maxDiff << "）";
+                }
+                line << (scenePassed ? "，通过" : "，未通过");
+                (scenePassed ? std::cout : std::cerr) << line.str() << std::endl;
+                passed = passed && scenePassed;
+            }
+        }
+        return passed;
+    }
+
+    /**
+     * @brief 按图元类型对比"BGR绘制+整帧转换"与直接在YUV平面上绘制的每帧耗时
+     */
+    void runBenchmark(int width, int height, int iterations)
+    {
+        width &= ~1;
+        height &= ~1;
+        iterations = (std::max)(1, iterations);
+        const cv::Mat clean(height, width, CV_8UC3, cv::Scalar(90, 110, 130));
+        cv::Mat canvas, i420;
+        cv::cvtColor(clean, i420, cv::COLOR_BGR2YUV_I420);
+        const std::vector<uint8_t> base(i420.data, i420.data + i420.total());
+        std::vector<uint8_t> planesBuffer(base);
+        YuvOverlayRenderer renderer(YuvOverlayRenderer::kBt601Limited);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            cv::cvtColor(clean, i420, cv::COLOR_BGR2YUV_I420);
+        const double convertUs = elapsedUs(start, iterations);
+        std::cout << "[YuvOverlayCheck] 基准 " << width << "x" << height << "，" << iterations << " 次，整帧BGR→I420转换 "
+                  << std::fixed << std::setprecision(1) << convertUs << " us" << std::endl;
+
+        for (const Scene &scene : makeScenes(width, height, 30))
+        {
+            // BGR路径：复制干净帧后绘制（转换另计）；YUV路径：复制转换后的平面后直接绘制
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                clean.copyTo(canvas);
+                scene.drawBgr(canvas);
+            }
+            const double bgrUs = elapsedUs(start, iterations);
+
+            scene.drawYuv(renderer, YuvPlanes::i420(planesBuffer.data(), width, height)); // 预热字形图集
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+            {
+                std::memcpy(planesBuffer.data(), base.data(), base.size());
+                scene.drawYuv(renderer, YuvPlanes::i420(planesBuffer.data(), width, height));
+            }
+            const double yuvUs = elapsedUs(start, iterations);
+
+            std::cout << "[YuvOverlayCheck] 基准 " << scene.name << "：BGR复制+绘制 " << bgrUs << " us（加转换 "
+                      << bgrUs + convertUs << " us），YUV复制+绘制 " << yuvUs << " us，加速 " << std::setprecision(2)
+                      << (yuvUs > 0 ? (bgrUs + convertUs) / (yuvUs + convertUs) : 0.0) << "x（含转换）"
+                      << std::setprecision(1) << std::endl;
+        }
+        std::cout.unsetf(std::ios::fixed);
+    }
+}
+
+/**
+ * @brief YUV平面标注渲染器校验与耗时对比工具
+ *
+ * 用法: YuvOverlayCheck [宽] [高] [迭代次数]
+ * 先按两种颜色系数与OpenCV绘制结果逐像素对比（框、线段、旋转矩形、文字），迭代次数大于0时再按图元类型
+ * 测量"BGR绘制+整帧转换"与直接在YUV平面上绘制的耗时。所有图元的差异都在容差内时退出码为0，否则为1。
+ */
+int main(int argc, char **argv)
+{
+    const int width = argc > 1 ? std::atoi(argv[1]) : 1920;
+    const int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int iterations = argc > 3 ? std::atoi(argv[3]) : 100;
+    if (width < 64 || height < 64 || iterations < 0)
+    {
+        std::cerr << "用法: " << argv[0] << " [宽] [高] [迭代次数]" << std::endl;
+        return 1;
+    }
+
+    const bool passed = compareWithOpenCv(width, height);
+    if (iterations > 0)
+    {
+        runBenchmark(width, height, iterations);
+    }
+    std::cout << "[YuvOverlayCheck] 与OpenCV绘制结果对比" << (passed ? "通过" : "未通过") << std::endl;
+    return passed ? 0 : 1;
+}